@@ -0,0 +1,132 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/AsyncBatchWriter.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.sql.*;
+import java.util.concurrent.*;
+
+/*
+ * AsyncBatchWriter
+ *      Executes the batches of a connection on a worker thread, so that C
+ *      code can produce and serialize the next batch while the previous one
+ *      is executed on the remote server.
+ *
+ *      At most MAX_PENDING_BATCHES batches are queued or running at a time;
+ *      submit() blocks until one of them is done. The first error of a
+ *      batch is kept, the batches queued after it are skipped, and it is
+ *      thrown by the next submit() or await().
+ */
+public class AsyncBatchWriter {
+  private static final int MAX_PENDING_BATCHES = 2;
+
+  private final ExecutorService executor;
+  private final Semaphore permits = new Semaphore(MAX_PENDING_BATCHES);
+  private volatile Throwable error = null;
+  private volatile boolean discarding = false;
+
+  public AsyncBatchWriter() {
+    executor = Executors.newSingleThreadExecutor(runnable -> {
+      Thread thread = new Thread(runnable, "jdbc_fdw async writer");
+
+      /* never keep the JVM of the backend alive */
+      thread.setDaemon(true);
+      return thread;
+    });
+  }
+
+  /*
+   * submit
+   *      Queue a batch for execution, waiting while the queue is full.
+   *      Throws the error of an earlier batch, if any.
+   */
+  public void submit(Callable<Void> batch) throws SQLException {
+    throwError();
+    try {
+      permits.acquire();
+    } catch (InterruptedException e) {
+      throw new SQLException("interrupted while waiting for a pending batch", e);
+    }
+    try {
+      executor.execute(() -> {
+        try {
+          if (error == null && !discarding) {
+            batch.call();
+          }
+        } catch (Throwable e) {
+          if (error == null) {
+            error = e;
+          }
+        } finally {
+          permits.release();
+        }
+      });
+    } catch (RejectedExecutionException e) {
+      permits.release();
+      throw new SQLException(e);
+    }
+  }
+
+  /*
+   * await
+   *      Wait until every queued batch has been executed, and throw the
+   *      error of one of them, if any.
+   */
+  public void await() throws SQLException {
+    waitIdle();
+    throwError();
+  }
+
+  /*
+   * discard
+   *      Skip the queued batches, wait for the running one and forget its
+   *      error. Used when the transaction is aborted.
+   */
+  public void discard() {
+    discarding = true;
+    try {
+      waitIdle();
+    } catch (SQLException e) {
+      /* nothing to report on abort */
+    } finally {
+      discarding = false;
+      error = null;
+    }
+  }
+
+  /* Stop the worker thread, the connection is being closed */
+  public void close() {
+    executor.shutdownNow();
+  }
+
+  private void waitIdle() throws SQLException {
+    try {
+      permits.acquire(MAX_PENDING_BATCHES);
+      permits.release(MAX_PENDING_BATCHES);
+    } catch (InterruptedException e) {
+      throw new SQLException("interrupted while waiting for pending batches", e);
+    }
+  }
+
+  private void throwError() throws SQLException {
+    Throwable e = error;
+
+    if (e == null) {
+      return;
+    }
+    error = null;
+    if (e instanceof SQLException) {
+      throw (SQLException) e;
+    }
+    throw new SQLException(e);
+  }
+}
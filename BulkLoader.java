@@ -0,0 +1,253 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/BulkLoader.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.sql.*;
+import java.time.LocalDate;
+import java.time.LocalDateTime;
+import java.time.LocalTime;
+import java.time.ZoneOffset;
+import java.time.format.DateTimeFormatter;
+
+/*
+ * BulkLoader
+ *      Loads rows into a table through the native bulk path of the remote
+ *      database instead of a batch of INSERT statements.
+ *
+ *      Rows come from C code in the layout of a bound row, see
+ *      JDBCUtils.bindRowPreparedStatement. They are collected in memory as
+ *      tab separated text, one line per row, with \N for NULL and
+ *      backslash escapes for backslash, tab, newline and carriage return.
+ *      This is the text format of PostgreSQL COPY and the default format of
+ *      MySQL LOAD DATA. load() streams the collected rows to the server.
+ *
+ *      Subclasses implement the driver specific part. They use the driver
+ *      API through reflection, because the driver is only known at run time.
+ */
+public abstract class BulkLoader {
+  private static final DateTimeFormatter TIME_FORMAT =
+      DateTimeFormatter.ofPattern("HH:mm:ss.SSSSSS");
+  private static final DateTimeFormatter TIMESTAMP_FORMAT =
+      DateTimeFormatter.ofPattern("uuuu-MM-dd HH:mm:ss.SSSSSS");
+
+  protected final Connection conn;
+  protected final String table;
+  protected final String columns;
+  private ByteArrayOutputStream data = new ByteArrayOutputStream();
+  private int numberOfRows = 0;
+
+  protected BulkLoader(Connection conn, String table, String columns) {
+    this.conn = conn;
+    this.table = table;
+    this.columns = columns;
+  }
+
+  /*
+   * create
+   *      Returns a bulk loader for the given quoted table name and comma
+   *      separated list of quoted column names, or null if the database or
+   *      its driver has no bulk path.
+   */
+  public static BulkLoader create(Connection conn, int queryTimeout, String table, String columns)
+      throws SQLException {
+    String productName = conn.getMetaData().getDatabaseProductName();
+
+    if ("PostgreSQL".equals(productName)) {
+      return PgCopyBulkLoader.create(conn, table, columns);
+    }
+    if ("MySQL".equals(productName)) {
+      return MySQLBulkLoader.create(conn, queryTimeout, table, columns);
+    }
+    return null;
+  }
+
+  /*
+   * addRow
+   *      Append a row serialized by jq_add_bulk_load_row to the data
+   */
+  public void addRow(ByteBuffer buffer) throws SQLException {
+    buffer.order(ByteOrder.nativeOrder());
+    int numberOfParams = buffer.getInt(0);
+    int nullsOffset = JDBCUtils.align8(4 * (numberOfParams + 1));
+    int slotsOffset = nullsOffset + JDBCUtils.align8((numberOfParams + 7) / 8);
+    int dataOffset = slotsOffset + 8 * numberOfParams;
+
+    for (int i = 0; i < numberOfParams; i++) {
+      int slot = slotsOffset + 8 * i;
+
+      if (i > 0) {
+        data.write('\t');
+      }
+      if ((buffer.get(nullsOffset + i / 8) & (1 << (i % 8))) != 0) {
+        writeAscii("\\N");
+        continue;
+      }
+      switch (buffer.getInt(4 * (i + 1))) {
+        case JDBCColumnarBatch.KIND_INT32:
+          writeAscii(Integer.toString(buffer.getInt(slot)));
+          break;
+        case JDBCColumnarBatch.KIND_INT64:
+          writeAscii(Long.toString(buffer.getLong(slot)));
+          break;
+        case JDBCColumnarBatch.KIND_FLOAT4:
+          writeAscii(Float.toString(buffer.getFloat(slot)));
+          break;
+        case JDBCColumnarBatch.KIND_FLOAT8:
+          writeAscii(Double.toString(buffer.getDouble(slot)));
+          break;
+        case JDBCColumnarBatch.KIND_BOOL:
+          writeAscii(formatBoolean(buffer.get(slot) != 0));
+          break;
+        case JDBCColumnarBatch.KIND_TIME:
+          /* microseconds since midnight */
+          writeAscii(LocalTime.ofNanoOfDay(buffer.getLong(slot) * 1000).format(TIME_FORMAT));
+          break;
+        case JDBCColumnarBatch.KIND_TIMESTAMP:
+          {
+            /* microseconds since the Unix epoch in UTC */
+            long micros = buffer.getLong(slot);
+            LocalDateTime timestamp = LocalDateTime.ofEpochSecond(
+                Math.floorDiv(micros, 1000000L), (int) Math.floorMod(micros, 1000000L) * 1000, ZoneOffset.UTC);
+            writeAscii(formatTimestamp(timestamp.format(TIMESTAMP_FORMAT)));
+            break;
+          }
+        case JDBCColumnarBatch.KIND_DATE:
+          /* days since the Unix epoch */
+          writeAscii(LocalDate.ofEpochDay(buffer.getLong(slot)).toString());
+          break;
+        case JDBCColumnarBatch.KIND_NUMERIC:
+          {
+            /* the text of a PostgreSQL numeric */
+            byte[] dat = JDBCUtils.getBytes(buffer, dataOffset, slot);
+            data.write(dat, 0, dat.length);
+            break;
+          }
+        case JDBCColumnarBatch.KIND_BINARY:
+          writeBinary(data, JDBCUtils.getBytes(buffer, dataOffset, slot));
+          break;
+        case JDBCColumnarBatch.KIND_TEXT:
+          /* UTF-8 text, the escaped bytes never occur inside a character */
+          writeEscaped(JDBCUtils.getBytes(buffer, dataOffset, slot));
+          break;
+        default:
+          throw new IllegalArgumentException("unexpected parameter kind for parameter " + (i + 1));
+      }
+    }
+    data.write('\n');
+    numberOfRows++;
+  }
+
+  /*
+   * load
+   *      Send the rows added since the last call to the server.
+   *      Returns the number of rows loaded. Throws an SQLException if the
+   *      server skipped some of them, as a batch of INSERT statements
+   *      would have failed on them.
+   */
+  public int load() throws SQLException {
+    long numberOfLoadedRows;
+
+    if (numberOfRows == 0) {
+      return 0;
+    }
+    try {
+      numberOfLoadedRows = load(new ByteArrayInputStream(data.toByteArray()));
+      if (numberOfLoadedRows != numberOfRows) {
+        String warnings = getLoadWarnings();
+
+        throw new SQLException("bulk load into " + table + " loaded " + numberOfLoadedRows
+            + " of " + numberOfRows + " rows" + (warnings == null ? "" : ": " + warnings));
+      }
+      return numberOfRows;
+    } finally {
+      data.reset();
+      numberOfRows = 0;
+    }
+  }
+
+  /* Number of rows added since the last load */
+  protected int getNumberOfRows() {
+    return numberOfRows;
+  }
+
+  /* Stream the data to the server, returns the number of rows loaded */
+  protected abstract long load(InputStream in) throws SQLException;
+
+  /*
+   * Text of the warnings the server gave for the rows it skipped in the
+   * last load, or null if it has none
+   */
+  protected String getLoadWarnings() {
+    return null;
+  }
+
+  /* Text of a boolean value */
+  protected abstract String formatBoolean(boolean value);
+
+  /* Text of a timestamp value, given in UTC */
+  protected abstract String formatTimestamp(String value);
+
+  /* Write a binary value, escaped as needed */
+  protected abstract void writeBinary(ByteArrayOutputStream out, byte[] value);
+
+  private void writeAscii(String value) {
+    for (int i = 0; i < value.length(); i++) {
+      data.write(value.charAt(i));
+    }
+  }
+
+  protected void writeEscaped(byte[] value) {
+    for (byte b : value) {
+      switch (b) {
+        case '\\':
+          writeAscii("\\\\");
+          break;
+        case '\t':
+          writeAscii("\\t");
+          break;
+        case '\n':
+          writeAscii("\\n");
+          break;
+        case '\r':
+          writeAscii("\\r");
+          break;
+        default:
+          data.write(b);
+          break;
+      }
+    }
+  }
+
+  /*
+   * invoke
+   *      Call a driver method found by reflection, rethrowing the
+   *      exception of the driver as an SQLException
+   */
+  protected static Object invoke(java.lang.reflect.Method method, Object target, Object... args)
+      throws SQLException {
+    try {
+      return method.invoke(target, args);
+    } catch (java.lang.reflect.InvocationTargetException e) {
+      Throwable cause = e.getCause();
+      if (cause instanceof SQLException) {
+        throw (SQLException) cause;
+      }
+      throw new SQLException(cause);
+    } catch (IllegalAccessException e) {
+      throw new SQLException(e);
+    }
+  }
+}
@@ -0,0 +1,471 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/JDBCColumnarBatch.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.math.BigDecimal;
+import java.math.BigInteger;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.sql.*;
+import java.time.LocalTime;
+import java.util.*;
+
+/*
+ * JDBCColumnarBatch
+ *      Transfers rows of a result set to C code in column-major batches
+ *      written into a direct ByteBuffer allocated by the C side.
+ *
+ *      Layout of a batch (native byte order, every section 8-byte aligned):
+ *        int32  number of rows in the batch
+ *        int32  1 if the result set is exhausted, 0 otherwise
+ *        int64  bytes needed for the next row if it did not fit into an
+ *               empty buffer, 0 otherwise
+ *        int32  number of columns in the batch
+ *        int32  transfer kind actually used, one per column
+ *      then for each column:
+ *        validity bitmap, one bit per row, bit set means NULL
+ *        KIND_INT64, KIND_FLOAT8, KIND_TIMESTAMP, KIND_BOOL, KIND_DATE,
+ *        KIND_TIME: one 8-byte value per row
+ *        KIND_TEXT, KIND_BINARY, KIND_NUMERIC: (rows + 1) int32 offsets,
+ *               then the data
+ *
+ *      The C side requests a kind per column from the PostgreSQL type.
+ *      When the JDBC column type does not match the requested kind, the
+ *      column is sent as KIND_TEXT instead. The kinds actually used are
+ *      written into the header so that C can decode each column.
+ */
+public class JDBCColumnarBatch {
+  /* Transfer kinds, must match JQ_KIND_* in jq.h */
+  public static final int KIND_TEXT = 0;
+  public static final int KIND_BINARY = 1;
+  public static final int KIND_INT64 = 2;
+  public static final int KIND_FLOAT8 = 3;
+  public static final int KIND_TIMESTAMP = 4;
+  public static final int KIND_BOOL = 5;
+  public static final int KIND_DATE = 6;
+  public static final int KIND_TIME = 7;
+  public static final int KIND_NUMERIC = 8;
+  /* Only used for the parameters of a bound row */
+  public static final int KIND_INT32 = 9;
+  public static final int KIND_FLOAT4 = 10;
+
+  private static final int HEADER_SIZE = 20;
+
+  private int numberOfColumns;
+  private int capacity;
+  private int[] kinds;
+  private int[] columnTypes;
+  private int[] columnPrecisions;
+  private boolean[][] nulls;
+  private long[][] fixedValues;
+  private int[][] offsets;
+  private byte[][] varData;
+  private int numberOfRows;
+  private boolean hasPendingRow;
+  private boolean exhausted;
+  private Calendar utcCalendar;
+  private boolean useLocalTime = true;
+  private ByteBuffer numericValue = ByteBuffer.allocate(13).order(ByteOrder.nativeOrder());
+
+  /*
+   * JDBCColumnarBatch
+   *      The column types and the UTC calendar are those cached in
+   *      resultSetInfo when the query was executed.
+   */
+  public JDBCColumnarBatch(int[] fieldColumnTypes, int[] fieldColumnPrecisions, Calendar fieldUtcCalendar) {
+    this.numberOfColumns = fieldColumnTypes.length;
+    this.columnTypes = fieldColumnTypes;
+    this.columnPrecisions = fieldColumnPrecisions;
+    this.utcCalendar = fieldUtcCalendar;
+    this.capacity = 0;
+    this.hasPendingRow = false;
+    this.exhausted = false;
+  }
+
+  /*
+   * fill
+   *      Reads up to fetchSize rows from the result set and writes them into
+   *      the buffer. A row that does not fit is kept pending and sent first
+   *      in the next batch. Returns the number of rows written.
+   */
+  public int fill(ResultSet resultSet, int[] requestedKinds, ByteBuffer buffer, int fetchSize) throws SQLException {
+    int limit = buffer.capacity();
+    long needed = 0;
+
+    prepare(requestedKinds, fetchSize);
+
+    while (numberOfRows < fetchSize) {
+      if (hasPendingRow) {
+        /* The current row of the result set was not sent yet */
+        hasPendingRow = false;
+      } else if (!resultSet.next()) {
+        exhausted = true;
+        break;
+      }
+      addRow(resultSet);
+      if (serializedSize() > limit) {
+        /* The row alone does not fit, C code must grow the buffer */
+        if (numberOfRows == 1) {
+          needed = serializedSize();
+        }
+        /* Keep this row for the next batch */
+        removeLastRow();
+        hasPendingRow = true;
+        break;
+      }
+    }
+
+    buffer.clear();
+    buffer.order(ByteOrder.nativeOrder());
+    buffer.putInt(numberOfRows);
+    buffer.putInt(exhausted ? 1 : 0);
+    buffer.putLong(needed);
+    buffer.putInt(numberOfColumns);
+    for (int i = 0; i < numberOfColumns; i++) {
+      buffer.putInt(kinds[i]);
+    }
+    align(buffer);
+
+    for (int i = 0; i < numberOfColumns; i++) {
+      writeBitmap(buffer, nulls[i]);
+      if (isFixedWidth(kinds[i])) {
+        for (int row = 0; row < numberOfRows; row++) {
+          buffer.putLong(fixedValues[i][row]);
+        }
+      } else {
+        for (int row = 0; row <= numberOfRows; row++) {
+          buffer.putInt(offsets[i][row]);
+        }
+        align(buffer);
+        buffer.put(varData[i], 0, offsets[i][numberOfRows]);
+        align(buffer);
+      }
+    }
+    return numberOfRows;
+  }
+
+  public boolean isExhausted() {
+    return exhausted;
+  }
+
+  /*
+   * prepare
+   *      Resolves the transfer kind of each column and resets the builders
+   *      for a new batch.
+   */
+  private void prepare(int[] requestedKinds, int fetchSize) {
+    if (kinds == null) {
+      /* Only the columns C code asked for are transferred */
+      numberOfColumns = Math.min(numberOfColumns, requestedKinds.length);
+      kinds = new int[numberOfColumns];
+      for (int i = 0; i < numberOfColumns; i++) {
+        kinds[i] = resolveKind(columnTypes[i], columnPrecisions[i], requestedKinds[i]);
+      }
+      nulls = new boolean[numberOfColumns][];
+      fixedValues = new long[numberOfColumns][];
+      offsets = new int[numberOfColumns][];
+      varData = new byte[numberOfColumns][];
+    }
+    if (capacity < fetchSize) {
+      capacity = fetchSize;
+      for (int i = 0; i < numberOfColumns; i++) {
+        nulls[i] = new boolean[capacity];
+        if (isFixedWidth(kinds[i])) {
+          fixedValues[i] = new long[capacity];
+        } else {
+          offsets[i] = new int[capacity + 1];
+          if (varData[i] == null) {
+            varData[i] = new byte[1024];
+          }
+        }
+      }
+    }
+    numberOfRows = 0;
+  }
+
+  /*
+   * resolveKind
+   *      Returns the requested kind when the JDBC type can be read with the
+   *      matching typed getter, KIND_TEXT otherwise. Binary related types are
+   *      always sent as KIND_BINARY, as getResultSet does.
+   */
+  private static int resolveKind(int columnType, int precision, int requestedKind) {
+    switch (columnType) {
+      case Types.BINARY:
+      case Types.LONGVARBINARY:
+      case Types.VARBINARY:
+      case Types.BLOB:
+        return KIND_BINARY;
+    }
+    switch (requestedKind) {
+      case KIND_INT64:
+        switch (columnType) {
+          case Types.TINYINT:
+          case Types.SMALLINT:
+          case Types.INTEGER:
+          case Types.BIGINT:
+            return KIND_INT64;
+        }
+        break;
+      case KIND_FLOAT8:
+        switch (columnType) {
+          case Types.TINYINT:
+          case Types.SMALLINT:
+          case Types.INTEGER:
+          case Types.REAL:
+          case Types.FLOAT:
+          case Types.DOUBLE:
+            return KIND_FLOAT8;
+        }
+        break;
+      case KIND_TIMESTAMP:
+        if (columnType == Types.TIMESTAMP) {
+          return KIND_TIMESTAMP;
+        }
+        break;
+      case KIND_BOOL:
+        /* BIT is also used for bit strings, which getBoolean cannot read */
+        if (columnType == Types.BOOLEAN || (columnType == Types.BIT && precision <= 1)) {
+          return KIND_BOOL;
+        }
+        break;
+      case KIND_DATE:
+        if (columnType == Types.DATE) {
+          return KIND_DATE;
+        }
+        break;
+      case KIND_TIME:
+        if (columnType == Types.TIME) {
+          return KIND_TIME;
+        }
+        break;
+      case KIND_NUMERIC:
+        if (columnType == Types.NUMERIC || columnType == Types.DECIMAL) {
+          return KIND_NUMERIC;
+        }
+        break;
+    }
+    return KIND_TEXT;
+  }
+
+  private static boolean isFixedWidth(int kind) {
+    return kind != KIND_TEXT && kind != KIND_BINARY && kind != KIND_NUMERIC;
+  }
+
+  /*
+   * addRow
+   *      Appends the values of the current row of the result set.
+   */
+  private void addRow(ResultSet resultSet) throws SQLException {
+    int row = numberOfRows;
+
+    for (int i = 0; i < numberOfColumns; i++) {
+      int index = i + 1;
+
+      switch (kinds[i]) {
+        case KIND_INT64:
+          fixedValues[i][row] = resultSet.getLong(index);
+          nulls[i][row] = resultSet.wasNull();
+          break;
+        case KIND_FLOAT8:
+          fixedValues[i][row] = Double.doubleToRawLongBits(resultSet.getDouble(index));
+          nulls[i][row] = resultSet.wasNull();
+          break;
+        case KIND_TIMESTAMP:
+          {
+            /*
+             * Get the timestamp in UTC time zone by default
+             * to avoid being affected by the remote server's time zone.
+             */
+            Timestamp ts = resultSet.getTimestamp(index, utcCalendar);
+
+            nulls[i][row] = (ts == null);
+            if (ts != null) {
+              /* Microseconds since the Unix epoch */
+              fixedValues[i][row] = Math.floorDiv(ts.getTime(), 1000L) * 1000000L + ts.getNanos() / 1000;
+            }
+          }
+          break;
+        case KIND_BOOL:
+          fixedValues[i][row] = resultSet.getBoolean(index) ? 1 : 0;
+          nulls[i][row] = resultSet.wasNull();
+          break;
+        case KIND_DATE:
+          {
+            java.sql.Date date = resultSet.getDate(index);
+
+            nulls[i][row] = (date == null);
+            if (date != null) {
+              /* Days since the Unix epoch */
+              fixedValues[i][row] = date.toLocalDate().toEpochDay();
+            }
+          }
+          break;
+        case KIND_TIME:
+          {
+            LocalTime time = getLocalTime(resultSet, index);
+
+            nulls[i][row] = (time == null);
+            if (time != null) {
+              /* Microseconds since midnight */
+              fixedValues[i][row] = time.toNanoOfDay() / 1000;
+            }
+          }
+          break;
+        case KIND_NUMERIC:
+          appendNumeric(i, row, resultSet, index);
+          break;
+        case KIND_BINARY:
+          appendVarData(i, row, resultSet.getBytes(index));
+          break;
+        default:
+          {
+            String value;
+
+            if (columnTypes[i] == Types.TIMESTAMP) {
+              Timestamp ts = resultSet.getTimestamp(index, utcCalendar);
+
+              /* Timestamp is returned as text in ISO 8601 style */
+              value = (ts != null) ? ts.toInstant().toString() : null;
+            } else {
+              value = resultSet.getString(index);
+            }
+            appendVarData(i, row, (value != null) ? value.getBytes(StandardCharsets.UTF_8) : null);
+          }
+      }
+    }
+    numberOfRows++;
+  }
+
+  /*
+   * getLocalTime
+   *      Reads a TIME column with its fractional seconds. Drivers that do
+   *      not support getObject with LocalTime fall back to getTime, which
+   *      keeps milliseconds only.
+   */
+  private LocalTime getLocalTime(ResultSet resultSet, int index) throws SQLException {
+    if (useLocalTime) {
+      try {
+        return resultSet.getObject(index, LocalTime.class);
+      } catch (SQLFeatureNotSupportedException | AbstractMethodError e) {
+        useLocalTime = false;
+      }
+    }
+
+    Time time = resultSet.getTime(index);
+
+    return (time != null) ? time.toLocalTime().withNano((int) (time.getTime() % 1000 + 1000) % 1000 * 1000000) : null;
+  }
+
+  /*
+   * appendNumeric
+   *      Appends a NUMERIC or DECIMAL value. When its unscaled value fits in
+   *      64 bits, it is sent as 'b' followed by the int32 scale and the int64
+   *      unscaled value. Any other value is sent as 't' followed by its text.
+   */
+  private void appendNumeric(int column, int row, ResultSet resultSet, int index) throws SQLException {
+    BigDecimal value;
+    BigInteger unscaled;
+
+    try {
+      value = resultSet.getBigDecimal(index);
+    } catch (SQLException e) {
+      /* NaN and infinity cannot be read as BigDecimal */
+      String text = resultSet.getString(index);
+
+      appendVarData(column, row, (text != null) ? ("t" + text).getBytes(StandardCharsets.UTF_8) : null);
+      return;
+    }
+    if (value == null) {
+      appendVarData(column, row, null);
+      return;
+    }
+
+    if (value.scale() < 0) {
+      value = value.setScale(0);
+    }
+    unscaled = value.unscaledValue();
+    if (unscaled.bitLength() < 64) {
+      numericValue.clear();
+      numericValue.put((byte) 'b');
+      numericValue.putInt(value.scale());
+      numericValue.putLong(unscaled.longValue());
+      appendVarData(column, row, numericValue.array());
+    } else {
+      appendVarData(column, row, ("t" + value.toPlainString()).getBytes(StandardCharsets.UTF_8));
+    }
+  }
+
+  private void appendVarData(int column, int row, byte[] value) {
+    int start = offsets[column][row];
+
+    nulls[column][row] = (value == null);
+    if (value == null) {
+      offsets[column][row + 1] = start;
+      return;
+    }
+    if (start + value.length > varData[column].length) {
+      varData[column] = Arrays.copyOf(varData[column], Math.max(varData[column].length * 2, start + value.length));
+    }
+    System.arraycopy(value, 0, varData[column], start, value.length);
+    offsets[column][row + 1] = start + value.length;
+  }
+
+  private void removeLastRow() {
+    numberOfRows--;
+  }
+
+  /*
+   * serializedSize
+   *      Returns the number of bytes needed to write the current batch.
+   */
+  private long serializedSize() {
+    long size = alignedSize(HEADER_SIZE + 4L * numberOfColumns);
+
+    for (int i = 0; i < numberOfColumns; i++) {
+      size += alignedSize((numberOfRows + 7) / 8);
+      if (isFixedWidth(kinds[i])) {
+        size += 8L * numberOfRows;
+      } else {
+        size += alignedSize(4L * (numberOfRows + 1));
+        size += alignedSize(offsets[i][numberOfRows]);
+      }
+    }
+    return size;
+  }
+
+  private void writeBitmap(ByteBuffer buffer, boolean[] columnNulls) {
+    for (int row = 0; row < numberOfRows; row += 8) {
+      int bits = 0;
+
+      for (int bit = 0; bit < 8 && row + bit < numberOfRows; bit++) {
+        if (columnNulls[row + bit]) {
+          bits |= (1 << bit);
+        }
+      }
+      buffer.put((byte) bits);
+    }
+    align(buffer);
+  }
+
+  private static long alignedSize(long size) {
+    return (size + 7) & ~7L;
+  }
+
+  private static void align(ByteBuffer buffer) {
+    while ((buffer.position() & 7) != 0) {
+      buffer.put((byte) 0);
+    }
+  }
+}
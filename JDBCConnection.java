@@ -25,17 +25,22 @@ public class JDBCConnection {
     private long mapping_hashvalue; // keep the uint32 val
 
     private int queryTimeoutValue;
+    private boolean streamResults;
+    private boolean streamingTransaction; // autocommit turned off until transaction end
+    private AsyncBatchWriter asyncBatchWriter; // created by the first asynchronous batch
     private static JDBCDriverLoader jdbcDriverLoader;
 
     /* JDBC connection hash map */
     private static ConcurrentHashMap<Integer, JDBCConnection> ConnectionHash = new ConcurrentHashMap<Integer, JDBCConnection>();
 
-    public JDBCConnection(Connection conn, boolean invalidate, long server_hashvalue, long mapping_hashvalue, int queryTimeoutValue) {
+    public JDBCConnection(Connection conn, boolean invalidate, long server_hashvalue, long mapping_hashvalue, int queryTimeoutValue, boolean streamResults) {
         this.conn = conn;
         this.invalidate = invalidate;
         this.server_hashvalue = server_hashvalue;
         this.mapping_hashvalue = mapping_hashvalue;
         this.queryTimeoutValue = queryTimeoutValue;
+        this.streamResults = streamResults;
+        this.streamingTransaction = false;
     }
 
     /* finalize all actived connection */
@@ -44,6 +49,7 @@ public class JDBCConnection {
             Jconn.invalidate = true;
 
             if (Jconn.conn != null) {
+                Jconn.closeAsyncBatchWriter();
                 Jconn.conn.close();
                 Jconn.conn = null;
             }
@@ -58,6 +64,7 @@ public class JDBCConnection {
                 System.out.println("Finalizing " +  Jconn);
 
                 if (Jconn.conn != null) {
+                    Jconn.closeAsyncBatchWriter();
                     Jconn.conn.close();
                     Jconn.conn = null;
                 }
@@ -74,6 +81,7 @@ public class JDBCConnection {
                 System.out.println("Finalizing " +  Jconn);
 
                 if (Jconn.conn != null) {
+                    Jconn.closeAsyncBatchWriter();
                     Jconn.conn.close();
                     Jconn.conn = null;
                 }
@@ -91,6 +99,126 @@ public class JDBCConnection {
         return this.conn;
     }
 
+    /* get the writer thread of the connection, starting it if needed */
+    public AsyncBatchWriter getAsyncBatchWriter() {
+        if (asyncBatchWriter == null)
+            asyncBatchWriter = new AsyncBatchWriter();
+        return asyncBatchWriter;
+    }
+
+    /*
+     * Wait for the batches still executed by the writer thread, so that
+     * other statements see their rows. Throws the error of one of them.
+     */
+    public void awaitAsyncWrites() throws SQLException {
+        if (asyncBatchWriter != null)
+            asyncBatchWriter.await();
+    }
+
+    /* Wait for the writer threads of all connections */
+    public static void awaitAllAsyncWrites() throws SQLException {
+        for (JDBCConnection Jconn : ConnectionHash.values())
+            Jconn.awaitAsyncWrites();
+    }
+
+    /* Drop the batches not executed yet by the writer threads */
+    public static void discardAllAsyncWrites() {
+        for (JDBCConnection Jconn : ConnectionHash.values()) {
+            if (Jconn.asyncBatchWriter != null)
+                Jconn.asyncBatchWriter.discard();
+        }
+    }
+
+    private void closeAsyncBatchWriter() {
+        if (asyncBatchWriter != null) {
+            asyncBatchWriter.discard();
+            asyncBatchWriter.close();
+            asyncBatchWriter = null;
+        }
+    }
+
+    /*
+     * Apply the fetch size to a statement that is about to be executed.
+     * When stream_results is set, use the driver specific way of streaming
+     * the result set instead of letting the driver buffer all of it:
+     * MySQL streams row by row with a fetch size of Integer.MIN_VALUE, and
+     * PostgreSQL only fetches with a cursor when autocommit is off.
+     * Returns true if the statement streams inside a remote transaction.
+     * The remote transaction is only ended together with the local one, by
+     * commitAllStreaming() before the local commit or rollbackAllStreaming()
+     * at abort, so that closing a scan never commits the other statements of
+     * the local transaction executed on this connection.
+     */
+    public boolean setFetchSize(Statement stmt, int fetchSize) throws SQLException {
+        String productName;
+
+        if (fetchSize <= 0)
+            return false;
+        if (!streamResults) {
+            stmt.setFetchSize(fetchSize);
+            return false;
+        }
+
+        productName = conn.getMetaData().getDatabaseProductName();
+        if ("MySQL".equals(productName)) {
+            stmt.setFetchSize(Integer.MIN_VALUE);
+            return false;
+        }
+
+        stmt.setFetchSize(fetchSize);
+        if ("PostgreSQL".equals(productName) && (streamingTransaction || conn.getAutoCommit())) {
+            if (!streamingTransaction) {
+                conn.setAutoCommit(false);
+                streamingTransaction = true;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * Commit the remote transaction begun for streaming and turn autocommit
+     * back on.
+     */
+    private void commitStreamingTransaction() throws SQLException {
+        if (!streamingTransaction)
+            return;
+        /* On error, the transaction is left to rollbackAllStreaming() */
+        conn.commit();
+        conn.setAutoCommit(true);
+        streamingTransaction = false;
+    }
+
+    /*
+     * Commit the streaming remote transactions of all connections before the
+     * local transaction commits.  Throws the error of the first one that
+     * fails, so that the local transaction aborts and the remaining ones are
+     * rolled back by rollbackAllStreaming().
+     */
+    public static void commitAllStreaming() throws SQLException {
+        for (JDBCConnection Jconn : ConnectionHash.values()) {
+            if (Jconn.conn != null)
+                Jconn.commitStreamingTransaction();
+        }
+    }
+
+    /* Roll back the streaming remote transactions of all connections */
+    public static void rollbackAllStreaming() {
+        for (JDBCConnection Jconn : ConnectionHash.values()) {
+            if (!Jconn.streamingTransaction)
+                continue;
+            Jconn.streamingTransaction = false;
+            try {
+                if (Jconn.conn != null && !Jconn.conn.isClosed()) {
+                    Jconn.conn.rollback();
+                    Jconn.conn.setAutoCommit(true);
+                }
+            } catch (SQLException e) {
+                /* The connection may already be broken at transaction abort */
+            }
+        }
+    }
+
     /* get jdbc connection, create new one if not cached before */
     public static JDBCConnection getConnection(int key, long server_hashvalue, long mapping_hashvalue, String[] options) throws Exception {
         if (ConnectionHash.containsKey(key)) {
@@ -117,6 +245,7 @@ public class JDBCConnection {
         String password = options[3];
         String qTimeoutValue = options[4];
         String fileName = options[5];
+        boolean streamResults = options.length > 6 && Boolean.parseBoolean(options[6]);
 
         try {
             File JarFile = new File(fileName);
@@ -140,7 +269,7 @@ public class JDBCConnection {
             if (conn == null)
                 throw new SQLException("Cannot connect server: " + url);
 
-            JDBCConnection Jconn = new JDBCConnection(conn, false, server_hashvalue, mapping_hashvalue, Integer.parseInt(qTimeoutValue));
+            JDBCConnection Jconn = new JDBCConnection(conn, false, server_hashvalue, mapping_hashvalue, Integer.parseInt(qTimeoutValue), streamResults);
 
             /* cache new connection */
             System.out.println("Create new connection " + key);
@@ -18,10 +18,13 @@
  */
 
 import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
 import java.sql.*;
+import java.time.LocalDate;
 import java.time.LocalTime;
 import java.time.Instant;
-import java.time.format.DateTimeFormatter;
 import java.time.temporal.ChronoUnit;
 import java.util.*;
 import java.util.concurrent.*;
@@ -39,9 +42,10 @@ public class JDBCUtils {
    *      Initiates the connection to the foreign database after setting
    *      up initial configuration.
    *      key - the serverid for the connection cache identifying
-   *      Caller will pass in a six element array with the following elements:
+   *      Caller will pass in a seven element array with the following elements:
    *          0 - Driver class name, 1 - JDBC URL, 2 - Username
    *          3 - Password, 4 - Query timeout in seconds, 5 - jarfile
+   *          6 - stream_results ("true" or "false")
    *
    */
   public void createConnection(int key, long server_hashvalue, long mapping_hashvalue, String[] options) throws Exception {
@@ -60,6 +64,7 @@ public class JDBCUtils {
      */
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       tmpStmt = conn.getConnection().createStatement(ResultSet.TYPE_FORWARD_ONLY, ResultSet.CONCUR_READ_ONLY);
       if (conn.getQueryTimeout() != 0) {
         tmpStmt.setQueryTimeout(conn.getQueryTimeout());
@@ -73,30 +78,46 @@ public class JDBCUtils {
   /*
    * createStatementID
    *      Create a statement object based on the query
-   *      with a specific resultID and return back to the calling C function
+   *      with a specific resultID and return back to the calling C function.
+   *      fetchSize is the number of rows to fetch from the server at a time.
    *      Returns:
    *          resultID on success
    */
-  public int createStatementID(String query) throws Exception {
+  public int createStatementID(String query, int fetchSize) throws Exception {
     ResultSet tmpResultSet;
     int tmpNumberOfColumns;
     int tmpNumberOfAffectedRows = 0;
     ResultSetMetaData rSetMetadata;
+    int[] tmpColumnTypes;
+    int[] tmpColumnPrecisions;
+    resultSetInfo tmpResultSetInfo;
     int tmpResultSetKey;
+    boolean streaming = false;
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       tmpStmt = conn.getConnection().createStatement(ResultSet.TYPE_FORWARD_ONLY, ResultSet.CONCUR_READ_ONLY);
       if (conn.getQueryTimeout() != 0) {
         tmpStmt.setQueryTimeout(conn.getQueryTimeout());
       }
+      streaming = conn.setFetchSize(tmpStmt, fetchSize);
       tmpResultSet = tmpStmt.executeQuery(query);
       rSetMetadata = tmpResultSet.getMetaData();
       tmpNumberOfColumns = rSetMetadata.getColumnCount();
+      tmpColumnTypes = new int[tmpNumberOfColumns];
+      tmpColumnPrecisions = new int[tmpNumberOfColumns];
+      for (int i = 0; i < tmpNumberOfColumns; i++) {
+        tmpColumnTypes[i] = rSetMetadata.getColumnType(i + 1);
+        tmpColumnPrecisions[i] = rSetMetadata.getPrecision(i + 1);
+      }
+      tmpResultSetInfo = new resultSetInfo(
+          tmpResultSet, tmpNumberOfColumns, tmpNumberOfAffectedRows, null);
+      tmpResultSetInfo.setColumnMetaData(tmpColumnTypes, tmpColumnPrecisions);
+      if (streaming) {
+        tmpResultSetInfo.setStreamingConnection(conn);
+      }
       tmpResultSetKey = initResultSetKey();
-      resultSetInfoMap.put(
-          tmpResultSetKey,
-          new resultSetInfo(
-              tmpResultSet, tmpNumberOfColumns, tmpNumberOfAffectedRows, null));
+      resultSetInfoMap.put(tmpResultSetKey, tmpResultSetInfo);
       return tmpResultSetKey;
     } catch (Throwable e) {
       throw e;
@@ -110,7 +131,10 @@ public class JDBCUtils {
   public void clearResultSetID(int resultSetID) throws SQLException {
     try {
       checkConnExist();
-      resultSetInfoMap.remove(resultSetID);
+      resultSetInfo tmpResultSetInfo = resultSetInfoMap.remove(resultSetID);
+      if (tmpResultSetInfo != null) {
+        tmpResultSetInfo.endStreaming();
+      }
     } catch (Throwable e) {
       throw e;
     }
@@ -126,6 +150,7 @@ public class JDBCUtils {
   public int createPreparedStatement(String query) throws Exception {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       PreparedStatement tmpPstmt = (PreparedStatement) conn.getConnection().prepareStatement(query);
       if (conn.getQueryTimeout() != 0) {
         tmpPstmt.setQueryTimeout(conn.getQueryTimeout());
@@ -138,6 +163,36 @@ public class JDBCUtils {
     }
   }
 
+  /*
+   * createPreparedStatementReturning
+   *      Like createPreparedStatement, for a statement whose RETURNING
+   *      columns are read back with getGeneratedKeysID. The driver is asked
+   *      for the given columns, or for the keys it generates if it cannot
+   *      return columns by name.
+   *      Returns:
+   *          resultID on success
+   */
+  public int createPreparedStatementReturning(String query, String[] columns) throws Exception {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt;
+      try {
+        tmpPstmt = conn.getConnection().prepareStatement(query, columns);
+      } catch (SQLFeatureNotSupportedException e) {
+        tmpPstmt = conn.getConnection().prepareStatement(query, Statement.RETURN_GENERATED_KEYS);
+      }
+      if (conn.getQueryTimeout() != 0) {
+        tmpPstmt.setQueryTimeout(conn.getQueryTimeout());
+      }
+      int tmpResultSetKey = initResultSetKey();
+      resultSetInfoMap.put(tmpResultSetKey, new resultSetInfo(null, null, 0, tmpPstmt));
+      return tmpResultSetKey;
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
   /*
    * execPreparedStatement
    *      Create a PreparedStatement object based on the query
@@ -145,6 +200,7 @@ public class JDBCUtils {
   public void execPreparedStatement(int resultSetID) throws SQLException {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
       checkPstmt(tmpPstmt);
       int tmpNumberOfAffectedRows = tmpPstmt.executeUpdate();
@@ -157,6 +213,260 @@ public class JDBCUtils {
     }
   }
 
+  /*
+   * addBatchPreparedStatement
+   *      Add the currently bound parameters of the PreparedStatement
+   *      to its batch
+   */
+  public void addBatchPreparedStatement(int resultSetID) throws SQLException {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
+      checkPstmt(tmpPstmt);
+      tmpPstmt.addBatch();
+      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * execBatchPreparedStatement
+   *      Execute the batch of the PreparedStatement and store the
+   *      total number of affected rows
+   */
+  public void execBatchPreparedStatement(int resultSetID) throws SQLException {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
+      checkPstmt(tmpPstmt);
+      int tmpNumberOfAffectedRows;
+      try {
+        tmpNumberOfAffectedRows = sumUpdateCounts(tmpPstmt.executeBatch());
+      } finally {
+        tmpPstmt.clearBatch();
+      }
+
+      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+      resultSetInfoMap.get(resultSetID).setNumberOfAffectedRows(tmpNumberOfAffectedRows);
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * sumUpdateCounts
+   *      Returns the number of rows affected by a batch from the update
+   *      counts of executeBatch, or -1 if the driver did not report them
+   */
+  private static int sumUpdateCounts(int[] updateCounts) {
+    int numberOfAffectedRows = 0;
+
+    for (int count : updateCounts) {
+      /* Drivers that rewrite the batch may not report a count per row */
+      if (count == Statement.SUCCESS_NO_INFO) {
+        return -1;
+      } else if (count > 0) {
+        numberOfAffectedRows += count;
+      }
+    }
+    return numberOfAffectedRows;
+  }
+
+  /*
+   * getGeneratedKeysID
+   *      Keep the rows returned by the last execution or batch of a
+   *      statement made by createPreparedStatementReturning under a new
+   *      resultID, so that C code reads them with fillResultSetBatch. Reading
+   *      them all closes the result set but not the statement.
+   *      Returns:
+   *          resultID on success, 0 if the driver returned no result set
+   */
+  public int getGeneratedKeysID(int resultSetID) throws Exception {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
+      checkPstmt(tmpPstmt);
+      ResultSet tmpResultSet = tmpPstmt.getGeneratedKeys();
+      if (tmpResultSet == null) {
+        return 0;
+      }
+      ResultSetMetaData rSetMetadata = tmpResultSet.getMetaData();
+      int tmpNumberOfColumns = rSetMetadata.getColumnCount();
+      int[] tmpColumnTypes = new int[tmpNumberOfColumns];
+      int[] tmpColumnPrecisions = new int[tmpNumberOfColumns];
+      for (int i = 0; i < tmpNumberOfColumns; i++) {
+        tmpColumnTypes[i] = rSetMetadata.getColumnType(i + 1);
+        tmpColumnPrecisions[i] = rSetMetadata.getPrecision(i + 1);
+      }
+      resultSetInfo tmpResultSetInfo = new resultSetInfo(
+          tmpResultSet, tmpNumberOfColumns, 0, null);
+      tmpResultSetInfo.setColumnMetaData(tmpColumnTypes, tmpColumnPrecisions);
+      tmpResultSetInfo.setSharedStatement(true);
+      int tmpResultSetKey = initResultSetKey();
+      resultSetInfoMap.put(tmpResultSetKey, tmpResultSetInfo);
+      return tmpResultSetKey;
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * createPreparedQuery
+   *      Create a PreparedStatement for a query with parameters, which is
+   *      executed by execPreparedQueryID each time its parameters have been
+   *      bound by bindRowPreparedStatement. fetchSize is the number of rows
+   *      to fetch from the server at a time.
+   *      Returns:
+   *          resultID on success
+   */
+  public int createPreparedQuery(String query, int fetchSize) throws Exception {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt = conn.getConnection().prepareStatement(
+          query, ResultSet.TYPE_FORWARD_ONLY, ResultSet.CONCUR_READ_ONLY);
+      if (conn.getQueryTimeout() != 0) {
+        tmpPstmt.setQueryTimeout(conn.getQueryTimeout());
+      }
+      if (fetchSize > 0) {
+        tmpPstmt.setFetchSize(fetchSize);
+      }
+      int tmpResultSetKey = initResultSetKey();
+      resultSetInfoMap.put(tmpResultSetKey, new resultSetInfo(null, null, 0, tmpPstmt));
+      return tmpResultSetKey;
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * execPreparedQueryID
+   *      Execute a statement made by createPreparedQuery with its bound
+   *      parameters, and keep the result set under a new resultID for
+   *      fillResultSetBatch. The result set of the previous execution, if
+   *      still open, is closed by the driver. Reading all rows closes the
+   *      result set but not the statement.
+   *      Returns:
+   *          resultID on success
+   */
+  public int execPreparedQueryID(int resultSetID) throws Exception {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
+      checkPstmt(tmpPstmt);
+      ResultSet tmpResultSet = tmpPstmt.executeQuery();
+      ResultSetMetaData rSetMetadata = tmpResultSet.getMetaData();
+      int tmpNumberOfColumns = rSetMetadata.getColumnCount();
+      int[] tmpColumnTypes = new int[tmpNumberOfColumns];
+      int[] tmpColumnPrecisions = new int[tmpNumberOfColumns];
+      for (int i = 0; i < tmpNumberOfColumns; i++) {
+        tmpColumnTypes[i] = rSetMetadata.getColumnType(i + 1);
+        tmpColumnPrecisions[i] = rSetMetadata.getPrecision(i + 1);
+      }
+      resultSetInfo tmpResultSetInfo = new resultSetInfo(
+          tmpResultSet, tmpNumberOfColumns, 0, null);
+      tmpResultSetInfo.setColumnMetaData(tmpColumnTypes, tmpColumnPrecisions);
+      tmpResultSetInfo.setSharedStatement(true);
+      int tmpResultSetKey = initResultSetKey();
+      resultSetInfoMap.put(tmpResultSetKey, tmpResultSetInfo);
+      return tmpResultSetKey;
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * addAsyncBatchRow
+   *      Keep a copy of a row serialized like for bindRowPreparedStatement
+   *      for the next batch executed by the writer thread. The row is only
+   *      bound by that thread, which is the only user of the
+   *      PreparedStatement once asynchronous batches are used.
+   */
+  public void addAsyncBatchRow(ByteBuffer buffer, int resultSetID) throws SQLException {
+    try {
+      checkConnExist();
+      checkPstmt(resultSetInfoMap.get(resultSetID).getPstmt());
+      ByteBuffer row = ByteBuffer.allocate(buffer.capacity());
+      row.put(buffer.duplicate());
+      resultSetInfoMap.get(resultSetID).addAsyncBatchRow(row);
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * execAsyncBatch
+   *      Hand the rows added by addAsyncBatchRow over to the writer thread
+   *      of the connection as one batch. Waits while its queue is full and
+   *      throws the error of an earlier batch, if any. The number of
+   *      affected rows is only known once the batch is done, which
+   *      getNumberOfAffectedRows waits for.
+   */
+  public void execAsyncBatch(int resultSetID) throws SQLException {
+    try {
+      checkConnExist();
+      resultSetInfo tmpResultSetInfo = resultSetInfoMap.get(resultSetID);
+      PreparedStatement tmpPstmt = tmpResultSetInfo.getPstmt();
+      checkPstmt(tmpPstmt);
+      List<ByteBuffer> tmpRows = tmpResultSetInfo.takeAsyncBatchRows();
+
+      /* The count is set by the writer thread once the batch is done */
+      tmpResultSetInfo.setNumberOfAffectedRows(0);
+      conn.getAsyncBatchWriter().submit(() -> {
+        try {
+          for (ByteBuffer row : tmpRows) {
+            bindRow(tmpPstmt, row);
+            tmpPstmt.addBatch();
+          }
+          tmpResultSetInfo.setNumberOfAffectedRows(sumUpdateCounts(tmpPstmt.executeBatch()));
+        } finally {
+          tmpPstmt.clearBatch();
+        }
+        return null;
+      });
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * waitAllAsyncWrites
+   *      Wait for the batches executed by the writer threads of all
+   *      connections and throw the error of one of them, if any
+   */
+  public static void waitAllAsyncWrites() throws SQLException {
+    JDBCConnection.awaitAllAsyncWrites();
+  }
+
+  /*
+   * commitAllStreaming
+   *      Commit the remote transactions begun for streaming on all
+   *      connections and throw the error of one of them, if any
+   */
+  public static void commitAllStreaming() throws SQLException {
+    JDBCConnection.commitAllStreaming();
+  }
+
+  /*
+   * waitAsyncWrites
+   *      Wait for the batches executed by the writer thread of the
+   *      connection and throw the error of one of them, if any
+   */
+  public void waitAsyncWrites() throws SQLException {
+    try {
+      if (conn != null) {
+        conn.awaitAsyncWrites();
+      }
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
   /*
    * getNumberOfColumns
    *      Returns arrayOfNumberOfColumns[resultSetID]
@@ -179,6 +489,9 @@ public class JDBCUtils {
    */
   public int getNumberOfAffectedRows(int resultSetID) throws SQLException {
     try {
+      checkConnExist();
+      /* The count of an asynchronous batch is only known once it is done */
+      conn.awaitAsyncWrites();
       return resultSetInfoMap.get(resultSetID).getNumberOfAffectedRows();
     } catch (Throwable e) {
       throw e;
@@ -186,69 +499,37 @@ public class JDBCUtils {
   }
 
   /*
-   * getResultSet
-   *      Returns the result set that is returned from the foreign database
-   *      after execution of the query to C code. One row is returned at a time
-   *      as an Object array. For binary related types (BINARY, LONGVARBINARY, VARBINARY,
-   *      BLOB), Object corresponds to byte array. For other types, Object corresponds to
-   *      String. After last row null is returned.
+   * fillResultSetBatch
+   *      Writes up to fetchSize rows of the result set into the direct buffer
+   *      allocated by C code, in the column-major layout described in
+   *      JDBCColumnarBatch. kinds holds the transfer kind requested for each
+   *      column. When the result set is exhausted, its statement is closed,
+   *      or only the result set for generated keys.
+   *      Returns the number of rows written.
    */
-  public Object[] getResultSet(int resultSetID) throws SQLException {
-    int i = 0;
+  public int fillResultSetBatch(int resultSetID, ByteBuffer buffer, int[] kinds, int fetchSize) throws SQLException {
     try {
-      ResultSet tmpResultSet = resultSetInfoMap.get(resultSetID).getResultSet();
-      int tmpNumberOfColumns = resultSetInfoMap.get(resultSetID).getNumberOfColumns();
-      Object[] tmpArrayOfResultRow = new Object[tmpNumberOfColumns];
-      ResultSetMetaData mtData = tmpResultSet.getMetaData();
-
-      /* Row-by-row processing is done in jdbc_fdw.One row
-       * at a time is returned to the C code. */
-      if (tmpResultSet.next()) {
-        for (i = 0; i < tmpNumberOfColumns; i++) {
-          int columnType = mtData.getColumnType(i + 1);
-
-          switch (columnType) {
-            case Types.BINARY:
-            case Types.LONGVARBINARY:
-            case Types.VARBINARY:
-            case Types.BLOB:
-              /* Get byte array */
-              tmpArrayOfResultRow[i] = tmpResultSet.getBytes(i + 1);
-              break;
-            case Types.TIMESTAMP:
-              /*
-               * Get the timestamp in UTC time zone by default
-               * to avoid being affected by the remote server's time zone.
-               */
-              java.util.Calendar cal = Calendar.getInstance();
-              cal.setTimeZone(TimeZone.getTimeZone("UTC"));
-              Timestamp resTimestamp = tmpResultSet.getTimestamp(i + 1, cal);
-              if (resTimestamp != null) {
-                /* Timestamp is returned as text in ISO 8601 style */
-                tmpArrayOfResultRow[i] = resTimestamp.toInstant().toString();
-              } else {
-                tmpArrayOfResultRow[i] = null;
-              }
-              break;
-            default:
-              /* Convert all columns to String */
-              tmpArrayOfResultRow[i] = tmpResultSet.getString(i + 1);
-          }
-        }
-        /* The current row in resultSet is returned
-         * to the C code in a Java String array that
-         * has the value of the fields of the current
-         * row as it values. */
-        return tmpArrayOfResultRow;
-      } else {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      resultSetInfo tmpResultSetInfo = resultSetInfoMap.get(resultSetID);
+      ResultSet tmpResultSet = tmpResultSetInfo.getResultSet();
+      JDBCColumnarBatch tmpColumnarBatch = tmpResultSetInfo.getColumnarBatch();
+      int numberOfRows = tmpColumnarBatch.fill(tmpResultSet, kinds, buffer, fetchSize);
+
+      if (tmpColumnarBatch.isExhausted()) {
         /*
          * All of resultSet's rows have been returned to the C code.
-         * Close tmpResultSet's statement
+         * Close tmpResultSet's statement, unless it is a prepared
+         * statement of another resultID, which is executed again.
          */
-        tmpResultSet.getStatement().close();
+        if (tmpResultSetInfo.isSharedStatement()) {
+          tmpResultSet.close();
+        } else {
+          tmpResultSet.getStatement().close();
+        }
         clearResultSetID(resultSetID);
-        return null;
       }
+      return numberOfRows;
     } catch (Throwable e) {
       throw e;
     }
@@ -398,6 +679,7 @@ public class JDBCUtils {
   public String[] getTableNames() throws SQLException {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       DatabaseMetaData md = conn.getConnection().getMetaData();
       ResultSet tmpResultSet = md.getTables(null, null, "%", null);
 
@@ -422,6 +704,7 @@ public class JDBCUtils {
   public String[] getColumnNames(String tableName) throws SQLException {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       DatabaseMetaData md = conn.getConnection().getMetaData();
       ResultSet tmpResultSet = md.getColumns(null, null, tableName, null);
       List<String> tmpColumnNamesList = new ArrayList<String>();
@@ -445,6 +728,7 @@ public class JDBCUtils {
   public String[] getColumnTypes(String tableName) throws SQLException {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       DatabaseMetaData md = conn.getConnection().getMetaData();
       ResultSet tmpResultSet = md.getColumns(null, null, tableName, null);
       List<String> tmpColumnTypesList = new ArrayList<String>();
@@ -518,6 +802,7 @@ public class JDBCUtils {
   public String[] getPrimaryKey(String tableName) throws SQLException {
     try {
       checkConnExist();
+      conn.awaitAsyncWrites();
       DatabaseMetaData md = conn.getConnection().getMetaData();
       ResultSet tmpResultSet = md.getPrimaryKeys(null, null, tableName);
       List<String> tmpPrimaryKeyList = new ArrayList<String>();
@@ -592,34 +877,43 @@ public class JDBCUtils {
   }
 
   /*
-   * bindNullPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * Set timestamp to prepared statement
+   * Use the UTC time zone as default to avoid being affected by the JVM time zone
    */
-  public void bindNullPreparedStatement(int attnum, int resultSetID) throws SQLException {
-
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setNull(attnum, Types.NULL);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
+  private void setTimestamp(PreparedStatement preparedStatement, int attnum, Timestamp timestamp)
+    throws SQLException {
+      java.util.Calendar cal = Calendar.getInstance();
+      cal.setTimeZone(TimeZone.getTimeZone("UTC"));
+      try {
+        /* Specify time zone (cal) if possible */
+        preparedStatement.setTimestamp(attnum, timestamp, cal);
+      } catch (SQLFeatureNotSupportedException e) {
+        /* GridDB only, no calendar support in setTimestamp() */
+        preparedStatement.setTimestamp(attnum, timestamp);
+      } catch (Throwable e) {
+        throw e;
+      }
     }
-  }
 
   /*
-   * bindIntPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * bindRowPreparedStatement
+   *      Bind every parameter of the PreparedStatement from a row serialized
+   *      by jq_bind_row in a direct buffer allocated by C code:
+   *        int32  number of parameters
+   *        int32  kind of each parameter (JDBCColumnarBatch.KIND_*),
+   *               padded to 8 bytes
+   *        null bitmap, bit set means NULL, padded to 8 bytes
+   *        one 8-byte slot per parameter, holding the value or, for
+   *        KIND_TEXT, KIND_BINARY and KIND_NUMERIC, an int32 offset and
+   *        an int32 length into the data area that follows
    */
-  public void bindIntPreparedStatement(int values, int attnum, int resultSetID)
+  public void bindRowPreparedStatement(ByteBuffer buffer, int resultSetID)
       throws SQLException {
-
     try {
       checkConnExist();
       PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
       checkPstmt(tmpPstmt);
-      tmpPstmt.setInt(attnum, values);
+      bindRow(tmpPstmt, buffer);
       resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
     } catch (Throwable e) {
       throw e;
@@ -627,209 +921,239 @@ public class JDBCUtils {
   }
 
   /*
-   * bindLongPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * bindRow
+   *      Bind the parameters of tmpPstmt from a serialized row
    */
-  public void bindLongPreparedStatement(long values, int attnum, int resultSetID)
+  private void bindRow(PreparedStatement tmpPstmt, ByteBuffer buffer)
       throws SQLException {
-
     try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setLong(attnum, values);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
-    }
-  }
+      buffer.order(ByteOrder.nativeOrder());
+      int numberOfParams = buffer.getInt(0);
+      int nullsOffset = align8(4 * (numberOfParams + 1));
+      int slotsOffset = nullsOffset + align8((numberOfParams + 7) / 8);
+      int dataOffset = slotsOffset + 8 * numberOfParams;
 
-  /*
-   * bindFloatPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
-   */
-  public void bindFloatPreparedStatement(float values, int attnum, int resultSetID)
-      throws SQLException {
+      for (int i = 0; i < numberOfParams; i++) {
+        int attnum = i + 1;
+        int slot = slotsOffset + 8 * i;
 
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setFloat(attnum, values);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+        if ((buffer.get(nullsOffset + i / 8) & (1 << (i % 8))) != 0) {
+          tmpPstmt.setNull(attnum, Types.NULL);
+          continue;
+        }
+        switch (buffer.getInt(4 * (i + 1))) {
+          case JDBCColumnarBatch.KIND_INT32:
+            tmpPstmt.setInt(attnum, buffer.getInt(slot));
+            break;
+          case JDBCColumnarBatch.KIND_INT64:
+            tmpPstmt.setLong(attnum, buffer.getLong(slot));
+            break;
+          case JDBCColumnarBatch.KIND_FLOAT4:
+            tmpPstmt.setFloat(attnum, buffer.getFloat(slot));
+            break;
+          case JDBCColumnarBatch.KIND_FLOAT8:
+            tmpPstmt.setDouble(attnum, buffer.getDouble(slot));
+            break;
+          case JDBCColumnarBatch.KIND_BOOL:
+            tmpPstmt.setBoolean(attnum, buffer.get(slot) != 0);
+            break;
+          case JDBCColumnarBatch.KIND_TIME:
+            /* microseconds since midnight */
+            tmpPstmt.setObject(attnum, LocalTime.ofNanoOfDay(buffer.getLong(slot) * 1000));
+            break;
+          case JDBCColumnarBatch.KIND_TIMESTAMP:
+            {
+              /* microseconds since the Unix epoch in UTC */
+              Instant instant = Instant.EPOCH.plus(buffer.getLong(slot), ChronoUnit.MICROS);
+              setTimestamp(tmpPstmt, attnum, Timestamp.from(instant));
+              break;
+            }
+          case JDBCColumnarBatch.KIND_DATE:
+            /* days since the Unix epoch */
+            tmpPstmt.setDate(attnum, java.sql.Date.valueOf(LocalDate.ofEpochDay(buffer.getLong(slot))));
+            break;
+          case JDBCColumnarBatch.KIND_NUMERIC:
+            {
+              /* the text of a PostgreSQL numeric, which keeps every digit */
+              java.math.BigDecimal tmpValue = new java.math.BigDecimal(
+                  new String(getBytes(buffer, dataOffset, slot), StandardCharsets.US_ASCII));
+              try {
+                tmpPstmt.setBigDecimal(attnum, tmpValue);
+              } catch (SQLFeatureNotSupportedException e) {
+                /* Drivers without decimal support get the value as a double */
+                tmpPstmt.setDouble(attnum, tmpValue.doubleValue());
+              }
+              break;
+            }
+          case JDBCColumnarBatch.KIND_BINARY:
+            {
+              byte[] dat = getBytes(buffer, dataOffset, slot);
+              tmpPstmt.setBinaryStream(attnum, new ByteArrayInputStream(dat), (long) dat.length);
+              break;
+            }
+          case JDBCColumnarBatch.KIND_TEXT:
+            tmpPstmt.setString(attnum, new String(getBytes(buffer, dataOffset, slot), StandardCharsets.UTF_8));
+            break;
+          default:
+            throw new IllegalArgumentException("unexpected parameter kind for parameter " + attnum);
+        }
+      }
     } catch (Throwable e) {
       throw e;
     }
   }
 
   /*
-   * bindDoublePreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * createBulkLoader
+   *      Set up a bulk load of the given columns of table through the
+   *      native bulk path of the remote database, see BulkLoader.
+   *      Returns:
+   *          resultID on success, 0 if the driver has no bulk path
    */
-  public void bindDoublePreparedStatement(double values, int attnum, int resultSetID)
-      throws SQLException {
-
+  public int createBulkLoader(String table, String columns) throws Exception {
     try {
       checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setDouble(attnum, values);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+      conn.awaitAsyncWrites();
+      BulkLoader tmpBulkLoader = BulkLoader.create(conn.getConnection(), conn.getQueryTimeout(), table, columns);
+      if (tmpBulkLoader == null) {
+        return 0;
+      }
+      resultSetInfo tmpResultSetInfo = new resultSetInfo(null, null, 0, null);
+      tmpResultSetInfo.setBulkLoader(tmpBulkLoader);
+      int tmpResultSetKey = initResultSetKey();
+      resultSetInfoMap.put(tmpResultSetKey, tmpResultSetInfo);
+      return tmpResultSetKey;
     } catch (Throwable e) {
       throw e;
     }
   }
 
   /*
-   * bindBooleanPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * addBulkLoadRow
+   *      Append a row serialized like for bindRowPreparedStatement to the
+   *      data of the bulk load
    */
-  public void bindBooleanPreparedStatement(boolean values, int attnum, int resultSetID)
-      throws SQLException {
-
+  public void addBulkLoadRow(ByteBuffer buffer, int resultSetID) throws SQLException {
     try {
       checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setBoolean(attnum, values);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+      conn.awaitAsyncWrites();
+      BulkLoader tmpBulkLoader = resultSetInfoMap.get(resultSetID).getBulkLoader();
+      checkBulkLoader(tmpBulkLoader);
+      tmpBulkLoader.addRow(buffer);
     } catch (Throwable e) {
       throw e;
     }
   }
 
   /*
-   * bindStringPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * execBulkLoad
+   *      Send the rows added to the bulk load to the server and store the
+   *      number of rows loaded
    */
-  public void bindStringPreparedStatement(String values, int attnum, int resultSetID)
-      throws SQLException {
-
+  public void execBulkLoad(int resultSetID) throws SQLException {
     try {
       checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setString(attnum, values);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+      conn.awaitAsyncWrites();
+      BulkLoader tmpBulkLoader = resultSetInfoMap.get(resultSetID).getBulkLoader();
+      checkBulkLoader(tmpBulkLoader);
+      int tmpNumberOfAffectedRows = tmpBulkLoader.load();
+      resultSetInfoMap.get(resultSetID).setNumberOfAffectedRows(tmpNumberOfAffectedRows);
     } catch (Throwable e) {
       throw e;
     }
   }
 
   /*
-   * bindByteaPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * checkBulkLoader
+   *      Check the bulk loader exists or not.
    */
-  public void bindByteaPreparedStatement(byte[] dat, long length, int attnum, int resultSetID)
-      throws SQLException {
-
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      InputStream targetStream = new ByteArrayInputStream(dat);
-      tmpPstmt.setBinaryStream(attnum, targetStream, length);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
+  public void checkBulkLoader(BulkLoader bulkLoader) throws IllegalArgumentException {
+    if (bulkLoader == null) {
+      throw new IllegalArgumentException(
+          "Must create a bulk loader before loading rows with it");
     }
   }
 
   /*
-   * bindTimePreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * execTruncate
+   *      Execute the TRUNCATE statement truncateQuery. If the driver or the
+   *      database rejects it as unsupported, empty the tables with
+   *      deleteQueries instead, unless there are none.
    */
-  public void bindTimePreparedStatement(String values, int attnum, int resultSetID)
-      throws SQLException {
-
+  public void execTruncate(String truncateQuery, String[] deleteQueries) throws SQLException {
     try {
       checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      String pattern = "[HH:mm:ss][.SSSSSS][.SSSSS][.SSSS][.SSS][.SS][.S][z][XXX][X]";
-      LocalTime localTime = LocalTime.parse(values, DateTimeFormatter.ofPattern(pattern));
-      tmpPstmt.setObject(attnum, localTime);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
+      conn.awaitAsyncWrites();
+      Connection tmpConn = conn.getConnection();
+      /* A failed statement aborts the open transaction of some databases */
+      Savepoint tmpSavepoint = tmpConn.getAutoCommit() ? null : tmpConn.setSavepoint();
+      try (Statement tmpStmt = tmpConn.createStatement()) {
+        if (conn.getQueryTimeout() != 0) {
+          tmpStmt.setQueryTimeout(conn.getQueryTimeout());
+        }
+        try {
+          tmpStmt.executeUpdate(truncateQuery);
+        } catch (SQLException e) {
+          if (deleteQueries.length == 0
+              || !isUnsupportedStatement(e, tmpConn.getMetaData().getDatabaseProductName())) {
+            throw e;
+          }
+          if (tmpSavepoint != null) {
+            tmpConn.rollback(tmpSavepoint);
+          }
+          for (String deleteQuery : deleteQueries) {
+            tmpStmt.executeUpdate(deleteQuery);
+          }
+        }
+        if (tmpSavepoint != null) {
+          tmpConn.releaseSavepoint(tmpSavepoint);
+        }
+      }
     } catch (Throwable e) {
       throw e;
     }
   }
 
   /*
-   * bindTimeTZPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
-   *      set with localtime: might lost time-zone
+   * isUnsupportedStatement
+   *      Tell whether the error means that the statement itself is not
+   *      supported: a syntax error or a feature that is not supported.
+   *      Other errors of class 42, such as a missing privilege or table,
+   *      would fail the same way with DELETE and are reported as is.
+   *      MySQL reports most errors of class 42 as 42000, including a
+   *      missing privilege (1142) and a table referenced by a foreign key
+   *      (1701), so only its parse error (1064), which a TRUNCATE of
+   *      several tables raises, is taken as unsupported.
    */
-  public void bindTimeTZPreparedStatement(String values, int attnum, int resultSetID)
-      throws SQLException {
-
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
+  private static boolean isUnsupportedStatement(SQLException e, String productName) {
+    String sqlState = e.getSQLState();
 
-      String pattern = "[HH:mm:ss][.SSSSSS][.SSSSS][.SSSS][.SSS][.SS][.S][z][XXX][X]";
-      LocalTime localTime = LocalTime.parse(values, DateTimeFormatter.ofPattern(pattern));
-      tmpPstmt.setObject(attnum, localTime);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
+    if (e instanceof SQLFeatureNotSupportedException) {
+      return true;
     }
-  }
-
-  /*
-   * Set timestamp to prepared statement
-   * Use the UTC time zone as default to avoid being affected by the JVM time zone
-   */
-  private void setTimestamp(PreparedStatement preparedStatement, int attnum, Timestamp timestamp)
-    throws SQLException {
-      java.util.Calendar cal = Calendar.getInstance();
-      cal.setTimeZone(TimeZone.getTimeZone("UTC"));
-      try {
-        /* Specify time zone (cal) if possible */
-        preparedStatement.setTimestamp(attnum, timestamp, cal);
-      } catch (SQLFeatureNotSupportedException e) {
-        /* GridDB only, no calendar support in setTimestamp() */
-        preparedStatement.setTimestamp(attnum, timestamp);
-      } catch (Throwable e) {
-        throw e;
-      }
+    if ("MySQL".equals(productName) || "MariaDB".equals(productName)) {
+      return e.getErrorCode() == 1064;
     }
+    return "42601".equals(sqlState) || "0A000".equals(sqlState);
+  }
 
   /*
-   * bindTimestampPreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
+   * getBytes
+   *      Copy the variable-width value whose offset and length are stored
+   *      in slot out of the data area of a bound row
    */
-  public void bindTimestampPreparedStatement(long usec, int attnum, int resultSetID)
-    throws SQLException {
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      Instant instant = Instant.EPOCH.plus(usec, ChronoUnit.MICROS);
-      Timestamp timestamp = Timestamp.from(instant);
-      setTimestamp(tmpPstmt, attnum, timestamp);
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
-    }
+  static byte[] getBytes(ByteBuffer buffer, int dataOffset, int slot) {
+    int offset = buffer.getInt(slot);
+    int length = buffer.getInt(slot + 4);
+    byte[] dat = new byte[length];
+    ByteBuffer tmpBuffer = buffer.duplicate();
+    tmpBuffer.position(dataOffset + offset);
+    tmpBuffer.get(dat);
+    return dat;
   }
 
-  /*
-   * bindDatePreparedStatement
-   *      Bind the value to the PreparedStatement object based on the query
-   */
-  public void bindDatePreparedStatement(String values, int attnum, int resultSetID)
-    throws SQLException {
-    try {
-      checkConnExist();
-      PreparedStatement tmpPstmt = resultSetInfoMap.get(resultSetID).getPstmt();
-      checkPstmt(tmpPstmt);
-      tmpPstmt.setDate(attnum, java.sql.Date.valueOf(values));
-      resultSetInfoMap.get(resultSetID).setPstmt(tmpPstmt);
-    } catch (Throwable e) {
-      throw e;
-    }
+  static int align8(int size) {
+    return (size + 7) & ~7;
   }
 
   /*
@@ -861,6 +1185,7 @@ public class JDBCUtils {
   public String getIdentifierQuoteString() throws SQLException{
     try{
       checkConnExist();
+      conn.awaitAsyncWrites();
       DatabaseMetaData md = conn.getConnection().getMetaData();
       return md.getIdentifierQuoteString();
     } catch (Throwable e) {
@@ -868,6 +1193,49 @@ public class JDBCUtils {
     }
   }
 
+  /*
+   * getDatabaseProductName
+   *      Return the name of the remote database product
+   */
+  public String getDatabaseProductName() throws SQLException {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      return conn.getConnection().getMetaData().getDatabaseProductName();
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
+  /*
+   * getMaxParameters
+   *      Return the number of parameters a statement can have on the remote
+   *      database. Oracle also limits an IN list to 1000 expressions, and
+   *      the limit of unknown databases is assumed to be the same.
+   */
+  public int getMaxParameters() throws SQLException {
+    try {
+      checkConnExist();
+      conn.awaitAsyncWrites();
+      String productName = conn.getConnection().getMetaData().getDatabaseProductName();
+      if ("PostgreSQL".equals(productName)) {
+        return 32767;
+      }
+      if ("MySQL".equals(productName) || "MariaDB".equals(productName)) {
+        return 65535;
+      }
+      if ("Microsoft SQL Server".equals(productName)) {
+        return 2100;
+      }
+      if ("SQLite".equals(productName)) {
+        return 999;
+      }
+      return 1000;
+    } catch (Throwable e) {
+      throw e;
+    }
+  }
+
   /* finalize all actived connection */
   public static void finalizeAllConns(long hashvalue) throws Exception {
     JDBCConnection.finalizeAllConns(hashvalue);
@@ -883,8 +1251,22 @@ public class JDBCUtils {
     JDBCConnection.finalizeAllUserMapingConns(hashvalue);
   }
 
-  /* finalize cached result set */
+  /*
+   * finalize cached result set
+   *      The remote transactions begun for streaming are still open only
+   *      if the local transaction did not commit, so roll them back
+   */
   public static void finalizeAllResultSet() {
+    /* Batches not waited for before commit belong to an aborted transaction */
+    JDBCConnection.discardAllAsyncWrites();
+    for (resultSetInfo tmpResultSetInfo : resultSetInfoMap.values()) {
+      try {
+        tmpResultSetInfo.endStreaming();
+      } catch (SQLException e) {
+        /* The connection may already be closed at transaction end */
+      }
+    }
     resultSetInfoMap.clear();
+    JDBCConnection.rollbackAllStreaming();
   }
 }
@@ -0,0 +1,156 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/MySQLBulkLoader.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.io.*;
+import java.lang.reflect.Method;
+import java.sql.*;
+
+/*
+ * MySQLBulkLoader
+ *      Loads rows with LOAD DATA LOCAL INFILE, reading the file from an
+ *      in-memory stream given to the statement of MySQL Connector/J.
+ *      The connection must allow it with allowLoadLocalInfile=true.
+ */
+public class MySQLBulkLoader extends BulkLoader {
+  /* Statement interfaces with setLocalInfileInputStream, newest first */
+  private static final String[] STATEMENT_CLASSES = {
+    "com.mysql.cj.jdbc.JdbcStatement",
+    "com.mysql.jdbc.Statement"
+  };
+
+  private final Class<?> statementClass;
+  private final Method setLocalInfileInputStream;
+  private final int queryTimeout;
+  private final String query;
+  private String loadWarnings; // SHOW WARNINGS of a load that skipped rows
+
+  private MySQLBulkLoader(Connection conn, int queryTimeout, String table, String columns,
+                          Class<?> statementClass, Method setLocalInfileInputStream) {
+    super(conn, table, columns);
+    this.queryTimeout = queryTimeout;
+    this.statementClass = statementClass;
+    this.setLocalInfileInputStream = setLocalInfileInputStream;
+    /* The file name is not used, the data comes from the input stream */
+    this.query = "LOAD DATA LOCAL INFILE 'jdbc_fdw' INTO TABLE " + table
+        + " CHARACTER SET binary"
+        + " FIELDS TERMINATED BY '\\t' ESCAPED BY '\\\\' LINES TERMINATED BY '\\n'"
+        + " (" + columns + ")";
+  }
+
+  /*
+   * create
+   *      Returns null if the driver is not MySQL Connector/J
+   */
+  public static MySQLBulkLoader create(Connection conn, int queryTimeout, String table, String columns) {
+    ClassLoader loader = conn.getClass().getClassLoader();
+
+    for (String className : STATEMENT_CLASSES) {
+      try {
+        Class<?> statementClass = Class.forName(className, true, loader);
+        Method setLocalInfileInputStream =
+            statementClass.getMethod("setLocalInfileInputStream", InputStream.class);
+        return new MySQLBulkLoader(conn, queryTimeout, table, columns, statementClass, setLocalInfileInputStream);
+      } catch (ClassNotFoundException | NoSuchMethodException e) {
+        continue;
+      }
+    }
+    return null;
+  }
+
+  /*
+   * The timestamps of the file are written in UTC, so the session time zone
+   * is set to UTC while the file is loaded, and restored afterwards.
+   * LOAD DATA LOCAL skips the rows with a duplicate key or a bad value as
+   * if IGNORE were given, leaving a warning for each of them. The warnings
+   * are read before the next statement clears them.
+   */
+  protected long load(InputStream in) throws SQLException {
+    loadWarnings = null;
+    try (Statement stmt = conn.createStatement()) {
+      String timeZone;
+
+      try (ResultSet rs = stmt.executeQuery("SELECT @@session.time_zone")) {
+        rs.next();
+        timeZone = rs.getString(1);
+      }
+      stmt.execute("SET time_zone = '+00:00'");
+      try {
+        if (queryTimeout != 0) {
+          stmt.setQueryTimeout(queryTimeout);
+        }
+        invoke(setLocalInfileInputStream, stmt.unwrap(statementClass), in);
+        long numberOfLoadedRows = stmt.executeUpdate(query);
+        if (numberOfLoadedRows != getNumberOfRows()) {
+          loadWarnings = showWarnings(stmt);
+        }
+        return numberOfLoadedRows;
+      } finally {
+        try (PreparedStatement pstmt = conn.prepareStatement("SET time_zone = ?")) {
+          pstmt.setString(1, timeZone);
+          pstmt.execute();
+        }
+      }
+    }
+  }
+
+  protected String getLoadWarnings() {
+    return loadWarnings;
+  }
+
+  /* The messages of SHOW WARNINGS, separated by semicolons */
+  private static String showWarnings(Statement stmt) throws SQLException {
+    StringBuilder warnings = new StringBuilder();
+
+    try (ResultSet rs = stmt.executeQuery("SHOW WARNINGS")) {
+      while (rs.next()) {
+        if (warnings.length() > 0) {
+          warnings.append("; ");
+        }
+        warnings.append(rs.getString("Message"));
+      }
+    }
+    return warnings.length() == 0 ? null : warnings.toString();
+  }
+
+  protected String formatBoolean(boolean value) {
+    return value ? "1" : "0";
+  }
+
+  /* Read in the UTC time zone of the load session, see load() */
+  protected String formatTimestamp(String value) {
+    return value;
+  }
+
+  /* Raw bytes; the file is read as CHARACTER SET binary */
+  protected void writeBinary(ByteArrayOutputStream out, byte[] value) {
+    for (byte b : value) {
+      switch (b) {
+        case 0:
+          out.write('\\');
+          out.write('0');
+          break;
+        case '\\':
+        case '\t':
+        case '\n':
+        case '\r':
+          out.write('\\');
+          out.write(b == '\t' ? 't' : b == '\n' ? 'n' : b == '\r' ? 'r' : '\\');
+          break;
+        default:
+          out.write(b);
+          break;
+      }
+    }
+  }
+}
@@ -0,0 +1,89 @@
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/PgCopyBulkLoader.java
+ *
+ *-------------------------------------------------------------------------
+ */
+
+import java.io.*;
+import java.lang.reflect.Method;
+import java.sql.*;
+
+/*
+ * PgCopyBulkLoader
+ *      Loads rows with COPY ... FROM STDIN through the CopyManager of PgJDBC.
+ */
+public class PgCopyBulkLoader extends BulkLoader {
+  private final Object copyManager;
+  private final Method copyIn;
+  private final String query;
+
+  private PgCopyBulkLoader(Connection conn, String table, String columns, Object copyManager, Method copyIn) {
+    super(conn, table, columns);
+    this.copyManager = copyManager;
+    this.copyIn = copyIn;
+    this.query = "COPY " + table + " (" + columns + ") FROM STDIN";
+  }
+
+  /*
+   * create
+   *      Returns null if the connection is not a PgJDBC connection
+   */
+  public static PgCopyBulkLoader create(Connection conn, String table, String columns) throws SQLException {
+    ClassLoader loader = conn.getClass().getClassLoader();
+    Class<?> pgConnectionClass;
+    Class<?> copyManagerClass;
+
+    try {
+      pgConnectionClass = Class.forName("org.postgresql.PGConnection", true, loader);
+      copyManagerClass = Class.forName("org.postgresql.copy.CopyManager", true, loader);
+    } catch (ClassNotFoundException e) {
+      return null;
+    }
+    if (!conn.isWrapperFor(pgConnectionClass)) {
+      return null;
+    }
+
+    try {
+      Object pgConnection = conn.unwrap(pgConnectionClass);
+      Object copyManager = invoke(pgConnectionClass.getMethod("getCopyAPI"), pgConnection);
+      Method copyIn = copyManagerClass.getMethod("copyIn", String.class, InputStream.class);
+      return new PgCopyBulkLoader(conn, table, columns, copyManager, copyIn);
+    } catch (NoSuchMethodException e) {
+      return null;
+    }
+  }
+
+  protected long load(InputStream in) throws SQLException {
+    return ((Long) invoke(copyIn, copyManager, query, in)).longValue();
+  }
+
+  protected String formatBoolean(boolean value) {
+    return value ? "t" : "f";
+  }
+
+  /* The offset is ignored for a timestamp without time zone column */
+  protected String formatTimestamp(String value) {
+    return value + "+00";
+  }
+
+  /* bytea in hex format, with the backslash escaped for COPY */
+  protected void writeBinary(ByteArrayOutputStream out, byte[] value) {
+    final char[] hex = "0123456789abcdef".toCharArray();
+
+    out.write('\\');
+    out.write('\\');
+    out.write('x');
+    for (byte b : value) {
+      out.write(hex[(b >> 4) & 0xF]);
+      out.write(hex[b & 0xF]);
+    }
+  }
+}
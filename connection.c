@@ -438,7 +438,23 @@ jdbcfdw_xact_callback(XactEvent event, void *arg)
 	if (!xact_got_connection)
 		return;
 
-	if (event == XACT_EVENT_COMMIT || event == XACT_EVENT_ABORT)
+	if (event == XACT_EVENT_PRE_COMMIT)
+	{
+		/*
+		 * Wait for the batches that the writer threads of the connections
+		 * still execute (async_write option).  An error of one of them
+		 * aborts the local transaction.
+		 */
+		jq_wait_all_async_writes();
+
+		/*
+		 * Commit the remote transactions begun for streaming (stream_results
+		 * option) while the local transaction can still abort, so that the
+		 * writes done in them are not lost if the remote commit fails.
+		 */
+		jq_commit_all_streaming();
+	}
+	else if (event == XACT_EVENT_COMMIT || event == XACT_EVENT_ABORT)
 	{
 		/*
 		 * Scan all connection cache entries and release its resource
@@ -34,6 +34,8 @@
  */
 #include "postgres.h"
 
+#include <float.h>
+
 #include "jdbc_fdw.h"
 
 #include "access/heapam.h"
@@ -62,6 +64,12 @@
 #include "utils/typcache.h"
 #include "optimizer/tlist.h"
 
+/*
+ * Prefix of the alias of each base relation in the FROM clause of a pushed
+ * down join, followed by its range table index, e.g. r1.
+ */
+#define REL_ALIAS_PREFIX	"r"
+
 
 /*
  * Global context for jdbc_foreign_expr_walker's search of an expression
@@ -130,8 +138,19 @@ static void jdbc_deparse_target_list(StringInfo buf,
 									 char *q_char);
 static void jdbc_deparse_column_ref(StringInfo buf, int varno, int varattno,
 									PlannerInfo *root, bool qualify_col, char *q_char);
+static void jdbc_deparse_column_name(StringInfo buf, Oid relid, int varattno,
+									 char *q_char);
 static void jdbc_deparse_aggref(Aggref *node, deparse_expr_cxt *context);
 static void jdbc_deparse_relation(StringInfo buf, Relation rel, char *q_char);
+static void jdbc_deparse_from_expr_for_rel(StringInfo buf, PlannerInfo *root,
+										   RelOptInfo *foreignrel, bool use_alias,
+										   List **params_list, char *q_char);
+static const char *jdbc_get_jointype_name(JoinType jointype);
+static void jdbc_append_conditions(List *exprs, deparse_expr_cxt *context);
+static void jdbc_deparse_merge_sql(StringInfo buf, Relation rel, List *targetAttrs,
+								   List *keyAttrs, List *updateAttrs, char *q_char);
+static void jdbc_append_key_conditions(StringInfo buf, Relation rel, List *attnums,
+									   int num_keysets, char *q_char);
 static void jdbc_deparse_string_literal(StringInfo buf, const char *val);
 static void jdbc_deparse_expr(Expr *expr, deparse_expr_cxt *context);
 static void jdbc_deparse_var(Var *node, deparse_expr_cxt *context);
@@ -281,6 +300,7 @@ jdbc_is_foreign_expr(PlannerInfo *root,
 {
 	foreign_glob_cxt glob_cxt;
 	foreign_loc_cxt loc_cxt;
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) (baserel->fdw_private);
 
 	/*
 	 * Check that the expression consists of nodes that are safe to execute
@@ -288,14 +308,29 @@ jdbc_is_foreign_expr(PlannerInfo *root,
 	 */
 	glob_cxt.root = root;
 	glob_cxt.foreignrel = baserel;
+
+	/*
+	 * For an upper relation, use relids from its underneath scan relation,
+	 * because the upperrel's own relids currently aren't set to anything
+	 * meaningful by the core code.  For other relations, use their own
+	 * relids.
+	 */
+	if (IS_UPPER_REL(baserel))
+		glob_cxt.relids = fpinfo->outerrel->relids;
+	else
+		glob_cxt.relids = baserel->relids;
 	loc_cxt.collation = InvalidOid;
 	loc_cxt.state = FDW_COLLATE_NONE;
 	if (!jdbc_foreign_expr_walker((Node *) expr, &glob_cxt, &loc_cxt))
 		return false;
 
-	/* Expressions examined here should be boolean, ie noncollatable */
-	Assert(loc_cxt.collation == InvalidOid);
-	Assert(loc_cxt.state == FDW_COLLATE_NONE);
+	/*
+	 * If the expression has a valid collation that does not arise from a
+	 * foreign var, the expression can not be sent over.  Quals are boolean
+	 * and noncollatable, but the new values of a direct UPDATE may not be.
+	 */
+	if (loc_cxt.state == FDW_COLLATE_UNSAFE)
+		return false;
 
 	/*
 	 * An expression which includes any mutable functions can't be sent over
@@ -403,7 +438,7 @@ jdbc_foreign_expr_walker(Node *node,
 				 * Param's collation, ie it's not safe for it to have a
 				 * non-default collation.
 				 */
-				if (var->varno == glob_cxt->foreignrel->relid &&
+				if (bms_is_member(var->varno, glob_cxt->relids) &&
 					var->varlevelsup == 0)
 				{
 					/* Var belongs to foreign table */
@@ -1004,7 +1039,9 @@ jdbc_is_builtin(Oid oid)
 /*
  * Construct a simple SELECT statement that retrieves desired columns of the
  * specified foreign table, and append it to "buf".  The output contains just
- * "SELECT ... FROM tablename".
+ * "SELECT ... FROM tablename".  For a join relation, or an upper relation on
+ * top of one, the FROM clause is the join of the base relations, each with
+ * an alias, and the columns come from the explicit target list tlist.
  *
  * We also create an integer List of the columns being retrieved, which is
  * returned to *retrieved_attrs.
@@ -1021,8 +1058,6 @@ jdbc_deparse_select_sql(StringInfo buf,
 						bool has_limit,
 						char *q_char)
 {
-	RangeTblEntry *rte;
-	Relation	rel;
 	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
 	deparse_expr_cxt context;
 
@@ -1034,43 +1069,48 @@ jdbc_deparse_select_sql(StringInfo buf,
 	context.scanrel = IS_UPPER_REL(baserel) ? fpinfo->outerrel : baserel;
 	context.q_char = q_char;
 
-	rte = planner_rt_fetch(context.scanrel->relid, root);
-
-	/*
-	 * Core code already has some lock on each rel being planned, so we can
-	 * use NoLock here.
-	 */
-#if PG_VERSION_NUM < 130000
-	rel = heap_open(rte->relid, NoLock);
-#else
-	rel = table_open(rte->relid, NoLock);
-#endif
-
 	/*
 	 * Construct SELECT list
 	 */
 	appendStringInfoString(buf, "SELECT ");
-	if (IS_UPPER_REL(baserel) || fpinfo->is_tlist_func_pushdown == true)
+	if (IS_JOIN_REL(baserel) || IS_UPPER_REL(baserel) ||
+		fpinfo->is_tlist_func_pushdown == true)
 	{
 		deparseExplicitTargetList(tlist, false, retrieved_attrs, &context);
 	}
 	else
 	{
+		RangeTblEntry *rte = planner_rt_fetch(baserel->relid, root);
+		Relation	rel;
+
+		/*
+		 * Core code already has some lock on each rel being planned, so we
+		 * can use NoLock here.
+		 */
+#if PG_VERSION_NUM < 130000
+		rel = heap_open(rte->relid, NoLock);
+#else
+		rel = table_open(rte->relid, NoLock);
+#endif
+
 		jdbc_deparse_target_list(buf, root, baserel->relid, rel, fpinfo->attrs_used,
 								 false, retrieved_attrs, q_char);
+
+#if PG_VERSION_NUM < 130000
+		heap_close(rel, NoLock);
+#else
+		table_close(rel, NoLock);
+#endif
 	}
 
 	/*
-	 * Construct FROM clause
+	 * Construct FROM clause.  The base relations of a join are given an
+	 * alias, so that the columns can be qualified.
 	 */
 	appendStringInfoString(buf, " FROM ");
-	jdbc_deparse_relation(buf, rel, q_char);
-
-#if PG_VERSION_NUM < 130000
-	heap_close(rel, NoLock);
-#else
-	table_close(rel, NoLock);
-#endif
+	jdbc_deparse_from_expr_for_rel(buf, root, context.scanrel,
+								   (bms_membership(context.scanrel->relids) == BMS_MULTIPLE),
+								   params_list, q_char);
 }
 
 /*
@@ -1143,8 +1183,8 @@ jdbc_deparse_target_list(StringInfo buf,
  * Vars used in the clauses; these values must be transmitted to the remote
  * server as parameter values.
  *
- * If params is NULL, we're generating the query for EXPLAIN purposes, so
- * Params and other-relation Vars should be replaced by dummy values.
+ * If params is NULL, we're generating the query for EXPLAIN purposes, which
+ * only contains the restriction clauses of the relation.
  */
 void
 jdbc_append_where_clause(StringInfo buf,
@@ -1202,18 +1242,54 @@ jdbc_append_where_clause(StringInfo buf,
  * The statement text is appended to buf, and we also create an integer List
  * of the columns being retrieved by RETURNING (if any), which is returned to
  * *retrieved_attrs.
+ *
+ * With onConflictAction other than ONCONFLICT_NONE, the statement is an
+ * upsert in the dialect of the remote server: rows conflicting on the key
+ * columns keyAttrs are skipped for ONCONFLICT_NOTHING, and get the values of
+ * the other target columns for ONCONFLICT_UPDATE.  A standard MERGE is used
+ * for remote servers that are neither PostgreSQL nor MySQL.
+ *
+ * root is not used, so that the statement can also be built at execution
+ * time for COPY and tuple routing, where no PlannerInfo is available.
  */
 void
 jdbc_deparse_insert_sql(StringInfo buf, PlannerInfo *root,
 						Index rtindex, Relation rel,
 						List *targetAttrs, List *returningList,
-						List **retrieved_attrs, char *q_char)
+						List **retrieved_attrs,
+						OnConflictAction onConflictAction,
+						List *keyAttrs, JdbcDialect dialect,
+						char *q_char)
 {
-	AttrNumber	pindex;
+	Oid			relid = RelationGetRelid(rel);
+	List	   *updateAttrs = NIL;
 	bool		first;
 	ListCell   *lc;
 
-	appendStringInfoString(buf, "INSERT INTO ");
+	/* The target columns that an upsert updates, that is not the key */
+	if (onConflictAction == ONCONFLICT_UPDATE)
+	{
+		foreach(lc, targetAttrs)
+		{
+			if (!list_member_int(keyAttrs, lfirst_int(lc)))
+				updateAttrs = lappend_int(updateAttrs, lfirst_int(lc));
+		}
+
+		/* With nothing to update, a conflicting row is just skipped */
+		if (updateAttrs == NIL)
+			onConflictAction = ONCONFLICT_NOTHING;
+	}
+
+	if (onConflictAction != ONCONFLICT_NONE && dialect == JDBC_DIALECT_STANDARD)
+	{
+		jdbc_deparse_merge_sql(buf, rel, targetAttrs, keyAttrs, updateAttrs, q_char);
+		return;
+	}
+
+	if (onConflictAction == ONCONFLICT_NOTHING && dialect == JDBC_DIALECT_MYSQL)
+		appendStringInfoString(buf, "INSERT IGNORE INTO ");
+	else
+		appendStringInfoString(buf, "INSERT INTO ");
 	jdbc_deparse_relation(buf, rel, q_char);
 
 	if (targetAttrs)
@@ -1229,12 +1305,11 @@ jdbc_deparse_insert_sql(StringInfo buf, PlannerInfo *root,
 				appendStringInfoString(buf, ", ");
 			first = false;
 
-			jdbc_deparse_column_ref(buf, rtindex, attnum, root, false, q_char);
+			jdbc_deparse_column_name(buf, relid, attnum, q_char);
 		}
 
 		appendStringInfoString(buf, ") VALUES (");
 
-		pindex = 1;
 		first = true;
 		foreach(lc, targetAttrs)
 		{
@@ -1243,31 +1318,163 @@ jdbc_deparse_insert_sql(StringInfo buf, PlannerInfo *root,
 			first = false;
 
 			appendStringInfo(buf, "?");
-			pindex++;
 		}
 
 		appendStringInfoChar(buf, ')');
 	}
 	else
 		appendStringInfoString(buf, " DEFAULT VALUES");
+
+	if (onConflictAction == ONCONFLICT_NOTHING && dialect == JDBC_DIALECT_POSTGRESQL)
+		appendStringInfoString(buf, " ON CONFLICT DO NOTHING");
+	else if (onConflictAction == ONCONFLICT_UPDATE && dialect == JDBC_DIALECT_POSTGRESQL)
+	{
+		appendStringInfoString(buf, " ON CONFLICT (");
+		foreach(lc, keyAttrs)
+		{
+			if (lc != list_head(keyAttrs))
+				appendStringInfoString(buf, ", ");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+		}
+		appendStringInfoString(buf, ") DO UPDATE SET ");
+		foreach(lc, updateAttrs)
+		{
+			if (lc != list_head(updateAttrs))
+				appendStringInfoString(buf, ", ");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+			appendStringInfoString(buf, " = EXCLUDED.");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+		}
+	}
+	else if (onConflictAction == ONCONFLICT_UPDATE && dialect == JDBC_DIALECT_MYSQL)
+	{
+		appendStringInfoString(buf, " ON DUPLICATE KEY UPDATE ");
+		foreach(lc, updateAttrs)
+		{
+			if (lc != list_head(updateAttrs))
+				appendStringInfoString(buf, ", ");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+			appendStringInfoString(buf, " = VALUES(");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+			appendStringInfoChar(buf, ')');
+		}
+	}
+}
+
+/*
+ * deparse remote MERGE statement for an upsert of one row
+ *
+ * The row is given as parameters for the targetAttrs columns.  It is matched
+ * with the existing rows on the key columns keyAttrs; a matching row gets
+ * the values of the updateAttrs columns, or is left alone if there are none.
+ */
+static void
+jdbc_deparse_merge_sql(StringInfo buf, Relation rel, List *targetAttrs,
+					   List *keyAttrs, List *updateAttrs, char *q_char)
+{
+	Oid			relid = RelationGetRelid(rel);
+	ListCell   *lc;
+
+	appendStringInfoString(buf, "MERGE INTO ");
+	jdbc_deparse_relation(buf, rel, q_char);
+	appendStringInfoString(buf, " AS tgt USING (VALUES (");
+	foreach(lc, targetAttrs)
+		appendStringInfoString(buf, lc == list_head(targetAttrs) ? "?" : ", ?");
+	appendStringInfoString(buf, ")) AS src (");
+	foreach(lc, targetAttrs)
+	{
+		if (lc != list_head(targetAttrs))
+			appendStringInfoString(buf, ", ");
+		jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+	}
+
+	appendStringInfoString(buf, ") ON (");
+	foreach(lc, keyAttrs)
+	{
+		if (lc != list_head(keyAttrs))
+			appendStringInfoString(buf, " AND ");
+		appendStringInfoString(buf, "tgt.");
+		jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+		appendStringInfoString(buf, " = src.");
+		jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+	}
+	appendStringInfoChar(buf, ')');
+
+	if (updateAttrs != NIL)
+	{
+		appendStringInfoString(buf, " WHEN MATCHED THEN UPDATE SET ");
+		foreach(lc, updateAttrs)
+		{
+			if (lc != list_head(updateAttrs))
+				appendStringInfoString(buf, ", ");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+			appendStringInfoString(buf, " = src.");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+		}
+	}
+
+	appendStringInfoString(buf, " WHEN NOT MATCHED THEN INSERT (");
+	foreach(lc, targetAttrs)
+	{
+		if (lc != list_head(targetAttrs))
+			appendStringInfoString(buf, ", ");
+		jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+	}
+	appendStringInfoString(buf, ") VALUES (");
+	foreach(lc, targetAttrs)
+	{
+		if (lc != list_head(targetAttrs))
+			appendStringInfoString(buf, ", ");
+		appendStringInfoString(buf, "src.");
+		jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+	}
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * deparse the target of a bulk load
+ *
+ * The name of the remote table is appended to table, and the names of the
+ * targetAttrs columns, separated by commas, to columns.  The statement
+ * itself depends on the bulk path of the remote database and is built by the
+ * Java side.
+ */
+void
+jdbc_deparse_bulk_load_target(StringInfo table, StringInfo columns,
+							  Relation rel, List *targetAttrs, char *q_char)
+{
+	bool		first = true;
+	ListCell   *lc;
+
+	jdbc_deparse_relation(table, rel, q_char);
+
+	foreach(lc, targetAttrs)
+	{
+		int			attnum = lfirst_int(lc);
+
+		if (!first)
+			appendStringInfoString(columns, ", ");
+		first = false;
+
+		jdbc_deparse_column_name(columns, RelationGetRelid(rel), attnum, q_char);
+	}
 }
 
 /*
  * deparse remote UPDATE statement
  *
- * The statement text is appended to buf, and we also create an integer List
- * of the columns being retrieved by RETURNING (if any), which is returned to
- * *retrieved_attrs.
+ * The statement updates the rows whose key columns attnums match one of
+ * num_keysets sets of parameters, see jdbc_append_key_conditions.  Column
+ * names are taken from the relation, so root may be NULL.
  */
 void
 jdbc_deparse_update_sql(StringInfo buf, PlannerInfo *root,
 						Index rtindex, Relation rel,
 						List *targetAttrs, List *attnums,
-						char *q_char)
+						int num_keysets, char *q_char)
 {
 	bool		first;
 	ListCell   *lc;
-	int			i;
 
 	appendStringInfoString(buf, "UPDATE ");
 	jdbc_deparse_relation(buf, rel, q_char);
@@ -1282,58 +1489,262 @@ jdbc_deparse_update_sql(StringInfo buf, PlannerInfo *root,
 			appendStringInfoString(buf, ", ");
 		first = false;
 
-		jdbc_deparse_column_ref(buf, rtindex, attnum, root, false, q_char);
+		jdbc_deparse_column_name(buf, RelationGetRelid(rel), attnum, q_char);
 		appendStringInfo(buf, " = ?");
 	}
-	i = 0;
-	foreach(lc, attnums)
-	{
-		int			attnum = lfirst_int(lc);
-
-		appendStringInfo(buf, i == 0 ? " WHERE " : " AND ");
-		jdbc_deparse_column_ref(buf, rtindex, attnum, root, false, q_char);
-		appendStringInfo(buf, "=?");
-		i++;
-	}
+	jdbc_append_key_conditions(buf, rel, attnums, num_keysets, q_char);
 }
 
 /*
  * deparse remote DELETE statement
  *
- * The statement text is appended to buf, and we also create an integer List
- * of the columns being retrieved by RETURNING (if any), which is returned to
- * *retrieved_attrs.
+ * The statement deletes the rows whose key columns attname match one of
+ * num_keysets sets of parameters, or every row if attname is NIL.  Column
+ * names are taken from the relation, so root may be NULL.
  */
 void
 jdbc_deparse_delete_sql(StringInfo buf, PlannerInfo *root,
 						Index rtindex, Relation rel,
-						List *attname, char *q_char)
+						List *attname, int num_keysets, char *q_char)
 {
-	int			i = 0;
+	appendStringInfoString(buf, "DELETE FROM ");
+	jdbc_deparse_relation(buf, rel, q_char);
+	jdbc_append_key_conditions(buf, rel, attname, num_keysets, q_char);
+}
+
+/*
+ * Append the WHERE clause of an UPDATE or DELETE statement that matches
+ * num_keysets sets of values of the key columns attnums, given as
+ * parameters in that order.  A single set gives "k1=? AND k2=?", several
+ * give "k IN (?, ?)" for a single key column and
+ * "(k1=? AND k2=?) OR (k1=? AND k2=?)" otherwise.
+ */
+static void
+jdbc_append_key_conditions(StringInfo buf, Relation rel, List *attnums,
+						   int num_keysets, char *q_char)
+{
+	Oid			relid = RelationGetRelid(rel);
 	ListCell   *lc;
+	int			i;
 
-	appendStringInfoString(buf, "DELETE FROM ");
+	if (attnums == NIL)
+		return;
+
+	appendStringInfoString(buf, " WHERE ");
+
+	if (num_keysets > 1 && list_length(attnums) == 1)
+	{
+		jdbc_deparse_column_name(buf, relid, linitial_int(attnums), q_char);
+		appendStringInfoString(buf, " IN (");
+		for (i = 0; i < num_keysets; i++)
+			appendStringInfoString(buf, i == 0 ? "?" : ", ?");
+		appendStringInfoChar(buf, ')');
+		return;
+	}
+
+	for (i = 0; i < num_keysets; i++)
+	{
+		if (num_keysets > 1)
+			appendStringInfoString(buf, i == 0 ? "(" : " OR (");
+
+		foreach(lc, attnums)
+		{
+			if (lc != list_head(attnums))
+				appendStringInfoString(buf, " AND ");
+			jdbc_deparse_column_name(buf, relid, lfirst_int(lc), q_char);
+			appendStringInfo(buf, "=?");
+		}
+
+		if (num_keysets > 1)
+			appendStringInfoChar(buf, ')');
+	}
+}
+
+/*
+ * deparse remote TRUNCATE statement
+ *
+ * The statement empties every relation of rels, which all belong to the
+ * same foreign server.  RESTART IDENTITY and CASCADE are only added when
+ * requested, because many databases other than PostgreSQL do not know them.
+ */
+void
+jdbc_deparse_truncate_sql(StringInfo buf, List *rels,
+						  DropBehavior behavior, bool restart_seqs,
+						  char *q_char)
+{
+	ListCell   *lc;
+
+	appendStringInfoString(buf, "TRUNCATE TABLE ");
+
+	foreach(lc, rels)
+	{
+		Relation	rel = lfirst(lc);
+
+		if (lc != list_head(rels))
+			appendStringInfoString(buf, ", ");
+
+		jdbc_deparse_relation(buf, rel, q_char);
+	}
+
+	if (restart_seqs)
+		appendStringInfoString(buf, " RESTART IDENTITY");
+
+	if (behavior == DROP_CASCADE)
+		appendStringInfoString(buf, " CASCADE");
+}
+
+/*
+ * deparse remote UPDATE statement that updates every row of the foreign
+ * table matching remote_conds, for a direct modification
+ *
+ * targetAttrs and targetExprs give the updated columns and their new values,
+ * which have already been checked to be shippable.  remote_conds is a list
+ * of RestrictInfos for the WHERE clause.
+ */
+void
+jdbc_deparse_direct_update_sql(StringInfo buf, PlannerInfo *root,
+							   Index rtindex, Relation rel,
+							   RelOptInfo *foreignrel,
+							   List *targetAttrs, List *targetExprs,
+							   List *remote_conds, char *q_char)
+{
+	deparse_expr_cxt context;
+	int			nestlevel;
+	bool		first;
+	ListCell   *lc,
+			   *lc2;
+
+	/* Set up context struct for recursion */
+	context.root = root;
+	context.foreignrel = foreignrel;
+	context.scanrel = foreignrel;
+	context.buf = buf;
+	context.params_list = NULL;
+	context.q_char = q_char;
+
+	appendStringInfoString(buf, "UPDATE ");
 	jdbc_deparse_relation(buf, rel, q_char);
-	foreach(lc, attname)
+	appendStringInfoString(buf, " SET ");
+
+	/* Make sure any constants in the exprs are printed portably */
+	nestlevel = jdbc_set_transmission_modes();
+
+	first = true;
+	forboth(lc, targetAttrs, lc2, targetExprs)
 	{
 		int			attnum = lfirst_int(lc);
 
-		appendStringInfo(buf, i == 0 ? " WHERE " : " AND ");
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
 		jdbc_deparse_column_ref(buf, rtindex, attnum, root, false, q_char);
-		appendStringInfo(buf, "=?");
-		i++;
+		appendStringInfoString(buf, " = ");
+		jdbc_deparse_expr((Expr *) lfirst(lc2), &context);
+	}
+
+	jdbc_reset_transmission_modes(nestlevel);
+
+	if (remote_conds)
+		jdbc_append_where_clause(buf, root, foreignrel, remote_conds,
+								 true, NULL, q_char);
+}
+
+/*
+ * deparse remote DELETE statement that deletes every row of the foreign
+ * table matching remote_conds, for a direct modification
+ */
+void
+jdbc_deparse_direct_delete_sql(StringInfo buf, PlannerInfo *root,
+							   Relation rel, RelOptInfo *foreignrel,
+							   List *remote_conds, char *q_char)
+{
+	appendStringInfoString(buf, "DELETE FROM ");
+	jdbc_deparse_relation(buf, rel, q_char);
+
+	if (remote_conds)
+		jdbc_append_where_clause(buf, root, foreignrel, remote_conds,
+								 true, NULL, q_char);
+}
+
+/*
+ * Return the integer list of the columns of rel used by the RETURNING list
+ * of an INSERT, UPDATE or DELETE on the rtindex'th range table entry.  A
+ * whole-row reference retrieves all columns.  The remote server returns
+ * these columns, in this order, through getGeneratedKeys.
+ */
+List *
+jdbc_get_returning_attrs(Index rtindex, Relation rel, List *returningList)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	Bitmapset  *attrs_used = NULL;
+	bool		have_wholerow;
+	List	   *retrieved_attrs = NIL;
+	int			i;
+
+	pull_varattnos((Node *) returningList, rtindex, &attrs_used);
+	have_wholerow = bms_is_member(0 - FirstLowInvalidHeapAttributeNumber,
+								  attrs_used);
+
+	for (i = 1; i <= tupdesc->natts; i++)
+	{
+		/* Ignore dropped attributes. */
+		if (TupleDescAttr(tupdesc, i - 1)->attisdropped)
+			continue;
+
+		if (have_wholerow ||
+			bms_is_member(i - FirstLowInvalidHeapAttributeNumber, attrs_used))
+			retrieved_attrs = lappend_int(retrieved_attrs, i);
+	}
+
+	return retrieved_attrs;
+}
+
+/*
+ * Construct SELECT statement to estimate the number of rows of given
+ * relation, before sampling it.  The remote catalog has an estimate for a
+ * PostgreSQL table, otherwise the rows are counted.
+ */
+void
+jdbc_deparse_analyze_info_sql(StringInfo buf, Relation rel, JdbcDialect dialect,
+							  char *q_char)
+{
+	if (dialect == JDBC_DIALECT_POSTGRESQL)
+	{
+		StringInfoData relname;
+
+		initStringInfo(&relname);
+		jdbc_deparse_relation(&relname, rel, q_char);
+
+		appendStringInfoString(buf, "SELECT reltuples FROM pg_catalog.pg_class WHERE oid = ");
+		jdbc_deparse_string_literal(buf, relname.data);
+		appendStringInfoString(buf, "::pg_catalog.regclass");
+	}
+	else
+	{
+		appendStringInfoString(buf, "SELECT COUNT(*) FROM ");
+		jdbc_deparse_relation(buf, rel, q_char);
 	}
 }
 
 /*
  * Construct SELECT statement to acquire sample rows of given relation.
  *
+ * The rows are sampled on the remote server by the given method: with
+ * TABLESAMPLE or a random predicate keeping sample_frac of the rows, or by
+ * ordering them randomly and keeping targrows of them.  The random function
+ * depends on the dialect.
+ *
  * SELECT command is appended to buf, and list of columns retrieved is
  * returned to *retrieved_attrs.
  */
 void
-jdbc_deparse_analyze_sql(StringInfo buf, Relation rel, List **retrieved_attrs, char *q_char)
+jdbc_deparse_analyze_sql(StringInfo buf, Relation rel, List **retrieved_attrs,
+						 JdbcAnalyzeSampling method, double sample_frac,
+						 int targrows, JdbcDialect dialect, char *q_char)
 {
+	const char *random_func;
+
 	Oid			relid = RelationGetRelid(rel);
 	TupleDesc	tupdesc = RelationGetDescr(rel);
 	int			i;
@@ -1347,7 +1758,7 @@ jdbc_deparse_analyze_sql(StringInfo buf, Relation rel, List **retrieved_attrs, c
 	appendStringInfoString(buf, "SELECT ");
 	for (i = 0; i < tupdesc->natts; i++)
 	{
-		Form_pg_attribute attr = TupleDescAttr(tupdesc, i - 1);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
 
 		/* Ignore dropped columns. */
 		if (attr->attisdropped)
@@ -1386,6 +1797,37 @@ jdbc_deparse_analyze_sql(StringInfo buf, Relation rel, List **retrieved_attrs, c
 	 */
 	appendStringInfoString(buf, " FROM ");
 	jdbc_deparse_relation(buf, rel, q_char);
+
+	/* PostgreSQL has random(), most others RAND() */
+	random_func = (dialect == JDBC_DIALECT_POSTGRESQL) ? "random()" : "RAND()";
+
+	/*
+	 * The fraction of a large table is tiny, so it is printed at full
+	 * precision, and kept above 0 so that some rows are sampled.
+	 */
+	sample_frac = Min(Max(sample_frac, DBL_MIN), 1.0);
+
+	switch (method)
+	{
+		case JDBC_SAMPLE_OFF:
+			break;
+		case JDBC_SAMPLE_RANDOM:
+			appendStringInfo(buf, " WHERE %s < %.17g", random_func, sample_frac);
+			break;
+		case JDBC_SAMPLE_SYSTEM:
+			appendStringInfo(buf, " TABLESAMPLE SYSTEM(%.17g)", (100.0 * sample_frac));
+			break;
+		case JDBC_SAMPLE_BERNOULLI:
+			appendStringInfo(buf, " TABLESAMPLE BERNOULLI(%.17g)", (100.0 * sample_frac));
+			break;
+		case JDBC_SAMPLE_ORDER:
+			appendStringInfo(buf, " ORDER BY %s LIMIT %d", random_func, targrows);
+			break;
+		case JDBC_SAMPLE_AUTO:
+			/* should have been resolved into an actual method */
+			elog(ERROR, "unexpected sampling method");
+			break;
+	}
 }
 
 /*
@@ -1397,9 +1839,6 @@ jdbc_deparse_column_ref(StringInfo buf, int varno, int varattno, PlannerInfo *ro
 						bool qualify_col, char *q_char)
 {
 	RangeTblEntry *rte;
-	char	   *colname = NULL;
-	List	   *options;
-	ListCell   *lc;
 
 	/* varno must not be any of OUTER_VAR, INNER_VAR and INDEX_VAR. */
 	Assert(!IS_SPECIAL_VARNO(varno));
@@ -1407,11 +1846,41 @@ jdbc_deparse_column_ref(StringInfo buf, int varno, int varattno, PlannerInfo *ro
 	/* Get RangeTblEntry from array in PlannerInfo. */
 	rte = planner_rt_fetch(varno, root);
 
+	/* Qualify the column with the alias of its relation in a join. */
+	if (qualify_col)
+		appendStringInfo(buf, "%s%d.", REL_ALIAS_PREFIX, varno);
+
+	jdbc_deparse_column_name(buf, rte->relid, varattno, q_char);
+}
+
+/*
+ * Construct name to use for given column of given relation, and emit it into
+ * buf.  If it has a column_name FDW option, use that instead of attribute
+ * name.  Needs no PlannerInfo, so it can be used at execution time too.
+ */
+static void
+jdbc_deparse_column_name(StringInfo buf, Oid relid, int varattno, char *q_char)
+{
+	appendStringInfoString(buf, jdbc_quote_identifier(jdbc_get_column_name(relid, varattno),
+													   q_char, false));
+}
+
+/*
+ * Return the name of given column on the remote server, that is its
+ * column_name FDW option or else its attribute name, without quotes.
+ */
+char *
+jdbc_get_column_name(Oid relid, int varattno)
+{
+	char	   *colname = NULL;
+	List	   *options;
+	ListCell   *lc;
+
 	/*
 	 * If it's a column of a foreign table, and it has the column_name FDW
 	 * option, use that value.
 	 */
-	options = GetForeignColumnOptions(rte->relid, varattno);
+	options = GetForeignColumnOptions(relid, varattno);
 	foreach(lc, options)
 	{
 		DefElem    *def = (DefElem *) lfirst(lc);
@@ -1429,12 +1898,12 @@ jdbc_deparse_column_ref(StringInfo buf, int varno, int varattno, PlannerInfo *ro
 	 */
 	if (colname == NULL)
 #if PG_VERSION_NUM >= 110000
-		colname = get_attname(rte->relid, varattno, false);
+		colname = get_attname(relid, varattno, false);
 #else
-		colname = get_relid_attribute_name(rte->relid, varattno);
+		colname = get_relid_attribute_name(relid, varattno);
 #endif
 
-	appendStringInfoString(buf, jdbc_quote_identifier(colname, q_char, false));
+	return colname;
 }
 
 /*
@@ -1601,6 +2070,158 @@ jdbc_deparse_relation(StringInfo buf, Relation rel, char *q_char)
 
 }
 
+/*
+ * Construct FROM clause for given relation
+ *
+ * The function constructs ... JOIN ... ON ... for join relation. For a base
+ * relation it just returns the remote name of the table, followed by its
+ * alias REL_ALIAS_PREFIX<rtindex> if use_alias is true.
+ *
+ * The conditions of an inner join are sent in the WHERE clause, so its ON
+ * clause is always true.  Constant TRUE is not understood by every remote
+ * server, hence "1 = 1".
+ */
+static void
+jdbc_deparse_from_expr_for_rel(StringInfo buf, PlannerInfo *root,
+							   RelOptInfo *foreignrel, bool use_alias,
+							   List **params_list, char *q_char)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) foreignrel->fdw_private;
+
+	if (IS_JOIN_REL(foreignrel))
+	{
+		StringInfoData join_sql_o;
+		StringInfoData join_sql_i;
+
+		/* Deparse outer relation */
+		initStringInfo(&join_sql_o);
+		jdbc_deparse_from_expr_for_rel(&join_sql_o, root, fpinfo->outerrel,
+									   true, params_list, q_char);
+
+		/* Deparse inner relation */
+		initStringInfo(&join_sql_i);
+		jdbc_deparse_from_expr_for_rel(&join_sql_i, root, fpinfo->innerrel,
+									   true, params_list, q_char);
+
+		/*
+		 * For a join relation FROM clause entry is deparsed as
+		 *
+		 * ((outer relation) <join type> (inner relation) ON (joinclauses))
+		 */
+		appendStringInfo(buf, "(%s %s JOIN %s ON ", join_sql_o.data,
+						 jdbc_get_jointype_name(fpinfo->jointype), join_sql_i.data);
+
+		if (fpinfo->joinclauses)
+		{
+			deparse_expr_cxt context;
+
+			context.buf = buf;
+			context.foreignrel = foreignrel;
+			context.scanrel = foreignrel;
+			context.root = root;
+			context.params_list = params_list;
+			context.q_char = q_char;
+
+			appendStringInfoChar(buf, '(');
+			jdbc_append_conditions(fpinfo->joinclauses, &context);
+			appendStringInfoChar(buf, ')');
+		}
+		else
+			appendStringInfoString(buf, "(1 = 1)");
+
+		/* End the FROM clause entry. */
+		appendStringInfoChar(buf, ')');
+	}
+	else
+	{
+		RangeTblEntry *rte = planner_rt_fetch(foreignrel->relid, root);
+		Relation	rel;
+
+		/*
+		 * Core code already has some lock on each rel being planned, so we
+		 * can use NoLock here.
+		 */
+#if PG_VERSION_NUM < 130000
+		rel = heap_open(rte->relid, NoLock);
+#else
+		rel = table_open(rte->relid, NoLock);
+#endif
+
+		jdbc_deparse_relation(buf, rel, q_char);
+
+		if (use_alias)
+			appendStringInfo(buf, " %s%d", REL_ALIAS_PREFIX, foreignrel->relid);
+
+#if PG_VERSION_NUM < 130000
+		heap_close(rel, NoLock);
+#else
+		table_close(rel, NoLock);
+#endif
+	}
+}
+
+/*
+ * Output join name for given join type
+ */
+static const char *
+jdbc_get_jointype_name(JoinType jointype)
+{
+	switch (jointype)
+	{
+		case JOIN_INNER:
+			return "INNER";
+
+		case JOIN_LEFT:
+			return "LEFT";
+
+		case JOIN_RIGHT:
+			return "RIGHT";
+
+		case JOIN_FULL:
+			return "FULL";
+
+		default:
+			/* Shouldn't come here, but protect from buggy code. */
+			elog(ERROR, "unsupported join type %d", jointype);
+	}
+
+	/* Keep compiler happy */
+	return NULL;
+}
+
+/*
+ * Deparse conditions from the provided list of RestrictInfos and append them
+ * to context->buf, connected with AND.
+ */
+static void
+jdbc_append_conditions(List *exprs, deparse_expr_cxt *context)
+{
+	int			nestlevel;
+	ListCell   *lc;
+	bool		is_first = true;
+	StringInfo	buf = context->buf;
+
+	/* Make sure any constants in the exprs are printed portably */
+	nestlevel = jdbc_set_transmission_modes();
+
+	foreach(lc, exprs)
+	{
+		RestrictInfo *ri = lfirst_node(RestrictInfo, lc);
+
+		/* Connect expressions with "AND" and parenthesize each condition. */
+		if (!is_first)
+			appendStringInfoString(buf, " AND ");
+
+		appendStringInfoChar(buf, '(');
+		jdbc_deparse_expr(ri->clause, context);
+		appendStringInfoChar(buf, ')');
+
+		is_first = false;
+	}
+
+	jdbc_reset_transmission_modes(nestlevel);
+}
+
 /*
  * Append a SQL string literal representing "val" to buf.
  */
@@ -1727,9 +2348,16 @@ jdbc_deparse_var(Var *node, deparse_expr_cxt *context)
 	}
 	else
 	{
-		/* Does not reach here. */
-		elog(ERROR, "Parameter is unsupported");
-		Assert(false);
+		/*
+		 * Var of another relation, in a join clause of a parameterized scan.
+		 * It is sent as a parameter of the prepared statement, bound with the
+		 * value of the outer row; each placeholder has its own parameter.
+		 */
+		if (context->params_list == NULL)
+			elog(ERROR, "unexpected Var of another relation in remote query");
+
+		*context->params_list = lappend(*context->params_list, node);
+		appendStringInfoChar(buf, '?');
 	}
 }
 
@@ -370,6 +370,8 @@ griddb_init(const char *addr,
 				loct1_rescan,
 				loct2_rescan,
 				loct_empty,
+				analyze_rtable1,
+				analyze_rtable2,
 				loct4_2,
 				locp1,
 				locp2,
@@ -625,7 +627,18 @@ griddb_init(const char *addr,
 				tbl04,
 				tbl05,
 				tbl06,
-				test_explicit_cast;
+				test_explicit_cast,
+				batch_tbl,
+				copy_tbl,
+				bulk_tbl,
+				async_tbl,
+				trunc_tbl1,
+				trunc_tbl2,
+				keyset_tbl,
+				upsert_tbl,
+				ret_tbl,
+				param_tbl,
+				defer_tbl;
 	const		GSPropertyEntry props[] = {
 		{"notificationAddress", addr},
 		{"notificationPort", port},
@@ -1624,6 +1637,22 @@ griddb_init(const char *addr,
 	if (!GS_SUCCEEDED(ret))
 		goto EXIT;
 
+	ret = set_tableInfo(store, "analyze_rtable1", &analyze_rtable1,
+						3,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"a", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE,
+						"b", GS_TYPE_LONG, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "analyze_rtable2", &analyze_rtable2,
+						3,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"a", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE,
+						"b", GS_TYPE_LONG, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
 	ret = set_tableInfo(store, "loct4_2", &loct4_2,
 						3,
 						"f1", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
@@ -2991,6 +3020,86 @@ griddb_init(const char *addr,
 	if (!GS_SUCCEEDED(ret))
 		goto EXIT;
 
+	ret = set_tableInfo(store, "batch_tbl", &batch_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "copy_tbl", &copy_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "bulk_tbl", &bulk_tbl,
+						4,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE,
+						"c2", GS_TYPE_TIMESTAMP, GS_TYPE_OPTION_NULLABLE,
+						"c3", GS_TYPE_BOOL, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "async_tbl", &async_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "trunc_tbl1", &trunc_tbl1,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "trunc_tbl2", &trunc_tbl2,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "keyset_tbl", &keyset_tbl,
+						3,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_INTEGER, GS_TYPE_OPTION_NULLABLE,
+						"c2", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "upsert_tbl", &upsert_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "ret_tbl", &ret_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "param_tbl", &param_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
+	ret = set_tableInfo(store, "defer_tbl", &defer_tbl,
+						2,
+						"id", GS_TYPE_INTEGER, GS_TYPE_OPTION_NOT_NULL,
+						"c1", GS_TYPE_STRING, GS_TYPE_OPTION_NULLABLE);
+	if (!GS_SUCCEEDED(ret))
+		goto EXIT;
+
 	/* Initialize data for some tables */
 	ret = insert_recordsFromTSV(store, &INT2_TBL, "/tmp/jdbc/int2.data");
 	if (!GS_SUCCEEDED(ret))
@@ -180,6 +180,14 @@ CREATE TABLE loct4_2 (f1 int, f2 int, f3 int);
 -- INSERT INTO fprt2_p1 SELECT i, i, to_char(i/50, 'FM0000') FROM generate_series(0, 249, 3) i;
 -- INSERT INTO fprt2_p2 SELECT i, i, to_char(i/50, 'FM0000') FROM generate_series(250, 499, 3) i;
 
+-- ===================================================================
+-- test for ANALYZE sampling
+-- ===================================================================
+DROP TABLE IF EXISTS analyze_rtable1 CASCADE;
+DROP TABLE IF EXISTS analyze_rtable2 CASCADE;
+create table analyze_rtable1 (id int, a text, b bigint);
+create table analyze_rtable2 (id int, a text, b bigint);
+
 -- -- ===================================================================
 -- -- test partitionwise aggregates
 -- -- ===================================================================
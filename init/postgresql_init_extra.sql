@@ -51,3 +51,33 @@ INSERT INTO non_error_throwing_api_date VALUES ('garbage', 2);
 INSERT INTO non_error_throwing_api_date VALUES ('6874898-01-01', 3);
 CREATE TABLE temp_t1 (f1 int, f2 int);
 CREATE TABLE temp_t2 (f1 bigint, f2 int);
+DROP TABLE IF EXISTS batch_tbl;
+CREATE TABLE batch_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS copy_tbl;
+CREATE TABLE copy_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS bulk_tbl;
+CREATE TABLE bulk_tbl (id int primary key, c1 text, c2 timestamp, c3 boolean);
+DROP TABLE IF EXISTS async_tbl;
+CREATE TABLE async_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS trunc_tbl1;
+DROP TABLE IF EXISTS trunc_tbl2;
+CREATE TABLE trunc_tbl1 (id int primary key, c1 text);
+CREATE TABLE trunc_tbl2 (id int primary key, c1 text);
+DROP TABLE IF EXISTS keyset_tbl;
+CREATE TABLE keyset_tbl (id int primary key, c1 int, c2 text);
+DROP TABLE IF EXISTS upsert_tbl;
+CREATE TABLE upsert_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS ret_tbl;
+CREATE TABLE ret_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS param_tbl;
+CREATE TABLE param_tbl (id int primary key, c1 text);
+DROP TABLE IF EXISTS defer_tbl;
+CREATE TABLE defer_tbl (id int primary key, c1 text);
+CREATE FUNCTION defer_tbl_reject() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+  IF NEW.c1 = 'reject' THEN
+    RAISE EXCEPTION 'row % is rejected at commit', NEW.id;
+  END IF;
+  RETURN NULL;
+END $$;
+CREATE CONSTRAINT TRIGGER defer_tbl_check AFTER INSERT ON defer_tbl DEFERRABLE INITIALLY DEFERRED FOR EACH ROW EXECUTE FUNCTION defer_tbl_reject();
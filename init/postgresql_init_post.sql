@@ -185,6 +185,19 @@ ALTER TABLE fprt2_p2 SET (autovacuum_enabled = 'false');
 INSERT INTO fprt2_p1 SELECT i, i, to_char(i/50, 'FM0000') FROM generate_series(0, 249, 3) i;
 INSERT INTO fprt2_p2 SELECT i, i, to_char(i/50, 'FM0000') FROM generate_series(250, 499, 3) i;
 
+-- ===================================================================
+-- test for ANALYZE sampling
+-- ===================================================================
+DROP TABLE IF EXISTS analyze_rtable1 CASCADE;
+DROP TABLE IF EXISTS analyze_rtable2 CASCADE;
+create table analyze_rtable1 (id int, a text, b bigint);
+create table analyze_rtable2 (id int, a text, b bigint);
+alter table analyze_rtable1 set (autovacuum_enabled = 'false');
+alter table analyze_rtable2 set (autovacuum_enabled = 'false');
+-- the estimate of analyze_rtable1 does not count the rows inserted by the test
+INSERT INTO analyze_rtable1 SELECT x FROM generate_series(1, 1000) x;
+ANALYZE analyze_rtable1;
+
 -- ===================================================================
 -- test partitionwise aggregates
 -- ===================================================================
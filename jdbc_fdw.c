@@ -16,6 +16,11 @@
 
 #include "jdbc_fdw.h"
 
+#if PG_VERSION_NUM >= 130000
+#include "common/hashfn.h"
+#else
+#include "access/hash.h"
+#endif
 #include "access/htup_details.h"
 #include "access/sysattr.h"
 #include "commands/defrem.h"
@@ -44,16 +49,21 @@
 #include "parser/parsetree.h"
 #include "parser/parse_relation.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/elog.h"
+#include "utils/sampling.h"
+#include "utils/timestamp.h"
 #include "executor/spi.h"
 
 
 #include "storage/ipc.h"
 #include "catalog/pg_foreign_server.h"
 #include "catalog/pg_foreign_table.h"
+#include "catalog/pg_type.h"
 #include "catalog/pg_user_mapping.h"
 #define Str(arg) #arg
 #define StrValue(arg) Str(arg)
@@ -82,7 +92,9 @@ PG_MODULE_MAGIC;
  * planner to executor.  Currently we store:
  *
  * 1) SELECT statement text to be sent to the remote server 2) Integer list
- * of attribute numbers retrieved by the SELECT
+ * of attribute numbers retrieved by the SELECT 3) Integer flag showing if
+ * the scan is for UPDATE/DELETE 4) Integer fetch size 5) Integer
+ * lookup_cache_size, 0 if disabled
  *
  * These items are indexed with the enum FdwScanPrivateIndex, so an item can
  * be fetched with list_nth().  For example, to get the SELECT statement: sql
@@ -94,6 +106,12 @@ enum FdwScanPrivateIndex
 	FdwScanPrivateSelectSql,
 	/* Integer list of attribute numbers retrieved by the SELECT */
 	FdwScanPrivateRetrievedAttrs,
+	/* Integer flag showing if the scan is for UPDATE/DELETE */
+	FdwScanPrivateForUpdate,
+	/* Integer representing the desired fetch_size */
+	FdwScanPrivateFetchSize,
+	/* Integer representing the lookup_cache_size, 0 if disabled */
+	FdwScanPrivateLookupCacheSize,
 };
 
 /*
@@ -133,6 +151,77 @@ enum FdwModifyPrivateIndex
 	FdwModifyPrivateRetrievedAttrs,
 };
 
+/*
+ * Similarly, this enum describes what's kept in the fdw_private list for
+ * a ForeignScan node that modifies a foreign table directly.  We store:
+ *
+ * 1) UPDATE/DELETE statement text to be sent to the remote server 2) Integer
+ * flag showing if we set the command es_processed
+ */
+enum FdwDirectModifyPrivateIndex
+{
+	/* SQL statement to execute remotely (as a String node) */
+	FdwDirectModifyPrivateUpdateSql,
+	/* set-processed flag (as an Integer node) */
+	FdwDirectModifyPrivateSetProcessed,
+};
+
+/*
+ * Callback argument for jdbc_ec_member_matches_foreign
+ */
+typedef struct
+{
+	Expr	   *current;		/* current expr, or NULL if not yet found */
+	List	   *already_used;	/* expressions already dealt with */
+} ec_member_foreign_arg;
+
+/*
+ * Rows of a parameterized scan remembered for one set of parameter values.
+ * The values are identified by their serialized form in the JparamBuffer.
+ */
+typedef struct jdbcLookupKey
+{
+	char	   *data;			/* serialized parameter values */
+	int			len;
+}			jdbcLookupKey;
+
+typedef struct jdbcLookupEntry
+{
+	jdbcLookupKey key;			/* hash key (must be first) */
+	HeapTuple  *tuples;			/* rows returned for these values */
+	int			num_tuples;
+}			jdbcLookupEntry;
+
+/*
+ * Remote estimates kept per server, user and SELECT statement, see
+ * get_remote_estimate.
+ */
+typedef struct jdbcEstimateKey
+{
+	Oid			serverid;
+	Oid			userid;
+	const char *query;			/* statement estimated */
+}			jdbcEstimateKey;
+
+typedef struct jdbcEstimateEntry
+{
+	jdbcEstimateKey key;		/* hash key (must be first) */
+	TimestampTz created;		/* when the estimate was made */
+	double		rows;
+	int			width;
+	Cost		startup_cost;
+	Cost		total_cost;
+}			jdbcEstimateEntry;
+
+/* Default number of seconds a remote estimate is reused */
+#define DEFAULT_ESTIMATE_CACHE_TTL	60
+
+/* The cache is emptied when it reaches this number of estimates */
+#define ESTIMATE_CACHE_MAX_ENTRIES	1024
+
+static HTAB *EstimateCache = NULL;
+static MemoryContext EstimateCacheContext = NULL;
+
 /*
  * Execution state of a foreign scan using jdbc_fdw.
  */
@@ -152,14 +241,21 @@ typedef struct jdbcFdwScanState
 	unsigned int cursor_number; /* quasi-unique ID for my cursor */
 	bool		cursor_exists;	/* have we created the cursor? */
 	int			numParams;		/* number of parameters passed to query */
-	FmgrInfo   *param_flinfo;	/* output conversion functions for them */
 	List	   *param_exprs;	/* executable expressions for param values */
-	const char **param_values;	/* textual values of query parameters */
+	JparamBuffer param_buffer;	/* binds the param values of each rescan */
+	int			statementID;	/* query prepared once if it has params */
+
+	/* rows already fetched for recent param values, see lookup_cache_size */
+	int			lookup_cache_size;	/* max # of entries, 0 if no cache */
+	HTAB	   *lookup_cache;	/* jdbcLookupEntry per set of param values */
+	MemoryContext cache_cxt;	/* context holding the cache */
 
 	/* for storing result tuples */
 	HeapTuple  *tuples;			/* array of currently-retrieved tuples */
 	int			num_tuples;		/* # of tuples in array */
 	int			next_tuple;		/* index of next one to return */
+	int			fetch_size;		/* number of tuples per fetch */
+	JcolumnarBuffer columnar_buffer;	/* receives batches from the JVM */
 
 	/*
 	 * batch-level state, for optimizing rewinds and avoiding useless fetch
@@ -182,6 +278,7 @@ typedef struct jdbcFdwModifyState
 {
 	Relation	rel;			/* relcache entry for the foreign table */
 	AttInMetadata *attinmeta;	/* attribute datatype conversion metadata */
+	CmdType		operation;		/* INSERT, UPDATE, or DELETE */
 
 	/* for remote query execution */
 	JDBCUtilsInfo	   *jdbcUtilsInfo;			/* connection for the scan */
@@ -194,11 +291,51 @@ typedef struct jdbcFdwModifyState
 	bool		has_returning;	/* is there a RETURNING clause? */
 	List	   *retrieved_attrs;	/* attr numbers retrieved by RETURNING */
 
+	/* for reading back the RETURNING columns through getGeneratedKeys */
+	List	   *returning_names;	/* remote names of retrieved_attrs */
+	TupleDesc	returning_desc; /* columns returned by the driver */
+	AttrNumber *returning_attnums;	/* attribute of each returned column, or
+									 * 0 if it matches none */
+	JcolumnarBuffer returning_buffer;	/* receives the returned rows */
+
 	/* info about parameters for prepared statement */
 	AttrNumber *junk_idx;		/* the attrnumber of the junk column for
 								 * UPDATE and DELETE */
 	int			p_nums;			/* number of parameters to transmit */
 	FmgrInfo   *p_flinfo;		/* output conversion functions for them */
+	List	   *key_attrs;		/* key columns bound after target_attrs for
+								 * UPDATE and DELETE */
+	Datum	   *p_values;		/* values of the row being bound */
+	bool	   *p_isnull;		/* null flags of the row being bound */
+	JparamBuffer param_buffer;	/* sends a whole row to the JVM */
+
+	/* batch operation stuff */
+	int			batch_size;		/* value of FDW option "batch_size" */
+	bool		defer_batch;	/* batch rows given one at a time to
+								 * jdbcExecForeignInsert? */
+	int			num_pending;	/* number of rows added to the batch but not
+								 * sent yet */
+	bool		bulk_load;		/* value of FDW option "bulk_load" */
+	bool		async_write;	/* value of FDW option "async_write" */
+	int			bulkLoadID;		/* bulk load used for the batches instead of
+								 * the prepared statement, 0 if none */
+	OnConflictAction on_conflict;	/* ON CONFLICT action of an INSERT, sent
+									 * as an upsert */
+	bool		batch_no_info;	/* driver reported no update counts for a
+								 * batch of ON CONFLICT DO NOTHING? */
+
+	/* key-set batch stuff, for UPDATE and DELETE */
+	int			key_batch_size; /* key sets per statement, 1 if rows are
+								 * updated or deleted one at a time */
+	int			num_keysets;	/* number of key sets collected */
+	Datum	   *keyset_values;	/* SET values, then the collected key sets */
+	bool	   *keyset_isnull;	/* null flags of keyset_values */
+	int16	   *keyset_typlen;	/* typlen of the SET values and keys */
+	bool	   *keyset_typbyval;	/* typbyval of the SET values and keys */
+	JparamBuffer keyset_buffer; /* sends a full statement to the JVM */
+	int			keysetID;		/* prepared statement for key_batch_size key
+								 * sets, 0 if not prepared yet */
+	MemoryContext keyset_cxt;	/* context of the collected values */
 
 	/* working memory context */
 	MemoryContext temp_cxt;		/* context for per-tuple temporary data */
@@ -208,6 +345,24 @@ typedef struct jdbcFdwModifyState
 
 }			jdbcFdwModifyState;
 
+/*
+ * Execution state of a foreign scan that modifies a foreign table directly.
+ */
+typedef struct jdbcFdwDirectModifyState
+{
+	Relation	rel;			/* relcache entry for the foreign table */
+
+	/* extracted fdw_private data */
+	char	   *query;			/* text of UPDATE/DELETE command */
+	bool		set_processed;	/* do we set the command es_processed? */
+
+	/* for remote query execution */
+	JDBCUtilsInfo	   *jdbcUtilsInfo;			/* connection for the update */
+
+	/* for storing result */
+	int			num_tuples;		/* # of result tuples */
+}			jdbcFdwDirectModifyState;
+
 /*
  * Workspace for analyzing a foreign table.
  */
@@ -225,7 +380,7 @@ typedef struct jdbcFdwAnalyzeState
 	/* for random sampling */
 	double		samplerows;		/* # of rows fetched */
 	double		rowstoskip;		/* # of rows to skip before next sample */
-	double		rstate;			/* random state */
+	ReservoirStateData rstate;	/* state for reservoir sampling */
 
 	/* working memory contexts */
 	MemoryContext anl_cxt;		/* context for per-analyze lifespan data */
@@ -298,9 +453,35 @@ static TupleTableSlot *jdbcExecForeignDelete(EState *estate,
 											 ResultRelInfo *resultRelInfo,
 											 TupleTableSlot *slot,
 											 TupleTableSlot *planSlot);
+#if PG_VERSION_NUM >= 140000
+static TupleTableSlot **jdbcExecForeignBatchInsert(EState *estate,
+												   ResultRelInfo *resultRelInfo,
+												   TupleTableSlot **slots,
+												   TupleTableSlot **planSlots,
+												   int *numSlots);
+static int	jdbcGetForeignModifyBatchSize(ResultRelInfo *resultRelInfo);
+#endif
 static void jdbcEndForeignModify(EState *estate,
 								 ResultRelInfo *resultRelInfo);
+#if PG_VERSION_NUM >= 110000
+static void jdbcBeginForeignInsert(ModifyTableState *mtstate,
+								   ResultRelInfo *resultRelInfo);
+static void jdbcEndForeignInsert(EState *estate,
+								 ResultRelInfo *resultRelInfo);
+#endif
+static bool jdbcPlanDirectModify(PlannerInfo *root,
+								 ModifyTable *plan,
+								 Index resultRelation,
+								 int subplan_index);
+static void jdbcBeginDirectModify(ForeignScanState *node, int eflags);
+static TupleTableSlot *jdbcIterateDirectModify(ForeignScanState *node);
+static void jdbcEndDirectModify(ForeignScanState *node);
 static int	jdbcIsForeignRelUpdatable(Relation rel);
+#if PG_VERSION_NUM >= 140000
+static void jdbcExecForeignTruncate(List *rels,
+									DropBehavior behavior,
+									bool restart_seqs);
+#endif
 static void jdbcExplainForeignScan(ForeignScanState *node,
 								   ExplainState *es);
 static void jdbcExplainForeignModify(ModifyTableState *mtstate,
@@ -308,11 +489,19 @@ static void jdbcExplainForeignModify(ModifyTableState *mtstate,
 									 List *fdw_private,
 									 int subplan_index,
 									 ExplainState *es);
+static void jdbcExplainDirectModify(ForeignScanState *node,
+									ExplainState *es);
 static bool jdbcAnalyzeForeignTable(Relation relation,
 									AcquireSampleRowsFunc *func,
 									BlockNumber *totalpages);
 static List *jdbcImportForeignSchema(ImportForeignSchemaStmt *stmt,
 									 Oid serverOid);
+static void jdbcGetForeignJoinPaths(PlannerInfo *root,
+									RelOptInfo *joinrel,
+									RelOptInfo *outerrel,
+									RelOptInfo *innerrel,
+									JoinType jointype,
+									JoinPathExtraData *extra);
 static void jdbcGetForeignUpperPaths(PlannerInfo *root,
 									 UpperRelationKind stage,
 									 RelOptInfo *input_rel,
@@ -333,12 +522,77 @@ static void estimate_path_cost_size(PlannerInfo *root,
 									Cost *p_total_cost,
 									char *q_char);
 static void get_remote_estimate(const char *sql,
+								ForeignServer *server,
+								UserMapping *user,
 								JDBCUtilsInfo * jdbcUtilsInfo,
 								double *rows,
 								int *width,
 								Cost *startup_cost,
 								Cost *total_cost);
+static bool jdbc_parse_mysql_explain(const char *json, double *rows,
+									 Cost *total_cost);
+static const char *jdbc_find_json_member(const char *json, const char *name,
+										 bool last);
+static uint32 jdbc_estimate_key_hash(const void *key, Size keysize);
+static int	jdbc_estimate_key_match(const void *key1, const void *key2, Size keysize);
+static List *jdbc_add_param_path_info(PlannerInfo *root, RelOptInfo *baserel,
+									  RestrictInfo *rinfo, Bitmapset *key_attrs,
+									  List *ppi_list);
+static bool jdbc_ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel,
+										   EquivalenceClass *ec, EquivalenceMember *em,
+										   void *arg);
+static void jdbc_exec_param_query(ForeignScanState *node);
+static int	jdbcAcquireSampleRowsFunc(Relation relation, int elevel,
+									  HeapTuple *rows, int targrows,
+									  double *totalrows,
+									  double *totaldeadrows);
+static double jdbc_get_remote_number(JDBCUtilsInfo * jdbcUtilsInfo, const char *sql);
+static Datum jdbc_get_remote_value(JDBCUtilsInfo * jdbcUtilsInfo, const char *sql, Oid type,
+								   bool *isnull);
+static void jdbc_analyze_row(jdbcFdwAnalyzeState * astate, HeapTuple tuple);
+static void jdbc_reset_lookup_cache(jdbcFdwScanState * fsstate);
+static uint32 jdbc_lookup_key_hash(const void *key, Size keysize);
+static int	jdbc_lookup_key_match(const void *key1, const void *key2, Size keysize);
+static void jdbc_fetch_more_data(ForeignScanState *node);
+static jdbcFdwModifyState *jdbc_create_foreign_modify(EState *estate,
+													  ResultRelInfo *resultRelInfo,
+													  CmdType operation,
+													  Plan *subplan,
+													  Oid userid,
+													  List *target_attrs);
 static void jdbc_prepare_foreign_modify(jdbcFdwModifyState * fmstate);
+static void jdbc_check_returning_attrs(Relation rel, CmdType operation,
+									   List *retrieved_attrs, JdbcDialect dialect);
+static void jdbc_init_returning(jdbcFdwModifyState * fmstate,
+								bool has_returning, List *retrieved_attrs);
+static void jdbc_map_returning_columns(jdbcFdwModifyState * fmstate, int keysID);
+static TupleTableSlot *jdbc_store_returning(jdbcFdwModifyState * fmstate,
+											TupleTableSlot *slot);
+static void jdbc_add_batch_row(jdbcFdwModifyState * fmstate,
+							   TupleTableSlot *slot,
+							   TupleTableSlot *planSlot);
+static void jdbc_flush_foreign_insert(jdbcFdwModifyState * fmstate);
+static void jdbc_add_keyset(jdbcFdwModifyState * fmstate,
+							TupleTableSlot *slot,
+							TupleTableSlot *planSlot);
+static void jdbc_flush_keysets(jdbcFdwModifyState * fmstate);
+static ForeignScan *jdbc_find_modifytable_subplan(PlannerInfo *root,
+												  ModifyTable *plan,
+												  Index rtindex,
+												  int subplan_index);
+static int	jdbc_get_batch_size_option(Relation rel);
+static bool jdbc_get_bulk_load_option(Relation rel);
+static bool jdbc_get_async_write_option(Relation rel);
+static int	jdbc_get_key_batch_size_option(Relation rel);
+static List *jdbc_get_key_attrs(Relation rel);
+static OnConflictAction jdbc_get_on_conflict_action(ModifyTable *plan, Relation rel);
+static JdbcDialect jdbc_check_upsert(Relation rel, OnConflictAction onConflictAction,
+									 List *keyAttrs, ForeignServer *server,
+									 JDBCUtilsInfo * jdbcUtilsInfo);
+static bool jdbc_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel,
+								 JoinType jointype, RelOptInfo *outerrel,
+								 RelOptInfo *innerrel,
+								 JoinPathExtraData *extra);
 static bool jdbc_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel);
 static void jdbc_add_foreign_grouping_paths(PlannerInfo *root,
 											RelOptInfo *input_rel,
@@ -356,11 +610,13 @@ static void jdbc_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_re
 
 static void jdbc_execute_commands(List *cmd_list);
 
-static void jdbc_bind_junk_column_value(jdbcFdwModifyState * fmstate,
-										TupleTableSlot *slot,
-										TupleTableSlot *planSlot,
-										Oid foreignTableId,
-										int bindnum);
+static void jdbc_extract_modify_values(jdbcFdwModifyState * fmstate,
+									   TupleTableSlot *slot,
+									   TupleTableSlot *planSlot);
+static void jdbc_bind_modify_values(jdbcFdwModifyState * fmstate,
+									TupleTableSlot *slot,
+									TupleTableSlot *planSlot,
+									bool batch);
 
 static void prepTuplestoreResult(FunctionCallInfo fcinfo);
 static JDBCUtilsInfo *jdbc_get_conn_by_server_name(char *servername);
@@ -394,12 +650,28 @@ jdbc_fdw_handler(PG_FUNCTION_ARGS)
 	routine->ExecForeignInsert = jdbcExecForeignInsert;
 	routine->ExecForeignUpdate = jdbcExecForeignUpdate;
 	routine->ExecForeignDelete = jdbcExecForeignDelete;
+#if PG_VERSION_NUM >= 140000
+	routine->ExecForeignBatchInsert = jdbcExecForeignBatchInsert;
+	routine->GetForeignModifyBatchSize = jdbcGetForeignModifyBatchSize;
+#endif
 	routine->EndForeignModify = jdbcEndForeignModify;
+#if PG_VERSION_NUM >= 110000
+	routine->BeginForeignInsert = jdbcBeginForeignInsert;
+	routine->EndForeignInsert = jdbcEndForeignInsert;
+#endif
 	routine->IsForeignRelUpdatable = jdbcIsForeignRelUpdatable;
+	routine->PlanDirectModify = jdbcPlanDirectModify;
+	routine->BeginDirectModify = jdbcBeginDirectModify;
+	routine->IterateDirectModify = jdbcIterateDirectModify;
+	routine->EndDirectModify = jdbcEndDirectModify;
+#if PG_VERSION_NUM >= 140000
+	routine->ExecForeignTruncate = jdbcExecForeignTruncate;
+#endif
 
 	/* Support functions for EXPLAIN */
 	routine->ExplainForeignScan = jdbcExplainForeignScan;
 	routine->ExplainForeignModify = jdbcExplainForeignModify;
+	routine->ExplainDirectModify = jdbcExplainDirectModify;
 
 	/* Support functions for ANALYZE */
 	routine->AnalyzeForeignTable = jdbcAnalyzeForeignTable;
@@ -407,6 +679,9 @@ jdbc_fdw_handler(PG_FUNCTION_ARGS)
 	/* support for IMPORT FOREIGN SCHEMA */
 	routine->ImportForeignSchema = jdbcImportForeignSchema;
 
+	/* Support functions for join push-down */
+	routine->GetForeignJoinPaths = jdbcGetForeignJoinPaths;
+
 	/* Support functions for upper relation push-down */
 	routine->GetForeignUpperPaths = jdbcGetForeignUpperPaths;
 	PG_RETURN_POINTER(routine);
@@ -454,7 +729,7 @@ jdbc_exec(PG_FUNCTION_ARGS)
 		prepTuplestoreResult(fcinfo);
 
 		/* Execute sql query */
-		res = jq_exec_id(jdbcUtilsInfo, sql, &resultSetID);
+		res = jq_exec_id(jdbcUtilsInfo, sql, DEFAULT_FETCH_SIZE, &resultSetID);
 
 		if (*res != PGRES_COMMAND_OK)
 			jdbc_fdw_report_error(ERROR, res, jdbcUtilsInfo, false, sql);
@@ -623,12 +898,14 @@ jdbcGetForeignRelSize(PlannerInfo *root,
 	fpinfo->server = GetForeignServer(fpinfo->table->serverid);
 
 	/*
-	 * Extract user-settable option values.  Note that per-table setting of
-	 * use_remote_estimate overrides per-server setting.
+	 * Extract user-settable option values.  Note that per-table settings of
+	 * use_remote_estimate and fetch_size override per-server settings.
 	 */
 	fpinfo->use_remote_estimate = false;
 	fpinfo->fdw_startup_cost = DEFAULT_FDW_STARTUP_COST;
 	fpinfo->fdw_tuple_cost = DEFAULT_FDW_TUPLE_COST;
+	fpinfo->fetch_size = DEFAULT_FETCH_SIZE;
+	fpinfo->lookup_cache_size = 0;
 
 	foreach(lc, fpinfo->server->options)
 	{
@@ -642,6 +919,10 @@ jdbcGetForeignRelSize(PlannerInfo *root,
 		else if (strcmp(def->defname, "fdw_tuple_cost") == 0)
 			(void) parse_real(defGetString(def), &fpinfo->fdw_tuple_cost, 0,
 							  NULL);
+		else if (strcmp(def->defname, "fetch_size") == 0)
+			(void) parse_int(defGetString(def), &fpinfo->fetch_size, 0, NULL);
+		else if (strcmp(def->defname, "lookup_cache_size") == 0)
+			(void) parse_int(defGetString(def), &fpinfo->lookup_cache_size, 0, NULL);
 	}
 	foreach(lc, fpinfo->table->options)
 	{
@@ -649,6 +930,10 @@ jdbcGetForeignRelSize(PlannerInfo *root,
 
 		if (strcmp(def->defname, "use_remote_estimate") == 0)
 			fpinfo->use_remote_estimate = defGetBoolean(def);
+		else if (strcmp(def->defname, "fetch_size") == 0)
+			(void) parse_int(defGetString(def), &fpinfo->fetch_size, 0, NULL);
+		else if (strcmp(def->defname, "lookup_cache_size") == 0)
+			(void) parse_int(defGetString(def), &fpinfo->lookup_cache_size, 0, NULL);
 	}
 
 	/*
@@ -771,6 +1056,10 @@ jdbcGetForeignPaths(PlannerInfo *root,
 					Oid foreigntableid)
 {
 	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	Bitmapset  *key_attrs = NULL;
+	List	   *ppi_list;
+	ListCell   *lc;
+	JDBCUtilsInfo *jdbcUtilsInfo;
 
 	ereport(DEBUG3, (errmsg("In jdbcGetForeignPaths")));
 
@@ -796,7 +1085,242 @@ jdbcGetForeignPaths(PlannerInfo *root,
 									 NIL, /* no fdw_restrictinfo list */
 #endif
 									 NULL));	/* no fdw_private data */
-	return;
+
+	/*
+	 * Without remote estimates, we can only assume that the remote server
+	 * finds the rows matching a join clause quickly if the clause is on a
+	 * key column, which is indexed there.  Parameterized paths are only
+	 * built for such clauses then.
+	 */
+	if (!fpinfo->use_remote_estimate)
+	{
+		Relation	rel;
+		ListCell   *lc2;
+
+#if PG_VERSION_NUM < 130000
+		rel = heap_open(foreigntableid, NoLock);
+#else
+		rel = table_open(foreigntableid, NoLock);
+#endif
+		foreach(lc2, jdbc_get_key_attrs(rel))
+			key_attrs = bms_add_member(key_attrs,
+									   lfirst_int(lc2) - FirstLowInvalidHeapAttributeNumber);
+#if PG_VERSION_NUM < 130000
+		heap_close(rel, NoLock);
+#else
+		table_close(rel, NoLock);
+#endif
+
+		if (key_attrs == NULL)
+			return;
+	}
+
+	/*
+	 * Thumb through all join clauses for the rel to identify which outer
+	 * relations could supply one or more safe-to-send-to-remote join clauses.
+	 * We'll build a parameterized path for each such outer relation.
+	 *
+	 * It's convenient to manage this by representing each candidate outer
+	 * relation by the ParamPathInfo node for it.  We can then use the
+	 * ppi_clauses list in the ParamPathInfo node directly as a list of the
+	 * interesting join clauses for that rel.  This takes care of the
+	 * possibility that there are multiple safe join clauses for such a rel,
+	 * and also ensures that we account for unsafe join clauses that we'll
+	 * still have to enforce locally (since the parameterized-path machinery
+	 * insists that we handle all movable clauses).
+	 */
+	ppi_list = NIL;
+	foreach(lc, baserel->joininfo)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		ppi_list = jdbc_add_param_path_info(root, baserel, rinfo, key_attrs,
+											ppi_list);
+	}
+
+	/*
+	 * The above scan examined only "generic" join clauses, not those that
+	 * were absorbed into EquivalenceClauses.  See if we can make anything out
+	 * of EquivalenceClauses.
+	 */
+	if (baserel->has_eclass_joins)
+	{
+		/*
+		 * We repeatedly scan the eclass list looking for column references
+		 * (or expressions) belonging to the foreign rel.  Each time we find
+		 * one, we generate a list of equivalence joinclauses for it, and then
+		 * see if any are safe to send to the remote.  Repeat till there are
+		 * no more candidate EC members.
+		 */
+		ec_member_foreign_arg arg;
+
+		arg.already_used = NIL;
+		for (;;)
+		{
+			List	   *clauses;
+
+			/* Make clauses, skipping any that join to lateral_referencers */
+			arg.current = NULL;
+			clauses = generate_implied_equalities_for_column(root,
+															 baserel,
+															 jdbc_ec_member_matches_foreign,
+															 (void *) &arg,
+															 baserel->lateral_referencers);
+
+			/* Done if there are no more expressions in the foreign rel */
+			if (arg.current == NULL)
+			{
+				Assert(clauses == NIL);
+				break;
+			}
+
+			/* Scan the extracted join clauses */
+			foreach(lc, clauses)
+			{
+				RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+				ppi_list = jdbc_add_param_path_info(root, baserel, rinfo,
+													key_attrs, ppi_list);
+			}
+
+			/* Try again, now ignoring the expression we found this time */
+			arg.already_used = lappend(arg.already_used, arg.current);
+		}
+	}
+
+	if (ppi_list == NIL)
+		return;
+
+	/*
+	 * Now build a path for each useful outer relation.
+	 */
+	jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo->server, fpinfo->user, false);
+	foreach(lc, ppi_list)
+	{
+		ParamPathInfo *param_info = (ParamPathInfo *) lfirst(lc);
+		double		rows;
+		int			width;
+		Cost		startup_cost;
+		Cost		total_cost;
+
+		/* Get a cost estimate for a scan with the join clauses */
+		estimate_path_cost_size(root, baserel, param_info->ppi_clauses,
+								&rows, &width, &startup_cost, &total_cost,
+								jdbcUtilsInfo->q_char);
+
+		/*
+		 * ppi_rows currently won't get looked at by anything, but still we
+		 * may as well ensure that it matches our idea of the rowcount.
+		 */
+		param_info->ppi_rows = rows;
+
+		/* Make the path */
+		add_path(baserel, (Path *)
+				 create_foreignscan_path(root, baserel,
+#if PG_VERSION_NUM >= 90600
+										 NULL,	/* default pathtarget */
+#endif
+										 rows,
+										 startup_cost,
+										 total_cost,
+										 NIL,	/* no pathkeys */
+										 param_info->ppi_req_outer,
+										 NULL,	/* no extra plan */
+#if PG_VERSION_NUM >= 170000
+										 NIL,	/* no fdw_restrictinfo list */
+#endif
+										 NIL));	/* no fdw_private list */
+	}
+}
+
+/*
+ * jdbc_add_param_path_info
+ *		If the given join clause can be sent to the remote server in a scan of
+ *		baserel parameterized by the other relations of the clause, add the
+ *		ParamPathInfo for those relations to ppi_list, and return the list.
+ *		If key_attrs is not NULL, the clause must also reference one of the
+ *		key columns in it.
+ */
+static List *
+jdbc_add_param_path_info(PlannerInfo *root, RelOptInfo *baserel,
+						 RestrictInfo *rinfo, Bitmapset *key_attrs,
+						 List *ppi_list)
+{
+	Relids		required_outer;
+	ParamPathInfo *param_info;
+
+	/* Check if clause can be moved to this rel */
+	if (!join_clause_is_movable_to(rinfo, baserel))
+		return ppi_list;
+
+	/* See if it is safe to send to remote */
+	if (!jdbc_is_foreign_expr(root, baserel, rinfo->clause))
+		return ppi_list;
+
+	/* See if it can use a key column */
+	if (key_attrs != NULL)
+	{
+		Bitmapset  *attrs = NULL;
+
+		pull_varattnos((Node *) rinfo->clause, baserel->relid, &attrs);
+		if (!bms_overlap(attrs, key_attrs))
+			return ppi_list;
+	}
+
+	/* Calculate required outer rels for the resulting path */
+	required_outer = bms_union(rinfo->clause_relids,
+							   baserel->lateral_relids);
+	/* We do not want the foreign rel itself listed in required_outer */
+	required_outer = bms_del_member(required_outer, baserel->relid);
+
+	/*
+	 * required_outer probably can't be empty here, but if it were, we
+	 * couldn't make a parameterized path.
+	 */
+	if (bms_is_empty(required_outer))
+		return ppi_list;
+
+	/* Get the ParamPathInfo */
+	param_info = get_baserel_parampathinfo(root, baserel, required_outer);
+	Assert(param_info != NULL);
+
+	/*
+	 * Add it to list unless we already have it.  Testing pointer equality is
+	 * OK since get_baserel_parampathinfo won't make duplicates.
+	 */
+	return list_append_unique_ptr(ppi_list, param_info);
+}
+
+/*
+ * jdbc_ec_member_matches_foreign
+ *		Callback for generate_implied_equalities_for_column, which picks one
+ *		not yet processed expression of the foreign relation per call of
+ *		generate_implied_equalities_for_column.
+ */
+static bool
+jdbc_ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel,
+							   EquivalenceClass *ec, EquivalenceMember *em,
+							   void *arg)
+{
+	ec_member_foreign_arg *state = (ec_member_foreign_arg *) arg;
+	Expr	   *expr = em->em_expr;
+
+	/*
+	 * If we've identified what we're processing in the current scan, we only
+	 * want to match that expression.
+	 */
+	if (state->current != NULL)
+		return equal(expr, state->current);
+
+	/*
+	 * Otherwise, ignore anything we've already processed.
+	 */
+	if (list_member(state->already_used, expr))
+		return false;
+
+	/* This is the new target to process. */
+	state->current = expr;
+	return true;
 }
 
 /*
@@ -922,6 +1446,7 @@ jdbcGetForeignPlan(PlannerInfo *root,
 		 * Instead we get the conditions to apply from the fdw_private
 		 * structure.
 		 */
+		remote_conds = fpinfo->remote_conds;
 		remote_exprs = extract_actual_clauses(fpinfo->remote_conds, false);
 		local_exprs = extract_actual_clauses(fpinfo->local_conds, false);
 
@@ -1059,7 +1584,9 @@ jdbcGetForeignPlan(PlannerInfo *root,
 	 * Build the fdw_private list that will be available to the executor.
 	 * Items in the list must match enum FdwScanPrivateIndex, above.
 	 */
-	fdw_private = list_make3(makeString(sql.data), retrieved_attrs, makeInteger(for_update));
+	fdw_private = list_make4(makeString(sql.data), retrieved_attrs, makeInteger(for_update),
+							 makeInteger(fpinfo->fetch_size));
+	fdw_private = lappend(fdw_private, makeInteger(fpinfo->lookup_cache_size));
 
 	/* Uninstall error context callback. */
 	jdbc_remove_error_callback(errcallback);
@@ -1222,6 +1749,18 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 									 FdwScanPrivateSelectSql));
 	fsstate->retrieved_attrs = (List *) list_nth(fsplan->fdw_private,
 												 FdwScanPrivateRetrievedAttrs);
+	fsstate->fetch_size = intVal(list_nth(fsplan->fdw_private,
+										  FdwScanPrivateFetchSize));
+
+	/*
+	 * Rows of a parameterized scan are remembered per set of parameter
+	 * values, except for the rows of an UPDATE or DELETE target, which may
+	 * change during the scan.
+	 */
+	if (fsplan->fdw_exprs != NIL &&
+		!intVal(list_nth(fsplan->fdw_private, FdwScanPrivateForUpdate)))
+		fsstate->lookup_cache_size = intVal(list_nth(fsplan->fdw_private,
+													 FdwScanPrivateLookupCacheSize));
 
 	/*
 	 * Create contexts for batches of tuples and per-tuple temp workspace.
@@ -1233,6 +1772,10 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 	fsstate->temp_cxt = AllocSetContextCreate(estate->es_query_cxt,
 											  "jdbc_fdw temporary data",
 											  ALLOCSET_DEFAULT_SIZES);
+	if (fsstate->lookup_cache_size > 0)
+		fsstate->cache_cxt = AllocSetContextCreate(estate->es_query_cxt,
+												   "jdbc_fdw lookup cache",
+												   ALLOCSET_DEFAULT_SIZES);
 #else
 	fsstate->batch_cxt = AllocSetContextCreate(estate->es_query_cxt,
 											   "jdbc_fdw tuple data",
@@ -1244,6 +1787,12 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 											  ALLOCSET_SMALL_MINSIZE,
 											  ALLOCSET_SMALL_INITSIZE,
 											  ALLOCSET_SMALL_MAXSIZE);
+	if (fsstate->lookup_cache_size > 0)
+		fsstate->cache_cxt = AllocSetContextCreate(estate->es_query_cxt,
+												   "jdbc_fdw lookup cache",
+												   ALLOCSET_DEFAULT_MINSIZE,
+												   ALLOCSET_DEFAULT_INITSIZE,
+												   ALLOCSET_DEFAULT_MAXSIZE);
 #endif
 
 	/*
@@ -1263,21 +1812,25 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 
 	fsstate->attinmeta = TupleDescGetAttInMetadata(fsstate->tupdesc);
 
-	/* Prepare for output conversion of parameters used in remote query. */
+	/*
+	 * Prepare the buffer receiving batches of rows from the JVM, and the
+	 * conversion plan of the retrieved columns.
+	 */
+	jq_init_columnar_buffer(&fsstate->columnar_buffer, fsstate->tupdesc,
+							fsstate->retrieved_attrs);
+
+	/* Prepare for binding the parameters used in remote query. */
 	numParams = list_length(fsplan->fdw_exprs);
 	fsstate->numParams = numParams;
-	fsstate->param_flinfo = (FmgrInfo *) palloc0(sizeof(FmgrInfo) * numParams);
-
-	i = 0;
-	foreach(lc, fsplan->fdw_exprs)
+	if (numParams > 0)
 	{
-		Node	   *param_expr = (Node *) lfirst(lc);
-		Oid			typefnoid;
-		bool		isvarlena;
+		Oid		   *param_types = (Oid *) palloc0(sizeof(Oid) * numParams);
 
-		getTypeOutputInfo(exprType(param_expr), &typefnoid, &isvarlena);
-		fmgr_info(typefnoid, &fsstate->param_flinfo[i]);
-		i++;
+		i = 0;
+		foreach(lc, fsplan->fdw_exprs)
+			param_types[i++] = exprType((Node *) lfirst(lc));
+
+		jq_init_param_buffer(&fsstate->param_buffer, numParams, param_types);
 	}
 
 	/*
@@ -1296,13 +1849,16 @@ jdbcBeginForeignScan(ForeignScanState *node, int eflags)
 #endif
 
 	/*
-	 * Allocate buffer for text form of query parameters, if any.
+	 * A query with parameters is prepared once here, and executed with the
+	 * current parameter values by jdbcIterateForeignScan after each rescan.
+	 * Otherwise the query is executed right away.
 	 */
 	if (numParams > 0)
-		fsstate->param_values = (const char **) palloc0(numParams * sizeof(char *));
+		(void) jq_prepare_query(fsstate->jdbcUtilsInfo, fsstate->query,
+								fsstate->fetch_size, &fsstate->statementID);
 	else
-		fsstate->param_values = NULL;
-	(void) jq_exec_id(fsstate->jdbcUtilsInfo, fsstate->query, &fsstate->resultSetID);
+		(void) jq_exec_id(fsstate->jdbcUtilsInfo, fsstate->query, fsstate->fetch_size,
+						  &fsstate->resultSetID);
 
 	/* Uninstall error context callback. */
 	jdbc_remove_error_callback(errcallback);
@@ -1316,76 +1872,325 @@ static TupleTableSlot *
 jdbcIterateForeignScan(ForeignScanState *node)
 {
 	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
-	ErrorContextCallback *errcallback = jdbc_register_error_callback();
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+
+	ereport(DEBUG3, (errmsg("In jdbcIterateForeignScan")));
 
+	/*
+	 * If this is the first call after Begin or ReScan, execute the prepared
+	 * query with the current parameter values, if it has any.
+	 */
 	if (!fsstate->cursor_exists)
+	{
+		if (fsstate->numParams > 0)
+			jdbc_exec_param_query(node);
 		fsstate->cursor_exists = true;
-	ereport(DEBUG3, (errmsg("In jdbcIterateForeignScan")));
-	jq_iterate(fsstate->jdbcUtilsInfo, node, fsstate->retrieved_attrs, fsstate->resultSetID);
+	}
 
-	/* Uninstall error context callback. */
-	jdbc_remove_error_callback(errcallback);
+	/*
+	 * Get some more tuples, if we've run out.
+	 */
+	if (fsstate->next_tuple >= fsstate->num_tuples)
+	{
+		/* No point in another fetch if we already detected EOF, though. */
+		if (!fsstate->eof_reached)
+			jdbc_fetch_more_data(node);
+		/* If we didn't get any tuples, must be end of data. */
+		if (fsstate->next_tuple >= fsstate->num_tuples)
+			return ExecClearTuple(slot);
+	}
+
+	/*
+	 * Return the next tuple.
+	 */
+#if PG_VERSION_NUM >= 120000
+	ExecStoreHeapTuple(fsstate->tuples[fsstate->next_tuple++],
+					   slot,
+					   false);
+#else
+	ExecStoreTuple(fsstate->tuples[fsstate->next_tuple++],
+				   slot,
+				   InvalidBuffer,
+				   false);
+#endif
 
-	return node->ss.ss_ScanTupleSlot;
+	return slot;
 }
 
 /*
- * jdbcReScanForeignScan Restart the scan.
+ * jdbc_exec_param_query Bind the current values of the parameters of the
+ * scan to its prepared query and execute it.
  */
 static void
-jdbcReScanForeignScan(ForeignScanState *node)
+jdbc_exec_param_query(ForeignScanState *node)
 {
 	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
 	ErrorContextCallback *errcallback = jdbc_register_error_callback();
+	MemoryContext oldcontext;
+	Datum	   *values;
+	bool	   *isnull;
+	ListCell   *lc;
+	int			i;
+	jdbcLookupEntry *entry;
 
-	ereport(DEBUG3, (errmsg("In jdbcReScanForeignScan")));
+	/*
+	 * Evaluate the parameter values, and convert them for the JVM, in the
+	 * per-tuple context.
+	 */
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
 
-	if (!fsstate->cursor_exists || (!fsstate->resultSetID) > 0)
-		return;
+	values = (Datum *) palloc(sizeof(Datum) * fsstate->numParams);
+	isnull = (bool *) palloc(sizeof(bool) * fsstate->numParams);
+
+	i = 0;
+	foreach(lc, fsstate->param_exprs)
+	{
+		ExprState  *expr_state = (ExprState *) lfirst(lc);
+
+#if PG_VERSION_NUM >= 100000
+		values[i] = ExecEvalExpr(expr_state, econtext, &isnull[i]);
+#else
+		values[i] = ExecEvalExpr(expr_state, econtext, &isnull[i], NULL);
+#endif
+		i++;
+	}
+
+	jq_bind_row(fsstate->jdbcUtilsInfo, &fsstate->param_buffer, values, isnull,
+				fsstate->statementID);
+
+	MemoryContextSwitchTo(oldcontext);
 
-	(void) jq_exec_id(fsstate->jdbcUtilsInfo, fsstate->query, &fsstate->resultSetID);
+	/*
+	 * The bound values stay serialized in the parameter buffer, which
+	 * identifies them in the lookup cache.  If their rows are known already,
+	 * return them without a round trip to the remote server.
+	 */
+	if (fsstate->lookup_cache_size > 0)
+	{
+		jdbcLookupKey key;
+
+		if (fsstate->lookup_cache == NULL)
+			jdbc_reset_lookup_cache(fsstate);
+
+		key.data = fsstate->param_buffer.data.data;
+		key.len = fsstate->param_buffer.data.len;
+		entry = (jdbcLookupEntry *) hash_search(fsstate->lookup_cache, &key,
+												HASH_FIND, NULL);
+		if (entry != NULL)
+		{
+			fsstate->tuples = entry->tuples;
+			fsstate->num_tuples = entry->num_tuples;
+			fsstate->next_tuple = 0;
+			fsstate->eof_reached = true;
+			jdbc_remove_error_callback(errcallback);
+			return;
+		}
+	}
+
+	(void) jq_exec_prepared_query(fsstate->jdbcUtilsInfo, fsstate->statementID,
+								  &fsstate->resultSetID);
+
+	/*
+	 * Remember the rows if they all come with the first fetch, so that the
+	 * memory of the cache stays bounded by lookup_cache_size * fetch_size
+	 * rows.  The cache is simply emptied when it is full.
+	 */
+	if (fsstate->lookup_cache_size > 0)
+	{
+		jdbc_fetch_more_data(node);
+
+		if (fsstate->eof_reached)
+		{
+			jdbcLookupKey key;
+			bool		found;
+
+			if (hash_get_num_entries(fsstate->lookup_cache) >= fsstate->lookup_cache_size)
+				jdbc_reset_lookup_cache(fsstate);
+
+			key.data = fsstate->param_buffer.data.data;
+			key.len = fsstate->param_buffer.data.len;
+			entry = (jdbcLookupEntry *) hash_search(fsstate->lookup_cache, &key,
+													HASH_ENTER, &found);
+			Assert(!found);
+
+			oldcontext = MemoryContextSwitchTo(fsstate->cache_cxt);
+			entry->key.data = palloc(key.len);
+			memcpy(entry->key.data, key.data, key.len);
+			entry->num_tuples = fsstate->num_tuples;
+			entry->tuples = (HeapTuple *) palloc(Max(fsstate->num_tuples, 1) * sizeof(HeapTuple));
+			for (i = 0; i < fsstate->num_tuples; i++)
+				entry->tuples[i] = heap_copytuple(fsstate->tuples[i]);
+			MemoryContextSwitchTo(oldcontext);
+		}
+	}
 
 	/* Uninstall error context callback. */
 	jdbc_remove_error_callback(errcallback);
-
-	/* Now force a fresh FETCH. */
-	fsstate->tuples = NULL;
-	fsstate->num_tuples = 0;
-	fsstate->next_tuple = 0;
-	fsstate->fetch_ct_2 = 0;
-	fsstate->eof_reached = false;
 }
 
 /*
- * jdbcEndForeignScan Finish scanning foreign table and dispose objects used
- * for this scan
+ * jdbc_reset_lookup_cache Forget all rows of the lookup cache of a
+ * parameterized scan, and create an empty one.
  */
 static void
-jdbcEndForeignScan(ForeignScanState *node)
+jdbc_reset_lookup_cache(jdbcFdwScanState * fsstate)
 {
-	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
+	HASHCTL		ctl;
+
+	MemoryContextReset(fsstate->cache_cxt);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(jdbcLookupKey);
+	ctl.entrysize = sizeof(jdbcLookupEntry);
+	ctl.hash = jdbc_lookup_key_hash;
+	ctl.match = jdbc_lookup_key_match;
+	ctl.hcxt = fsstate->cache_cxt;
+	fsstate->lookup_cache = hash_create("jdbc_fdw lookup cache",
+										fsstate->lookup_cache_size,
+										&ctl,
+										HASH_ELEM | HASH_FUNCTION | HASH_COMPARE |
+										HASH_CONTEXT);
+}
 
-	ereport(DEBUG3, (errmsg("In jdbcEndForeignScan")));
+/*
+ * Hash and match functions of the lookup cache, comparing the serialized
+ * parameter values byte by byte.
+ */
+static uint32
+jdbc_lookup_key_hash(const void *key, Size keysize)
+{
+	const		jdbcLookupKey *k = (const jdbcLookupKey *) key;
 
-	/* if fsstate is NULL, we are in EXPLAIN; nothing to do */
-	if (fsstate == NULL)
-		return;
+	return DatumGetUInt32(hash_any((const unsigned char *) k->data, k->len));
+}
 
-	/* Release remote connection */
-	jdbc_release_jdbc_utils_obj();
+static int
+jdbc_lookup_key_match(const void *key1, const void *key2, Size keysize)
+{
+	const		jdbcLookupKey *k1 = (const jdbcLookupKey *) key1;
+	const		jdbcLookupKey *k2 = (const jdbcLookupKey *) key2;
 
-	fsstate->jdbcUtilsInfo = NULL;
-	/* MemoryContexts will be deleted automatically. */
+	if (k1->len != k2->len)
+		return 1;
+	return memcmp(k1->data, k2->data, k1->len);
 }
 
 /*
- * jdbcAddForeignUpdateTargets Add resjunk column(s) needed for update/delete
- * on a foreign table
+ * jdbc_fetch_more_data Fetch the next batch of rows from the remote result
+ * set into the scan state's tuple array.
  */
 static void
-jdbcAddForeignUpdateTargets(
-#if PG_VERSION_NUM >= 140000
-							PlannerInfo *root,
+jdbc_fetch_more_data(ForeignScanState *node)
+{
+	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
+	TupleDesc	tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	ErrorContextCallback *errcallback = jdbc_register_error_callback();
+	MemoryContext oldcontext;
+
+	/*
+	 * We'll store the tuples in the batch_cxt.  First, flush the previous
+	 * batch.
+	 */
+	fsstate->tuples = NULL;
+	MemoryContextReset(fsstate->batch_cxt);
+	oldcontext = MemoryContextSwitchTo(fsstate->batch_cxt);
+
+	fsstate->num_tuples = jq_iterate_batch(fsstate->jdbcUtilsInfo, tupdesc,
+										   &fsstate->columnar_buffer,
+										   fsstate->resultSetID,
+										   fsstate->fetch_size,
+										   &fsstate->tuples,
+										   &fsstate->eof_reached);
+	fsstate->next_tuple = 0;
+
+	/* Update fetch_ct_2 */
+	if (fsstate->fetch_ct_2 < 2)
+		fsstate->fetch_ct_2++;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
+}
+
+/*
+ * jdbcReScanForeignScan Restart the scan.
+ */
+static void
+jdbcReScanForeignScan(ForeignScanState *node)
+{
+	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
+	ErrorContextCallback *errcallback = jdbc_register_error_callback();
+
+	ereport(DEBUG3, (errmsg("In jdbcReScanForeignScan")));
+
+	if (!fsstate->cursor_exists)
+		return;
+
+	/*
+	 * Forget the rows not read yet, the JVM releases them once all are read.
+	 * There is no result set if the rows came from the lookup cache.
+	 */
+	if (fsstate->resultSetID != 0 && !fsstate->eof_reached)
+		jq_release_resultset_id(fsstate->jdbcUtilsInfo, fsstate->resultSetID);
+	fsstate->resultSetID = 0;
+
+	/*
+	 * The parameter values may have changed, so a prepared query is executed
+	 * again by the next jdbcIterateForeignScan, after binding them.
+	 */
+	if (fsstate->numParams > 0)
+		fsstate->cursor_exists = false;
+	else
+		(void) jq_exec_id(fsstate->jdbcUtilsInfo, fsstate->query, fsstate->fetch_size,
+						  &fsstate->resultSetID);
+
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
+
+	/* Now force a fresh FETCH. */
+	fsstate->tuples = NULL;
+	fsstate->num_tuples = 0;
+	fsstate->next_tuple = 0;
+	fsstate->fetch_ct_2 = 0;
+	fsstate->eof_reached = false;
+}
+
+/*
+ * jdbcEndForeignScan Finish scanning foreign table and dispose objects used
+ * for this scan
+ */
+static void
+jdbcEndForeignScan(ForeignScanState *node)
+{
+	jdbcFdwScanState *fsstate = (jdbcFdwScanState *) node->fdw_state;
+
+	ereport(DEBUG3, (errmsg("In jdbcEndForeignScan")));
+
+	/* if fsstate is NULL, we are in EXPLAIN; nothing to do */
+	if (fsstate == NULL)
+		return;
+
+	/* Release the prepared query, if any */
+	if (fsstate->statementID != 0)
+		jq_release_resultset_id(fsstate->jdbcUtilsInfo, fsstate->statementID);
+
+	/* Release remote connection */
+	jdbc_release_jdbc_utils_obj();
+
+	fsstate->jdbcUtilsInfo = NULL;
+	/* MemoryContexts will be deleted automatically. */
+}
+
+/*
+ * jdbcAddForeignUpdateTargets Add resjunk column(s) needed for update/delete
+ * on a foreign table
+ */
+static void
+jdbcAddForeignUpdateTargets(
+#if PG_VERSION_NUM >= 140000
+							PlannerInfo *root,
 							Index rtindex,
 #else
 							Query *parsetree,
@@ -1488,7 +2293,6 @@ jdbcPlanForeignModify(PlannerInfo *root,
 	Oid			foreignTableId;
 	List	   *condAttr = NULL;
 	TupleDesc	tupdesc;
-	int			i;
 	JDBCUtilsInfo	   *jdbcUtilsInfo;
 	ForeignTable *table;
 	ForeignServer *server;
@@ -1578,37 +2382,24 @@ jdbcPlanForeignModify(PlannerInfo *root,
 	}
 
 	/*
-	 * Extract the relevant RETURNING list if any. RETURNING clause is not
-	 * supported.
+	 * Extract the relevant RETURNING list if any.  The columns it uses are
+	 * read back through getGeneratedKeys.
 	 */
 	if (plan->returningLists)
-		ereport(ERROR,
-				(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
-				 errmsg("RETURNING clause is not supported")));
+	{
+		returningList = (List *) list_nth(plan->returningLists, subplan_index);
+		retrieved_attrs = jdbc_get_returning_attrs(resultRelation, rel, returningList);
+
+		if (retrieved_attrs != NIL)
+			jdbc_check_returning_attrs(rel, operation, retrieved_attrs,
+									   jdbc_get_dialect(server, jdbcUtilsInfo));
+	}
 
 	/*
 	 * Add all primary key attribute names to condAttr used in where clause of
-	 * update
+	 * update, and in the conflict condition of an upsert
 	 */
-	for (i = 0; i < tupdesc->natts; ++i)
-	{
-		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
-		AttrNumber	attrno = att->attnum;
-		List	   *options;
-		ListCell   *option;
-
-		/* look for the "key" option on this column */
-		options = GetForeignColumnOptions(foreignTableId, attrno);
-		foreach(option, options)
-		{
-			DefElem    *def = (DefElem *) lfirst(option);
-
-			if (IS_KEY_COLUMN(def))
-			{
-				condAttr = lappend_int(condAttr, attrno);
-			}
-		}
-	}
+	condAttr = jdbc_get_key_attrs(rel);
 
 	/*
 	 * Construct the SQL command string.
@@ -1616,17 +2407,26 @@ jdbcPlanForeignModify(PlannerInfo *root,
 	switch (operation)
 	{
 		case CMD_INSERT:
-			jdbc_deparse_insert_sql(&sql, root, resultRelation, rel,
-									targetAttrs, returningList,
-									&retrieved_attrs, jdbcUtilsInfo->q_char);
-			break;
+			{
+				OnConflictAction onConflictAction = jdbc_get_on_conflict_action(plan, rel);
+				JdbcDialect dialect = jdbc_check_upsert(rel, onConflictAction,
+														condAttr, server,
+														jdbcUtilsInfo);
+
+				jdbc_deparse_insert_sql(&sql, root, resultRelation, rel,
+										targetAttrs, returningList,
+										&retrieved_attrs, onConflictAction,
+										condAttr, dialect, jdbcUtilsInfo->q_char);
+				break;
+			}
 		case CMD_UPDATE:
 			jdbc_deparse_update_sql(&sql, root, resultRelation, rel,
-									targetAttrs, condAttr, jdbcUtilsInfo->q_char);
+									targetAttrs, condAttr, 1,
+									jdbcUtilsInfo->q_char);
 			break;
 		case CMD_DELETE:
 			jdbc_deparse_delete_sql(&sql, root, resultRelation, rel,
-									condAttr, jdbcUtilsInfo->q_char);
+									condAttr, 1, jdbcUtilsInfo->q_char);
 			break;
 		default:
 			elog(ERROR, "unexpected operation: %d", (int) operation);
@@ -1645,8 +2445,10 @@ jdbcPlanForeignModify(PlannerInfo *root,
 	 * Build the fdw_private list that will be available to the executor.
 	 * Items in the list must match enum FdwModifyPrivateIndex, above.
 	 */
-	return list_make2(makeString(sql.data),
-					  targetAttrs);
+	return list_make4(makeString(sql.data),
+					  targetAttrs,
+					  makeInteger((retrieved_attrs != NIL)),
+					  retrieved_attrs);
 }
 
 /*
@@ -1662,20 +2464,10 @@ jdbcBeginForeignModify(ModifyTableState *mtstate,
 {
 	jdbcFdwModifyState *fmstate;
 	EState	   *estate = mtstate->ps.state;
-	Relation	rel = resultRelInfo->ri_RelationDesc;
-	AttrNumber	n_params;
-	Oid			typefnoid = InvalidOid;
-	bool		isvarlena = false;
-	ListCell   *lc;
 #if PG_VERSION_NUM < 160000
 	RangeTblEntry *rte;
 #endif
 	Oid			userid;
-	ForeignServer *server;
-	UserMapping *user;
-	ForeignTable *table;
-	Oid			foreignTableId = InvalidOid;
-	int			i;
 	Plan	   *subplan;
 	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
@@ -1700,82 +2492,42 @@ jdbcBeginForeignModify(ModifyTableState *mtstate,
 	userid = ExecGetResultRelCheckAsUser(resultRelInfo, estate);
 #endif
 
-	foreignTableId = RelationGetRelid(rel);
 #if (PG_VERSION_NUM >= 140000)
 	subplan = outerPlanState(mtstate)->plan;
 #else
 	subplan = mtstate->mt_plans[subplan_index]->plan;
 #endif
 
-	/* Get info about foreign table. */
-	table = GetForeignTable(foreignTableId);
-	server = GetForeignServer(table->serverid);
-	user = GetUserMapping(userid, server->serverid);
-
-	/* Begin constructing jdbcFdwModifyState. */
-	fmstate = (jdbcFdwModifyState *) palloc0(sizeof(jdbcFdwModifyState));
-	fmstate->rel = rel;
-
-	/* Open connection; report that we'll create a prepared statement. */
-	fmstate->jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(server, user, true);
-	fmstate->is_prepared = false;	/* prepared statement not made yet */
-
-	/* Deconstruct fdw_private data. */
+	/* Construct an execution state from fdw_private data. */
+	fmstate = jdbc_create_foreign_modify(estate, resultRelInfo,
+										 mtstate->operation, subplan, userid,
+										 (List *) list_nth(fdw_private,
+														   FdwModifyPrivateTargetAttnums));
 	fmstate->query = strVal(list_nth(fdw_private,
 									 FdwModifyPrivateUpdateSql));
-	fmstate->target_attrs = (List *) list_nth(fdw_private,
-											  FdwModifyPrivateTargetAttnums);
-	/* Create context for per-tuple temp workspace. */
-#if PG_VERSION_NUM >= 110000
-	fmstate->temp_cxt = AllocSetContextCreate(estate->es_query_cxt,
-											  "jdbc_fdw temporary data",
-											  ALLOCSET_DEFAULT_SIZES);
-#else
-	fmstate->temp_cxt = AllocSetContextCreate(estate->es_query_cxt,
-											  "jdbc_fdw temporary data",
-											  ALLOCSET_SMALL_MINSIZE,
-											  ALLOCSET_SMALL_INITSIZE,
-											  ALLOCSET_SMALL_MAXSIZE);
-#endif
-
-	/* Prepare for output conversion of parameters used in prepared stmt. */
-	n_params = list_length(fmstate->target_attrs) + 1;
-	fmstate->p_flinfo = (FmgrInfo *) palloc0(sizeof(FmgrInfo) * n_params);
-	fmstate->p_nums = 0;
+	jdbc_init_returning(fmstate,
+						intVal(list_nth(fdw_private,
+										FdwModifyPrivateHasReturning)),
+						(List *) list_nth(fdw_private,
+										  FdwModifyPrivateRetrievedAttrs));
 
-	/* Set up for remaining transmittable parameters */
-	foreach(lc, fmstate->target_attrs)
+	/*
+	 * An upsert is sent as a statement, never through the bulk path.  The
+	 * number of rows ON CONFLICT DO NOTHING inserted is only known once its
+	 * batch is done, so it is not handed to the writer thread.
+	 */
+	if (mtstate->operation == CMD_INSERT)
 	{
-		int			attnum = lfirst_int(lc);
-		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), attnum - 1);
-
-		Assert(!attr->attisdropped);
-
-		getTypeOutputInfo(attr->atttypid, &typefnoid, &isvarlena);
-		fmgr_info(typefnoid, &fmstate->p_flinfo[fmstate->p_nums]);
-		fmstate->p_nums++;
+		fmstate->on_conflict = jdbc_get_on_conflict_action((ModifyTable *) mtstate->ps.plan,
+														   fmstate->rel);
+		if (fmstate->on_conflict != ONCONFLICT_NONE)
+			fmstate->bulk_load = false;
+		if (fmstate->on_conflict == ONCONFLICT_NOTHING)
+			fmstate->async_write = false;
 	}
-	Assert(fmstate->p_nums <= n_params);
 
 	resultRelInfo->ri_FdwState = fmstate;
 
-	fmstate->junk_idx = palloc0(RelationGetDescr(rel)->natts * sizeof(AttrNumber));
-	/* loop through table columns */
-	for (i = 0; i < RelationGetDescr(rel)->natts; ++i)
-	{
-		/*
-		 * for primary key columns, get the resjunk attribute number and store
-		 * it
-		 */
-		fmstate->junk_idx[i] =
-			ExecFindJunkAttributeInTlist(subplan->targetlist,
-										 get_attname(foreignTableId, i + 1
-#if (PG_VERSION_NUM >= 110000)
-													 ,false
-#endif
-													 ));
-	}
-
 	/* Uninstall error context callback. */
 	jdbc_remove_error_callback(errcallback);
 }
@@ -1791,30 +2543,35 @@ jdbcExecForeignInsert(EState *estate,
 {
 	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
 	Jresult    *res;
-	int			bindnum = 0;
-	ListCell   *lc;
-	Datum		value = 0;
 	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
 	ereport(DEBUG3, (errmsg("In jdbcExecForeignInsert")));
 
+	/*
+	 * Rows routed into the table by COPY or by tuple routing arrive here one
+	 * at a time when the core code does not batch them itself.  Collect them
+	 * into a batch, and send it once it is full.
+	 */
+	if (fmstate->defer_batch)
+	{
+		jdbc_add_batch_row(fmstate, slot, planSlot);
+		if (fmstate->num_pending >= fmstate->batch_size)
+			jdbc_flush_foreign_insert(fmstate);
+
+		MemoryContextReset(fmstate->temp_cxt);
+
+		/* Uninstall error context callback. */
+		jdbc_remove_error_callback(errcallback);
+		return slot;
+	}
+
 	/*
 	 * Set up the prepared statement on the remote server, if we didn't yet
 	 */
 	if (!fmstate->is_prepared)
 		jdbc_prepare_foreign_modify(fmstate);
 
-	/* Bind the value with jq_bind_sql_var. */
-	foreach(lc, fmstate->target_attrs)
-	{
-		int			attnum = lfirst_int(lc) - 1;
-		Oid			type = TupleDescAttr(slot->tts_tupleDescriptor, attnum)->atttypid;
-		bool		isnull;
-
-		value = slot_getattr(slot, attnum + 1, &isnull);
-		jq_bind_sql_var(fmstate->jdbcUtilsInfo, type, bindnum, value, &isnull, fmstate->resultSetID);
-		bindnum++;
-	}
+	jdbc_bind_modify_values(fmstate, slot, planSlot, false);
 
 	/*
 	 * Execute the prepared statement, and check for success.
@@ -1827,17 +2584,144 @@ jdbcExecForeignInsert(EState *estate,
 						   NULL,
 						   0,
 						   fmstate->resultSetID);
-	if (*res !=
-		(fmstate->has_returning ? PGRES_TUPLES_OK : PGRES_COMMAND_OK))
+	if (*res != PGRES_COMMAND_OK)
 		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
 
 	jq_clear(res);
 
+	/*
+	 * Return NULL if the row was skipped by ON CONFLICT DO NOTHING, and
+	 * otherwise the row returned by the remote server for RETURNING, if any
+	 */
+	if (fmstate->on_conflict == ONCONFLICT_NOTHING &&
+		jq_get_affected_rows(fmstate->jdbcUtilsInfo, fmstate->resultSetID) == 0)
+		slot = NULL;
+	else if (fmstate->has_returning)
+		slot = jdbc_store_returning(fmstate, slot);
+
+	MemoryContextReset(fmstate->temp_cxt);
+
 	/* Uninstall error context callback. */
 	jdbc_remove_error_callback(errcallback);
+
 	return slot;
 }
 
+#if PG_VERSION_NUM >= 140000
+/*
+ * jdbcExecForeignBatchInsert Insert multiple rows into a foreign table
+ *
+ * Each row is added to the batch, and the whole batch is sent to the remote
+ * server at once, see jdbc_add_batch_row.  For ON CONFLICT DO NOTHING,
+ * *numSlots is set to the number of rows inserted, summed from the update
+ * counts of the batch.
+ */
+static TupleTableSlot **
+jdbcExecForeignBatchInsert(EState *estate,
+						   ResultRelInfo *resultRelInfo,
+						   TupleTableSlot **slots,
+						   TupleTableSlot **planSlots,
+						   int *numSlots)
+{
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
+	int			i;
+	ErrorContextCallback *errcallback = jdbc_register_error_callback();
+
+	ereport(DEBUG3, (errmsg("In jdbcExecForeignBatchInsert")));
+
+	/*
+	 * The driver did not report the update counts of an earlier batch, so
+	 * send the rows one at a time to learn which ones were skipped.
+	 */
+	if (fmstate->batch_no_info)
+	{
+		int			num_inserted = 0;
+
+		for (i = 0; i < *numSlots; i++)
+		{
+			if (jdbcExecForeignInsert(estate, resultRelInfo,
+									  slots[i], planSlots[i]) != NULL)
+				slots[num_inserted++] = slots[i];
+		}
+		*numSlots = num_inserted;
+
+		/* Uninstall error context callback. */
+		jdbc_remove_error_callback(errcallback);
+		return slots;
+	}
+
+	for (i = 0; i < *numSlots; i++)
+		jdbc_add_batch_row(fmstate, slots[i], planSlots[i]);
+
+	/* Execute the batch, and check for success. */
+	jdbc_flush_foreign_insert(fmstate);
+
+	/*
+	 * Only the number of rows ON CONFLICT DO NOTHING inserted is needed,
+	 * there is neither RETURNING nor a row trigger when rows are batched.
+	 * If the driver reported SUCCESS_NO_INFO, all rows of this batch are
+	 * counted as inserted.
+	 */
+	if (fmstate->on_conflict == ONCONFLICT_NOTHING)
+	{
+		int			num_inserted = jq_get_affected_rows(fmstate->jdbcUtilsInfo,
+														fmstate->resultSetID);
+
+		if (num_inserted >= 0)
+			*numSlots = Min(num_inserted, *numSlots);
+		else
+			fmstate->batch_no_info = true;
+	}
+
+	MemoryContextReset(fmstate->temp_cxt);
+
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
+	return slots;
+}
+
+/*
+ * jdbcGetForeignModifyBatchSize Determine the maximum number of tuples that
+ * can be inserted in bulk
+ *
+ * Returns the batch size specified for server or table. When batching is not
+ * allowed (e.g. for tables with BEFORE/AFTER ROW triggers or with RETURNING
+ * clause), returns 1.
+ */
+static int
+jdbcGetForeignModifyBatchSize(ResultRelInfo *resultRelInfo)
+{
+	int			batch_size;
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
+
+	ereport(DEBUG3, (errmsg("In jdbcGetForeignModifyBatchSize")));
+
+	/* should be called only once */
+	Assert(resultRelInfo->ri_BatchSize == 0);
+
+	/*
+	 * Use the batch size stored in fmstate, if any.  Otherwise look at the
+	 * foreign server/table options.
+	 */
+	if (fmstate)
+		batch_size = fmstate->batch_size;
+	else
+		batch_size = jdbc_get_batch_size_option(resultRelInfo->ri_RelationDesc);
+
+	/*
+	 * Disable batching when we have to use RETURNING or there are any
+	 * BEFORE/AFTER ROW INSERT triggers on the foreign table.
+	 */
+	if (resultRelInfo->ri_projectReturning != NULL ||
+		(resultRelInfo->ri_TrigDesc &&
+		 (resultRelInfo->ri_TrigDesc->trig_insert_before_row ||
+		  resultRelInfo->ri_TrigDesc->trig_insert_after_row)))
+		return 1;
+
+	return batch_size;
+}
+#endif
+
 /*
  * jdbcExecForeignUpdate Update one row in a foreign table
  */
@@ -1849,36 +2733,19 @@ jdbcExecForeignUpdate(EState *estate,
 {
 	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
 	Jresult    *res;
-	Relation	rel = resultRelInfo->ri_RelationDesc;
-	Oid			foreignTableId = RelationGetRelid(rel);
-	ListCell   *lc = NULL;
-	int			bindnum = 0;
-	int			i = 0;
 	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
 	ereport(DEBUG3, (errmsg("In jdbcExecForeignUpdate")));
 
 	/*
-	 * Set up the prepared statement on the remote server, if we didn't yet
+	 * Collect the keys of the row, they are sent together with the keys of
+	 * other rows getting the same new values
 	 */
-	if (!fmstate->is_prepared)
-		jdbc_prepare_foreign_modify(fmstate);
-
-	/* Bind the values */
-	foreach(lc, fmstate->target_attrs)
+	if (fmstate->key_batch_size > 1)
 	{
-		int			attnum = lfirst_int(lc);
-		Oid			type;
-		bool		is_null;
-		Datum		value = 0;
-
-		/* first attribute cannot be in target list attribute */
-		type = TupleDescAttr(slot->tts_tupleDescriptor, attnum - 1)->atttypid;
-
-		value = slot_getattr(slot, attnum, &is_null);
-		jq_bind_sql_var(fmstate->jdbcUtilsInfo, type, bindnum, value, &is_null, fmstate->resultSetID);
-		bindnum++;
-		i++;
+		jdbc_add_keyset(fmstate, slot, planSlot);
+		jdbc_remove_error_callback(errcallback);
+		return slot;
 	}
 
 	/*
@@ -1887,7 +2754,8 @@ jdbcExecForeignUpdate(EState *estate,
 	if (!fmstate->is_prepared)
 		jdbc_prepare_foreign_modify(fmstate);
 
-	jdbc_bind_junk_column_value(fmstate, slot, planSlot, foreignTableId, bindnum);
+	/* Bind the new values and the key columns */
+	jdbc_bind_modify_values(fmstate, slot, planSlot, false);
 
 	/*
 	 * Execute the prepared statement, and check for success.
@@ -1900,13 +2768,16 @@ jdbcExecForeignUpdate(EState *estate,
 						   NULL,
 						   0,
 						   fmstate->resultSetID);
-	if (*res !=
-		(fmstate->has_returning ? PGRES_TUPLES_OK : PGRES_COMMAND_OK))
+	if (*res != PGRES_COMMAND_OK)
 		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
 
 	/* And clean up */
 	jq_clear(res);
 
+	/* Get the row returned by the remote server for RETURNING, if any */
+	if (fmstate->has_returning)
+		slot = jdbc_store_returning(fmstate, slot);
+
 	MemoryContextReset(fmstate->temp_cxt);
 
 	/* Uninstall error context callback. */
@@ -1925,20 +2796,27 @@ jdbcExecForeignDelete(EState *estate,
 					  TupleTableSlot *planSlot)
 {
 	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
-	Relation	rel = resultRelInfo->ri_RelationDesc;
-	Oid			foreignTableId = RelationGetRelid(rel);
 	Jresult    *res;
 	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
 	ereport(DEBUG3, (errmsg("In jdbcExecForeignDelete")));
 
+	/* Collect the keys of the row, they are sent together with others */
+	if (fmstate->key_batch_size > 1)
+	{
+		jdbc_add_keyset(fmstate, slot, planSlot);
+		jdbc_remove_error_callback(errcallback);
+		return slot;
+	}
+
 	/*
 	 * Set up the prepared statement on the remote server, if we didn't yet
 	 */
 	if (!fmstate->is_prepared)
 		jdbc_prepare_foreign_modify(fmstate);
 
-	jdbc_bind_junk_column_value(fmstate, slot, planSlot, foreignTableId, 0);
+	/* Bind the key columns */
+	jdbc_bind_modify_values(fmstate, slot, planSlot, false);
 
 	/*
 	 * Execute the prepared statement, and check for success.
@@ -1951,13 +2829,16 @@ jdbcExecForeignDelete(EState *estate,
 						   NULL,
 						   0,
 						   fmstate->resultSetID);
-	if (*res !=
-		(fmstate->has_returning ? PGRES_TUPLES_OK : PGRES_COMMAND_OK))
+	if (*res != PGRES_COMMAND_OK)
 		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
 
 	/* And clean up */
 	jq_clear(res);
 
+	/* Get the row returned by the remote server for RETURNING, if any */
+	if (fmstate->has_returning)
+		slot = jdbc_store_returning(fmstate, slot);
+
 	MemoryContextReset(fmstate->temp_cxt);
 
 	/* Uninstall error context callback. */
@@ -1967,50 +2848,6 @@ jdbcExecForeignDelete(EState *estate,
 	return slot;
 }
 
-static void
-jdbc_bind_junk_column_value(jdbcFdwModifyState * fmstate,
-							TupleTableSlot *slot,
-							TupleTableSlot *planSlot,
-							Oid foreignTableId,
-							int bindnum)
-{
-	int			i;
-	Datum		value;
-	Oid			typeoid;
-
-	/* Bind where condition using junk column */
-	for (i = 0; i < slot->tts_tupleDescriptor->natts; ++i)
-	{
-		Form_pg_attribute att = TupleDescAttr(slot->tts_tupleDescriptor, i);
-		AttrNumber	attrno = att->attnum;
-		List	   *options;
-		ListCell   *option;
-
-		/* look for the "key" option on this column */
-		if (fmstate->junk_idx[i] == InvalidAttrNumber)
-			continue;
-		options = GetForeignColumnOptions(foreignTableId, attrno);
-		foreach(option, options)
-		{
-			DefElem    *def = (DefElem *) lfirst(option);
-			bool		is_null = false;
-
-			if (IS_KEY_COLUMN(def))
-			{
-				/*
-				 * Get the id that was passed up as a resjunk column
-				 */
-				value = ExecGetJunkAttribute(planSlot, fmstate->junk_idx[i], &is_null);
-				typeoid = att->atttypid;
-
-				/* Bind qual */
-				jq_bind_sql_var(fmstate->jdbcUtilsInfo, typeoid, bindnum, value, &is_null, fmstate->resultSetID);
-				bindnum++;
-			}
-		}
-	}
-}
-
 /*
  * jdbcEndForeignModify Finish an insert/update/delete operation on a foreign
  * table
@@ -2025,1062 +2862,3785 @@ jdbcEndForeignModify(EState *estate,
 	/* If fmstate is NULL, we are in EXPLAIN; nothing to do */
 	if (fmstate == NULL)
 		return;
+	/* Send the key sets still collected, and release their statement */
+	if (fmstate->key_batch_size > 1)
+	{
+		ErrorContextCallback *errcallback = jdbc_register_error_callback();
+
+		jdbc_flush_keysets(fmstate);
+		jdbc_remove_error_callback(errcallback);
+		if (fmstate->keysetID != 0)
+		{
+			jq_release_resultset_id(fmstate->jdbcUtilsInfo, fmstate->keysetID);
+			fmstate->keysetID = 0;
+		}
+	}
+
 	/* If we created a prepared statement, destroy it */
 	if (fmstate->is_prepared)
 	{
 		fmstate->is_prepared = false;
 	}
 
+	/* Release the bulk loader, if any */
+	if (fmstate->bulkLoadID != 0)
+	{
+		jq_release_resultset_id(fmstate->jdbcUtilsInfo, fmstate->bulkLoadID);
+		fmstate->bulkLoadID = 0;
+	}
+
+	/*
+	 * Wait for the batches still executed by the writer thread, since the
+	 * statements of the connection are closed below.  An error of one of
+	 * them is reported here.
+	 */
+	if (fmstate->async_write)
+	{
+		ErrorContextCallback *errcallback = jdbc_register_error_callback();
+
+		jq_wait_async_writes(fmstate->jdbcUtilsInfo);
+		jdbc_remove_error_callback(errcallback);
+	}
+
 	/* Release remote connection */
 	jdbc_release_jdbc_utils_obj();
 	fmstate->jdbcUtilsInfo = NULL;
 }
 
+#if PG_VERSION_NUM >= 110000
 /*
- * jdbcIsForeignRelUpdatable Determine whether a foreign table supports
- * INSERT, UPDATE and/or DELETE.
+ * jdbcBeginForeignInsert Begin an insert operation on a foreign table
+ *
+ * Called when rows are inserted into the foreign table by COPY FROM, or when
+ * it is a partition that tuples are routed into.  There is no plan for the
+ * table in those cases, so the INSERT statement is built here.
  */
-static int
-jdbcIsForeignRelUpdatable(Relation rel)
+static void
+jdbcBeginForeignInsert(ModifyTableState *mtstate,
+					   ResultRelInfo *resultRelInfo)
 {
-	bool		updatable;
-	ForeignTable *table;
-	ForeignServer *server;
-	ListCell   *lc;
+	jdbcFdwModifyState *fmstate;
+	ModifyTable *plan = castNode(ModifyTable, mtstate->ps.plan);
+	EState	   *estate = mtstate->ps.state;
+	Relation	rel = resultRelInfo->ri_RelationDesc;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+#if PG_VERSION_NUM < 160000
+	RangeTblEntry *rte;
+	Index		rtindex;
+#endif
+	Oid			userid;
+	int			attnum;
+	StringInfoData sql;
+	List	   *targetAttrs = NIL;
+	List	   *retrieved_attrs = NIL;
+	JdbcDialect dialect;
+	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
-	ereport(DEBUG3, (errmsg("In jdbcIsForeignRelUpdatable")));
+	ereport(DEBUG3, (errmsg("In jdbcBeginForeignInsert")));
 
 	/*
-	 * By default, all jdbc_fdw foreign tables are assumed updatable. This can
-	 * be overridden by a per-server setting, which in turn can be overridden
-	 * by a per-table setting.
+	 * If the foreign table we are about to insert routed rows into is also an
+	 * UPDATE subplan result rel that will be updated later, proceeding with
+	 * the INSERT will result in the later UPDATE incorrectly modifying those
+	 * routed rows, so prevent the INSERT --- it would be nice if we could
+	 * handle this case; but for now, throw an error for safety.
 	 */
-	updatable = true;
+	if (plan && plan->operation == CMD_UPDATE &&
+		(resultRelInfo->ri_usesFdwDirectModify ||
+		 resultRelInfo->ri_FdwState)
+#if PG_VERSION_NUM < 140000
+		&& resultRelInfo > mtstate->resultRelInfo + mtstate->mt_whichplan
+#endif
+		)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot route tuples into foreign table to be updated \"%s\"",
+						RelationGetRelationName(rel))));
 
-	table = GetForeignTable(RelationGetRelid(rel));
-	server = GetForeignServer(table->serverid);
+#if PG_VERSION_NUM < 160000
+	/*
+	 * Identify which user to do the remote access as.  A partition created
+	 * for tuple routing has no RTE of its own; use the one of the table the
+	 * rows were inserted into.
+	 */
+	rtindex = resultRelInfo->ri_RangeTableIndex;
+#if PG_VERSION_NUM >= 140000
+	if (rtindex == 0)
+		rtindex = resultRelInfo->ri_RootResultRelInfo->ri_RangeTableIndex;
+#endif
+	rte = rt_fetch(rtindex, estate->es_range_table);
+	userid = rte->checkAsUser ? rte->checkAsUser : GetUserId();
+#else
+	/* Identify which user to do the remote access as. */
+	userid = ExecGetResultRelCheckAsUser(resultRelInfo, estate);
+#endif
 
-	foreach(lc, server->options)
+	/* We transmit all columns that are defined in the foreign table. */
+	for (attnum = 1; attnum <= tupdesc->natts; attnum++)
 	{
-		DefElem    *def = (DefElem *) lfirst(lc);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
 
-		if (strcmp(def->defname, "updatable") == 0)
-			updatable = defGetBoolean(def);
+		if (!attr->attisdropped)
+			targetAttrs = lappend_int(targetAttrs, attnum);
 	}
-	foreach(lc, table->options)
-	{
-		DefElem    *def = (DefElem *) lfirst(lc);
 
-		if (strcmp(def->defname, "updatable") == 0)
-			updatable = defGetBoolean(def);
+	/* Construct an execution state. */
+	fmstate = jdbc_create_foreign_modify(estate, resultRelInfo, CMD_INSERT,
+										 NULL, userid, targetAttrs);
+
+	/*
+	 * Construct the SQL command string.  An upsert is sent as a statement,
+	 * never through the bulk path, and ON CONFLICT DO NOTHING does not use
+	 * the writer thread, as in jdbcBeginForeignModify.
+	 */
+	fmstate->on_conflict = jdbc_get_on_conflict_action(plan, rel);
+	if (fmstate->on_conflict != ONCONFLICT_NONE)
+	{
+		ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+		List	   *keyAttrs = jdbc_get_key_attrs(rel);
+
+		fmstate->bulk_load = false;
+		if (fmstate->on_conflict == ONCONFLICT_NOTHING)
+			fmstate->async_write = false;
+		dialect = jdbc_check_upsert(rel, fmstate->on_conflict, keyAttrs,
+									GetForeignServer(table->serverid),
+									fmstate->jdbcUtilsInfo);
+		initStringInfo(&sql);
+		jdbc_deparse_insert_sql(&sql, NULL, 0, rel, targetAttrs, NIL,
+								&retrieved_attrs, fmstate->on_conflict,
+								keyAttrs, dialect, fmstate->jdbcUtilsInfo->q_char);
+	}
+	else
+	{
+		initStringInfo(&sql);
+		jdbc_deparse_insert_sql(&sql, NULL, 0, rel, targetAttrs, NIL,
+								&retrieved_attrs, ONCONFLICT_NONE, NIL,
+								JDBC_DIALECT_STANDARD, fmstate->jdbcUtilsInfo->q_char);
 	}
+	fmstate->query = sql.data;
 
 	/*
-	 * Currently "updatable" means support for INSERT, UPDATE and DELETE.
+	 * Rows routed into the table by an INSERT or UPDATE with RETURNING have
+	 * its columns read back.  The Vars of the RETURNING list refer to the
+	 * range table entry of the table the rows were given to, or for an
+	 * UPDATE to the first of its result relations.
 	 */
-	return updatable ?
-		(1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE) : 0;
-}
+	if (resultRelInfo->ri_returningList)
+	{
+#if PG_VERSION_NUM >= 140000
+		ResultRelInfo *rootResultRelInfo = resultRelInfo->ri_RootResultRelInfo;
+		Index		resultRelation = resultRelInfo->ri_RangeTableIndex;
 
-/*
- * jdbcExplainForeignScan Produce extra output for EXPLAIN of a ForeignScan
- * on a foreign table
- */
-static void
-jdbcExplainForeignScan(ForeignScanState *node, ExplainState *es)
-{
-	List	   *fdw_private;
-	char	   *sql;
+		if (resultRelation == 0)
+		{
+			if (plan && plan->operation == CMD_UPDATE &&
+				rootResultRelInfo->ri_RangeTableIndex == plan->rootRelation)
+				resultRelation = mtstate->resultRelInfo[0].ri_RangeTableIndex;
+			else
+				resultRelation = rootResultRelInfo->ri_RangeTableIndex;
+		}
+#else
+		Index		resultRelation = resultRelInfo->ri_RangeTableIndex;
 
-	ereport(DEBUG3, (errmsg("In jdbcExplainForeignScan")));
-	if (es->verbose)
-	{
-		fdw_private = ((ForeignScan *) node->ss.ps.plan)->fdw_private;
-		sql = strVal(list_nth(fdw_private, FdwScanPrivateSelectSql));
-		ExplainPropertyText("Remote SQL", sql, es);
+#if PG_VERSION_NUM >= 120000
+		if (plan && plan->operation == CMD_UPDATE &&
+			resultRelation == plan->rootRelation)
+#else
+		if (plan && plan->operation == CMD_UPDATE &&
+			resultRelation == plan->nominalRelation)
+#endif
+			resultRelation = mtstate->resultRelInfo[0].ri_RangeTableIndex;
+#endif
+		retrieved_attrs = jdbc_get_returning_attrs(resultRelation, rel,
+												   resultRelInfo->ri_returningList);
+		if (retrieved_attrs != NIL)
+		{
+			ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+
+			jdbc_check_returning_attrs(rel, CMD_INSERT, retrieved_attrs,
+									   jdbc_get_dialect(GetForeignServer(table->serverid),
+														fmstate->jdbcUtilsInfo));
+		}
 	}
+	jdbc_init_returning(fmstate, (retrieved_attrs != NIL), retrieved_attrs);
+
+	/*
+	 * Rows are handed over one at a time unless the core code batches them
+	 * through jdbcExecForeignBatchInsert, so batch them ourselves.  That is
+	 * not possible when row triggers need to see each row inserted, when
+	 * RETURNING needs the row returned by the remote server, nor when ON
+	 * CONFLICT DO NOTHING must tell whether each row was inserted.
+	 */
+	fmstate->defer_batch = (fmstate->batch_size > 1 &&
+							!fmstate->has_returning &&
+							fmstate->on_conflict != ONCONFLICT_NOTHING &&
+							!(resultRelInfo->ri_TrigDesc &&
+							  (resultRelInfo->ri_TrigDesc->trig_insert_before_row ||
+							   resultRelInfo->ri_TrigDesc->trig_insert_after_row)));
+
+	resultRelInfo->ri_FdwState = fmstate;
+
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
 }
 
 /*
- * jdbcExplainForeignModify Produce extra output for EXPLAIN of a ModifyTable
- * on a foreign table
+ * jdbcEndForeignInsert Finish an insert operation on a foreign table
  */
 static void
-jdbcExplainForeignModify(ModifyTableState *mtstate,
-						 ResultRelInfo *rinfo,
-						 List *fdw_private,
-						 int subplan_index,
-						 ExplainState *es)
+jdbcEndForeignInsert(EState *estate,
+					 ResultRelInfo *resultRelInfo)
 {
-	if (es->verbose)
-	{
-		char	   *sql = strVal(list_nth(fdw_private,
-										  FdwModifyPrivateUpdateSql));
+	jdbcFdwModifyState *fmstate = (jdbcFdwModifyState *) resultRelInfo->ri_FdwState;
+	ErrorContextCallback *errcallback;
 
-		ExplainPropertyText("Remote SQL", sql, es);
-	}
+	ereport(DEBUG3, (errmsg("In jdbcEndForeignInsert")));
+
+	Assert(fmstate != NULL);
+
+	/* Send the rows still waiting in the batch */
+	errcallback = jdbc_register_error_callback();
+	jdbc_flush_foreign_insert(fmstate);
+	jdbc_remove_error_callback(errcallback);
+
+	jdbcEndForeignModify(estate, resultRelInfo);
 }
+#endif
 
 /*
- * Assess whether the aggregation, grouping and having operations can be
- * pushed down to the foreign server.  As a side effect, save information we
- * obtain in this function to jdbcFdwRelationInfo of the input relation.
+ * jdbcPlanDirectModify Consider a direct foreign table modification
+ *
+ * Decide whether it is safe to modify a foreign table directly, and if so,
+ * rewrite subplan accordingly.  The whole UPDATE/DELETE is then sent to the
+ * remote server as a single statement instead of one statement per row.
  */
 static bool
-jdbc_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel)
+jdbcPlanDirectModify(PlannerInfo *root,
+					 ModifyTable *plan,
+					 Index resultRelation,
+					 int subplan_index)
 {
-	Query	   *query = root->parse;
-	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) grouped_rel->fdw_private;
-	PathTarget *grouping_target;
-	jdbcFdwRelationInfo *ofpinfo;
-	ListCell   *lc;
-	int			i;
-	List	   *tlist = NIL;
+	CmdType		operation = plan->operation;
+	RelOptInfo *foreignrel;
+	RangeTblEntry *rte;
+	jdbcFdwRelationInfo *fpinfo;
+	Relation	rel;
+	StringInfoData sql;
+	ForeignScan *fscan;
+	List	   *targetAttrs = NIL;
+	List	   *targetExprs = NIL;
+	JDBCUtilsInfo	   *jdbcUtilsInfo;
+	ErrorContextCallback *errcallback;
 
-	/* We currently don't support pushing Grouping Sets. */
-	if (query->groupingSets)
+	ereport(DEBUG3, (errmsg("In jdbcPlanDirectModify")));
+
+	/*
+	 * Decide whether it is safe to modify a foreign table directly.
+	 */
+
+	/*
+	 * The table modification must be an UPDATE or DELETE.
+	 */
+	if (operation != CMD_UPDATE && operation != CMD_DELETE)
 		return false;
 
-	/* Get the fpinfo of the underlying scan relation. */
-	ofpinfo = (jdbcFdwRelationInfo *) fpinfo->outerrel->fdw_private;
+	/*
+	 * Try to locate the ForeignScan subplan that's scanning resultRelation.
+	 */
+	fscan = jdbc_find_modifytable_subplan(root, plan, resultRelation, subplan_index);
+	if (!fscan)
+		return false;
 
 	/*
-	 * If underlying scan relation has any local conditions, those conditions
-	 * are required to be applied before performing aggregation.  Hence the
-	 * aggregate cannot be pushed down.
+	 * It's unsafe to modify a foreign table directly if there are any quals
+	 * that should be evaluated locally.
 	 */
-	if (ofpinfo->local_conds)
+	if (fscan->scan.plan.qual != NIL)
 		return false;
 
 	/*
-	 * The targetlist expected from this node and the targetlist pushed down
-	 * to the foreign server may be different. The latter requires
-	 * sortgrouprefs to be set to push down GROUP BY clause, but should not
-	 * have those arising from ORDER BY clause. These sortgrouprefs may be
-	 * different from those in the plan's targetlist. Use a copy of path
-	 * target to record the new sortgrouprefs.
+	 * Only a plain scan of the target table can be turned into a direct
+	 * modification, not a pushed down join or aggregation, nor a scan
+	 * parameterized by the rows of another relation.
 	 */
-	grouping_target = grouped_rel->reltarget;
+	if (fscan->scan.scanrelid != resultRelation || fscan->fdw_exprs != NIL)
+		return false;
 
 	/*
-	 * Examine grouping expressions, as well as other expressions we'd need to
-	 * compute, and check whether they are safe to push down to the foreign
-	 * server.  All GROUP BY expressions will be part of the grouping target
-	 * and thus there is no need to search for them separately.  Add grouping
-	 * expressions into target list which will be passed to foreign server.
-	 *
-	 * A tricky fine point is that we must not put any expression into the
-	 * target list that is just a foreign param (that is, something that
-	 * deparse.c would conclude has to be sent to the foreign server).  If we
-	 * do, the expression will also appear in the fdw_exprs list of the plan
-	 * node, and setrefs.c will get confused and decide that the fdw_exprs
-	 * entry is actually a reference to the fdw_scan_tlist entry, resulting in
-	 * a broken plan.  Somewhat oddly, it's OK if the expression contains such
-	 * a node, as long as it's not at top level; then no match is possible.
+	 * RETURNING is not supported, leave the error to jdbcPlanForeignModify.
 	 */
-	i = 0;
+	if (plan->returningLists)
+		return false;
 
-	foreach(lc, grouping_target->exprs)
+	foreignrel = find_base_rel(root, resultRelation);
+	fpinfo = (jdbcFdwRelationInfo *) foreignrel->fdw_private;
+	rte = planner_rt_fetch(resultRelation, root);
+
+	/*
+	 * For UPDATE, it's unsafe to perform the update directly if any
+	 * expressions to assign to the target columns are unsafe to evaluate
+	 * remotely.
+	 */
+	if (operation == CMD_UPDATE)
 	{
-		Expr	   *expr = (Expr *) lfirst(lc);
-		ListCell   *l;
+#if PG_VERSION_NUM >= 140000
+		List	   *processed_tlist = NIL;
+		ListCell   *lc,
+				   *lc2;
 
 		/*
-		 * Non-grouping expression we need to compute.  Can we ship it as-is
-		 * to the foreign server?
+		 * The expressions of concern are the first N columns of the
+		 * processed targetlist, where N is the length of the rel's
+		 * update_colnos.
 		 */
-		if (jdbc_is_foreign_expr(root, grouped_rel, expr /* , true */ ) &&
-			!jdbc_is_foreign_param(root, grouped_rel, expr))
-		{
-			/*
-			 * Yes, so add to tlist as-is; OK to suppress duplicates
-			 */
-			tlist = add_to_flat_tlist(tlist, list_make1(expr));
-		}
-		else
+		get_translated_update_targetlist(root, resultRelation,
+										 &processed_tlist, &targetAttrs);
+		forboth(lc, processed_tlist, lc2, targetAttrs)
 		{
-			/*
-			 * Not pushable as a whole; extract its Vars and aggregates
-			 */
-			List	   *aggvars;
+			TargetEntry *tle = lfirst_node(TargetEntry, lc);
+			AttrNumber	attno = lfirst_int(lc2);
 
-			aggvars = pull_var_clause((Node *) expr,
-									  PVC_INCLUDE_AGGREGATES);
+			/* update's new-value expressions shouldn't be resjunk */
+			Assert(!tle->resjunk);
 
-			/*
-			 * If any aggregate expression is not shippable, then we cannot
-			 * push down aggregation to the foreign server.  (We don't have to
-			 * check is_foreign_param, since that certainly won't return true
-			 * for any such expression.)
-			 */
-			if (!jdbc_is_foreign_expr(root, grouped_rel, (Expr *) aggvars /* , true */ ))
+			if (attno <= InvalidAttrNumber) /* shouldn't happen */
+				elog(ERROR, "system-column update is not supported");
+
+			if (!jdbc_is_foreign_expr(root, foreignrel, (Expr *) tle->expr))
 				return false;
+			targetExprs = lappend(targetExprs, tle->expr);
+		}
+#else
+		Bitmapset  *updatedCols = bms_copy(rte->updatedCols);
+		AttrNumber	col;
 
-			/*
-			 * Add aggregates, if any, into the targetlist. Plain Vars outside
-			 * an aggregate can be ignored, because they should be either same
-			 * as some GROUP BY column or part of some GROUP BY expression. In
-			 * either case, they are already part of the targetlist and thus
-			 * no need to add them again.  In fact including plain Vars in the
-			 * tlist when they do not match a GROUP BY column would cause the
-			 * foreign server to complain that the shipped query is invalid.
-			 */
-			foreach(l, aggvars)
-			{
-				Expr	   *aggref = (Expr *) lfirst(l);
+		/* The subplan computes the new values at the resno of each column */
+		while ((col = bms_first_member(updatedCols)) >= 0)
+		{
+			/* bit numbers are offset by FirstLowInvalidHeapAttributeNumber */
+			AttrNumber	attno = col + FirstLowInvalidHeapAttributeNumber;
+			TargetEntry *tle;
 
-				if (IsA(aggref, Aggref))
-					tlist = add_to_flat_tlist(tlist, list_make1(aggref));
-			}
-		}
+			if (attno <= InvalidAttrNumber) /* shouldn't happen */
+				elog(ERROR, "system-column update is not supported");
 
-		i++;
+			tle = get_tle_by_resno(fscan->scan.plan.targetlist, attno);
+			if (!tle)
+				elog(ERROR, "attribute number %d not found in subplan targetlist",
+					 attno);
+
+			if (!jdbc_is_foreign_expr(root, foreignrel, (Expr *) tle->expr))
+				return false;
+			targetAttrs = lappend_int(targetAttrs, attno);
+			targetExprs = lappend(targetExprs, tle->expr);
+		}
+#endif
 	}
 
 	/*
-	 * If there are any local conditions, pull Vars and aggregates from it and
-	 * check whether they are safe to pushdown or not.
+	 * Ok, rewrite subplan so as to modify the foreign table directly.
 	 */
-	if (fpinfo->local_conds)
-	{
-		List	   *aggvars = NIL;
-
-		foreach(lc, fpinfo->local_conds)
-		{
-			RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
-
-			aggvars = list_concat(aggvars,
-								  pull_var_clause((Node *) rinfo->clause,
-												  PVC_INCLUDE_AGGREGATES));
-		}
+	errcallback = jdbc_register_error_callback();
+	initStringInfo(&sql);
 
-		foreach(lc, aggvars)
-		{
-			Expr	   *expr = (Expr *) lfirst(lc);
+	/*
+	 * Core code already has some lock on each rel being planned, so we can
+	 * use NoLock here.
+	 */
+#if PG_VERSION_NUM < 130000
+	rel = heap_open(rte->relid, NoLock);
+#else
+	rel = table_open(rte->relid, NoLock);
+#endif
 
-			/*
-			 * If aggregates within local conditions are not safe to push
-			 * down, then we cannot push down the query. Vars are already part
-			 * of GROUP BY clause which are checked above, so no need to
-			 * access them again here.  Again, we need not check
-			 * is_foreign_param for a foreign aggregate.
-			 */
-			if (IsA(expr, Aggref))
-			{
-				if (!jdbc_is_foreign_expr(root, grouped_rel, expr))
-					return false;
+	jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo->server, fpinfo->user, false);
 
-				tlist = add_to_flat_tlist(tlist, list_make1(expr));
-			}
-		}
+	/*
+	 * Every qual of the scan is a remote condition, since there are no local
+	 * quals left.
+	 */
+	switch (operation)
+	{
+		case CMD_UPDATE:
+			jdbc_deparse_direct_update_sql(&sql, root, resultRelation, rel,
+										   foreignrel, targetAttrs, targetExprs,
+										   fpinfo->remote_conds,
+										   jdbcUtilsInfo->q_char);
+			break;
+		case CMD_DELETE:
+			jdbc_deparse_direct_delete_sql(&sql, root, rel, foreignrel,
+										   fpinfo->remote_conds,
+										   jdbcUtilsInfo->q_char);
+			break;
+		default:
+			elog(ERROR, "unexpected operation: %d", (int) operation);
+			break;
 	}
 
-	/* Store generated targetlist */
-	fpinfo->grouped_tlist = tlist;
-
-	/* Safe to pushdown */
-	fpinfo->pushdown_safe = true;
+	ereport(DEBUG3, (errmsg("SQL: %s", sql.data)));
 
 	/*
-	 * Set # of retrieved rows and cached relation costs to some negative
-	 * value, so that we can detect when they are set to some sensible values,
-	 * during one (usually the first) of the calls to estimate_path_cost_size.
+	 * Update the operation and target relation info.
 	 */
-	fpinfo->retrieved_rows = -1;
-	fpinfo->rel_startup_cost = -1;
-	fpinfo->rel_total_cost = -1;
+	fscan->operation = operation;
+#if PG_VERSION_NUM >= 140000
+	fscan->resultRelation = resultRelation;
+#endif
 
 	/*
-	 * Set the string describing this grouped relation to be used in EXPLAIN
-	 * output of corresponding ForeignScan.  Note that the decoration we add
-	 * to the base relation name mustn't include any digits, or it'll confuse
-	 * postgresExplainForeignScan.
+	 * Update the fdw_exprs list that will be available to the executor.
 	 */
+	fscan->fdw_exprs = NIL;
 
 	/*
-	 * Set the string describing this grouped relation to be used in EXPLAIN
-	 * output of corresponding ForeignScan.
+	 * Update the fdw_private list that will be available to the executor.
+	 * Items in the list must match enum FdwDirectModifyPrivateIndex, above.
 	 */
-	fpinfo->relation_name = makeStringInfo();
+	fscan->fdw_private = list_make2(makeString(sql.data),
+									makeInteger(plan->canSetTag));
+
+#if PG_VERSION_NUM < 130000
+	heap_close(rel, NoLock);
+#else
+	table_close(rel, NoLock);
+#endif
 
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
 	return true;
 }
 
 /*
- * jdbc_add_foreign_grouping_paths Add foreign path for grouping and/or
- * aggregation.
- *
- * Given input_rel represents the underlying scan.  The paths are added to
- * the given grouped_rel.
+ * jdbcBeginDirectModify Prepare a direct foreign table modification
  */
 static void
-jdbc_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
-								RelOptInfo *grouped_rel
-#if (PG_VERSION_NUM >= 110000)
-								,GroupPathExtraData *extra
-#endif
-)
+jdbcBeginDirectModify(ForeignScanState *node, int eflags)
 {
-	Query	   *parse = root->parse;
-	jdbcFdwRelationInfo *ifpinfo = input_rel->fdw_private;
-	jdbcFdwRelationInfo *fpinfo = grouped_rel->fdw_private;
-	ForeignPath *grouppath;
-	double		rows;
-	int			width;
-	Cost		startup_cost;
-	Cost		total_cost;
+	ForeignScan *fsplan = (ForeignScan *) node->ss.ps.plan;
+	EState	   *estate = node->ss.ps.state;
+	jdbcFdwDirectModifyState *dmstate;
+	RangeTblEntry *rte;
+	Oid			userid;
+	ForeignTable *table;
+	ForeignServer *server;
+	UserMapping *user;
+	ErrorContextCallback *errcallback;
+
+	ereport(DEBUG3, (errmsg("In jdbcBeginDirectModify")));
 
 	/*
-	 * Nothing to be done, if there is no aggregation required. JDBC does not
-	 * support GROUP BY, GROUPING SET, HAVING, so also return when there are
-	 * those clauses.
+	 * Do nothing in EXPLAIN (no ANALYZE) case.  node->fdw_state stays NULL.
 	 */
-	if (parse->groupClause ||
-		parse->groupingSets ||
-		root->hasHavingQual ||
-		!parse->hasAggs)
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
 		return;
 
-#if (PG_VERSION_NUM >= 110000)
-	Assert(extra->patype == PARTITIONWISE_AGGREGATE_NONE ||
-		   extra->patype == PARTITIONWISE_AGGREGATE_FULL);
-#endif
-
-	/* save the input_rel as outerrel in fpinfo */
-	fpinfo->outerrel = input_rel;
+	errcallback = jdbc_register_error_callback();
 
 	/*
-	 * Copy foreign table, foreign server, user mapping, FDW options etc.
-	 * details from the input relation's fpinfo.
+	 * We'll save private state in node->fdw_state.
 	 */
-	fpinfo->table = ifpinfo->table;
-	fpinfo->server = ifpinfo->server;
-	fpinfo->user = ifpinfo->user;
+	dmstate = (jdbcFdwDirectModifyState *) palloc0(sizeof(jdbcFdwDirectModifyState));
+	node->fdw_state = (void *) dmstate;
 
 	/*
-	 * Assess if it is safe to push down aggregation and grouping.
-	 *
-	 * Use HAVING qual from extra. In case of child partition, it will have
-	 * translated Vars.
+	 * Identify which user to do the remote access as.  This should match what
+	 * ExecCheckRTEPerms() does.
 	 */
-	if (!jdbc_foreign_grouping_ok(root, grouped_rel))
-		return;
+	rte = rt_fetch(fsplan->scan.scanrelid, estate->es_range_table);
+#if PG_VERSION_NUM < 160000
+	userid = rte->checkAsUser ? rte->checkAsUser : GetUserId();
+#else
+	userid = OidIsValid(fsplan->checkAsUser) ? fsplan->checkAsUser : GetUserId();
+#endif
+
+	/* Get info about foreign table. */
+	dmstate->rel = node->ss.ss_currentRelation;
+	table = GetForeignTable(RelationGetRelid(dmstate->rel));
+	server = GetForeignServer(table->serverid);
+	user = GetUserMapping(userid, server->serverid);
 
 	/*
-	 * Compute the selectivity and cost of the local_conds, so we don't have
-	 * to do it over again for each path.  (Currently we create just a single
-	 * path here, but in future it would be possible that we build more paths
-	 * such as pre-sorted paths as in postgresGetForeignPaths and
-	 * postgresGetForeignJoinPaths.)  The best we can do for these conditions
-	 * is to estimate selectivity on the basis of local statistics.
+	 * Get connection to the foreign server.  Connection manager will
+	 * establish new connection if necessary.
 	 */
-	fpinfo->local_conds_sel = clauselist_selectivity(root,
-													 fpinfo->local_conds,
-													 0,
-													 JOIN_INNER,
-													 NULL);
-
-	/* Use small cost to push down aggregate always */
-	rows = width = startup_cost = total_cost = 1;
-
-	/* Now update this information in the fpinfo */
-	fpinfo->rows = rows;
-	fpinfo->width = width;
-	fpinfo->startup_cost = startup_cost;
-	fpinfo->total_cost = total_cost;
+	dmstate->jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(server, user, true);
 
-	/* Create and add foreign path to the grouping relation. */
-#if (PG_VERSION_NUM >= 120000)
-	grouppath = create_foreign_upper_path(root,
-										  grouped_rel,
-										  grouped_rel->reltarget,
-										  rows,
-										  startup_cost,
-										  total_cost,
-										  NIL,	/* no pathkeys */
-										  NULL,
-#if PG_VERSION_NUM >= 170000
-										  NIL,	/* no fdw_restrictinfo list */
-#endif
-										  NIL); /* no fdw_private */
-#else
-	grouppath = create_foreignscan_path(root,
-										grouped_rel,
-										root->upper_targets[UPPERREL_GROUP_AGG],
-										rows,
-										startup_cost,
-										total_cost,
-										NIL,	/* no pathkeys */
-										NULL,	/* no required_outer */
-										NULL,
-										NIL);	/* no fdw_private */
-#endif
+	/* Get private info created by planner functions. */
+	dmstate->query = strVal(list_nth(fsplan->fdw_private,
+									 FdwDirectModifyPrivateUpdateSql));
+	dmstate->set_processed = intVal(list_nth(fsplan->fdw_private,
+											 FdwDirectModifyPrivateSetProcessed)) != 0;
 
-	/* Add generated path into grouped_rel by add_path(). */
-	add_path(grouped_rel, (Path *) grouppath);
+	/* The statement is executed by the first jdbcIterateDirectModify call */
+	dmstate->num_tuples = -1;
 
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
 }
 
 /*
- * jdbc_add_foreign_final_paths Add foreign paths for performing the final
- * processing remotely.
- *
- * Given input_rel contains the source-data Paths.  The paths are added to
- * the given final_rel.
+ * jdbcIterateDirectModify Execute a direct foreign table modification
  */
-static void
-jdbc_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_rel,
-							 RelOptInfo *final_rel
-#if (PG_VERSION_NUM >= 120000)
-							 ,FinalPathExtraData *extra
-#endif
-)
+static TupleTableSlot *
+jdbcIterateDirectModify(ForeignScanState *node)
 {
-	Query	   *parse = root->parse;
-	jdbcFdwRelationInfo *ifpinfo = (jdbcFdwRelationInfo *) input_rel->fdw_private;
-	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) final_rel->fdw_private;
-	bool		has_final_sort = false;
-	List	   *pathkeys = NIL;
-	double		rows;
-	int			width;
-	Cost		startup_cost;
-	Cost		total_cost;
-	List	   *fdw_private;
-	ForeignPath *final_path;
-
-	/*
-	 * Currently, we only support this for SELECT commands
-	 */
-	if (parse->commandType != CMD_SELECT)
-		return;
+	jdbcFdwDirectModifyState *dmstate = (jdbcFdwDirectModifyState *) node->fdw_state;
+	EState	   *estate = node->ss.ps.state;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	Instrumentation *instr = node->ss.ps.instrument;
+	Jresult    *res;
+	int			resultSetID;
+	ErrorContextCallback *errcallback;
 
-	/*
-	 * Currently, we do not support FOR UPDATE/SHARE
-	 */
-	if (parse->rowMarks)
-		return;
+	ereport(DEBUG3, (errmsg("In jdbcIterateDirectModify")));
 
 	/*
-	 * No work if there is no FOR UPDATE/SHARE clause and if there is no need
-	 * to add a LIMIT node
+	 * The whole modification is done by the first call, there is no
+	 * RETURNING result to return.
 	 */
-	if (!parse->rowMarks
-#if (PG_VERSION_NUM >= 120000)
-		&& !extra->limit_needed
-#endif
-		)
-		return;
+	if (dmstate->num_tuples != -1)
+		return ExecClearTuple(slot);
 
-#if (PG_VERSION_NUM >= 100000)
-	/* We don't support cases where there are any SRFs in the targetlist */
-	if (parse->hasTargetSRFs)
-		return;
-#endif
-	/* Save the input_rel as outerrel in fpinfo */
-	fpinfo->outerrel = input_rel;
+	errcallback = jdbc_register_error_callback();
 
 	/*
-	 * Copy foreign table, foreign server, user mapping, FDW options etc.
-	 * details from the input relation's fpinfo.
+	 * Execute the statement, and check for success.
+	 *
+	 * We don't use a PG_TRY block here, so be careful not to throw error
+	 * without releasing the Jresult.
 	 */
-	fpinfo->table = ifpinfo->table;
-	fpinfo->server = ifpinfo->server;
-	fpinfo->user = ifpinfo->user;
+	res = jq_prepare(dmstate->jdbcUtilsInfo, dmstate->query, NULL, &resultSetID);
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, dmstate->jdbcUtilsInfo, true, dmstate->query);
+	jq_clear(res);
 
-#if (PG_VERSION_NUM >= 120000)
+	res = jq_exec_prepared(dmstate->jdbcUtilsInfo, NULL, NULL, 0, resultSetID);
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, dmstate->jdbcUtilsInfo, true, dmstate->query);
+	jq_clear(res);
 
-	/*
-	 * If there is no need to add a LIMIT node, there might be a ForeignPath
-	 * in the input_rel's pathlist that implements all behavior of the query.
-	 * Note: we would already have accounted for the query's FOR UPDATE/SHARE
-	 * (if any) before we get here.
-	 */
-	if (!extra->limit_needed)
-	{
-		ListCell   *lc;
+	/* Get the number of rows affected. */
+	dmstate->num_tuples = jq_get_affected_rows(dmstate->jdbcUtilsInfo, resultSetID);
+	jq_release_resultset_id(dmstate->jdbcUtilsInfo, resultSetID);
 
-		Assert(parse->rowMarks);
+	/* Increment the command es_processed count if necessary. */
+	if (dmstate->set_processed)
+		estate->es_processed += dmstate->num_tuples;
 
-		/*
-		 * Grouping and aggregation are not supported with FOR UPDATE/SHARE,
-		 * so the input_rel should be a base, join, or ordered relation; and
-		 * if it's an ordered relation, its input relation should be a base or
-		 * join relation.
-		 */
-		Assert(input_rel->reloptkind == RELOPT_BASEREL ||
-			   input_rel->reloptkind == RELOPT_JOINREL ||
-			   (input_rel->reloptkind == RELOPT_UPPER_REL &&
-				ifpinfo->stage == UPPERREL_ORDERED &&
-				(ifpinfo->outerrel->reloptkind == RELOPT_BASEREL ||
-				 ifpinfo->outerrel->reloptkind == RELOPT_JOINREL)));
+	/* Increment the tuple count for EXPLAIN ANALYZE if necessary. */
+	if (instr)
+		instr->tuplecount += dmstate->num_tuples;
 
-		foreach(lc, input_rel->pathlist)
-		{
-			Path	   *path = (Path *) lfirst(lc);
+	/* Uninstall error context callback. */
+	jdbc_remove_error_callback(errcallback);
 
-			/*
-			 * apply_scanjoin_target_to_paths() uses create_projection_path()
-			 * to adjust each of its input paths if needed, whereas
-			 * create_ordered_paths() uses apply_projection_to_path() to do
-			 * that.  So the former might have put a ProjectionPath on top of
-			 * the ForeignPath; look through ProjectionPath and see if the
-			 * path underneath it is ForeignPath.
-			 */
-			if (IsA(path, ForeignPath) ||
-				(IsA(path, ProjectionPath) &&
-				 IsA(((ProjectionPath *) path)->subpath, ForeignPath)))
-			{
-				/*
-				 * Create foreign final path; this gets rid of a
-				 * no-longer-needed outer plan (if any), which makes the
-				 * EXPLAIN output look cleaner
-				 */
-#if (PG_VERSION_NUM >= 120000)
-				final_path = create_foreign_upper_path(root,
-													   path->parent,
-													   path->pathtarget,
-													   path->rows,
-													   path->startup_cost,
-													   path->total_cost,
-													   path->pathkeys,
-													   NULL,	/* no extra plan */
-#if PG_VERSION_NUM >= 170000
-													   NIL, /* no fdw_restrictinfo
-															 * list */
-#endif
-													   NULL);	/* no fdw_private */
-#else
-				final_path = create_foreignscan_path(root,
-													 input_rel,
-													 root->upper_targets[UPPERREL_FINAL],
-													 rows,
-													 startup_cost,
-													 total_cost,
-													 pathkeys,
-													 NULL,	/* no required_outer */
-													 NULL,	/* no extra plan */
-													 fdw_private);
-#endif
-				/* and add it to the final_rel */
-				add_path(final_rel, (Path *) final_path);
+	return ExecClearTuple(slot);
+}
 
-				/* Safe to push down */
-				fpinfo->pushdown_safe = true;
+/*
+ * jdbcEndDirectModify Finish a direct foreign table modification
+ */
+static void
+jdbcEndDirectModify(ForeignScanState *node)
+{
+	jdbcFdwDirectModifyState *dmstate = (jdbcFdwDirectModifyState *) node->fdw_state;
 
-				return;
-			}
-		}
+	ereport(DEBUG3, (errmsg("In jdbcEndDirectModify")));
 
-		/*
-		 * If we get here it means no ForeignPaths; since we would already
-		 * have considered pushing down all operations for the query to the
-		 * remote server, give up on it.
-		 */
+	/* if dmstate is NULL, we are in EXPLAIN; nothing to do */
+	if (dmstate == NULL)
 		return;
-	}
 
-	Assert(extra->limit_needed);
-#endif
+	/* Release remote connection */
+	jdbc_release_jdbc_utils_obj();
+	dmstate->jdbcUtilsInfo = NULL;
+
+	/* MemoryContext will be deleted automatically. */
+}
+
+/*
+ * jdbcIsForeignRelUpdatable Determine whether a foreign table supports
+ * INSERT, UPDATE and/or DELETE.
+ */
+static int
+jdbcIsForeignRelUpdatable(Relation rel)
+{
+	bool		updatable;
+	ForeignTable *table;
+	ForeignServer *server;
+	ListCell   *lc;
+
+	ereport(DEBUG3, (errmsg("In jdbcIsForeignRelUpdatable")));
 
 	/*
-	 * If the input_rel is an ordered relation, replace the input_rel with its
-	 * input relation
+	 * By default, all jdbc_fdw foreign tables are assumed updatable. This can
+	 * be overridden by a per-server setting, which in turn can be overridden
+	 * by a per-table setting.
 	 */
-	if (input_rel->reloptkind == RELOPT_UPPER_REL &&
-		ifpinfo->stage == UPPERREL_ORDERED)
+	updatable = true;
+
+	table = GetForeignTable(RelationGetRelid(rel));
+	server = GetForeignServer(table->serverid);
+
+	foreach(lc, server->options)
 	{
-		input_rel = ifpinfo->outerrel;
-		ifpinfo = (jdbcFdwRelationInfo *) input_rel->fdw_private;
-		has_final_sort = true;
-		pathkeys = root->sort_pathkeys;
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "updatable") == 0)
+			updatable = defGetBoolean(def);
 	}
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
 
-	/* The input_rel should be a base, join, or grouping relation */
-	Assert(input_rel->reloptkind == RELOPT_BASEREL ||
-		   input_rel->reloptkind == RELOPT_JOINREL ||
-		   (input_rel->reloptkind == RELOPT_UPPER_REL &&
-			ifpinfo->stage == UPPERREL_GROUP_AGG));
+		if (strcmp(def->defname, "updatable") == 0)
+			updatable = defGetBoolean(def);
+	}
 
 	/*
-	 * We try to create a path below by extending a simple foreign path for
-	 * the underlying base, join, or grouping relation to perform the final
-	 * sort (if has_final_sort) and the LIMIT restriction remotely, which is
-	 * stored into the fdw_private list of the resulting path. (We re-estimate
-	 * the costs of sorting the underlying relation, if has_final_sort.)
+	 * Currently "updatable" means support for INSERT, UPDATE and DELETE.
 	 */
+	return updatable ?
+		(1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE) : 0;
+}
 
-	/*
-	 * Assess if it is safe to push down the LIMIT and OFFSET to the remote
-	 * server
-	 */
+#if PG_VERSION_NUM >= 140000
+/*
+ * jdbcExecForeignTruncate Truncate one or more foreign tables
+ *
+ * All the relations of rels belong to the same foreign server, so they are
+ * emptied by a single remote TRUNCATE statement.  If the remote database
+ * does not support it, for example because it only truncates one table at a
+ * time, each table is emptied by a DELETE statement instead.  There is no
+ * such fallback for RESTART IDENTITY and CASCADE, which DELETE cannot honor.
+ */
+static void
+jdbcExecForeignTruncate(List *rels,
+						DropBehavior behavior,
+						bool restart_seqs)
+{
+	Oid			serverid = InvalidOid;
+	ForeignServer *server = NULL;
+	UserMapping *user;
+	JDBCUtilsInfo *jdbcUtilsInfo;
+	bool		server_truncatable = true;
+	List	   *delete_sqls = NIL;
+	StringInfoData sql;
+	Jresult    *res;
+	ListCell   *lc;
 
-	/*
-	 * If the underlying relation has any local conditions, the LIMIT/OFFSET
-	 * cannot be pushed down.
-	 */
-	if (ifpinfo->local_conds)
-		return;
+	ereport(DEBUG3, (errmsg("In jdbcExecForeignTruncate")));
 
-#if PG_VERSION_NUM >= 130000
 	/*
-	 * In PostgreSQL version is v13 or later, If the query has FETCH FIRST .. WITH TIES,
-	 * 1) it must have ORDER BY as well, which is used to determine which additional rows
-	 * tie for the last place in the result set, and 2) ORDER BY must already have been
-	 * determined to be safe to push down before we get here.  Since jdbc_fdw
-	 * does not currently support ORDER BY and FETCH FIRST .. WITH TIES clauses, disable
-	 * pushing the FETCH clause.
+	 * By default, all jdbc_fdw foreign tables are assumed truncatable. This
+	 * can be overridden by a per-server setting, which in turn can be
+	 * overridden by a per-table setting.
 	 */
-	if (parse->limitOption == LIMIT_OPTION_WITH_TIES)
-		return;
-#endif
+	foreach(lc, rels)
+	{
+		Relation	rel = lfirst(lc);
+		ForeignTable *table;
+		bool		truncatable;
+		ListCell   *cell;
 
-	/*
-	 * When query contains OFFSET but no LIMIT, do not push down because JDBC
-	 * does not support.
-	 */
-	if (!parse->limitCount && parse->limitOffset)
-		return;
+		if (!OidIsValid(serverid))
+		{
+			serverid = GetForeignServerIdByRelId(RelationGetRelid(rel));
+			server = GetForeignServer(serverid);
 
-	/*
-	 * Also, the LIMIT/OFFSET cannot be pushed down, if their expressions are
-	 * not safe to remote.
-	 */
-	if (!jdbc_is_foreign_expr(root, input_rel, (Expr *) parse->limitOffset /* , true */ ) ||
-		!jdbc_is_foreign_expr(root, input_rel, (Expr *) parse->limitCount /* , true */ ))
-		return;
+			foreach(cell, server->options)
+			{
+				DefElem    *def = (DefElem *) lfirst(cell);
 
-	/* Safe to push down */
-	fpinfo->pushdown_safe = true;
+				if (strcmp(def->defname, "truncatable") == 0)
+					server_truncatable = defGetBoolean(def);
+			}
+		}
 
-	/* Use small cost to push down limit always */
-	rows = width = startup_cost = total_cost = 1;
-	/* Now update this information in the fpinfo */
-	fpinfo->rows = rows;
-	fpinfo->width = width;
-	fpinfo->startup_cost = startup_cost;
-	fpinfo->total_cost = total_cost;
+		/* ExecuteTruncateGuts calls us once per foreign server */
+		Assert(serverid == GetForeignServerIdByRelId(RelationGetRelid(rel)));
 
-	/*
-	 * Build the fdw_private list that will be used by postgresGetForeignPlan.
-	 * Items in the list must match order in enum FdwPathPrivateIndex.
-	 */
-#if PG_VERSION_NUM >= 150000
-	fdw_private = list_make2(makeBoolean(has_final_sort),
-							 makeBoolean(extra->limit_needed));
-#elif (PG_VERSION_NUM >= 120000)
-    fdw_private = list_make2(makeInteger(has_final_sort),
-							 makeInteger(extra->limit_needed));
-#else
-    fdw_private = list_make2(makeInteger(has_final_sort),
-                             makeInteger(false));
-#endif
+		truncatable = server_truncatable;
+		table = GetForeignTable(RelationGetRelid(rel));
+		foreach(cell, table->options)
+		{
+			DefElem    *def = (DefElem *) lfirst(cell);
 
-	/*
-	 * Create foreign final path; this gets rid of a no-longer-needed outer
-	 * plan (if any), which makes the EXPLAIN output look cleaner
-	 */
-#if (PG_VERSION_NUM >= 120000)
-	final_path = create_foreign_upper_path(root,
-										   input_rel,
-										   root->upper_targets[UPPERREL_FINAL],
-										   rows,
-										   startup_cost,
-										   total_cost,
-										   pathkeys,
-										   NULL,	/* no extra plan */
-#if PG_VERSION_NUM >= 170000
-										   NIL, /* no fdw_restrictinfo list */
-#endif
-										   fdw_private);
-#else
-	final_path = create_foreignscan_path(root,
-										 input_rel,
-										 root->upper_targets[UPPERREL_FINAL],
-										 rows,
-										 startup_cost,
-										 total_cost,
-										 pathkeys,
-										 NULL,	/* no required_outer */
-										 NULL,	/* no extra plan */
-										 fdw_private);
+			if (strcmp(def->defname, "truncatable") == 0)
+				truncatable = defGetBoolean(def);
+		}
+
+		if (!truncatable)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("foreign table \"%s\" does not allow truncates",
+							RelationGetRelationName(rel))));
+	}
+	Assert(OidIsValid(serverid));
+
+	user = GetUserMapping(GetUserId(), serverid);
+	jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(server, user, false);
+
+	/* Construct the TRUNCATE statement, and the DELETE fallback if any */
+	initStringInfo(&sql);
+	jdbc_deparse_truncate_sql(&sql, rels, behavior, restart_seqs,
+							  jdbcUtilsInfo->q_char);
+
+	if (behavior != DROP_CASCADE && !restart_seqs)
+	{
+		foreach(lc, rels)
+		{
+			Relation	rel = lfirst(lc);
+			StringInfoData delete_sql;
+
+			initStringInfo(&delete_sql);
+			jdbc_deparse_delete_sql(&delete_sql, NULL, 0, rel, NIL, 1,
+									jdbcUtilsInfo->q_char);
+			delete_sqls = lappend(delete_sqls, delete_sql.data);
+		}
+	}
+
+	res = jq_exec_truncate(jdbcUtilsInfo, sql.data, delete_sqls);
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, jdbcUtilsInfo, true, sql.data);
+	jq_clear(res);
+
+	jdbc_release_jdbc_utils_obj();
+}
 #endif
 
-	/* and add it to the final_rel */
-	add_path(final_rel, (Path *) final_path);
+/*
+ * jdbcExplainForeignScan Produce extra output for EXPLAIN of a ForeignScan
+ * on a foreign table
+ */
+static void
+jdbcExplainForeignScan(ForeignScanState *node, ExplainState *es)
+{
+	List	   *fdw_private;
+	char	   *sql;
+
+	ereport(DEBUG3, (errmsg("In jdbcExplainForeignScan")));
+	if (es->verbose)
+	{
+		fdw_private = ((ForeignScan *) node->ss.ps.plan)->fdw_private;
+		sql = strVal(list_nth(fdw_private, FdwScanPrivateSelectSql));
+		ExplainPropertyText("Remote SQL", sql, es);
+	}
 }
 
 /*
- * jdbcGetForeignUpperPaths Add paths for post-join operations like
- * aggregation, grouping etc. if corresponding operations are safe to push
- * down. Currently, we only support push down LIMIT...OFFSET
+ * jdbcExplainForeignModify Produce extra output for EXPLAIN of a ModifyTable
+ * on a foreign table
  */
 static void
-jdbcGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage,
-						 RelOptInfo *input_rel, RelOptInfo *output_rel
-#if (PG_VERSION_NUM >= 110000)
-						 ,
-						 void *extra
-#endif
-)
+jdbcExplainForeignModify(ModifyTableState *mtstate,
+						 ResultRelInfo *rinfo,
+						 List *fdw_private,
+						 int subplan_index,
+						 ExplainState *es)
+{
+	if (es->verbose)
+	{
+		char	   *sql = strVal(list_nth(fdw_private,
+										  FdwModifyPrivateUpdateSql));
+
+		ExplainPropertyText("Remote SQL", sql, es);
+	}
+}
+
+/*
+ * jdbcExplainDirectModify Produce extra output for EXPLAIN of a ForeignScan
+ * that modifies a foreign table directly
+ */
+static void
+jdbcExplainDirectModify(ForeignScanState *node, ExplainState *es)
+{
+	List	   *fdw_private;
+	char	   *sql;
+
+	ereport(DEBUG3, (errmsg("In jdbcExplainDirectModify")));
+	if (es->verbose)
+	{
+		fdw_private = ((ForeignScan *) node->ss.ps.plan)->fdw_private;
+		sql = strVal(list_nth(fdw_private, FdwDirectModifyPrivateUpdateSql));
+		ExplainPropertyText("Remote SQL", sql, es);
+	}
+}
+
+/*
+ * Assess whether the join between inner and outer relations can be pushed down
+ * to the foreign server.  As a side effect, save information we obtain in this
+ * function to jdbcFdwRelationInfo passed in.
+ */
+static bool
+jdbc_foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel, JoinType jointype,
+					 RelOptInfo *outerrel, RelOptInfo *innerrel,
+					 JoinPathExtraData *extra)
 {
 	jdbcFdwRelationInfo *fpinfo;
+	jdbcFdwRelationInfo *fpinfo_o;
+	jdbcFdwRelationInfo *fpinfo_i;
+	ListCell   *lc;
+	List	   *joinclauses;
 
 	/*
-	 * If input rel is not safe to pushdown, then simply return as we cannot
-	 * perform any post-join operations on the foreign server.
+	 * We support pushing down INNER, LEFT, RIGHT and FULL OUTER joins.
+	 * Constructing queries representing SEMI and ANTI joins is hard, hence
+	 * not considered right now.
 	 */
-	if (!input_rel->fdw_private ||
-		!((jdbcFdwRelationInfo *) input_rel->fdw_private)->pushdown_safe)
-		return;
+	if (jointype != JOIN_INNER && jointype != JOIN_LEFT &&
+		jointype != JOIN_RIGHT && jointype != JOIN_FULL)
+		return false;
 
 	/*
-	 * Ignore stages we don't support; and skip any duplicate calls. We only
-	 * support LIMIT...OFFSET and aggregation push down
+	 * If either of the joining relations is marked as unsafe to pushdown, the
+	 * join can not be pushed down.
 	 */
-	if ((stage != UPPERREL_GROUP_AGG &&
-		 stage != UPPERREL_FINAL) ||
-		output_rel->fdw_private)
-		return;
+	fpinfo = (jdbcFdwRelationInfo *) joinrel->fdw_private;
+	fpinfo_o = (jdbcFdwRelationInfo *) outerrel->fdw_private;
+	fpinfo_i = (jdbcFdwRelationInfo *) innerrel->fdw_private;
+	if (!fpinfo_o || !fpinfo_o->pushdown_safe ||
+		!fpinfo_i || !fpinfo_i->pushdown_safe)
+		return false;
 
-	fpinfo = (jdbcFdwRelationInfo *) palloc0(sizeof(jdbcFdwRelationInfo));
-	fpinfo->pushdown_safe = false;
-	fpinfo->stage = stage;
-	output_rel->fdw_private = fpinfo;
+	/*
+	 * If joining relations have local conditions, those conditions are
+	 * required to be applied before joining the relations. Hence the join can
+	 * not be pushed down.
+	 */
+	if (fpinfo_o->local_conds || fpinfo_i->local_conds)
+		return false;
 
-	switch (stage)
+	/*
+	 * A full outer join can not be pushed down if either side has conditions
+	 * of its own, since they would have to be applied in a subquery.
+	 */
+	if (jointype == JOIN_FULL &&
+		(fpinfo_o->remote_conds || fpinfo_i->remote_conds))
+		return false;
+
+	/* MySQL has no FULL JOIN. */
+	if (jointype == JOIN_FULL)
 	{
-		case UPPERREL_GROUP_AGG:
-			jdbc_add_foreign_grouping_paths(root, input_rel, output_rel
-#if (PG_VERSION_NUM >= 110000)
-											,(GroupPathExtraData *) extra
+		JDBCUtilsInfo *jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo_o->server,
+															   fpinfo_o->user,
+															   false);
+
+		if (jdbc_get_dialect(fpinfo_o->server, jdbcUtilsInfo) == JDBC_DIALECT_MYSQL)
+			return false;
+	}
+
+	/*
+	 * Separate restrict list into join quals and pushed-down (other) quals.
+	 *
+	 * Join quals belonging to an outer join must all be shippable, else we
+	 * cannot execute the join remotely.  Add such quals to 'joinclauses'.
+	 *
+	 * Add other quals to fpinfo->remote_conds if they are shippable, else to
+	 * fpinfo->local_conds.  In an inner join it's okay to execute conditions
+	 * either locally or remotely; the same is true for pushed-down conditions
+	 * at an outer join.
+	 */
+	joinclauses = NIL;
+	foreach(lc, extra->restrictlist)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		bool		is_remote_clause = jdbc_is_foreign_expr(root, joinrel,
+															rinfo->clause);
+
+#if PG_VERSION_NUM >= 110000
+		if (IS_OUTER_JOIN(jointype) &&
+			!RINFO_IS_PUSHED_DOWN(rinfo, joinrel->relids))
+#else
+		if (IS_OUTER_JOIN(jointype) && !rinfo->is_pushed_down)
 #endif
-				);
-			break;
-		case UPPERREL_FINAL:
-			jdbc_add_foreign_final_paths(root, input_rel, output_rel
-#if (PG_VERSION_NUM >= 120000)
-										 ,(FinalPathExtraData *) extra
+		{
+			if (!is_remote_clause)
+				return false;
+			joinclauses = lappend(joinclauses, rinfo);
+		}
+		else
+		{
+			if (is_remote_clause)
+				fpinfo->remote_conds = lappend(fpinfo->remote_conds, rinfo);
+			else
+				fpinfo->local_conds = lappend(fpinfo->local_conds, rinfo);
+		}
+	}
+
+	/*
+	 * Only plain columns of the joining relations can be retrieved, since
+	 * whole-row references and system columns have no remote equivalent.
+	 * Such a reference appears for instance for the row marks of SELECT FOR
+	 * UPDATE.
+	 */
+	foreach(lc, pull_var_clause((Node *) joinrel->reltarget->exprs,
+								PVC_RECURSE_PLACEHOLDERS))
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (!IsA(var, Var) || var->varattno <= 0)
+			return false;
+	}
+
+	/*
+	 * deparseExplicitTargetList() isn't smart enough to handle anything other
+	 * than a Var.  In particular, if there's some PlaceHolderVar that would
+	 * need to be evaluated within this join tree (because there's an upper
+	 * reference to a quantity that may go to NULL as a result of an outer
+	 * join), then we can't try to push the join down because we'll fail when
+	 * we get to deparseExplicitTargetList().
+	 */
+	foreach(lc, root->placeholder_list)
+	{
+		PlaceHolderInfo *phinfo = lfirst(lc);
+		Relids		relids;
+
+		/* PlaceHolderInfo refers to parent relids, not child relids. */
+#if PG_VERSION_NUM >= 110000
+		relids = IS_OTHER_REL(joinrel) ?
+			joinrel->top_parent_relids : joinrel->relids;
+#else
+		relids = joinrel->relids;
 #endif
-				);
+
+		if (bms_is_subset(phinfo->ph_eval_at, relids) &&
+			bms_nonempty_difference(relids, phinfo->ph_eval_at))
+			return false;
+	}
+
+	/* Save the join clauses, for later use. */
+	fpinfo->joinclauses = joinclauses;
+
+	fpinfo->outerrel = outerrel;
+	fpinfo->innerrel = innerrel;
+	fpinfo->jointype = jointype;
+
+	/*
+	 * Pull the other remote conditions from the joining relations into those
+	 * of the join relation.  The conditions of the inner side of a LEFT join
+	 * and of the outer side of a RIGHT join go to its ON clause, instead of
+	 * its WHERE clause, where they would turn the join into an inner join.
+	 * The conditions of the joining relations of a FULL join have been
+	 * refused above.
+	 */
+	switch (jointype)
+	{
+		case JOIN_INNER:
+			fpinfo->remote_conds = list_concat(fpinfo->remote_conds,
+											   list_copy(fpinfo_i->remote_conds));
+			fpinfo->remote_conds = list_concat(fpinfo->remote_conds,
+											   list_copy(fpinfo_o->remote_conds));
 			break;
-		default:
-			elog(ERROR, "unexpected upper relation: %d", (int) stage);
+
+		case JOIN_LEFT:
+			fpinfo->joinclauses = list_concat(fpinfo->joinclauses,
+											  list_copy(fpinfo_i->remote_conds));
+			fpinfo->remote_conds = list_concat(fpinfo->remote_conds,
+											   list_copy(fpinfo_o->remote_conds));
+			break;
+
+		case JOIN_RIGHT:
+			fpinfo->joinclauses = list_concat(fpinfo->joinclauses,
+											  list_copy(fpinfo_o->remote_conds));
+			fpinfo->remote_conds = list_concat(fpinfo->remote_conds,
+											   list_copy(fpinfo_i->remote_conds));
+			break;
+
+		case JOIN_FULL:
 			break;
+
+		default:
+			/* Should not happen, we have just checked this above */
+			elog(ERROR, "unsupported join type %d", jointype);
 	}
+
+	/* Mark that this join can be pushed down safely */
+	fpinfo->pushdown_safe = true;
+
+	/*
+	 * Both relations are on the same server with the same user mapping, the
+	 * core code has checked that before calling us.  Take the catalog
+	 * information and the options from the outer relation, but use remote
+	 * estimates if either side does.
+	 */
+	fpinfo->server = fpinfo_o->server;
+	fpinfo->user = fpinfo_o->user;
+	fpinfo->use_remote_estimate = fpinfo_o->use_remote_estimate ||
+		fpinfo_i->use_remote_estimate;
+	fpinfo->fdw_startup_cost = fpinfo_o->fdw_startup_cost;
+	fpinfo->fdw_tuple_cost = fpinfo_o->fdw_tuple_cost;
+	fpinfo->fetch_size = Max(fpinfo_o->fetch_size, fpinfo_i->fetch_size);
+
+	return true;
 }
 
 /*
- * estimate_path_cost_size Get cost and size estimates for a foreign scan
- *
- * We assume that all the baserestrictinfo clauses will be applied, plus any
- * join clauses listed in join_conds.
+ * jdbcGetForeignJoinPaths Add possible ForeignPath to joinrel, if join is
+ * safe to push down.
  */
 static void
-estimate_path_cost_size(PlannerInfo *root,
-						RelOptInfo *baserel,
-						List *join_conds,
-						double *p_rows, int *p_width,
-						Cost *p_startup_cost,
-						Cost *p_total_cost,
-						char *q_char)
+jdbcGetForeignJoinPaths(PlannerInfo *root,
+						RelOptInfo *joinrel,
+						RelOptInfo *outerrel,
+						RelOptInfo *innerrel,
+						JoinType jointype,
+						JoinPathExtraData *extra)
 {
-	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	jdbcFdwRelationInfo *fpinfo;
+	ForeignPath *joinpath;
 	double		rows;
-	double		retrieved_rows;
 	int			width;
 	Cost		startup_cost;
 	Cost		total_cost;
-	Cost		run_cost;
-	Cost		cpu_per_tuple;
+	Path	   *epq_path;		/* Path to create plan to be executed when
+								 * EvalPlanQual gets triggered. */
+	JDBCUtilsInfo *jdbcUtilsInfo;
+	ErrorContextCallback *errcallback;
+
+	ereport(DEBUG3, (errmsg("In jdbcGetForeignJoinPaths")));
 
 	/*
-	 * If the table or the server is configured to use remote estimates,
-	 * connect to the foreign server and execute EXPLAIN to estimate the
-	 * number of rows selected by the restriction+join clauses. Otherwise,
-	 * estimate rows using whatever statistics we have locally, in a way
-	 * similar to ordinary tables.
+	 * Skip if this join combination has been considered already.
 	 */
-	if (fpinfo->use_remote_estimate)
-	{
-		List	   *remote_join_conds;
-		List	   *local_join_conds;
-		StringInfoData sql;
-		List	   *retrieved_attrs;
-		JDBCUtilsInfo	   *jdbcUtilsInfo;
-		Selectivity local_sel;
-		QualCost	local_cost;
-		List	   *fdw_scan_tlist = NIL;
-		List	   *remote_conds;
+	if (joinrel->fdw_private)
+		return;
 
-		/*
-		 * join_conds might contain both clauses that are safe to send across,
-		 * and clauses that aren't.
+	/*
+	 * Create unfinished jdbcFdwRelationInfo entry which is used to indicate
+	 * that the join relation is already considered, so that we won't waste
+	 * time in judging safety of join pushdown and adding the same paths again
+	 * if found safe. Once we know that this join can be pushed down, we fill
+	 * the entry.
+	 */
+	fpinfo = (jdbcFdwRelationInfo *) palloc0(sizeof(jdbcFdwRelationInfo));
+	fpinfo->pushdown_safe = false;
+	joinrel->fdw_private = fpinfo;
+
+	/*
+	 * If there is a possibility that EvalPlanQual will be executed, we need
+	 * to be able to reconstruct the row using scans of the base relations.
+	 * GetExistingLocalJoinPath will find a suitable path for this purpose in
+	 * the path list of the joinrel, if one exists.  We must be careful to
+	 * call it before adding any ForeignPath, since the ForeignPath might
+	 * dominate the only suitable local path available.  We also do it before
+	 * calling jdbc_foreign_join_ok(), since that function updates fpinfo and
+	 * marks it as pushable if the join is found to be pushable.
+	 */
+	if (root->parse->commandType == CMD_DELETE ||
+		root->parse->commandType == CMD_UPDATE ||
+		root->rowMarks)
+	{
+		epq_path = GetExistingLocalJoinPath(joinrel);
+		if (!epq_path)
+		{
+			elog(DEBUG3, "could not push down foreign join because a local path suitable for EPQ checks was not found");
+			return;
+		}
+	}
+	else
+		epq_path = NULL;
+
+	if (!jdbc_foreign_join_ok(root, joinrel, jointype, outerrel, innerrel, extra))
+	{
+		/* Free path required for EPQ if we copied one; we don't need it now */
+		if (epq_path)
+			pfree(epq_path);
+		return;
+	}
+
+	/*
+	 * Compute the selectivity and cost of the local_conds, so we don't have
+	 * to do it over again for each path. The best we can do for these
+	 * conditions is to estimate selectivity on the basis of local statistics.
+	 * The local conditions are applied after the join has been computed on
+	 * the remote side like quals in WHERE clause, so pass jointype as
+	 * JOIN_INNER.
+	 */
+	fpinfo->local_conds_sel = clauselist_selectivity(root,
+													 fpinfo->local_conds,
+													 0,
+													 JOIN_INNER,
+													 NULL);
+	cost_qual_eval(&fpinfo->local_conds_cost, fpinfo->local_conds, root);
+
+	/*
+	 * If we are going to estimate costs locally, estimate the join clause
+	 * selectivity here while we have special join info.
+	 */
+	if (!fpinfo->use_remote_estimate)
+		fpinfo->joinclause_sel = clauselist_selectivity(root, fpinfo->joinclauses,
+														0, fpinfo->jointype,
+														extra->sjinfo);
+
+	/* Estimate costs for bare join relation */
+	errcallback = jdbc_register_error_callback();
+	jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo->server, fpinfo->user, false);
+	estimate_path_cost_size(root, joinrel, NIL, &rows, &width,
+							&startup_cost, &total_cost, jdbcUtilsInfo->q_char);
+	jdbc_remove_error_callback(errcallback);
+
+	/* Now update this information in the joinrel */
+	joinrel->rows = rows;
+	joinrel->reltarget->width = width;
+	fpinfo->rows = rows;
+	fpinfo->width = width;
+	fpinfo->startup_cost = startup_cost;
+	fpinfo->total_cost = total_cost;
+
+	/*
+	 * Create a new join path and add it to the joinrel which represents a
+	 * join between foreign tables.
+	 */
+#if PG_VERSION_NUM >= 120000
+	joinpath = create_foreign_join_path(root,
+										joinrel,
+										NULL,	/* default pathtarget */
+										rows,
+										startup_cost,
+										total_cost,
+										NIL,	/* no pathkeys */
+										joinrel->lateral_relids,
+										epq_path,
+#if PG_VERSION_NUM >= 170000
+										extra->restrictlist,
+#endif
+										NIL);	/* no fdw_private */
+#else
+	joinpath = create_foreignscan_path(root,
+									   joinrel,
+									   NULL,	/* default pathtarget */
+									   rows,
+									   startup_cost,
+									   total_cost,
+									   NIL, /* no pathkeys */
+									   joinrel->lateral_relids,
+									   epq_path,
+									   NIL);	/* no fdw_private */
+#endif
+
+	/* Add generated path into joinrel by add_path(). */
+	add_path(joinrel, (Path *) joinpath);
+}
+
+/*
+ * Assess whether the aggregation, grouping and having operations can be
+ * pushed down to the foreign server.  As a side effect, save information we
+ * obtain in this function to jdbcFdwRelationInfo of the input relation.
+ */
+static bool
+jdbc_foreign_grouping_ok(PlannerInfo *root, RelOptInfo *grouped_rel)
+{
+	Query	   *query = root->parse;
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) grouped_rel->fdw_private;
+	PathTarget *grouping_target;
+	jdbcFdwRelationInfo *ofpinfo;
+	ListCell   *lc;
+	int			i;
+	List	   *tlist = NIL;
+
+	/* We currently don't support pushing Grouping Sets. */
+	if (query->groupingSets)
+		return false;
+
+	/* Get the fpinfo of the underlying scan relation. */
+	ofpinfo = (jdbcFdwRelationInfo *) fpinfo->outerrel->fdw_private;
+
+	/*
+	 * If underlying scan relation has any local conditions, those conditions
+	 * are required to be applied before performing aggregation.  Hence the
+	 * aggregate cannot be pushed down.
+	 */
+	if (ofpinfo->local_conds)
+		return false;
+
+	/*
+	 * The targetlist expected from this node and the targetlist pushed down
+	 * to the foreign server may be different. The latter requires
+	 * sortgrouprefs to be set to push down GROUP BY clause, but should not
+	 * have those arising from ORDER BY clause. These sortgrouprefs may be
+	 * different from those in the plan's targetlist. Use a copy of path
+	 * target to record the new sortgrouprefs.
+	 */
+	grouping_target = grouped_rel->reltarget;
+
+	/*
+	 * Examine grouping expressions, as well as other expressions we'd need to
+	 * compute, and check whether they are safe to push down to the foreign
+	 * server.  All GROUP BY expressions will be part of the grouping target
+	 * and thus there is no need to search for them separately.  Add grouping
+	 * expressions into target list which will be passed to foreign server.
+	 *
+	 * A tricky fine point is that we must not put any expression into the
+	 * target list that is just a foreign param (that is, something that
+	 * deparse.c would conclude has to be sent to the foreign server).  If we
+	 * do, the expression will also appear in the fdw_exprs list of the plan
+	 * node, and setrefs.c will get confused and decide that the fdw_exprs
+	 * entry is actually a reference to the fdw_scan_tlist entry, resulting in
+	 * a broken plan.  Somewhat oddly, it's OK if the expression contains such
+	 * a node, as long as it's not at top level; then no match is possible.
+	 */
+	i = 0;
+
+	foreach(lc, grouping_target->exprs)
+	{
+		Expr	   *expr = (Expr *) lfirst(lc);
+		ListCell   *l;
+
+		/*
+		 * Non-grouping expression we need to compute.  Can we ship it as-is
+		 * to the foreign server?
 		 */
-		jdbc_classify_conditions(root, baserel, join_conds,
-								 &remote_join_conds, &local_join_conds);
+		if (jdbc_is_foreign_expr(root, grouped_rel, expr /* , true */ ) &&
+			!jdbc_is_foreign_param(root, grouped_rel, expr))
+		{
+			/*
+			 * Yes, so add to tlist as-is; OK to suppress duplicates
+			 */
+			tlist = add_to_flat_tlist(tlist, list_make1(expr));
+		}
+		else
+		{
+			/*
+			 * Not pushable as a whole; extract its Vars and aggregates
+			 */
+			List	   *aggvars;
+
+			aggvars = pull_var_clause((Node *) expr,
+									  PVC_INCLUDE_AGGREGATES);
+
+			/*
+			 * If any aggregate expression is not shippable, then we cannot
+			 * push down aggregation to the foreign server.  (We don't have to
+			 * check is_foreign_param, since that certainly won't return true
+			 * for any such expression.)
+			 */
+			if (!jdbc_is_foreign_expr(root, grouped_rel, (Expr *) aggvars /* , true */ ))
+				return false;
+
+			/*
+			 * Add aggregates, if any, into the targetlist. Plain Vars outside
+			 * an aggregate can be ignored, because they should be either same
+			 * as some GROUP BY column or part of some GROUP BY expression. In
+			 * either case, they are already part of the targetlist and thus
+			 * no need to add them again.  In fact including plain Vars in the
+			 * tlist when they do not match a GROUP BY column would cause the
+			 * foreign server to complain that the shipped query is invalid.
+			 */
+			foreach(l, aggvars)
+			{
+				Expr	   *aggref = (Expr *) lfirst(l);
+
+				if (IsA(aggref, Aggref))
+					tlist = add_to_flat_tlist(tlist, list_make1(aggref));
+			}
+		}
+
+		i++;
+	}
+
+	/*
+	 * If there are any local conditions, pull Vars and aggregates from it and
+	 * check whether they are safe to pushdown or not.
+	 */
+	if (fpinfo->local_conds)
+	{
+		List	   *aggvars = NIL;
+
+		foreach(lc, fpinfo->local_conds)
+		{
+			RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+			aggvars = list_concat(aggvars,
+								  pull_var_clause((Node *) rinfo->clause,
+												  PVC_INCLUDE_AGGREGATES));
+		}
+
+		foreach(lc, aggvars)
+		{
+			Expr	   *expr = (Expr *) lfirst(lc);
+
+			/*
+			 * If aggregates within local conditions are not safe to push
+			 * down, then we cannot push down the query. Vars are already part
+			 * of GROUP BY clause which are checked above, so no need to
+			 * access them again here.  Again, we need not check
+			 * is_foreign_param for a foreign aggregate.
+			 */
+			if (IsA(expr, Aggref))
+			{
+				if (!jdbc_is_foreign_expr(root, grouped_rel, expr))
+					return false;
+
+				tlist = add_to_flat_tlist(tlist, list_make1(expr));
+			}
+		}
+	}
+
+	/* Store generated targetlist */
+	fpinfo->grouped_tlist = tlist;
+
+	/* Safe to pushdown */
+	fpinfo->pushdown_safe = true;
+
+	/*
+	 * Set # of retrieved rows and cached relation costs to some negative
+	 * value, so that we can detect when they are set to some sensible values,
+	 * during one (usually the first) of the calls to estimate_path_cost_size.
+	 */
+	fpinfo->retrieved_rows = -1;
+	fpinfo->rel_startup_cost = -1;
+	fpinfo->rel_total_cost = -1;
+
+	/*
+	 * Set the string describing this grouped relation to be used in EXPLAIN
+	 * output of corresponding ForeignScan.  Note that the decoration we add
+	 * to the base relation name mustn't include any digits, or it'll confuse
+	 * postgresExplainForeignScan.
+	 */
+
+	/*
+	 * Set the string describing this grouped relation to be used in EXPLAIN
+	 * output of corresponding ForeignScan.
+	 */
+	fpinfo->relation_name = makeStringInfo();
+
+	return true;
+}
+
+/*
+ * jdbc_add_foreign_grouping_paths Add foreign path for grouping and/or
+ * aggregation.
+ *
+ * Given input_rel represents the underlying scan.  The paths are added to
+ * the given grouped_rel.
+ */
+static void
+jdbc_add_foreign_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
+								RelOptInfo *grouped_rel
+#if (PG_VERSION_NUM >= 110000)
+								,GroupPathExtraData *extra
+#endif
+)
+{
+	Query	   *parse = root->parse;
+	jdbcFdwRelationInfo *ifpinfo = input_rel->fdw_private;
+	jdbcFdwRelationInfo *fpinfo = grouped_rel->fdw_private;
+	ForeignPath *grouppath;
+	double		rows;
+	int			width;
+	Cost		startup_cost;
+	Cost		total_cost;
+
+	/*
+	 * Nothing to be done, if there is no aggregation required. JDBC does not
+	 * support GROUP BY, GROUPING SET, HAVING, so also return when there are
+	 * those clauses.
+	 */
+	if (parse->groupClause ||
+		parse->groupingSets ||
+		root->hasHavingQual ||
+		!parse->hasAggs)
+		return;
+
+#if (PG_VERSION_NUM >= 110000)
+	Assert(extra->patype == PARTITIONWISE_AGGREGATE_NONE ||
+		   extra->patype == PARTITIONWISE_AGGREGATE_FULL);
+#endif
+
+	/* save the input_rel as outerrel in fpinfo */
+	fpinfo->outerrel = input_rel;
+
+	/*
+	 * Copy foreign table, foreign server, user mapping, FDW options etc.
+	 * details from the input relation's fpinfo.
+	 */
+	fpinfo->table = ifpinfo->table;
+	fpinfo->server = ifpinfo->server;
+	fpinfo->user = ifpinfo->user;
+	fpinfo->fetch_size = ifpinfo->fetch_size;
+
+	/*
+	 * Assess if it is safe to push down aggregation and grouping.
+	 *
+	 * Use HAVING qual from extra. In case of child partition, it will have
+	 * translated Vars.
+	 */
+	if (!jdbc_foreign_grouping_ok(root, grouped_rel))
+		return;
+
+	/*
+	 * Compute the selectivity and cost of the local_conds, so we don't have
+	 * to do it over again for each path.  (Currently we create just a single
+	 * path here, but in future it would be possible that we build more paths
+	 * such as pre-sorted paths as in postgresGetForeignPaths and
+	 * postgresGetForeignJoinPaths.)  The best we can do for these conditions
+	 * is to estimate selectivity on the basis of local statistics.
+	 */
+	fpinfo->local_conds_sel = clauselist_selectivity(root,
+													 fpinfo->local_conds,
+													 0,
+													 JOIN_INNER,
+													 NULL);
+
+	/* Use small cost to push down aggregate always */
+	rows = width = startup_cost = total_cost = 1;
+
+	/* Now update this information in the fpinfo */
+	fpinfo->rows = rows;
+	fpinfo->width = width;
+	fpinfo->startup_cost = startup_cost;
+	fpinfo->total_cost = total_cost;
+
+	/* Create and add foreign path to the grouping relation. */
+#if (PG_VERSION_NUM >= 120000)
+	grouppath = create_foreign_upper_path(root,
+										  grouped_rel,
+										  grouped_rel->reltarget,
+										  rows,
+										  startup_cost,
+										  total_cost,
+										  NIL,	/* no pathkeys */
+										  NULL,
+#if PG_VERSION_NUM >= 170000
+										  NIL,	/* no fdw_restrictinfo list */
+#endif
+										  NIL); /* no fdw_private */
+#else
+	grouppath = create_foreignscan_path(root,
+										grouped_rel,
+										root->upper_targets[UPPERREL_GROUP_AGG],
+										rows,
+										startup_cost,
+										total_cost,
+										NIL,	/* no pathkeys */
+										NULL,	/* no required_outer */
+										NULL,
+										NIL);	/* no fdw_private */
+#endif
+
+	/* Add generated path into grouped_rel by add_path(). */
+	add_path(grouped_rel, (Path *) grouppath);
+
+}
+
+/*
+ * jdbc_add_foreign_final_paths Add foreign paths for performing the final
+ * processing remotely.
+ *
+ * Given input_rel contains the source-data Paths.  The paths are added to
+ * the given final_rel.
+ */
+static void
+jdbc_add_foreign_final_paths(PlannerInfo *root, RelOptInfo *input_rel,
+							 RelOptInfo *final_rel
+#if (PG_VERSION_NUM >= 120000)
+							 ,FinalPathExtraData *extra
+#endif
+)
+{
+	Query	   *parse = root->parse;
+	jdbcFdwRelationInfo *ifpinfo = (jdbcFdwRelationInfo *) input_rel->fdw_private;
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) final_rel->fdw_private;
+	bool		has_final_sort = false;
+	List	   *pathkeys = NIL;
+	double		rows;
+	int			width;
+	Cost		startup_cost;
+	Cost		total_cost;
+	List	   *fdw_private;
+	ForeignPath *final_path;
+
+	/*
+	 * Currently, we only support this for SELECT commands
+	 */
+	if (parse->commandType != CMD_SELECT)
+		return;
+
+	/*
+	 * Currently, we do not support FOR UPDATE/SHARE
+	 */
+	if (parse->rowMarks)
+		return;
+
+	/*
+	 * No work if there is no FOR UPDATE/SHARE clause and if there is no need
+	 * to add a LIMIT node
+	 */
+	if (!parse->rowMarks
+#if (PG_VERSION_NUM >= 120000)
+		&& !extra->limit_needed
+#endif
+		)
+		return;
+
+#if (PG_VERSION_NUM >= 100000)
+	/* We don't support cases where there are any SRFs in the targetlist */
+	if (parse->hasTargetSRFs)
+		return;
+#endif
+	/* Save the input_rel as outerrel in fpinfo */
+	fpinfo->outerrel = input_rel;
+
+	/*
+	 * Copy foreign table, foreign server, user mapping, FDW options etc.
+	 * details from the input relation's fpinfo.
+	 */
+	fpinfo->table = ifpinfo->table;
+	fpinfo->server = ifpinfo->server;
+	fpinfo->user = ifpinfo->user;
+	fpinfo->fetch_size = ifpinfo->fetch_size;
+
+#if (PG_VERSION_NUM >= 120000)
+
+	/*
+	 * If there is no need to add a LIMIT node, there might be a ForeignPath
+	 * in the input_rel's pathlist that implements all behavior of the query.
+	 * Note: we would already have accounted for the query's FOR UPDATE/SHARE
+	 * (if any) before we get here.
+	 */
+	if (!extra->limit_needed)
+	{
+		ListCell   *lc;
+
+		Assert(parse->rowMarks);
+
+		/*
+		 * Grouping and aggregation are not supported with FOR UPDATE/SHARE,
+		 * so the input_rel should be a base, join, or ordered relation; and
+		 * if it's an ordered relation, its input relation should be a base or
+		 * join relation.
+		 */
+		Assert(input_rel->reloptkind == RELOPT_BASEREL ||
+			   input_rel->reloptkind == RELOPT_JOINREL ||
+			   (input_rel->reloptkind == RELOPT_UPPER_REL &&
+				ifpinfo->stage == UPPERREL_ORDERED &&
+				(ifpinfo->outerrel->reloptkind == RELOPT_BASEREL ||
+				 ifpinfo->outerrel->reloptkind == RELOPT_JOINREL)));
+
+		foreach(lc, input_rel->pathlist)
+		{
+			Path	   *path = (Path *) lfirst(lc);
+
+			/*
+			 * apply_scanjoin_target_to_paths() uses create_projection_path()
+			 * to adjust each of its input paths if needed, whereas
+			 * create_ordered_paths() uses apply_projection_to_path() to do
+			 * that.  So the former might have put a ProjectionPath on top of
+			 * the ForeignPath; look through ProjectionPath and see if the
+			 * path underneath it is ForeignPath.
+			 */
+			if (IsA(path, ForeignPath) ||
+				(IsA(path, ProjectionPath) &&
+				 IsA(((ProjectionPath *) path)->subpath, ForeignPath)))
+			{
+				/*
+				 * Create foreign final path; this gets rid of a
+				 * no-longer-needed outer plan (if any), which makes the
+				 * EXPLAIN output look cleaner
+				 */
+#if (PG_VERSION_NUM >= 120000)
+				final_path = create_foreign_upper_path(root,
+													   path->parent,
+													   path->pathtarget,
+													   path->rows,
+													   path->startup_cost,
+													   path->total_cost,
+													   path->pathkeys,
+													   NULL,	/* no extra plan */
+#if PG_VERSION_NUM >= 170000
+													   NIL, /* no fdw_restrictinfo
+															 * list */
+#endif
+													   NULL);	/* no fdw_private */
+#else
+				final_path = create_foreignscan_path(root,
+													 input_rel,
+													 root->upper_targets[UPPERREL_FINAL],
+													 rows,
+													 startup_cost,
+													 total_cost,
+													 pathkeys,
+													 NULL,	/* no required_outer */
+													 NULL,	/* no extra plan */
+													 fdw_private);
+#endif
+				/* and add it to the final_rel */
+				add_path(final_rel, (Path *) final_path);
+
+				/* Safe to push down */
+				fpinfo->pushdown_safe = true;
+
+				return;
+			}
+		}
+
+		/*
+		 * If we get here it means no ForeignPaths; since we would already
+		 * have considered pushing down all operations for the query to the
+		 * remote server, give up on it.
+		 */
+		return;
+	}
+
+	Assert(extra->limit_needed);
+#endif
+
+	/*
+	 * If the input_rel is an ordered relation, replace the input_rel with its
+	 * input relation
+	 */
+	if (input_rel->reloptkind == RELOPT_UPPER_REL &&
+		ifpinfo->stage == UPPERREL_ORDERED)
+	{
+		input_rel = ifpinfo->outerrel;
+		ifpinfo = (jdbcFdwRelationInfo *) input_rel->fdw_private;
+		has_final_sort = true;
+		pathkeys = root->sort_pathkeys;
+	}
+
+	/* The input_rel should be a base, join, or grouping relation */
+	Assert(input_rel->reloptkind == RELOPT_BASEREL ||
+		   input_rel->reloptkind == RELOPT_JOINREL ||
+		   (input_rel->reloptkind == RELOPT_UPPER_REL &&
+			ifpinfo->stage == UPPERREL_GROUP_AGG));
+
+	/*
+	 * We try to create a path below by extending a simple foreign path for
+	 * the underlying base, join, or grouping relation to perform the final
+	 * sort (if has_final_sort) and the LIMIT restriction remotely, which is
+	 * stored into the fdw_private list of the resulting path. (We re-estimate
+	 * the costs of sorting the underlying relation, if has_final_sort.)
+	 */
+
+	/*
+	 * Assess if it is safe to push down the LIMIT and OFFSET to the remote
+	 * server
+	 */
+
+	/*
+	 * If the underlying relation has any local conditions, the LIMIT/OFFSET
+	 * cannot be pushed down.
+	 */
+	if (ifpinfo->local_conds)
+		return;
+
+#if PG_VERSION_NUM >= 130000
+	/*
+	 * In PostgreSQL version is v13 or later, If the query has FETCH FIRST .. WITH TIES,
+	 * 1) it must have ORDER BY as well, which is used to determine which additional rows
+	 * tie for the last place in the result set, and 2) ORDER BY must already have been
+	 * determined to be safe to push down before we get here.  Since jdbc_fdw
+	 * does not currently support ORDER BY and FETCH FIRST .. WITH TIES clauses, disable
+	 * pushing the FETCH clause.
+	 */
+	if (parse->limitOption == LIMIT_OPTION_WITH_TIES)
+		return;
+#endif
+
+	/*
+	 * When query contains OFFSET but no LIMIT, do not push down because JDBC
+	 * does not support.
+	 */
+	if (!parse->limitCount && parse->limitOffset)
+		return;
+
+	/*
+	 * Also, the LIMIT/OFFSET cannot be pushed down, if their expressions are
+	 * not safe to remote.
+	 */
+	if (!jdbc_is_foreign_expr(root, input_rel, (Expr *) parse->limitOffset /* , true */ ) ||
+		!jdbc_is_foreign_expr(root, input_rel, (Expr *) parse->limitCount /* , true */ ))
+		return;
+
+	/* Safe to push down */
+	fpinfo->pushdown_safe = true;
+
+	/* Use small cost to push down limit always */
+	rows = width = startup_cost = total_cost = 1;
+	/* Now update this information in the fpinfo */
+	fpinfo->rows = rows;
+	fpinfo->width = width;
+	fpinfo->startup_cost = startup_cost;
+	fpinfo->total_cost = total_cost;
+
+	/*
+	 * Build the fdw_private list that will be used by postgresGetForeignPlan.
+	 * Items in the list must match order in enum FdwPathPrivateIndex.
+	 */
+#if PG_VERSION_NUM >= 150000
+	fdw_private = list_make2(makeBoolean(has_final_sort),
+							 makeBoolean(extra->limit_needed));
+#elif (PG_VERSION_NUM >= 120000)
+    fdw_private = list_make2(makeInteger(has_final_sort),
+							 makeInteger(extra->limit_needed));
+#else
+    fdw_private = list_make2(makeInteger(has_final_sort),
+                             makeInteger(false));
+#endif
+
+	/*
+	 * Create foreign final path; this gets rid of a no-longer-needed outer
+	 * plan (if any), which makes the EXPLAIN output look cleaner
+	 */
+#if (PG_VERSION_NUM >= 120000)
+	final_path = create_foreign_upper_path(root,
+										   input_rel,
+										   root->upper_targets[UPPERREL_FINAL],
+										   rows,
+										   startup_cost,
+										   total_cost,
+										   pathkeys,
+										   NULL,	/* no extra plan */
+#if PG_VERSION_NUM >= 170000
+										   NIL, /* no fdw_restrictinfo list */
+#endif
+										   fdw_private);
+#else
+	final_path = create_foreignscan_path(root,
+										 input_rel,
+										 root->upper_targets[UPPERREL_FINAL],
+										 rows,
+										 startup_cost,
+										 total_cost,
+										 pathkeys,
+										 NULL,	/* no required_outer */
+										 NULL,	/* no extra plan */
+										 fdw_private);
+#endif
+
+	/* and add it to the final_rel */
+	add_path(final_rel, (Path *) final_path);
+}
+
+/*
+ * jdbcGetForeignUpperPaths Add paths for post-join operations like
+ * aggregation, grouping etc. if corresponding operations are safe to push
+ * down. Currently, we only support push down LIMIT...OFFSET
+ */
+static void
+jdbcGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage,
+						 RelOptInfo *input_rel, RelOptInfo *output_rel
+#if (PG_VERSION_NUM >= 110000)
+						 ,
+						 void *extra
+#endif
+)
+{
+	jdbcFdwRelationInfo *fpinfo;
+
+	/*
+	 * If input rel is not safe to pushdown, then simply return as we cannot
+	 * perform any post-join operations on the foreign server.
+	 */
+	if (!input_rel->fdw_private ||
+		!((jdbcFdwRelationInfo *) input_rel->fdw_private)->pushdown_safe)
+		return;
+
+	/*
+	 * Ignore stages we don't support; and skip any duplicate calls. We only
+	 * support LIMIT...OFFSET and aggregation push down
+	 */
+	if ((stage != UPPERREL_GROUP_AGG &&
+		 stage != UPPERREL_FINAL) ||
+		output_rel->fdw_private)
+		return;
+
+	fpinfo = (jdbcFdwRelationInfo *) palloc0(sizeof(jdbcFdwRelationInfo));
+	fpinfo->pushdown_safe = false;
+	fpinfo->stage = stage;
+	output_rel->fdw_private = fpinfo;
+
+	switch (stage)
+	{
+		case UPPERREL_GROUP_AGG:
+			jdbc_add_foreign_grouping_paths(root, input_rel, output_rel
+#if (PG_VERSION_NUM >= 110000)
+											,(GroupPathExtraData *) extra
+#endif
+				);
+			break;
+		case UPPERREL_FINAL:
+			jdbc_add_foreign_final_paths(root, input_rel, output_rel
+#if (PG_VERSION_NUM >= 120000)
+										 ,(FinalPathExtraData *) extra
+#endif
+				);
+			break;
+		default:
+			elog(ERROR, "unexpected upper relation: %d", (int) stage);
+			break;
+	}
+}
+
+/*
+ * estimate_path_cost_size Get cost and size estimates for a foreign scan
+ * on given foreign relation, either a base relation or a join between
+ * foreign relations.
+ *
+ * We assume that all the baserestrictinfo clauses will be applied, plus any
+ * join clauses listed in join_conds.
+ */
+static void
+estimate_path_cost_size(PlannerInfo *root,
+						RelOptInfo *baserel,
+						List *join_conds,
+						double *p_rows, int *p_width,
+						Cost *p_startup_cost,
+						Cost *p_total_cost,
+						char *q_char)
+{
+	jdbcFdwRelationInfo *fpinfo = (jdbcFdwRelationInfo *) baserel->fdw_private;
+	double		rows;
+	double		retrieved_rows;
+	int			width;
+	Cost		startup_cost;
+	Cost		total_cost;
+	Cost		run_cost;
+	Cost		cpu_per_tuple;
+
+	/*
+	 * If the table or the server is configured to use remote estimates,
+	 * connect to the foreign server and execute EXPLAIN to estimate the
+	 * number of rows selected by the restriction+join clauses. Otherwise,
+	 * estimate rows using whatever statistics we have locally, in a way
+	 * similar to ordinary tables.
+	 */
+	if (fpinfo->use_remote_estimate)
+	{
+		List	   *remote_join_conds;
+		List	   *local_join_conds;
+		StringInfoData sql;
+		List	   *retrieved_attrs;
+		JDBCUtilsInfo	   *jdbcUtilsInfo;
+		Selectivity local_sel;
+		QualCost	local_cost;
+		List	   *fdw_scan_tlist = NIL;
+		List	   *remote_conds;
+
+		/*
+		 * join_conds might contain both clauses that are safe to send across,
+		 * and clauses that aren't.
+		 */
+		jdbc_classify_conditions(root, baserel, join_conds,
+								 &remote_join_conds, &local_join_conds);
+
+		/*
+		 * Build the list of columns to be fetched from the foreign server.
+		 */
+		if (IS_JOIN_REL(baserel) || IS_UPPER_REL(baserel))
+			fdw_scan_tlist = jdbc_build_tlist_to_deparse(baserel);
+		else
+			fdw_scan_tlist = NIL;
+
+		/*
+		 * Only baserestrictinfo is sent to the remote server.  A join clause
+		 * would need a value for the Vars of the other relation, and a
+		 * constant dummy value such as NULL makes the remote planner expect
+		 * no row at all; not every remote database has a typed non-constant
+		 * expression to use instead.  The selectivity of join_conds is
+		 * estimated locally below, like for local join clauses.
+		 */
+		remote_conds = fpinfo->remote_conds;
+
+		/*
+		 * Construct the query to estimate, including the desired SELECT,
+		 * FROM, and WHERE clauses.
+		 */
+		initStringInfo(&sql);
+		jdbc_deparse_select_stmt_for_rel(&sql, root, baserel, remote_conds,
+										 NULL, &retrieved_attrs, NULL, fdw_scan_tlist,
+										 NULL, true, fpinfo->remote_conds,
+										 NIL, q_char);
+
+		/*
+		 * Get the remote estimate.  The width is only given by some remote
+		 * servers, use the local estimate otherwise.
+		 */
+		width = baserel->reltarget->width;
+		jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo->server, fpinfo->user, false);
+		get_remote_estimate(sql.data, fpinfo->server, fpinfo->user, jdbcUtilsInfo,
+							&rows, &width, &startup_cost, &total_cost);
+		jdbc_release_jdbc_utils_obj();
+
+		retrieved_rows = rows;
+
+		/*
+		 * Factor in the selectivity of the locally-checked quals and of the
+		 * join clauses the remote server did not see.
+		 */
+		local_sel = clauselist_selectivity(root,
+										   join_conds,
+										   baserel->relid,
+										   JOIN_INNER,
+										   NULL);
+		local_sel *= fpinfo->local_conds_sel;
+
+		rows = clamp_row_est(rows * local_sel);
+
+		/*
+		 * The remote server only sends the rows matching the pushed-down
+		 * join clauses.  Assume that it finds them at a proportional part of
+		 * the run cost of the unparameterized query.
+		 */
+		if (remote_join_conds != NIL)
+		{
+			Selectivity join_sel = clauselist_selectivity(root,
+														  remote_join_conds,
+														  baserel->relid,
+														  JOIN_INNER,
+														  NULL);
+
+			retrieved_rows = clamp_row_est(retrieved_rows * join_sel);
+			total_cost = startup_cost + (total_cost - startup_cost) * join_sel;
+		}
+
+		/* Add in the eval cost of the locally-checked quals */
+		startup_cost += fpinfo->local_conds_cost.startup;
+		total_cost += fpinfo->local_conds_cost.per_tuple * retrieved_rows;
+		cost_qual_eval(&local_cost, local_join_conds, root);
+		startup_cost += local_cost.startup;
+		total_cost += local_cost.per_tuple * retrieved_rows;
+	}
+	else
+	{
+		/*
+		 * Use rows/width estimates made by set_baserel_size_estimates for
+		 * base foreign relations and set_joinrel_size_estimates for join
+		 * between foreign relations.  Join conditions are only given for
+		 * parameterized scans of base relations, whose size is estimated as
+		 * for a parameterized path of an ordinary table.
+		 */
+		if (join_conds != NIL)
+			rows = get_parameterized_baserel_size(root, baserel, join_conds);
+		else
+			rows = baserel->rows;
+		width = baserel->reltarget->width;
+
+		/* Back into an estimate of the number of retrieved rows. */
+		retrieved_rows = clamp_row_est(rows / fpinfo->local_conds_sel);
+
+		if (IS_JOIN_REL(baserel))
+		{
+			jdbcFdwRelationInfo *fpinfo_i;
+			jdbcFdwRelationInfo *fpinfo_o;
+			QualCost	join_cost;
+			QualCost	remote_conds_cost;
+			double		nrows;
+
+			/* For join we expect inner and outer relations set */
+			Assert(fpinfo->innerrel && fpinfo->outerrel);
+
+			fpinfo_i = (jdbcFdwRelationInfo *) fpinfo->innerrel->fdw_private;
+			fpinfo_o = (jdbcFdwRelationInfo *) fpinfo->outerrel->fdw_private;
+
+			/* Estimate of number of rows in cross product */
+			nrows = fpinfo_i->rows * fpinfo_o->rows;
+
+			/* Clamp retrieved rows estimate to at most size of cross product */
+			retrieved_rows = Min(retrieved_rows, nrows);
+
+			/*
+			 * The cost of foreign join is estimated as cost of generating
+			 * rows for the joining relations + cost for applying quals on the
+			 * rows.
+			 */
+
+			/*
+			 * Calculate the cost of clauses pushed down to the foreign server
+			 */
+			cost_qual_eval(&remote_conds_cost, fpinfo->remote_conds, root);
+			/* Calculate the cost of applying join clauses */
+			cost_qual_eval(&join_cost, fpinfo->joinclauses, root);
+
+			/*
+			 * Startup cost includes startup cost of joining relations and the
+			 * startup cost for join and other clauses. We do not include the
+			 * startup cost specific to join strategy (e.g. setting up hash
+			 * tables) since we do not know what strategy the foreign server
+			 * is going to use.
+			 */
+			startup_cost = fpinfo_i->rel_startup_cost + fpinfo_o->rel_startup_cost;
+			startup_cost += join_cost.startup;
+			startup_cost += remote_conds_cost.startup;
+			startup_cost += fpinfo->local_conds_cost.startup;
+
+			/*
+			 * Run time cost includes:
+			 *
+			 * 1. Run time cost (total_cost - startup_cost) of relations being
+			 * joined
+			 *
+			 * 2. Run time cost of applying join clauses on the cross product
+			 * of the joining relations.
+			 *
+			 * 3. Run time cost of applying pushed down other clauses on the
+			 * result of join
+			 *
+			 * 4. Run time cost of applying nonpushable other clauses locally
+			 * on the result fetched from the foreign server.
+			 */
+			run_cost = fpinfo_i->rel_total_cost - fpinfo_i->rel_startup_cost;
+			run_cost += fpinfo_o->rel_total_cost - fpinfo_o->rel_startup_cost;
+			run_cost += nrows * join_cost.per_tuple;
+			nrows = clamp_row_est(nrows * fpinfo->joinclause_sel);
+			run_cost += nrows * remote_conds_cost.per_tuple;
+			run_cost += fpinfo->local_conds_cost.per_tuple * retrieved_rows;
+
+			total_cost = startup_cost + run_cost;
+		}
+		else if (join_conds != NIL)
+		{
+			QualCost	join_cost;
+
+			/* Just in case this is nuts, clamp to at most baserel->tuples. */
+			retrieved_rows = Min(retrieved_rows, baserel->tuples);
+
+			/*
+			 * Parameterized paths are only made for join clauses on key
+			 * columns in this mode, so cost this as though it were an index
+			 * scan fetching one page per retrieved row.  The join clauses are
+			 * evaluated remotely along with the other quals.
+			 */
+			cost_qual_eval(&join_cost, join_conds, root);
+
+			startup_cost = baserel->baserestrictcost.startup + join_cost.startup;
+			run_cost = random_page_cost * Min(retrieved_rows, baserel->pages);
+			cpu_per_tuple = cpu_tuple_cost + baserel->baserestrictcost.per_tuple +
+				join_cost.per_tuple;
+			run_cost += cpu_per_tuple * retrieved_rows;
+
+			total_cost = startup_cost + run_cost;
+		}
+		else
+		{
+			/* Just in case this is nuts, clamp to at most baserel->tuples. */
+			retrieved_rows = Min(retrieved_rows, baserel->tuples);
+
+			/*
+			 * Cost as though this were a seqscan, which is pessimistic. We
+			 * effectively imagine the local_conds are being evaluated
+			 * remotely, too.
+			 */
+			startup_cost = 0;
+			run_cost = 0;
+			run_cost += seq_page_cost * baserel->pages;
+
+			startup_cost += baserel->baserestrictcost.startup;
+			cpu_per_tuple = cpu_tuple_cost + baserel->baserestrictcost.per_tuple;
+			run_cost += cpu_per_tuple * baserel->tuples;
+
+			total_cost = startup_cost + run_cost;
+		}
+	}
+
+	/*
+	 * Cache the retrieved rows and the cost of the scan without the cost of
+	 * transferring the data, so that the cost of a join of this relation can
+	 * be built on them.
+	 */
+	if (join_conds == NIL)
+	{
+		fpinfo->retrieved_rows = retrieved_rows;
+		fpinfo->rel_startup_cost = startup_cost;
+		fpinfo->rel_total_cost = total_cost;
+	}
+
+	/*
+	 * Add some additional cost factors to account for connection overhead
+	 * (fdw_startup_cost), transferring data across the network
+	 * (fdw_tuple_cost per retrieved row), and local manipulation of the data
+	 * (cpu_tuple_cost per retrieved row).
+	 */
+	startup_cost += fpinfo->fdw_startup_cost;
+	total_cost += fpinfo->fdw_startup_cost;
+	total_cost += fpinfo->fdw_tuple_cost * retrieved_rows;
+	total_cost += cpu_tuple_cost * retrieved_rows;
+
+	/* Return results. */
+	*p_rows = rows;
+	*p_width = width;
+	*p_startup_cost = startup_cost;
+	*p_total_cost = total_cost;
+}
+
+/*
+ * get_remote_estimate Estimate costs of executing a SELECT statement
+ * remotely.
+ *
+ * The statement is explained in the format of the dialect of the remote
+ * server: the cost line of the top plan node for PostgreSQL, and the JSON
+ * plan for MySQL.  Other databases have no EXPLAIN output we can read, so
+ * the rows of the statement are counted, and its cost is that of
+ * returning them.  *width is only set for PostgreSQL.
+ *
+ * As this costs a round trip, and for other databases a full execution,
+ * the estimates are kept for estimate_cache_ttl seconds per server, user
+ * and statement, to be reused by the planning of later queries.
+ */
+static void
+get_remote_estimate(const char *sql, ForeignServer *server, UserMapping *user,
+					JDBCUtilsInfo * jdbcUtilsInfo,
+					double *rows, int *width,
+					Cost *startup_cost, Cost *total_cost)
+{
+	int			ttl = DEFAULT_ESTIMATE_CACHE_TTL;
+	jdbcEstimateKey key;
+	jdbcEstimateEntry *entry;
+	StringInfoData explain;
+	JdbcDialect dialect;
+	ListCell   *lc;
+	MemoryContext oldcontext;
+	bool		found;
+
+	foreach(lc, server->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "estimate_cache_ttl") == 0)
+			(void) parse_int(defGetString(def), &ttl, 0, NULL);
+	}
+
+	key.serverid = server->serverid;
+	key.userid = user->userid;
+	key.query = sql;
+
+	/* Use a cached estimate which is recent enough */
+	if (ttl > 0 && EstimateCache != NULL)
+	{
+		entry = (jdbcEstimateEntry *) hash_search(EstimateCache, &key, HASH_FIND, NULL);
+		if (entry != NULL &&
+			!TimestampDifferenceExceeds(entry->created, GetCurrentTimestamp(), ttl * 1000))
+		{
+			*rows = entry->rows;
+			*width = entry->width;
+			*startup_cost = entry->startup_cost;
+			*total_cost = entry->total_cost;
+			return;
+		}
+	}
+
+	dialect = jdbc_get_dialect(server, jdbcUtilsInfo);
+	initStringInfo(&explain);
+
+	if (dialect == JDBC_DIALECT_POSTGRESQL)
+	{
+		Datum		value;
+		bool		isnull;
+		char	   *line;
+		char	   *p;
+		int			n;
+
+		/*
+		 * Extract cost numbers for topmost plan node, which is on the first
+		 * line.  Note we search for a left paren from the end of the line to
+		 * avoid being confused by other uses of parentheses.
+		 */
+		appendStringInfo(&explain, "EXPLAIN %s", sql);
+		value = jdbc_get_remote_value(jdbcUtilsInfo, explain.data, TEXTOID, &isnull);
+		if (isnull)
+			elog(ERROR, "could not get EXPLAIN output for query: %s", sql);
+		line = TextDatumGetCString(value);
+		p = strrchr(line, '(');
+		if (p == NULL)
+			elog(ERROR, "could not interpret EXPLAIN output: \"%s\"", line);
+		n = sscanf(p, "(cost=%lf..%lf rows=%lf width=%d)",
+				   startup_cost, total_cost, rows, width);
+		if (n != 4)
+			elog(ERROR, "could not interpret EXPLAIN output: \"%s\"", line);
+	}
+	else if (dialect == JDBC_DIALECT_MYSQL)
+	{
+		Datum		value;
+		bool		isnull;
+		char	   *json;
+
+		appendStringInfo(&explain, "EXPLAIN FORMAT=JSON %s", sql);
+		value = jdbc_get_remote_value(jdbcUtilsInfo, explain.data, TEXTOID, &isnull);
+		if (isnull)
+			elog(ERROR, "could not get EXPLAIN output for query: %s", sql);
+		json = TextDatumGetCString(value);
+		if (!jdbc_parse_mysql_explain(json, rows, total_cost))
+			elog(ERROR, "could not interpret EXPLAIN output: \"%s\"", json);
+		*startup_cost = 0;
+	}
+	else
+	{
+		appendStringInfo(&explain, "SELECT COUNT(*) FROM (%s) q", sql);
+		*rows = Max(jdbc_get_remote_number(jdbcUtilsInfo, explain.data), 0);
+		*startup_cost = 0;
+		*total_cost = cpu_tuple_cost * *rows;
+	}
+
+	if (ttl <= 0)
+		return;
+
+	/*
+	 * Remember the estimate.  The cache is simply emptied when it is full.
+	 */
+	if (EstimateCache == NULL ||
+		hash_get_num_entries(EstimateCache) >= ESTIMATE_CACHE_MAX_ENTRIES)
+	{
+		HASHCTL		ctl;
+
+		if (EstimateCacheContext == NULL)
+			EstimateCacheContext = AllocSetContextCreate(CacheMemoryContext,
+														 "jdbc_fdw remote estimates",
+														 ALLOCSET_DEFAULT_MINSIZE,
+														 ALLOCSET_DEFAULT_INITSIZE,
+														 ALLOCSET_DEFAULT_MAXSIZE);
+		else
+			MemoryContextReset(EstimateCacheContext);
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(jdbcEstimateKey);
+		ctl.entrysize = sizeof(jdbcEstimateEntry);
+		ctl.hash = jdbc_estimate_key_hash;
+		ctl.match = jdbc_estimate_key_match;
+		ctl.hcxt = EstimateCacheContext;
+		EstimateCache = hash_create("jdbc_fdw remote estimates", 64, &ctl,
+									HASH_ELEM | HASH_FUNCTION | HASH_COMPARE |
+									HASH_CONTEXT);
+	}
+
+	entry = (jdbcEstimateEntry *) hash_search(EstimateCache, &key, HASH_ENTER, &found);
+	if (!found)
+	{
+		oldcontext = MemoryContextSwitchTo(EstimateCacheContext);
+		entry->key.query = pstrdup(sql);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	entry->created = GetCurrentTimestamp();
+	entry->rows = *rows;
+	entry->width = *width;
+	entry->startup_cost = *startup_cost;
+	entry->total_cost = *total_cost;
+}
+
+/*
+ * jdbc_parse_mysql_explain Get the estimates of the query from the output of
+ * MySQL EXPLAIN FORMAT=JSON.
+ *
+ * The rows of a query are those produced by the last table of its join
+ * order, and its cost is the query_cost of the outermost query block.
+ * MariaDB only reports the rows of each table, and no cost.
+ */
+static bool
+jdbc_parse_mysql_explain(const char *json, double *rows, Cost *total_cost)
+{
+	const char *value;
+
+	value = jdbc_find_json_member(json, "rows_produced_per_join", true);
+	if (value == NULL)
+		value = jdbc_find_json_member(json, "rows", true);
+	if (value == NULL)
+		return false;
+	*rows = strtod(value, NULL);
+
+	value = jdbc_find_json_member(json, "query_cost", false);
+	if (value != NULL)
+		*total_cost = strtod(value, NULL);
+	else
+		*total_cost = cpu_tuple_cost * *rows;
+
+	return true;
+}
+
+/*
+ * jdbc_find_json_member Find the first or last member of the given name in
+ * a JSON text, and return the start of its value, after the quote of a
+ * string.  Returns NULL if there is none.
+ */
+static const char *
+jdbc_find_json_member(const char *json, const char *name, bool last)
+{
+	const char *found = NULL;
+	const char *p = json;
+	size_t		len = strlen(name);
+
+	while ((p = strchr(p, '"')) != NULL)
+	{
+		const char *value = p + 1;
+
+		if (strncmp(value, name, len) == 0 && value[len] == '"')
+		{
+			/* skip the JSON whitespace around the colon, and a quote */
+			value += len + 1;
+			value += strspn(value, " \t\n\r");
+			if (*value == ':')
+			{
+				value++;
+				value += strspn(value, " \t\n\r\"");
+				found = value;
+				if (!last)
+					break;
+			}
+		}
+		p++;
+	}
+
+	return found;
+}
+
+/*
+ * Hash and match functions of the cache of remote estimates.
+ */
+static uint32
+jdbc_estimate_key_hash(const void *key, Size keysize)
+{
+	const		jdbcEstimateKey *k = (const jdbcEstimateKey *) key;
+
+	return DatumGetUInt32(hash_any((const unsigned char *) k->query,
+								   strlen(k->query)));
+}
+
+static int
+jdbc_estimate_key_match(const void *key1, const void *key2, Size keysize)
+{
+	const		jdbcEstimateKey *k1 = (const jdbcEstimateKey *) key1;
+	const		jdbcEstimateKey *k2 = (const jdbcEstimateKey *) key2;
+
+	if (k1->serverid != k2->serverid || k1->userid != k2->userid)
+		return 1;
+	return strcmp(k1->query, k2->query);
+}
+
+/*
+ * Force assorted GUC parameters to settings that ensure that we'll output
+ * data values in a form that is unambiguous to the remote server.
+ *
+ * This is rather expensive and annoying to do once per row, but there's
+ * little choice if we want to be sure values are transmitted accurately; we
+ * can't leave the settings in place between rows for fear of affecting
+ * user-visible computations.
+ *
+ * We use the equivalent of a function SET option to allow the settings to
+ * persist only until the caller calls jdbc_reset_transmission_modes().  If
+ * an error is thrown in between, guc.c will take care of undoing the
+ * settings.
+ *
+ * The return value is the nestlevel that must be passed to
+ * jdbc_reset_transmission_modes() to undo things.
+ */
+int
+jdbc_set_transmission_modes(void)
+{
+	int			nestlevel = NewGUCNestLevel();
+
+	/*
+	 * The values set here should match what pg_dump does.  See also
+	 * configure_remote_session in connection.c.
+	 */
+	if (DateStyle != USE_ISO_DATES)
+		(void) set_config_option("datestyle", "ISO",
+								 PGC_USERSET, PGC_S_SESSION,
+								 GUC_ACTION_SAVE, true, 0, false);
+	if (IntervalStyle != INTSTYLE_POSTGRES)
+		(void) set_config_option("intervalstyle", "postgres",
+								 PGC_USERSET, PGC_S_SESSION,
+								 GUC_ACTION_SAVE, true, 0, false);
+	if (extra_float_digits < 3)
+		(void) set_config_option("extra_float_digits", "3",
+								 PGC_USERSET, PGC_S_SESSION,
+								 GUC_ACTION_SAVE, true, 0, false);
+	/*
+	 * In addition force restrictive search_path, in case there are any
+	 * regproc or similar constants to be printed.
+	 */
+	(void) set_config_option("search_path", "pg_catalog",
+							 PGC_USERSET, PGC_S_SESSION,
+							 GUC_ACTION_SAVE, true, 0, false);
+
+	return nestlevel;
+}
+
+/*
+ * Undo the effects of jdbc_set_transmission_modes().
+ */
+void
+jdbc_reset_transmission_modes(int nestlevel)
+{
+	AtEOXact_GUC(true, nestlevel);
+}
+
+/*
+ * jdbc_create_foreign_modify
+ *		Construct an execution state of a foreign insert/update/delete
+ *		operation.  The caller fills in the query text.
+ */
+static jdbcFdwModifyState *
+jdbc_create_foreign_modify(EState *estate,
+						   ResultRelInfo *resultRelInfo,
+						   CmdType operation,
+						   Plan *subplan,
+						   Oid userid,
+						   List *target_attrs)
+{
+	jdbcFdwModifyState *fmstate;
+	Relation	rel = resultRelInfo->ri_RelationDesc;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	AttrNumber	n_params;
+	Oid		   *p_types;
+	Oid			typefnoid = InvalidOid;
+	bool		isvarlena = false;
+	ListCell   *lc;
+	ForeignServer *server;
+	UserMapping *user;
+	ForeignTable *table;
+	Oid			foreignTableId = RelationGetRelid(rel);
+	int			i;
+
+	/* Get info about foreign table. */
+	table = GetForeignTable(foreignTableId);
+	server = GetForeignServer(table->serverid);
+	user = GetUserMapping(userid, server->serverid);
+
+	/* Begin constructing jdbcFdwModifyState. */
+	fmstate = (jdbcFdwModifyState *) palloc0(sizeof(jdbcFdwModifyState));
+	fmstate->rel = rel;
+	fmstate->operation = operation;
+
+	/* Open connection; report that we'll create a prepared statement. */
+	fmstate->jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(server, user, true);
+	fmstate->is_prepared = false;	/* prepared statement not made yet */
+
+	fmstate->target_attrs = target_attrs;
+
+	/* Create context for per-tuple temp workspace. */
+#if PG_VERSION_NUM >= 110000
+	fmstate->temp_cxt = AllocSetContextCreate(estate->es_query_cxt,
+											  "jdbc_fdw temporary data",
+											  ALLOCSET_DEFAULT_SIZES);
+#else
+	fmstate->temp_cxt = AllocSetContextCreate(estate->es_query_cxt,
+											  "jdbc_fdw temporary data",
+											  ALLOCSET_SMALL_MINSIZE,
+											  ALLOCSET_SMALL_INITSIZE,
+											  ALLOCSET_SMALL_MAXSIZE);
+#endif
+
+	/* Prepare for output conversion of parameters used in prepared stmt. */
+	n_params = list_length(fmstate->target_attrs) + 1;
+	fmstate->p_flinfo = (FmgrInfo *) palloc0(sizeof(FmgrInfo) * n_params);
+	fmstate->p_nums = 0;
+
+	/* Set up for remaining transmittable parameters */
+	foreach(lc, fmstate->target_attrs)
+	{
+		int			attnum = lfirst_int(lc);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+
+		Assert(!attr->attisdropped);
+
+		getTypeOutputInfo(attr->atttypid, &typefnoid, &isvarlena);
+		fmgr_info(typefnoid, &fmstate->p_flinfo[fmstate->p_nums]);
+		fmstate->p_nums++;
+	}
+	Assert(fmstate->p_nums <= n_params);
+
+	/* Set batch_size and bulk_load from foreign server/table options. */
+	if (operation == CMD_INSERT)
+	{
+		fmstate->batch_size = jdbc_get_batch_size_option(rel);
+		fmstate->bulk_load = jdbc_get_bulk_load_option(rel);
+		fmstate->async_write = jdbc_get_async_write_option(rel);
+	}
+	else
+		fmstate->batch_size = 1;
+
+	/*
+	 * For primary key columns, get the resjunk attribute number and store
+	 * it.  There is no subplan when rows are routed into the table by COPY
+	 * or by tuple routing.
+	 */
+	fmstate->junk_idx = palloc0(tupdesc->natts * sizeof(AttrNumber));
+	for (i = 0; i < tupdesc->natts && subplan != NULL; ++i)
+	{
+		fmstate->junk_idx[i] =
+			ExecFindJunkAttributeInTlist(subplan->targetlist,
+										 get_attname(foreignTableId, i + 1
+#if (PG_VERSION_NUM >= 110000)
+													 ,false
+#endif
+													 ));
+	}
+
+	/*
+	 * Key columns passed up as resjunk columns are bound after the target
+	 * columns, for the WHERE clause of UPDATE and DELETE.
+	 */
+	fmstate->key_attrs = NIL;
+	for (i = 0; i < tupdesc->natts && operation != CMD_INSERT; ++i)
+	{
+		ListCell   *option;
+
+		if (fmstate->junk_idx[i] == InvalidAttrNumber)
+			continue;
+		foreach(option, GetForeignColumnOptions(foreignTableId, i + 1))
+		{
+			DefElem    *def = (DefElem *) lfirst(option);
+
+			if (IS_KEY_COLUMN(def))
+				fmstate->key_attrs = lappend_int(fmstate->key_attrs, i + 1);
+		}
+	}
+
+	/* Prepare for binding all parameters of a row at once. */
+	n_params = list_length(fmstate->target_attrs) + list_length(fmstate->key_attrs);
+	p_types = (Oid *) palloc0(Max(n_params, 1) * sizeof(Oid));
+	fmstate->p_values = (Datum *) palloc0(Max(n_params, 1) * sizeof(Datum));
+	fmstate->p_isnull = (bool *) palloc0(Max(n_params, 1) * sizeof(bool));
+	i = 0;
+	foreach(lc, fmstate->target_attrs)
+		p_types[i++] = TupleDescAttr(tupdesc, lfirst_int(lc) - 1)->atttypid;
+	foreach(lc, fmstate->key_attrs)
+		p_types[i++] = TupleDescAttr(tupdesc, lfirst_int(lc) - 1)->atttypid;
+	jq_init_param_buffer(&fmstate->param_buffer, n_params, p_types);
+
+	/*
+	 * Collect the keys of the rows to update or delete, and send them in
+	 * statements matching key_batch_size key sets at once.  Not done with
+	 * triggers, which must see each row modified before they fire, nor with
+	 * RETURNING, which needs the row returned for each of them.  The
+	 * number of key sets is limited by the parameters the remote database
+	 * allows in a statement.
+	 */
+	fmstate->key_batch_size = 1;
+	if ((operation == CMD_UPDATE || operation == CMD_DELETE) &&
+		fmstate->key_attrs != NIL &&
+		resultRelInfo->ri_TrigDesc == NULL &&
+		resultRelInfo->ri_returningList == NIL)
+	{
+		int			n_targets = list_length(fmstate->target_attrs);
+		int			n_keys = list_length(fmstate->key_attrs);
+		int			key_batch_size = jdbc_get_key_batch_size_option(rel);
+
+		if (key_batch_size > 1)
+			key_batch_size = Min(key_batch_size,
+								 (jq_get_max_parameters(fmstate->jdbcUtilsInfo) - n_targets) / n_keys);
+		if (key_batch_size > 1)
+		{
+			Oid		   *keyset_types;
+			int			n_keyset_params = n_targets + key_batch_size * n_keys;
+
+			fmstate->key_batch_size = key_batch_size;
+			fmstate->keyset_values = (Datum *) palloc0(n_keyset_params * sizeof(Datum));
+			fmstate->keyset_isnull = (bool *) palloc0(n_keyset_params * sizeof(bool));
+			fmstate->keyset_typlen = (int16 *) palloc0(n_params * sizeof(int16));
+			fmstate->keyset_typbyval = (bool *) palloc0(n_params * sizeof(bool));
+			for (i = 0; i < n_params; i++)
+				get_typlenbyval(p_types[i], &fmstate->keyset_typlen[i],
+								&fmstate->keyset_typbyval[i]);
+
+			/* The SET values, then the key columns of each key set */
+			keyset_types = (Oid *) palloc0(n_keyset_params * sizeof(Oid));
+			memcpy(keyset_types, p_types, n_targets * sizeof(Oid));
+			for (i = n_targets; i < n_keyset_params; i++)
+				keyset_types[i] = p_types[n_targets + (i - n_targets) % n_keys];
+			jq_init_param_buffer(&fmstate->keyset_buffer, n_keyset_params, keyset_types);
+
+#if PG_VERSION_NUM >= 110000
+			fmstate->keyset_cxt = AllocSetContextCreate(estate->es_query_cxt,
+														"jdbc_fdw key sets",
+														ALLOCSET_DEFAULT_SIZES);
+#else
+			fmstate->keyset_cxt = AllocSetContextCreate(estate->es_query_cxt,
+														"jdbc_fdw key sets",
+														ALLOCSET_SMALL_MINSIZE,
+														ALLOCSET_SMALL_INITSIZE,
+														ALLOCSET_SMALL_MAXSIZE);
+#endif
+		}
+	}
+
+	return fmstate;
+}
+
+/*
+ * jdbc_prepare_foreign_modify Establish a prepared statement for execution
+ * of INSERT/UPDATE/DELETE
+ */
+static void
+jdbc_prepare_foreign_modify(jdbcFdwModifyState * fmstate)
+{
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jdbc_prepare_foreign_modify")));
+
+	/*
+	 * We intentionally do not specify parameter types here, but leave the
+	 * remote server to derive them by default.  This avoids possible problems
+	 * with the remote server using different type OIDs than we do.  All of
+	 * the prepared statements we use in this module are simple enough that
+	 * the remote server will make the right choices.
+	 *
+	 * We don't use a PG_TRY block here, so be careful not to throw error
+	 * without releasing the Jresult.
+	 */
+	if (fmstate->has_returning)
+		res = jq_prepare_returning(fmstate->jdbcUtilsInfo,
+								   fmstate->query,
+								   fmstate->returning_names,
+								   &fmstate->resultSetID);
+	else
+		res = jq_prepare(fmstate->jdbcUtilsInfo,
+						 fmstate->query,
+						 NULL,
+						 &fmstate->resultSetID);
+
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
+	jq_clear(res);
+
+	/* This action shows that the prepare has been done. */
+	fmstate->is_prepared = true;
+}
+
+/*
+ * jdbc_check_returning_attrs
+ *		Check that the remote server can return the columns retrieved_attrs
+ *		used by RETURNING.  Only PostgreSQL returns the columns of the rows
+ *		through getGeneratedKeys; other drivers return the keys they
+ *		generate for the rows inserted, if any, and nothing for an UPDATE or
+ *		DELETE.  Any other column would silently be the value sent.
+ */
+static void
+jdbc_check_returning_attrs(Relation rel, CmdType operation,
+						   List *retrieved_attrs, JdbcDialect dialect)
+{
+	List	   *key_attrs;
+	ListCell   *lc;
+
+	if (dialect == JDBC_DIALECT_POSTGRESQL)
+		return;
+
+	if (operation != CMD_INSERT)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+				 errmsg("RETURNING clause of UPDATE or DELETE is only supported on a PostgreSQL remote server")));
+
+	key_attrs = jdbc_get_key_attrs(rel);
+	foreach(lc, retrieved_attrs)
+	{
+		if (!list_member_int(key_attrs, lfirst_int(lc)))
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+					 errmsg("RETURNING clause of INSERT can only return key columns unless the remote server is PostgreSQL"),
+					 errdetail("Column \"%s\" of foreign table \"%s\" is not a key column.",
+							   get_attname(RelationGetRelid(rel), lfirst_int(lc)
+#if PG_VERSION_NUM >= 110000
+										   ,false
+#endif
+										   ),
+							   RelationGetRelationName(rel))));
+	}
+}
+
+/*
+ * jdbc_init_returning
+ *		Set up reading back the columns retrieved_attrs used by RETURNING,
+ *		and disable the batch paths, which do not return the rows sent.
+ */
+static void
+jdbc_init_returning(jdbcFdwModifyState * fmstate, bool has_returning,
+					List *retrieved_attrs)
+{
+	ListCell   *lc;
+
+	fmstate->has_returning = has_returning;
+	fmstate->retrieved_attrs = retrieved_attrs;
+	if (!has_returning)
+		return;
+
+	fmstate->bulk_load = false;
+	fmstate->async_write = false;
+
+	/* The driver is asked for the columns by their remote names */
+	fmstate->returning_names = NIL;
+	foreach(lc, retrieved_attrs)
+		fmstate->returning_names = lappend(fmstate->returning_names,
+										   jdbc_get_column_name(RelationGetRelid(fmstate->rel),
+																lfirst_int(lc)));
+}
+
+/*
+ * jdbc_map_returning_columns
+ *		Match the columns of the first result of getGeneratedKeys with the
+ *		columns of the foreign table, by their remote names.  A driver that
+ *		only returns the keys it generates may name the single key after
+ *		nothing in the table, such as MySQL's GENERATED_KEY; it is taken as
+ *		the value of the key column of the table then.  Columns matching
+ *		nothing are read as text and ignored.
+ */
+static void
+jdbc_map_returning_columns(jdbcFdwModifyState * fmstate, int keysID)
+{
+	TupleDesc	tupdesc = RelationGetDescr(fmstate->rel);
+	List	   *column_names = jq_get_column_names(fmstate->jdbcUtilsInfo, keysID);
+	List	   *key_attrs = jdbc_get_key_attrs(fmstate->rel);
+	List	   *returned_attrs = NIL;
+	int			ncolumns = list_length(column_names);
+	ListCell   *lc;
+	int			i = 0;
+
+#if PG_VERSION_NUM >= 120000
+	fmstate->returning_desc = CreateTemplateTupleDesc(ncolumns);
+#else
+	fmstate->returning_desc = CreateTemplateTupleDesc(ncolumns, false);
+#endif
+	fmstate->returning_attnums = (AttrNumber *) palloc0(Max(ncolumns, 1) * sizeof(AttrNumber));
+	foreach(lc, column_names)
+	{
+		char	   *column_name = (char *) lfirst(lc);
+		ListCell   *lc_attr;
+		ListCell   *lc_name;
+		AttrNumber	attnum = InvalidAttrNumber;
+
+		forboth(lc_attr, fmstate->retrieved_attrs, lc_name, fmstate->returning_names)
+		{
+			if (column_name != NULL &&
+				pg_strcasecmp(column_name, (char *) lfirst(lc_name)) == 0)
+			{
+				attnum = lfirst_int(lc_attr);
+				break;
+			}
+		}
+		if (attnum == InvalidAttrNumber && ncolumns == 1 &&
+			list_length(key_attrs) == 1 &&
+			list_member_int(fmstate->retrieved_attrs, linitial_int(key_attrs)))
+			attnum = linitial_int(key_attrs);
+
+		if (attnum != InvalidAttrNumber)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+
+			TupleDescInitEntry(fmstate->returning_desc, i + 1, NULL,
+							   attr->atttypid, attr->atttypmod, 0);
+		}
+		else
+			TupleDescInitEntry(fmstate->returning_desc, i + 1, NULL,
+							   TEXTOID, -1, 0);
+		fmstate->returning_attnums[i] = attnum;
+		returned_attrs = lappend_int(returned_attrs, ++i);
+	}
+
+	jq_init_columnar_buffer(&fmstate->returning_buffer, fmstate->returning_desc,
+							returned_attrs);
+}
+
+/*
+ * jdbc_store_returning
+ *		Read back the row returned for the statement just executed, and
+ *		store it into slot.  The columns the remote server did not return
+ *		keep the values that were sent, which is all a driver that only
+ *		returns generated keys gives for an INSERT.  Returns NULL when no
+ *		row is returned for an UPDATE or DELETE, since the row was not found
+ *		on the remote server.
+ */
+static TupleTableSlot *
+jdbc_store_returning(jdbcFdwModifyState * fmstate, TupleTableSlot *slot)
+{
+	TupleDesc	tupdesc = RelationGetDescr(fmstate->rel);
+	int			natts = tupdesc->natts;
+	Datum	   *values;
+	bool	   *isnull;
+	bool		found = false;
+	bool		eof_reached = false;
+	int			keysID;
+	HeapTuple	tuple;
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(fmstate->temp_cxt);
+
+	/* Start from the values sent; nothing is sent for a DELETE */
+	values = (Datum *) palloc0(natts * sizeof(Datum));
+	isnull = (bool *) palloc(natts * sizeof(bool));
+	if (fmstate->operation == CMD_DELETE)
+		memset(isnull, true, natts * sizeof(bool));
+	else
+	{
+		slot_getallattrs(slot);
+		memcpy(values, slot->tts_values, natts * sizeof(Datum));
+		memcpy(isnull, slot->tts_isnull, natts * sizeof(bool));
+	}
+
+	keysID = jq_get_generated_keys(fmstate->jdbcUtilsInfo, fmstate->resultSetID);
+	while (keysID != 0 && !eof_reached)
+	{
+		HeapTuple  *tuples;
+		int			numberOfRows;
+
+		/* The columns returned are the same for every execution */
+		if (fmstate->returning_desc == NULL)
+		{
+			MemoryContext querycontext = MemoryContextSwitchTo(MemoryContextGetParent(fmstate->temp_cxt));
+
+			jdbc_map_returning_columns(fmstate, keysID);
+			MemoryContextSwitchTo(querycontext);
+		}
+
+		/* A statement returns a single row, the result ends after it */
+		numberOfRows = jq_iterate_batch(fmstate->jdbcUtilsInfo, fmstate->returning_desc,
+										&fmstate->returning_buffer, keysID, 2,
+										&tuples, &eof_reached);
+		if (numberOfRows > 0 && !found)
+		{
+			int			ncolumns = fmstate->returning_desc->natts;
+			Datum	   *returned_values = (Datum *) palloc(ncolumns * sizeof(Datum));
+			bool	   *returned_isnull = (bool *) palloc(ncolumns * sizeof(bool));
+			int			i;
+
+			heap_deform_tuple(tuples[0], fmstate->returning_desc,
+							  returned_values, returned_isnull);
+			for (i = 0; i < ncolumns; i++)
+			{
+				AttrNumber	attnum = fmstate->returning_attnums[i];
+
+				if (attnum == InvalidAttrNumber)
+					continue;
+				values[attnum - 1] = returned_values[i];
+				isnull[attnum - 1] = returned_isnull[i];
+			}
+			found = true;
+		}
+	}
 
-		/*
-		 * Build the list of columns to be fetched from the foreign server.
-		 */
-		if (IS_JOIN_REL(baserel) || IS_UPPER_REL(baserel))
-			fdw_scan_tlist = jdbc_build_tlist_to_deparse(baserel);
+	if (!found && fmstate->operation != CMD_INSERT)
+	{
+		MemoryContextSwitchTo(oldcontext);
+		return NULL;
+	}
+
+	/* The tuple belongs to the slot, it must outlive the per-tuple data */
+	MemoryContextSwitchTo(slot->tts_mcxt);
+	tuple = heap_form_tuple(tupdesc, values, isnull);
+	MemoryContextSwitchTo(oldcontext);
+
+#if PG_VERSION_NUM >= 120000
+	ExecForceStoreHeapTuple(tuple, slot, true);
+#else
+	ExecStoreTuple(tuple, slot, InvalidBuffer, true);
+#endif
+
+	return slot;
+}
+
+/*
+ * jdbc_extract_modify_values
+ *		Store the target columns of slot, followed by the key columns passed
+ *		up in planSlot, into p_values and p_isnull.
+ */
+static void
+jdbc_extract_modify_values(jdbcFdwModifyState * fmstate,
+						   TupleTableSlot *slot,
+						   TupleTableSlot *planSlot)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, fmstate->target_attrs)
+	{
+		fmstate->p_values[i] = slot_getattr(slot, lfirst_int(lc), &fmstate->p_isnull[i]);
+		i++;
+	}
+
+	/* Get the values of the key columns that were passed up as resjunk */
+	foreach(lc, fmstate->key_attrs)
+	{
+		fmstate->p_values[i] = ExecGetJunkAttribute(planSlot,
+													fmstate->junk_idx[lfirst_int(lc) - 1],
+													&fmstate->p_isnull[i]);
+		i++;
+	}
+}
+
+/*
+ * jdbc_bind_modify_values
+ *		Bind the target columns of slot, followed by the key columns passed
+ *		up in planSlot, to the prepared statement with a single call into
+ *		the JVM.  If batch is true, the row is added to the current batch
+ *		instead: to the bulk load or the asynchronous batch if one is used,
+ *		or to the batch of the prepared statement.  Values are converted in
+ *		the per-tuple memory context.
+ */
+static void
+jdbc_bind_modify_values(jdbcFdwModifyState * fmstate,
+						TupleTableSlot *slot,
+						TupleTableSlot *planSlot,
+						bool batch)
+{
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(fmstate->temp_cxt);
+
+	jdbc_extract_modify_values(fmstate, slot, planSlot);
+
+	if (!batch)
+		jq_bind_row(fmstate->jdbcUtilsInfo, &fmstate->param_buffer,
+					fmstate->p_values, fmstate->p_isnull, fmstate->resultSetID);
+	else if (fmstate->bulkLoadID != 0)
+		jq_add_bulk_load_row(fmstate->jdbcUtilsInfo, &fmstate->param_buffer,
+							 fmstate->p_values, fmstate->p_isnull, fmstate->bulkLoadID);
+	else if (fmstate->async_write)
+		jq_add_async_batch_row(fmstate->jdbcUtilsInfo, &fmstate->param_buffer,
+							   fmstate->p_values, fmstate->p_isnull, fmstate->resultSetID);
+	else
+	{
+		jq_bind_row(fmstate->jdbcUtilsInfo, &fmstate->param_buffer,
+					fmstate->p_values, fmstate->p_isnull, fmstate->resultSetID);
+		jq_add_batch(fmstate->jdbcUtilsInfo, fmstate->resultSetID);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * jdbc_add_batch_row
+ *		Add a row to the batch of rows to insert.  The batch goes through the
+ *		bulk path of the remote database when the bulk_load option is set and
+ *		the driver has one, and through the prepared INSERT otherwise.
+ */
+static void
+jdbc_add_batch_row(jdbcFdwModifyState * fmstate,
+				   TupleTableSlot *slot,
+				   TupleTableSlot *planSlot)
+{
+	if (fmstate->bulk_load && fmstate->bulkLoadID == 0)
+	{
+		StringInfoData table;
+		StringInfoData columns;
+
+		initStringInfo(&table);
+		initStringInfo(&columns);
+		jdbc_deparse_bulk_load_target(&table, &columns, fmstate->rel,
+									  fmstate->target_attrs,
+									  fmstate->jdbcUtilsInfo->q_char);
+		if (fmstate->target_attrs != NIL)
+			fmstate->bulkLoadID = jq_create_bulk_loader(fmstate->jdbcUtilsInfo,
+														table.data, columns.data);
+
+		/* Fall back to the prepared INSERT if there is no bulk path */
+		if (fmstate->bulkLoadID == 0)
+			fmstate->bulk_load = false;
+	}
+
+	/*
+	 * Set up the prepared statement on the remote server, if we didn't yet
+	 */
+	if (fmstate->bulkLoadID == 0 && !fmstate->is_prepared)
+		jdbc_prepare_foreign_modify(fmstate);
+
+	jdbc_bind_modify_values(fmstate, slot, planSlot, true);
+	fmstate->num_pending++;
+}
+
+/*
+ * jdbc_flush_foreign_insert
+ *		Send the rows added by jdbc_add_batch_row to the remote server, with
+ *		a single bulk load or executeBatch.  With async_write, the batch is
+ *		handed to the writer thread of the connection and an error of an
+ *		earlier batch is reported here.
+ */
+static void
+jdbc_flush_foreign_insert(jdbcFdwModifyState * fmstate)
+{
+	Jresult    *res;
+
+	if (fmstate->num_pending == 0)
+		return;
+
+	/*
+	 * We don't use a PG_TRY block here, so be careful not to throw error
+	 * without releasing the Jresult.
+	 */
+	if (fmstate->bulkLoadID != 0)
+		res = jq_exec_bulk_load(fmstate->jdbcUtilsInfo, fmstate->bulkLoadID);
+	else if (fmstate->async_write)
+		res = jq_exec_async_batch(fmstate->jdbcUtilsInfo, fmstate->resultSetID);
+	else
+		res = jq_exec_batch(fmstate->jdbcUtilsInfo, fmstate->resultSetID);
+	fmstate->num_pending = 0;
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
+	jq_clear(res);
+}
+
+/*
+ * jdbc_add_keyset
+ *		Collect the key columns of a row to update or delete, and send the
+ *		collected key sets once key_batch_size of them are there.  Rows of
+ *		an UPDATE are only collected together while their SET values are
+ *		the same; the key sets collected so far are sent when they change.
+ */
+static void
+jdbc_add_keyset(jdbcFdwModifyState * fmstate,
+				TupleTableSlot *slot,
+				TupleTableSlot *planSlot)
+{
+	int			n_targets = list_length(fmstate->target_attrs);
+	int			n_keys = list_length(fmstate->key_attrs);
+	Datum	   *keyset_values;
+	bool	   *keyset_isnull;
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(fmstate->temp_cxt);
+
+	jdbc_extract_modify_values(fmstate, slot, planSlot);
+
+	for (i = 0; i < n_targets && fmstate->num_keysets > 0; i++)
+	{
+		if (fmstate->p_isnull[i] != fmstate->keyset_isnull[i] ||
+			(!fmstate->p_isnull[i] &&
+			 !datumIsEqual(fmstate->p_values[i], fmstate->keyset_values[i],
+						   fmstate->keyset_typbyval[i], fmstate->keyset_typlen[i])))
+		{
+			jdbc_flush_keysets(fmstate);
+			break;
+		}
+	}
+
+	/* Copy the values, the slots are reused for the next row */
+	MemoryContextSwitchTo(fmstate->keyset_cxt);
+
+	if (fmstate->num_keysets == 0)
+	{
+		for (i = 0; i < n_targets; i++)
+		{
+			fmstate->keyset_isnull[i] = fmstate->p_isnull[i];
+			if (!fmstate->p_isnull[i])
+				fmstate->keyset_values[i] = datumCopy(fmstate->p_values[i],
+													  fmstate->keyset_typbyval[i],
+													  fmstate->keyset_typlen[i]);
+		}
+	}
+
+	keyset_values = fmstate->keyset_values + n_targets + fmstate->num_keysets * n_keys;
+	keyset_isnull = fmstate->keyset_isnull + n_targets + fmstate->num_keysets * n_keys;
+	for (i = 0; i < n_keys; i++)
+	{
+		int			j = n_targets + i;
+
+		keyset_isnull[i] = fmstate->p_isnull[j];
+		if (!fmstate->p_isnull[j])
+			keyset_values[i] = datumCopy(fmstate->p_values[j],
+										 fmstate->keyset_typbyval[j],
+										 fmstate->keyset_typlen[j]);
+	}
+	fmstate->num_keysets++;
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(fmstate->temp_cxt);
+
+	if (fmstate->num_keysets == fmstate->key_batch_size)
+		jdbc_flush_keysets(fmstate);
+}
+
+/*
+ * jdbc_flush_keysets
+ *		Update or delete the rows of the key sets collected by
+ *		jdbc_add_keyset with a single statement.  A full set of
+ *		key_batch_size key sets uses a statement prepared once, a single
+ *		key set uses the statement for one row, and a partial set uses a
+ *		statement prepared for its size.
+ */
+static void
+jdbc_flush_keysets(jdbcFdwModifyState * fmstate)
+{
+	int			num_keysets = fmstate->num_keysets;
+	JparamBuffer *buffer;
+	int			resultSetID;
+	StringInfoData sql;
+	Jresult    *res;
+	MemoryContext oldcontext;
+
+	if (num_keysets == 0)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(fmstate->temp_cxt);
+
+	initStringInfo(&sql);
+	if (num_keysets == 1)
+	{
+		if (!fmstate->is_prepared)
+			jdbc_prepare_foreign_modify(fmstate);
+		appendStringInfoString(&sql, fmstate->query);
+		buffer = &fmstate->param_buffer;
+		resultSetID = fmstate->resultSetID;
+	}
+	else
+	{
+		if (fmstate->operation == CMD_UPDATE)
+			jdbc_deparse_update_sql(&sql, NULL, 0, fmstate->rel,
+									fmstate->target_attrs, fmstate->key_attrs,
+									num_keysets, fmstate->jdbcUtilsInfo->q_char);
 		else
-			fdw_scan_tlist = NIL;
+			jdbc_deparse_delete_sql(&sql, NULL, 0, fmstate->rel,
+									fmstate->key_attrs, num_keysets,
+									fmstate->jdbcUtilsInfo->q_char);
 
-		/*
-		 * The complete list of remote conditions includes everything from
-		 * baserestrictinfo plus any extra join_conds relevant to this
-		 * particular path.
-		 */
-		remote_conds = list_concat(remote_join_conds,
-								   fpinfo->remote_conds);
+		if (num_keysets == fmstate->key_batch_size)
+			buffer = &fmstate->keyset_buffer;
+		else
+		{
+			/* Only the first parameters of the full buffer are used */
+			buffer = palloc(sizeof(JparamBuffer));
+			jq_init_param_buffer(buffer,
+								 list_length(fmstate->target_attrs) +
+								 num_keysets * list_length(fmstate->key_attrs),
+								 fmstate->keyset_buffer.types);
+		}
 
 		/*
-		 * Construct EXPLAIN query including the desired SELECT, FROM, and
-		 * WHERE clauses.  Params and other-relation Vars are replaced by
-		 * dummy values.
+		 * We don't use a PG_TRY block here, so be careful not to throw error
+		 * without releasing the Jresult.
 		 */
-		initStringInfo(&sql);
-		appendStringInfoString(&sql, "EXPLAIN ");
-		jdbc_deparse_select_stmt_for_rel(&sql, root, baserel, remote_conds,
-										 NULL, &retrieved_attrs, NULL, fdw_scan_tlist,
-										 NULL, true, fpinfo->remote_conds,
-										 remote_join_conds, q_char);
+		if (num_keysets == fmstate->key_batch_size && fmstate->keysetID != 0)
+			resultSetID = fmstate->keysetID;
+		else
+		{
+			res = jq_prepare(fmstate->jdbcUtilsInfo, sql.data, NULL, &resultSetID);
+			if (*res != PGRES_COMMAND_OK)
+				jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, sql.data);
+			jq_clear(res);
+
+			if (num_keysets == fmstate->key_batch_size)
+				fmstate->keysetID = resultSetID;
+		}
+	}
+
+	jq_bind_row(fmstate->jdbcUtilsInfo, buffer, fmstate->keyset_values,
+				fmstate->keyset_isnull, resultSetID);
+	res = jq_exec_prepared(fmstate->jdbcUtilsInfo, NULL, NULL, 0, resultSetID);
+	if (*res != PGRES_COMMAND_OK)
+		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, sql.data);
+	jq_clear(res);
+
+	/* The statement of a partial set is not used again */
+	if (resultSetID != fmstate->resultSetID && resultSetID != fmstate->keysetID)
+		jq_release_resultset_id(fmstate->jdbcUtilsInfo, resultSetID);
+
+	fmstate->num_keysets = 0;
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(fmstate->keyset_cxt);
+}
+
+/*
+ * jdbc_get_bulk_load_option
+ *		Determine whether rows are inserted into a given foreign table
+ *		through the bulk path of the remote database.
+ */
+static bool
+jdbc_get_bulk_load_option(Relation rel)
+{
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	ListCell   *lc;
+
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "bulk_load") == 0)
+			return defGetBoolean(def);
+	}
+
+	return false;
+}
+
+/*
+ * jdbc_get_async_write_option
+ *		Determine whether batches inserted into a given foreign table are
+ *		executed by the writer thread of the connection.  The option
+ *		specified for a table has precedence over the server option.
+ */
+static bool
+jdbc_get_async_write_option(Relation rel)
+{
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	ForeignServer *server = GetForeignServer(table->serverid);
+	List	   *options = NIL;
+	ListCell   *lc;
+
+	/* Table options come first, because they take precedence. */
+	options = list_concat(options, list_copy(table->options));
+	options = list_concat(options, list_copy(server->options));
+
+	foreach(lc, options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "async_write") == 0)
+			return defGetBoolean(def);
+	}
+
+	return false;
+}
+
+/*
+ * jdbc_get_batch_size_option
+ *		Determine the batch size for a given foreign table.  The option
+ *		specified for a table has precedence over the server option.
+ */
+static int
+jdbc_get_batch_size_option(Relation rel)
+{
+	Oid			foreigntableid = RelationGetRelid(rel);
+	ForeignTable *table;
+	ForeignServer *server;
+	List	   *options;
+	ListCell   *lc;
+
+	/* we use 1 by default, which means "no batching" */
+	int			batch_size = 1;
+
+	/*
+	 * Load options for table and server. We append server options after
+	 * table options, because table options take precedence.
+	 */
+	table = GetForeignTable(foreigntableid);
+	server = GetForeignServer(table->serverid);
+
+	options = NIL;
+	options = list_concat(options, table->options);
+	options = list_concat(options, server->options);
+
+	/* See if either table or server specifies batch_size. */
+	foreach(lc, options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "batch_size") == 0)
+		{
+			(void) parse_int(defGetString(def), &batch_size, 0, NULL);
+			break;
+		}
+	}
+
+	return batch_size;
+}
+
+/*
+ * jdbc_get_key_batch_size_option
+ *		Determine the number of key sets that UPDATE and DELETE send in one
+ *		statement for a given foreign table.  The option specified for a
+ *		table has precedence over the server option.
+ */
+static int
+jdbc_get_key_batch_size_option(Relation rel)
+{
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	ForeignServer *server = GetForeignServer(table->serverid);
+	List	   *options = NIL;
+	ListCell   *lc;
+
+	/* Table options come first, because they take precedence. */
+	options = list_concat(options, list_copy(table->options));
+	options = list_concat(options, list_copy(server->options));
+
+	foreach(lc, options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+		int			key_batch_size;
+
+		if (strcmp(def->defname, "key_batch_size") == 0)
+		{
+			(void) parse_int(defGetString(def), &key_batch_size, 0, NULL);
+			return key_batch_size;
+		}
+	}
+
+	/* we use 1 by default, which means "one row at a time" */
+	return 1;
+}
+
+/*
+ * jdbc_get_key_attrs
+ *		Return the attribute numbers of the columns of a foreign table that
+ *		have the "key" option.
+ */
+static List *
+jdbc_get_key_attrs(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	List	   *keyAttrs = NIL;
+	int			i;
+
+	for (i = 0; i < tupdesc->natts; ++i)
+	{
+		AttrNumber	attrno = TupleDescAttr(tupdesc, i)->attnum;
+		ListCell   *option;
+
+		/* look for the "key" option on this column */
+		foreach(option, GetForeignColumnOptions(RelationGetRelid(rel), attrno))
+		{
+			DefElem    *def = (DefElem *) lfirst(option);
+
+			if (IS_KEY_COLUMN(def))
+				keyAttrs = lappend_int(keyAttrs, attrno);
+		}
+	}
+
+	return keyAttrs;
+}
+
+/*
+ * jdbc_get_on_conflict_action
+ *		Determine how an INSERT into a foreign table handles rows conflicting
+ *		with existing ones: as requested by ON CONFLICT DO NOTHING, or as an
+ *		upsert updating them when the table has the "upsert" option.
+ *
+ * The planner cannot infer an arbiter for ON CONFLICT DO UPDATE on a
+ * foreign table, so that never arrives here.
+ */
+static OnConflictAction
+jdbc_get_on_conflict_action(ModifyTable *plan, Relation rel)
+{
+	ForeignTable *table;
+	ListCell   *lc;
+
+	if (plan && plan->onConflictAction == ONCONFLICT_NOTHING)
+		return ONCONFLICT_NOTHING;
+	if (plan && plan->onConflictAction != ONCONFLICT_NONE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+				 errmsg("ON CONFLICT DO UPDATE is not supported")));
+
+	table = GetForeignTable(RelationGetRelid(rel));
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "upsert") == 0 && defGetBoolean(def))
+			return ONCONFLICT_UPDATE;
+	}
+
+	return ONCONFLICT_NONE;
+}
+
+/*
+ * jdbc_check_upsert
+ *		Return the dialect an INSERT with the given ON CONFLICT action is
+ *		deparsed in, and check that the foreign table has the key columns
+ *		the dialect needs to find conflicting rows.  MySQL finds them with
+ *		the unique keys of the remote table.
+ */
+static JdbcDialect
+jdbc_check_upsert(Relation rel, OnConflictAction onConflictAction,
+				  List *keyAttrs, ForeignServer *server,
+				  JDBCUtilsInfo * jdbcUtilsInfo)
+{
+	JdbcDialect dialect;
 
-		/* Get the remote estimate */
-		jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(fpinfo->server, fpinfo->user, false);
-		get_remote_estimate(sql.data, jdbcUtilsInfo, &rows, &width,
-							&startup_cost, &total_cost);
-		jdbc_release_jdbc_utils_obj();
+	if (onConflictAction == ONCONFLICT_NONE)
+		return JDBC_DIALECT_STANDARD;
 
-		retrieved_rows = rows;
+	dialect = jdbc_get_dialect(server, jdbcUtilsInfo);
+	if (keyAttrs == NIL &&
+		(dialect == JDBC_DIALECT_STANDARD ||
+		 (dialect == JDBC_DIALECT_POSTGRESQL && onConflictAction == ONCONFLICT_UPDATE)))
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_UNABLE_TO_CREATE_EXECUTION),
+				 errmsg("upsert into foreign table \"%s\" requires key columns",
+						RelationGetRelationName(rel)),
+				 errhint("Set the \"key\" option of the columns that identify a row.")));
 
-		/* Factor in the selectivity of the locally-checked quals */
-		local_sel = clauselist_selectivity(root,
-										   local_join_conds,
-										   baserel->relid,
-										   JOIN_INNER,
-										   NULL);
-		local_sel *= fpinfo->local_conds_sel;
+	return dialect;
+}
 
-		rows = clamp_row_est(rows * local_sel);
+/*
+ * jdbc_find_modifytable_subplan
+ *		Try to find the ForeignScan of a ModifyTable that scans rtindex.
+ *		Returns NULL if the subplan is anything else, e.g. a local join.
+ */
+static ForeignScan *
+jdbc_find_modifytable_subplan(PlannerInfo *root,
+							  ModifyTable *plan,
+							  Index rtindex,
+							  int subplan_index)
+{
+#if PG_VERSION_NUM >= 140000
+	Plan	   *subplan = outerPlan(plan);
 
-		/* Add in the eval cost of the locally-checked quals */
-		startup_cost += fpinfo->local_conds_cost.startup;
-		total_cost += fpinfo->local_conds_cost.per_tuple * retrieved_rows;
-		cost_qual_eval(&local_cost, local_join_conds, root);
-		startup_cost += local_cost.startup;
-		total_cost += local_cost.per_tuple * retrieved_rows;
+	/*
+	 * The cases we support are (1) the desired ForeignScan is the immediate
+	 * child of ModifyTable, or (2) it is the subplan_index'th child of an
+	 * Append node that is the immediate child of ModifyTable.  There is no
+	 * point in looking further down, as that would mean that local joins are
+	 * involved, so we can't do the update directly.
+	 *
+	 * There could be a Result atop the Append too, acting to compute the
+	 * UPDATE targetlist values.  We ignore that here; the tlist will be
+	 * checked by our caller.
+	 */
+	if (IsA(subplan, Append))
+	{
+		Append	   *appendplan = (Append *) subplan;
+
+		if (subplan_index < list_length(appendplan->appendplans))
+			subplan = (Plan *) list_nth(appendplan->appendplans, subplan_index);
 	}
-	else
+	else if (IsA(subplan, Result) &&
+			 outerPlan(subplan) != NULL &&
+			 IsA(outerPlan(subplan), Append))
 	{
-		/*
-		 * We don't support join conditions in this mode (hence, no
-		 * parameterized paths can be made).
-		 */
-		Assert(join_conds == NIL);
+		Append	   *appendplan = (Append *) outerPlan(subplan);
 
-		/*
-		 * Use rows/width estimates made by set_baserel_size_estimates.
-		 */
-		rows = baserel->rows;
-		width = baserel->reltarget->width;
+		if (subplan_index < list_length(appendplan->appendplans))
+			subplan = (Plan *) list_nth(appendplan->appendplans, subplan_index);
+	}
+#else
+	Plan	   *subplan = (Plan *) list_nth(plan->plans, subplan_index);
+#endif
 
-		/*
-		 * Back into an estimate of the number of retrieved rows. Just in case
-		 * this is nuts, clamp to at most baserel->tuples.
-		 */
-		retrieved_rows = clamp_row_est(rows / fpinfo->local_conds_sel);
-		retrieved_rows = Min(retrieved_rows, baserel->tuples);
+	/* Now, have we got a ForeignScan on the desired rel? */
+	if (IsA(subplan, ForeignScan))
+	{
+		ForeignScan *fscan = (ForeignScan *) subplan;
 
-		/*
-		 * Cost as though this were a seqscan, which is pessimistic. We
-		 * effectively imagine the local_conds are being evaluated remotely,
-		 * too.
-		 */
-		startup_cost = 0;
-		run_cost = 0;
-		run_cost += seq_page_cost * baserel->pages;
+#if PG_VERSION_NUM < 160000
+		if (bms_is_member(rtindex, fscan->fs_relids))
+#else
+		if (bms_is_member(rtindex, fscan->fs_base_relids))
+#endif
+			return fscan;
+	}
 
-		startup_cost += baserel->baserestrictcost.startup;
-		cpu_per_tuple = cpu_tuple_cost + baserel->baserestrictcost.per_tuple;
-		run_cost += cpu_per_tuple * baserel->tuples;
+	return NULL;
+}
 
-		total_cost = startup_cost + run_cost;
-	}
+/*
+ * jdbcAnalyzeForeignTable Test whether analyzing this foreign table is
+ * supported
+ */
+static bool
+jdbcAnalyzeForeignTable(Relation relation,
+						AcquireSampleRowsFunc *func,
+						BlockNumber *totalpages)
+{
+	/* Return the row-analysis function pointer */
+	*func = jdbcAcquireSampleRowsFunc;
 
 	/*
-	 * Add some additional cost factors to account for connection overhead
-	 * (fdw_startup_cost), transferring data across the network
-	 * (fdw_tuple_cost per retrieved row), and local manipulation of the data
-	 * (cpu_tuple_cost per retrieved row).
+	 * The number of pages of the remote table is not known, and is only used
+	 * to report the progress of ANALYZE.
 	 */
-	startup_cost += fpinfo->fdw_startup_cost;
-	total_cost += fpinfo->fdw_startup_cost;
-	total_cost += fpinfo->fdw_tuple_cost * retrieved_rows;
-	total_cost += cpu_tuple_cost * retrieved_rows;
+	*totalpages = 1;
 
-	/* Return results. */
-	*p_rows = rows;
-	*p_width = width;
-	*p_startup_cost = startup_cost;
-	*p_total_cost = total_cost;
+	return true;
 }
 
 /*
- * Estimate costs of executing a SQL statement remotely. The given "sql" must
- * be an EXPLAIN command.
+ * jdbcAcquireSampleRowsFunc Acquire a random sample of rows from foreign
+ * table
+ *
+ * Selected rows are returned in the caller-allocated array rows[], which must
+ * have at least targrows entries.  The actual number of rows selected is
+ * returned as the function result.  We also count the total number of rows
+ * in the table and return it into *totalrows.  Note that *totaldeadrows is
+ * always set to 0.
+ *
+ * The rows are sampled on the remote server as far as possible, see
+ * jdbc_deparse_analyze_sql, so that only about targrows rows are fetched
+ * even from a large table.  They are sampled again locally with the
+ * reservoir algorithm, in case the remote sample is larger than wanted.
  */
-static void
-get_remote_estimate(const char *sql, JDBCUtilsInfo * jdbcUtilsInfo,
-					double *rows, int *width,
-					Cost *startup_cost, Cost *total_cost)
+static int
+jdbcAcquireSampleRowsFunc(Relation relation, int elevel,
+						  HeapTuple *rows, int targrows,
+						  double *totalrows,
+						  double *totaldeadrows)
 {
-	Jresult    *volatile res = NULL;
+	jdbcFdwAnalyzeState astate;
+	ForeignTable *table;
+	ForeignServer *server;
+	UserMapping *user;
+	JDBCUtilsInfo *jdbcUtilsInfo;
+	JdbcDialect dialect;
+	JdbcAnalyzeSampling method = JDBC_SAMPLE_AUTO;
+	double		reltuples = -1;
+	double		sample_frac = -1;
+	int			fetch_size = DEFAULT_FETCH_SIZE;
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	JcolumnarBuffer columnar_buffer;
+	MemoryContext oldcontext;
+	StringInfoData sql;
+	int			resultSetID;
+	bool		eof_reached = false;
+	ListCell   *lc;
+	ErrorContextCallback *errcallback = jdbc_register_error_callback();
 
-	/* Jresult must be released before leaving this function. */
-	PG_TRY();
+	ereport(DEBUG3, (errmsg("In jdbcAcquireSampleRowsFunc")));
+
+	/* Initialize workspace state */
+	astate.rel = relation;
+	astate.attinmeta = NULL;	/* rows are converted by jq_iterate_batch */
+	astate.rows = rows;
+	astate.targrows = targrows;
+	astate.numrows = 0;
+	astate.samplerows = 0;
+	astate.rowstoskip = -1;		/* -1 means not set yet */
+	reservoir_init_selection_state(&astate.rstate, targrows);
+
+	/* Remember ANALYZE context, and create a context for each batch of rows */
+	astate.anl_cxt = CurrentMemoryContext;
+	astate.temp_cxt = AllocSetContextCreate(CurrentMemoryContext,
+											"jdbc_fdw analyze sample",
+											ALLOCSET_DEFAULT_MINSIZE,
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
+
+	/*
+	 * Get the connection to use.  We do the remote access as the table's
+	 * owner, even if the ANALYZE was started by some other user.
+	 */
+	table = GetForeignTable(RelationGetRelid(relation));
+	server = GetForeignServer(table->serverid);
+	user = GetUserMapping(relation->rd_rel->relowner, table->serverid);
+	jdbcUtilsInfo = jdbc_get_jdbc_utils_obj(server, user, false);
+	dialect = jdbc_get_dialect(server, jdbcUtilsInfo);
+
+	/*
+	 * Per-table settings of fetch_size and analyze_sampling override
+	 * per-server settings.
+	 */
+	foreach(lc, server->options)
 	{
-		char	   *line;
-		char	   *p;
-		int			n;
+		DefElem    *def = (DefElem *) lfirst(lc);
 
-		/*
-		 * Execute EXPLAIN remotely.
-		 */
-		res = jq_exec(jdbcUtilsInfo, sql);
-		if (*res != PGRES_TUPLES_OK)
-			jdbc_fdw_report_error(ERROR, res, jdbcUtilsInfo, false, sql);
+		if (strcmp(def->defname, "fetch_size") == 0)
+			(void) parse_int(defGetString(def), &fetch_size, 0, NULL);
+		else if (strcmp(def->defname, "analyze_sampling") == 0)
+			(void) jdbc_parse_analyze_sampling(defGetString(def), &method);
+	}
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "fetch_size") == 0)
+			(void) parse_int(defGetString(def), &fetch_size, 0, NULL);
+		else if (strcmp(def->defname, "analyze_sampling") == 0)
+			(void) jdbc_parse_analyze_sampling(defGetString(def), &method);
+	}
+
+	/*
+	 * With "auto", PostgreSQL samples with TABLESAMPLE, MySQL sorts the rows
+	 * randomly, and other databases filter them with a random predicate.
+	 */
+	if (method == JDBC_SAMPLE_AUTO)
+	{
+		if (dialect == JDBC_DIALECT_POSTGRESQL)
+			method = JDBC_SAMPLE_BERNOULLI;
+		else if (dialect == JDBC_DIALECT_MYSQL)
+			method = JDBC_SAMPLE_ORDER;
+		else
+			method = JDBC_SAMPLE_RANDOM;
+	}
+
+	/*
+	 * Sampling needs the number of rows of the remote table.  The estimate
+	 * of the remote catalog of a PostgreSQL table is unset (-1, or 0 before
+	 * PostgreSQL 14) until it has been analyzed, count its rows then.
+	 */
+	if (method != JDBC_SAMPLE_OFF)
+	{
+		initStringInfo(&sql);
+		jdbc_deparse_analyze_info_sql(&sql, relation, dialect, jdbcUtilsInfo->q_char);
+		reltuples = jdbc_get_remote_number(jdbcUtilsInfo, sql.data);
+
+		if (reltuples <= 0 && dialect == JDBC_DIALECT_POSTGRESQL)
+		{
+			resetStringInfo(&sql);
+			jdbc_deparse_analyze_info_sql(&sql, relation, JDBC_DIALECT_STANDARD,
+										  jdbcUtilsInfo->q_char);
+			reltuples = jdbc_get_remote_number(jdbcUtilsInfo, sql.data);
+		}
 
 		/*
-		 * Extract cost numbers for topmost plan node.  Note we search for a
-		 * left paren from the end of the line to avoid being confused by
-		 * other uses of parentheses.
+		 * No sampling is needed when the whole table fits into the sample.
 		 */
-		line = jq_get_value(res, 0, 0);
-		p = strrchr(line, '(');
-		if (p == NULL)
-			elog(ERROR, "could not interpret EXPLAIN output: \"%s\"", line);
-		n = sscanf(p, "(cost=%lf..%lf rows=%lf width=%d)",
-				   startup_cost, total_cost, rows, width);
-		if (n != 4)
-			elog(ERROR, "could not interpret EXPLAIN output: \"%s\"", line);
-
-		jq_clear(res);
-		res = NULL;
+		if (reltuples <= targrows)
+			method = JDBC_SAMPLE_OFF;
+		else
+			sample_frac = targrows / reltuples;
 	}
-	PG_CATCH();
+
+	/*
+	 * Construct command to get the sample rows, and fetch them in batches.
+	 */
+	initStringInfo(&sql);
+	jdbc_deparse_analyze_sql(&sql, relation, &astate.retrieved_attrs, method,
+							 sample_frac, targrows, dialect, jdbcUtilsInfo->q_char);
+
+	jq_init_columnar_buffer(&columnar_buffer, tupdesc, astate.retrieved_attrs);
+	(void) jq_exec_id(jdbcUtilsInfo, sql.data, fetch_size, &resultSetID);
+
+	while (!eof_reached)
 	{
-		if (res)
-			jq_clear(res);
-		PG_RE_THROW();
+		HeapTuple  *tuples;
+		int			numrows;
+		int			i;
+
+		/* Allow users to cancel long query */
+		CHECK_FOR_INTERRUPTS();
+
+		/* ANALYZE honors the cost-based delay settings */
+		vacuum_delay_point();
+
+		MemoryContextReset(astate.temp_cxt);
+		oldcontext = MemoryContextSwitchTo(astate.temp_cxt);
+		numrows = jq_iterate_batch(jdbcUtilsInfo, tupdesc, &columnar_buffer,
+								   resultSetID, fetch_size, &tuples,
+								   &eof_reached);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* Process whatever we got. */
+		for (i = 0; i < numrows; i++)
+			jdbc_analyze_row(&astate, tuples[i]);
 	}
-	PG_END_TRY();
-}
 
-/*
- * Force assorted GUC parameters to settings that ensure that we'll output
- * data values in a form that is unambiguous to the remote server.
- *
- * This is rather expensive and annoying to do once per row, but there's
- * little choice if we want to be sure values are transmitted accurately; we
- * can't leave the settings in place between rows for fear of affecting
- * user-visible computations.
- *
- * We use the equivalent of a function SET option to allow the settings to
- * persist only until the caller calls jdbc_reset_transmission_modes().  If
- * an error is thrown in between, guc.c will take care of undoing the
- * settings.
- *
- * The return value is the nestlevel that must be passed to
- * jdbc_reset_transmission_modes() to undo things.
- */
-int
-jdbc_set_transmission_modes(void)
-{
-	int			nestlevel = NewGUCNestLevel();
+	MemoryContextDelete(astate.temp_cxt);
+	jdbc_release_jdbc_utils_obj();
+	jdbc_remove_error_callback(errcallback);
+
+	/* We assume that we have no dead tuple. */
+	*totaldeadrows = 0.0;
 
 	/*
-	 * The values set here should match what pg_dump does.  See also
-	 * configure_remote_session in connection.c.
+	 * Without remote sampling, we've retrieved all living tuples from the
+	 * foreign server.  Otherwise the number of rows of the table is the one
+	 * the sampling was based on.
 	 */
-	if (DateStyle != USE_ISO_DATES)
-		(void) set_config_option("datestyle", "ISO",
-								 PGC_USERSET, PGC_S_SESSION,
-								 GUC_ACTION_SAVE, true, 0, false);
-	if (IntervalStyle != INTSTYLE_POSTGRES)
-		(void) set_config_option("intervalstyle", "postgres",
-								 PGC_USERSET, PGC_S_SESSION,
-								 GUC_ACTION_SAVE, true, 0, false);
-	if (extra_float_digits < 3)
-		(void) set_config_option("extra_float_digits", "3",
-								 PGC_USERSET, PGC_S_SESSION,
-								 GUC_ACTION_SAVE, true, 0, false);
+	if (method == JDBC_SAMPLE_OFF)
+		*totalrows = astate.samplerows;
+	else
+		*totalrows = reltuples;
+
 	/*
-	 * In addition force restrictive search_path, in case there are any
-	 * regproc or similar constants to be printed.
+	 * Emit some interesting relation info
 	 */
-	(void) set_config_option("search_path", "pg_catalog",
-							 PGC_USERSET, PGC_S_SESSION,
-							 GUC_ACTION_SAVE, true, 0, false);
+	ereport(elevel,
+			(errmsg("\"%s\": table contains %.0f rows, %d rows in sample",
+					RelationGetRelationName(relation),
+					*totalrows, astate.numrows)));
 
-	return nestlevel;
+	return astate.numrows;
 }
 
 /*
- * Undo the effects of jdbc_set_transmission_modes().
+ * jdbc_get_remote_number Execute a query returning a single number on the
+ * remote server, and return the number, or -1 if there is none.
  */
-void
-jdbc_reset_transmission_modes(int nestlevel)
+static double
+jdbc_get_remote_number(JDBCUtilsInfo * jdbcUtilsInfo, const char *sql)
 {
-	AtEOXact_GUC(true, nestlevel);
+	bool		isnull;
+	Datum		value = jdbc_get_remote_value(jdbcUtilsInfo, sql, FLOAT8OID, &isnull);
+
+	return isnull ? -1 : DatumGetFloat8(value);
 }
 
 /*
- * jdbc_prepare_foreign_modify Establish a prepared statement for execution
- * of INSERT/UPDATE/DELETE
+ * jdbc_get_remote_value Execute a query on the remote server, and return the
+ * first column of its first row converted to the given type.  *isnull is
+ * set if the query returns no row or NULL.
  */
-static void
-jdbc_prepare_foreign_modify(jdbcFdwModifyState * fmstate)
+static Datum
+jdbc_get_remote_value(JDBCUtilsInfo * jdbcUtilsInfo, const char *sql, Oid type,
+					  bool *isnull)
 {
-	Jresult    *res;
+	TupleDesc	tupdesc;
+	JcolumnarBuffer columnar_buffer;
+	HeapTuple  *tuples;
+	int			resultSetID;
+	bool		eof_reached;
+	Datum		result = (Datum) 0;
 
-	ereport(DEBUG3, (errmsg("In jdbc_prepare_foreign_modify")));
+#if PG_VERSION_NUM >= 120000
+	tupdesc = CreateTemplateTupleDesc(1);
+#else
+	tupdesc = CreateTemplateTupleDesc(1, false);
+#endif
+	TupleDescInitEntry(tupdesc, 1, "value", type, -1, 0);
+	jq_init_columnar_buffer(&columnar_buffer, tupdesc, list_make1_int(1));
 
-	/*
-	 * We intentionally do not specify parameter types here, but leave the
-	 * remote server to derive them by default.  This avoids possible problems
-	 * with the remote server using different type OIDs than we do.  All of
-	 * the prepared statements we use in this module are simple enough that
-	 * the remote server will make the right choices.
-	 *
-	 * We don't use a PG_TRY block here, so be careful not to throw error
-	 * without releasing the Jresult.
-	 */
-	res = jq_prepare(fmstate->jdbcUtilsInfo,
-					 fmstate->query,
-					 NULL,
-					 &fmstate->resultSetID);
+	*isnull = true;
+	(void) jq_exec_id(jdbcUtilsInfo, sql, 1, &resultSetID);
+	if (jq_iterate_batch(jdbcUtilsInfo, tupdesc, &columnar_buffer, resultSetID, 1,
+						 &tuples, &eof_reached) > 0)
+		result = heap_getattr(tuples[0], 1, tupdesc, isnull);
 
-	if (*res != PGRES_COMMAND_OK)
-		jdbc_fdw_report_error(ERROR, res, fmstate->jdbcUtilsInfo, true, fmstate->query);
-	jq_clear(res);
+	/* Forget the rows not read, the JVM releases them once all are read */
+	if (!eof_reached)
+		jq_release_resultset_id(jdbcUtilsInfo, resultSetID);
 
-	/* This action shows that the prepare has been done. */
-	fmstate->is_prepared = true;
+	return result;
 }
 
 /*
- * jdbcAnalyzeForeignTable Test whether analyzing this foreign table is
- * supported
+ * jdbc_analyze_row Collect sample rows from the result of the query
+ *
+ * The first targrows rows are kept, subsequent ones randomly replace
+ * already-sampled rows.
  */
-static bool
-jdbcAnalyzeForeignTable(Relation relation,
-						AcquireSampleRowsFunc *func,
-						BlockNumber *totalpages)
+static void
+jdbc_analyze_row(jdbcFdwAnalyzeState * astate, HeapTuple tuple)
 {
-	/* Not support now. */
-	return false;
+	int			targrows = astate->targrows;
+	int			pos;			/* array index to store tuple in */
+	MemoryContext oldcontext;
+
+	/* Always increment sample row counter. */
+	astate->samplerows += 1;
+
+	/*
+	 * Determine the slot where this sample row should be stored.  Set pos to
+	 * negative value to indicate the row should be skipped.
+	 */
+	if (astate->numrows < targrows)
+	{
+		/* First targrows rows are always included into the sample */
+		pos = astate->numrows++;
+	}
+	else
+	{
+		/*
+		 * Now we start replacing tuples in the sample until we reach the end
+		 * of the relation.  Same algorithm as in acquire_sample_rows in
+		 * analyze.c; see Jeff Vitter's paper.
+		 */
+		if (astate->rowstoskip < 0)
+			astate->rowstoskip = reservoir_get_next_S(&astate->rstate, astate->samplerows, targrows);
+
+		if (astate->rowstoskip <= 0)
+		{
+			/* Choose a random reservoir element to replace. */
+#if PG_VERSION_NUM >= 150000
+			pos = (int) (targrows * sampler_random_fract(&astate->rstate.randstate));
+#else
+			pos = (int) (targrows * sampler_random_fract(astate->rstate.randstate));
+#endif
+			Assert(pos >= 0 && pos < targrows);
+			heap_freetuple(astate->rows[pos]);
+		}
+		else
+		{
+			/* Skip this tuple. */
+			pos = -1;
+		}
+
+		astate->rowstoskip -= 1;
+	}
+
+	if (pos >= 0)
+	{
+		/*
+		 * Create sample tuple from current result row, and store it in the
+		 * position determined above.  The tuple has to be created in anl_cxt.
+		 */
+		oldcontext = MemoryContextSwitchTo(astate->anl_cxt);
+		astate->rows[pos] = heap_copytuple(tuple);
+		MemoryContextSwitchTo(oldcontext);
+	}
 }
 
 
@@ -35,6 +35,34 @@
 #include "jq.h"
 
 #define CODE_VERSION	500
+
+/* Default number of rows fetched from the remote result set per JNI call. */
+#define DEFAULT_FETCH_SIZE	100
+
+/*
+ * SQL dialect of the remote server, for the statements that have no
+ * standard form supported everywhere.
+ */
+typedef enum JdbcDialect
+{
+	JDBC_DIALECT_STANDARD,		/* standard SQL, e.g. MERGE */
+	JDBC_DIALECT_POSTGRESQL,
+	JDBC_DIALECT_MYSQL
+}			JdbcDialect;
+
+/*
+ * How ANALYZE samples the rows of a foreign table on the remote server.
+ */
+typedef enum JdbcAnalyzeSampling
+{
+	JDBC_SAMPLE_OFF,			/* fetch all rows, sample locally */
+	JDBC_SAMPLE_AUTO,			/* choose by the dialect */
+	JDBC_SAMPLE_RANDOM,			/* WHERE random() < fraction */
+	JDBC_SAMPLE_SYSTEM,			/* TABLESAMPLE SYSTEM */
+	JDBC_SAMPLE_BERNOULLI,		/* TABLESAMPLE BERNOULLI */
+	JDBC_SAMPLE_ORDER			/* ORDER BY random() LIMIT n */
+}			JdbcAnalyzeSampling;
+
 typedef struct jdbcAggref
 {
 	StringInfo	aggname;
@@ -92,6 +120,7 @@ typedef struct jdbcFdwRelationInfo
 
 
 	int			fetch_size;		/* fetch size for this remote table */
+	int			lookup_cache_size;	/* param values whose rows are kept */
 
 	/*
 	 * Name of the relation, for use while EXPLAINing ForeignScan.  It is used
@@ -103,7 +132,14 @@ typedef struct jdbcFdwRelationInfo
 	 */
 	StringInfo	relation_name;
 
+	/* Join information */
 	RelOptInfo *outerrel;
+	RelOptInfo *innerrel;
+	JoinType	jointype;
+	/* joinclauses contains only JOIN/ON conditions for an outer join */
+	List	   *joinclauses;
+	Selectivity joinclause_sel;
+
 	/* Upper relation information */
 	UpperRelationKind stage;
 
@@ -130,6 +166,9 @@ extern void jdbc_fdw_report_error(int elevel, Jresult * res, JDBCUtilsInfo * jdb
 extern int	jdbc_extract_connection_options(List *defelems,
 											const char **keywords,
 											const char **values);
+extern bool jdbc_parse_dialect(const char *value, JdbcDialect * dialect);
+extern JdbcDialect jdbc_get_dialect(ForeignServer *server, JDBCUtilsInfo * jdbcUtilsInfo);
+extern bool jdbc_parse_analyze_sampling(const char *value, JdbcAnalyzeSampling * method);
 
 /* in deparse.c */
 extern void jdbc_classify_conditions(PlannerInfo *root,
@@ -164,16 +203,41 @@ extern void jdbc_append_where_clause(StringInfo buf,
 extern void jdbc_deparse_insert_sql(StringInfo buf, PlannerInfo *root,
 									Index rtindex, Relation rel,
 									List *targetAttrs, List *returningList,
-									List **retrieved_attrs, char *q_char);
+									List **retrieved_attrs,
+									OnConflictAction onConflictAction,
+									List *keyAttrs, JdbcDialect dialect,
+									char *q_char);
+extern void jdbc_deparse_bulk_load_target(StringInfo table, StringInfo columns,
+										  Relation rel, List *targetAttrs,
+										  char *q_char);
 extern void jdbc_deparse_update_sql(StringInfo buf, PlannerInfo *root,
 									Index rtindex, Relation rel,
 									List *targetAttrs, List *attnums,
-									char *q_char);
+									int num_keysets, char *q_char);
 extern void jdbc_deparse_delete_sql(StringInfo buf, PlannerInfo *root,
 									Index rtindex, Relation rel,
-									List *attname, char *q_char);
+									List *attname, int num_keysets,
+									char *q_char);
+extern void jdbc_deparse_truncate_sql(StringInfo buf, List *rels,
+									  DropBehavior behavior, bool restart_seqs,
+									  char *q_char);
+extern void jdbc_deparse_direct_update_sql(StringInfo buf, PlannerInfo *root,
+										   Index rtindex, Relation rel,
+										   RelOptInfo *foreignrel,
+										   List *targetAttrs, List *targetExprs,
+										   List *remote_conds, char *q_char);
+extern void jdbc_deparse_direct_delete_sql(StringInfo buf, PlannerInfo *root,
+										   Relation rel, RelOptInfo *foreignrel,
+										   List *remote_conds, char *q_char);
+extern void jdbc_deparse_analyze_info_sql(StringInfo buf, Relation rel,
+										  JdbcDialect dialect, char *q_char);
 extern void jdbc_deparse_analyze_sql(StringInfo buf, Relation rel,
-									 List **retrieved_attrs, char *q_char);
+									 List **retrieved_attrs,
+									 JdbcAnalyzeSampling method, double sample_frac,
+									 int targrows, JdbcDialect dialect, char *q_char);
+extern List *jdbc_get_returning_attrs(Index rtindex, Relation rel,
+									  List *returningList);
+extern char *jdbc_get_column_name(Oid relid, int varattno);
 extern List *jdbc_build_tlist_to_deparse(RelOptInfo *foreignrel);
 
 #endif							/* jdbc_fdw_H */
@@ -8,6 +8,7 @@
  *
  * ---------------------------------------------
  */
+#include <math.h>
 #include <stdlib.h>
 #include "postgres.h"
 #include "jdbc_fdw.h"
@@ -17,16 +18,19 @@
 #include "catalog/pg_type.h"
 #include "storage/ipc.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
 #include "utils/datetime.h"
 #include "utils/guc.h"
 #include "utils/syscache.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/numeric.h"
 #include "foreign/fdwapi.h"
 #include "funcapi.h"
 #include "miscadmin.h"
 #include "commands/defrem.h"
 #include "libpq-fe.h"
+#include "mb/pg_wchar.h"
 
 #include "jni.h"
 
@@ -51,6 +55,72 @@
 static __thread JNIEnv * Jenv = NULL;
 static JavaVM * jvm = NULL;
 
+/*
+ * Global references to the Java classes and IDs of the Java methods used by
+ * jdbc_fdw.  They are resolved once by jq_load_jni_registry() after the JVM
+ * is created or attached, instead of calling FindClass/GetMethodID for every
+ * call into Java.  Both class global references and method IDs stay valid
+ * until the JVM is destroyed, so detaching and re-attaching the current
+ * thread does not invalidate them.
+ */
+typedef struct JNIRegistry
+{
+	bool		loaded;			/* true if all entries below are resolved */
+
+	/* classes */
+	jclass		JDBCUtilsClass;
+	jclass		StringClass;
+	jclass		ObjectClass;
+
+	/* JDBCUtils instance methods */
+	jmethodID	idCancel;
+	jmethodID	idCreateConnection;
+	jmethodID	idGetIdentifierQuoteString;
+	jmethodID	idCreateStatement;
+	jmethodID	idCreateStatementID;
+	jmethodID	idClearResultSetID;
+	jmethodID	idFillResultSetBatch;
+	jmethodID	idGetNumberOfColumns;
+	jmethodID	idGetNumberOfAffectedRows;
+	jmethodID	idExecPreparedStatement;
+	jmethodID	idAddBatchPreparedStatement;
+	jmethodID	idExecBatchPreparedStatement;
+	jmethodID	idCreatePreparedStatement;
+	jmethodID	idCreatePreparedStatementReturning;
+	jmethodID	idGetGeneratedKeysID;
+	jmethodID	idCreatePreparedQuery;
+	jmethodID	idExecPreparedQueryID;
+	jmethodID	idBindRowPreparedStatement;
+	jmethodID	idCreateBulkLoader;
+	jmethodID	idAddBulkLoadRow;
+	jmethodID	idExecBulkLoad;
+	jmethodID	idAddAsyncBatchRow;
+	jmethodID	idExecAsyncBatch;
+	jmethodID	idWaitAsyncWrites;
+	jmethodID	idExecTruncate;
+	jmethodID	idGetMaxParameters;
+	jmethodID	idGetDatabaseProductName;
+	jmethodID	idGetColumnNames;
+	jmethodID	idGetColumnTypes;
+	jmethodID	idGetPrimaryKey;
+	jmethodID	idGetColumnNamesByResultSetID;
+	jmethodID	idGetColumnTypesByResultSetID;
+	jmethodID	idGetTableNames;
+
+	/* JDBCUtils static methods */
+	jmethodID	idFinalizeAllConns;
+	jmethodID	idFinalizeAllServerConns;
+	jmethodID	idFinalizeAllUserMapingConns;
+	jmethodID	idFinalizeAllResultSet;
+	jmethodID	idWaitAllAsyncWrites;
+	jmethodID	idCommitAllStreaming;
+
+	/* java.lang.Object methods */
+	jmethodID	idToString;
+}			JNIRegistry;
+
+static __thread JNIRegistry jni_registry;
+
 /*
  * Describes the valid options for objects that use this wrapper.
  */
@@ -73,6 +143,7 @@ typedef struct JserverOptions
 	int			querytimeout;
 	char	   *jarfile;
 	int			maxheapsize;
+	bool		stream_results;
 }			JserverOptions;
 
 static JserverOptions opts;
@@ -87,16 +158,6 @@ static JDBCUtilsInfo * jdbc_create_JDBC_connection(const ForeignServer *server,
  */
 static char *jdbc_convert_string_to_cstring(jobject);
 
-/*
- * Convert byte array to Datum
- */
-static Datum jdbc_convert_byte_array_to_datum(jbyteArray);
-
-/*
- * Common function to convert Object value to datum
- */
-static Datum jdbc_convert_object_to_datum(Oid, int32, jobject);
-
 /*
  * JVM destroy function
  */
@@ -129,7 +190,40 @@ static List *jq_get_column_infos(JDBCUtilsInfo * jdbcUtilsInfo, char *tablename)
 static List *jq_get_table_names(JDBCUtilsInfo * jdbcUtilsInfo);
 
 
-static void jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jclass * JDBCUtilsClass, jobject * JDBCUtilsObject);
+static void jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jobject * JDBCUtilsObject);
+
+/*
+ * resolve the Java classes and methods used by jdbc_fdw
+ */
+static void jq_load_jni_registry(void);
+
+/*
+ * convert the values of a columnar batch to datum
+ */
+static jint jq_columnar_kind(Oid pgtype, int32 pgtypmod);
+static JcolumnFastPath jq_columnar_fast_path(Oid pgtype, jint kind);
+static Datum jq_convert_int2(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_int4(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_int8(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_float4(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_float8(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_timestamp(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_time(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_bool(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_date(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_numeric(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_bytea(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_text(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_binary_text(const JcolumnConverter * converter, const char *data, int32 len);
+static Datum jq_convert_varlena(const JcolumnConverter * converter, const char *data, int32 len);
+
+/*
+ * serialize the parameters of a row for the JVM
+ */
+static jint jq_param_kind(Oid pgtype);
+static void jq_send_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer,
+						const Datum *values, const bool *isnull,
+						jmethodID methodID, int id);
 
 /* jq_cancel
  * 		Call cancel method from JDBCUtilsObject to release
@@ -138,8 +232,6 @@ static void jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jclass * JDBCUtilsCl
 void
 jq_cancel(JDBCUtilsInfo * jdbcUtilsInfo)
 {
-	jclass		JDBCUtilsClass;
-	jmethodID	id_cancel;
 	MemoryContext ccxt = CurrentMemoryContext;
 
 	/* JDBCUtils object has been cleaned, do nothing */
@@ -148,19 +240,9 @@ jq_cancel(JDBCUtilsInfo * jdbcUtilsInfo)
 
 	PG_TRY();
 	{
-		JDBCUtilsClass = (*Jenv)->FindClass(Jenv, "JDBCUtils");
-		if (JDBCUtilsClass == NULL)
-		{
-			elog(ERROR, "JDBCUtilsClass is NULL");
-		}
-		id_cancel = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "cancel",
-											"()V");
-		if (id_cancel == NULL)
-		{
-			elog(ERROR, "id_cancel is NULL");
-		}
+		jq_load_jni_registry();
 		jq_exception_clear();
-		(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, id_cancel);
+		(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idCancel);
 		jq_get_exception();
 	}
 	PG_CATCH();
@@ -189,12 +271,10 @@ jq_cancel(JDBCUtilsInfo * jdbcUtilsInfo)
 static char *
 jdbc_convert_string_to_cstring(jobject java_cstring)
 {
-	jclass		JavaString;
 	char	   *StringPointer;
 	char	   *cString = NULL;
 
-	JavaString = (*Jenv)->FindClass(Jenv, "java/lang/String");
-	if (!((*Jenv)->IsInstanceOf(Jenv, java_cstring, JavaString)))
+	if (!((*Jenv)->IsInstanceOf(Jenv, java_cstring, jni_registry.StringClass)))
 	{
 		elog(ERROR, "Object not an instance of String class");
 	}
@@ -214,53 +294,6 @@ jdbc_convert_string_to_cstring(jobject java_cstring)
 	return (cString);
 }
 
-/*
- * jdbc_convert_byte_array_to_datum Uses a byte array object passed as a jbyteArray to
- * the function to convert into Datum.
- */
-static Datum
-jdbc_convert_byte_array_to_datum(jbyteArray byteVal)
-{
-	Datum		valueDatum;
-	jbyte	   *buf = (*Jenv)->GetByteArrayElements(Jenv, byteVal, NULL);
-	jsize		size = (*Jenv)->GetArrayLength(Jenv, byteVal);
-
-	if (buf == NULL)
-		return 0;
-
-	valueDatum = (Datum) palloc0(size + VARHDRSZ);
-	memcpy(VARDATA(valueDatum), buf, size);
-	SET_VARSIZE(valueDatum, size + VARHDRSZ);
-	return valueDatum;
-}
-
-/*
- * jdbc_convert_object_to_datum Convert jobject to Datum value
- */
-static Datum
-jdbc_convert_object_to_datum(Oid pgtype, int32 pgtypmod, jobject obj)
-{
-	switch (pgtype)
-	{
-		case BYTEAOID:
-			return jdbc_convert_byte_array_to_datum(obj);
-		default:
-			{
-				/*
-				 * By default, data is retrieved as string and then convert to
-				 * compatible data types
-				 */
-				char	   *value = jdbc_convert_string_to_cstring(obj);
-
-				if (value != NULL)
-					return jdbc_convert_to_pg(pgtype, pgtypmod, value);
-				else
-					/* Return 0 if value is NULL */
-					return 0;
-			}
-	}
-}
-
 /*
  * jdbc_destroy_jvm Shuts down the JVM.
  */
@@ -273,6 +306,9 @@ jdbc_destroy_jvm()
 
 	res = (*jvm)->DestroyJavaVM(jvm);
 
+	/* Global references and method IDs die with the JVM */
+	memset(&jni_registry, 0, sizeof(JNIRegistry));
+
 	/*
 	 * jdbc_destroy_jvm will be called at on_proc_exit callback,
 	 * so WARNING instead of ERROR for safe.
@@ -318,6 +354,122 @@ jdbc_detach_jvm()
 	}
 }
 
+/*
+ * jq_find_class: look up a Java class and return a global reference to it
+ */
+static jclass
+jq_find_class(const char *name)
+{
+	jclass		localClass;
+	jclass		globalClass;
+
+	localClass = (*Jenv)->FindClass(Jenv, name);
+	if (localClass == NULL)
+	{
+		jq_exception_clear();
+		ereport(ERROR, (errmsg("Failed to find the %s class!", name)));
+	}
+	globalClass = (jclass) (*Jenv)->NewGlobalRef(Jenv, localClass);
+	(*Jenv)->DeleteLocalRef(Jenv, localClass);
+	if (globalClass == NULL)
+	{
+		ereport(ERROR, (errmsg("Failed to create a global reference to the %s class", name)));
+	}
+	return globalClass;
+}
+
+/*
+ * jq_find_method: look up an instance or static method of a Java class
+ */
+static jmethodID
+jq_find_method(jclass clazz, const char *classname, const char *name, const char *signature, bool is_static)
+{
+	jmethodID	methodId;
+
+	if (is_static)
+		methodId = (*Jenv)->GetStaticMethodID(Jenv, clazz, name, signature);
+	else
+		methodId = (*Jenv)->GetMethodID(Jenv, clazz, name, signature);
+	if (methodId == NULL)
+	{
+		jq_exception_clear();
+		ereport(ERROR, (errmsg("Failed to find the %s.%s method!", classname, name)));
+	}
+	return methodId;
+}
+
+/*
+ * jq_load_jni_registry
+ *		Resolve the Java classes and methods used by jdbc_fdw, if that has not
+ *		been done yet by the current thread.  The current thread must be
+ *		attached to the JVM.
+ */
+static void
+jq_load_jni_registry(void)
+{
+	JNIRegistry registry;
+
+	if (jni_registry.loaded)
+		return;
+
+	ereport(DEBUG3, (errmsg("In jq_load_jni_registry")));
+
+	/*
+	 * Fill a local copy first, so that an error part way through leaves the
+	 * registry unloaded and the lookup is retried on the next call.
+	 */
+	memset(&registry, 0, sizeof(JNIRegistry));
+	registry.JDBCUtilsClass = jq_find_class("JDBCUtils");
+	registry.StringClass = jq_find_class("java/lang/String");
+	registry.ObjectClass = jq_find_class("java/lang/Object");
+
+	registry.idCancel = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "cancel", "()V", false);
+	registry.idCreateConnection = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createConnection", "(IJJ[Ljava/lang/String;)V", false);
+	registry.idGetIdentifierQuoteString = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getIdentifierQuoteString", "()Ljava/lang/String;", false);
+	registry.idCreateStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createStatement", "(Ljava/lang/String;)V", false);
+	registry.idCreateStatementID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createStatementID", "(Ljava/lang/String;I)I", false);
+	registry.idClearResultSetID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "clearResultSetID", "(I)V", false);
+	registry.idFillResultSetBatch = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "fillResultSetBatch", "(ILjava/nio/ByteBuffer;[II)I", false);
+	registry.idGetNumberOfColumns = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getNumberOfColumns", "(I)I", false);
+	registry.idGetNumberOfAffectedRows = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getNumberOfAffectedRows", "(I)I", false);
+	registry.idExecPreparedStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execPreparedStatement", "(I)V", false);
+	registry.idAddBatchPreparedStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "addBatchPreparedStatement", "(I)V", false);
+	registry.idExecBatchPreparedStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execBatchPreparedStatement", "(I)V", false);
+	registry.idCreatePreparedStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createPreparedStatement", "(Ljava/lang/String;)I", false);
+	registry.idCreatePreparedStatementReturning = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createPreparedStatementReturning", "(Ljava/lang/String;[Ljava/lang/String;)I", false);
+	registry.idGetGeneratedKeysID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getGeneratedKeysID", "(I)I", false);
+	registry.idCreatePreparedQuery = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createPreparedQuery", "(Ljava/lang/String;I)I", false);
+	registry.idExecPreparedQueryID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execPreparedQueryID", "(I)I", false);
+	registry.idBindRowPreparedStatement = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "bindRowPreparedStatement", "(Ljava/nio/ByteBuffer;I)V", false);
+	registry.idCreateBulkLoader = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "createBulkLoader", "(Ljava/lang/String;Ljava/lang/String;)I", false);
+	registry.idAddBulkLoadRow = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "addBulkLoadRow", "(Ljava/nio/ByteBuffer;I)V", false);
+	registry.idExecBulkLoad = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execBulkLoad", "(I)V", false);
+	registry.idAddAsyncBatchRow = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "addAsyncBatchRow", "(Ljava/nio/ByteBuffer;I)V", false);
+	registry.idExecAsyncBatch = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execAsyncBatch", "(I)V", false);
+	registry.idWaitAsyncWrites = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "waitAsyncWrites", "()V", false);
+	registry.idGetDatabaseProductName = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getDatabaseProductName", "()Ljava/lang/String;", false);
+	registry.idGetMaxParameters = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getMaxParameters", "()I", false);
+	registry.idExecTruncate = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "execTruncate", "(Ljava/lang/String;[Ljava/lang/String;)V", false);
+	registry.idGetColumnNames = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getColumnNames", "(Ljava/lang/String;)[Ljava/lang/String;", false);
+	registry.idGetColumnTypes = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getColumnTypes", "(Ljava/lang/String;)[Ljava/lang/String;", false);
+	registry.idGetPrimaryKey = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getPrimaryKey", "(Ljava/lang/String;)[Ljava/lang/String;", false);
+	registry.idGetColumnNamesByResultSetID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getColumnNamesByResultSetID", "(I)[Ljava/lang/String;", false);
+	registry.idGetColumnTypesByResultSetID = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getColumnTypesByResultSetID", "(I)[Ljava/lang/String;", false);
+	registry.idGetTableNames = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "getTableNames", "()[Ljava/lang/String;", false);
+
+	registry.idFinalizeAllConns = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "finalizeAllConns", "(J)V", true);
+	registry.idFinalizeAllServerConns = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "finalizeAllServerConns", "(J)V", true);
+	registry.idFinalizeAllUserMapingConns = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "finalizeAllUserMapingConns", "(J)V", true);
+	registry.idFinalizeAllResultSet = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "finalizeAllResultSet", "()V", true);
+	registry.idWaitAllAsyncWrites = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "waitAllAsyncWrites", "()V", true);
+	registry.idCommitAllStreaming = jq_find_method(registry.JDBCUtilsClass, "JDBCUtils", "commitAllStreaming", "()V", true);
+
+	registry.idToString = jq_find_method(registry.ObjectClass, "java/lang/Object", "toString", "()Ljava/lang/String;", false);
+
+	registry.loaded = true;
+	jni_registry = registry;
+}
+
 /*
  * jdbc_jvm_init Create the JVM which will be used for calling the Java
  * routines that use JDBC to connect and access the foreign database.
@@ -338,6 +490,7 @@ jdbc_jvm_init(const ForeignServer *server, const UserMapping *user)
 	char	   *maxheapsizeoption = NULL;
 
 	opts.maxheapsize = 0;
+	opts.stream_results = false;
 
 	ereport(DEBUG3, (errmsg("In jdbc_jvm_init")));
 	jdbc_get_server_options(&opts, server, user);	/* Get the maxheapsize
@@ -413,6 +566,9 @@ jdbc_jvm_init(const ForeignServer *server, const UserMapping *user)
 			ereport(ERROR, (errmsg("JVMEnvStat: JNI_EVERSION; the specified version is not supported")));
 		}
 	}
+
+	/* Resolve the Java classes and methods used by jdbc_fdw */
+	jq_load_jni_registry();
 }
 
 /*
@@ -424,12 +580,8 @@ jdbc_jvm_init(const ForeignServer *server, const UserMapping *user)
 static JDBCUtilsInfo *
 jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user)
 {
-	jmethodID	idCreate;
-	jstring		stringArray[6];
-	jclass		javaString;
+	jstring		stringArray[7];
 	jobjectArray argArray;
-	jclass		JDBCUtilsClass;
-	jmethodID	idGetIdentifierQuoteString;
 	jstring		identifierQuoteString;
 	char	   *quote_string;
 	char	   *querytimeout_string;
@@ -456,22 +608,6 @@ jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user
 	jdbcUtilsInfo->status = CONNECTION_BAD;
 	jdbcUtilsInfo->festate = (jdbcFdwExecutionState *) palloc0(sizeof(jdbcFdwExecutionState));
 	jdbcUtilsInfo->festate->query = NULL;
-	JDBCUtilsClass = (*Jenv)->FindClass(Jenv, "JDBCUtils");
-	if (JDBCUtilsClass == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils class!")));
-	}
-	idCreate = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "createConnection",
-									"(IJJ[Ljava/lang/String;)V");
-	if (idCreate == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.createConnection method!")));
-	}
-	idGetIdentifierQuoteString = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getIdentifierQuoteString", "()Ljava/lang/String;");
-	if (idGetIdentifierQuoteString == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getIdentifierQuoteString method")));
-	}
 
 	/*
 	 * Construct the array to pass our parameters Query timeout is an int, we
@@ -485,9 +621,9 @@ jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user
 	stringArray[3] = (*Jenv)->NewStringUTF(Jenv, opts.password);
 	stringArray[4] = (*Jenv)->NewStringUTF(Jenv, querytimeout_string);
 	stringArray[5] = (*Jenv)->NewStringUTF(Jenv, opts.jarfile);
+	stringArray[6] = (*Jenv)->NewStringUTF(Jenv, opts.stream_results ? "true" : "false");
 	/* Set up the return value */
-	javaString = (*Jenv)->FindClass(Jenv, "java/lang/String");
-	argArray = (*Jenv)->NewObjectArray(Jenv, numParams, javaString, stringArray[0]);
+	argArray = (*Jenv)->NewObjectArray(Jenv, numParams, jni_registry.StringClass, stringArray[0]);
 	if (argArray == NULL)
 	{
 		/* Return Java memory */
@@ -501,7 +637,7 @@ jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user
 	{
 		(*Jenv)->SetObjectArrayElement(Jenv, argArray, i, stringArray[i]);
 	}
-	jdbcUtilsInfo->JDBCUtilsObject = (*Jenv)->AllocObject(Jenv, JDBCUtilsClass);
+	jdbcUtilsInfo->JDBCUtilsObject = (*Jenv)->AllocObject(Jenv, jni_registry.JDBCUtilsClass);
 	if (jdbcUtilsInfo->JDBCUtilsObject == NULL)
 	{
 		/* Return Java memory */
@@ -517,7 +653,7 @@ jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user
 	mapping_hashvalue = (jlong) GetSysCacheHashValue1(USERMAPPINGOID, ObjectIdGetDatum(user->umid));
 
 	jq_exception_clear();
-	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idCreate, keyid, server_hashvalue, mapping_hashvalue, argArray);
+	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idCreateConnection, keyid, server_hashvalue, mapping_hashvalue, argArray);
 	jq_get_exception();
 	/* Return Java memory */
 	for (i = 0; i < numParams; i++)
@@ -528,7 +664,7 @@ jdbc_create_JDBC_connection(const ForeignServer *server, const UserMapping *user
 	ereport(DEBUG3, (errmsg("Created a JDBC connection: %s", opts.url)));
 	/* get default identifier quote string */
 	jq_exception_clear();
-	identifierQuoteString = (jstring) (*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idGetIdentifierQuoteString);
+	identifierQuoteString = (jstring) (*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idGetIdentifierQuoteString);
 	jq_get_exception();
 	quote_string = jdbc_convert_string_to_cstring((jobject) identifierQuoteString);
 	jdbcUtilsInfo->q_char = pstrdup(quote_string);
@@ -586,31 +722,27 @@ jdbc_get_server_options(JserverOptions * opts, const ForeignServer *f_server, co
 		{
 			opts->url = defGetString(def);
 		}
+		if (strcmp(def->defname, "stream_results") == 0)
+		{
+			opts->stream_results = defGetBoolean(def);
+		}
 	}
 }
 
 Jresult *
 jq_exec(JDBCUtilsInfo * jdbcUtilsInfo, const char *query)
 {
-	jmethodID	idCreateStatement;
 	jstring		statement;
-	jclass		JDBCUtilsClass;
 	jobject		JDBCUtilsObject;
 	Jresult    *res;
 
 	ereport(DEBUG3, (errmsg("In jq_exec(%p): %s", jdbcUtilsInfo, query)));
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
 	res = (Jresult *) palloc0(sizeof(Jresult));
 	*res = PGRES_FATAL_ERROR;
 
-	idCreateStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "createStatement",
-											 "(Ljava/lang/String;)V");
-	if (idCreateStatement == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.createStatement method!")));
-	}
 	/* The query argument */
 	statement = (*Jenv)->NewStringUTF(Jenv, query);
 	if (statement == NULL)
@@ -618,7 +750,7 @@ jq_exec(JDBCUtilsInfo * jdbcUtilsInfo, const char *query)
 		ereport(ERROR, (errmsg("Failed to create query argument")));
 	}
 	jq_exception_clear();
-	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idCreateStatement, statement);
+	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idCreateStatement, statement);
 	jq_get_exception();
 	/* Return Java memory */
 	(*Jenv)->DeleteLocalRef(Jenv, statement);
@@ -626,28 +758,25 @@ jq_exec(JDBCUtilsInfo * jdbcUtilsInfo, const char *query)
 	return res;
 }
 
+/*
+ * jq_exec_id: Execute the query and keep its result set on the Java side,
+ * returning its ID in *resultSetID.  fetch_size is given to the JDBC
+ * statement as the number of rows to fetch from the server at a time.
+ */
 Jresult *
-jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int *resultSetID)
+jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int fetch_size, int *resultSetID)
 {
-	jmethodID	idCreateStatementID;
 	jstring		statement;
-	jclass		JDBCUtilsClass;
 	jobject		JDBCUtilsObject;
 	Jresult    *res;
 
 	ereport(DEBUG3, (errmsg("In jq_exec_id(%p): %s", jdbcUtilsInfo, query)));
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
 	res = (Jresult *) palloc0(sizeof(Jresult));
 	*res = PGRES_FATAL_ERROR;
 
-	idCreateStatementID = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "createStatementID",
-											   "(Ljava/lang/String;)I");
-	if (idCreateStatementID == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.createStatementID method!")));
-	}
 	/* The query argument */
 	statement = (*Jenv)->NewStringUTF(Jenv, query);
 	if (statement == NULL)
@@ -655,7 +784,7 @@ jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int *resultSetID)
 		ereport(ERROR, (errmsg("Failed to create query argument")));
 	}
 	jq_exception_clear();
-	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idCreateStatementID, statement);
+	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idCreateStatementID, statement, fetch_size);
 	jq_get_exception();
 	if (*resultSetID < 0)
 	{
@@ -674,240 +803,905 @@ jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int *resultSetID)
 void *
 jq_release_resultset_id(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
 {
-	jmethodID	idClearResultSetID;
-	jclass		JDBCUtilsClass;
 	jobject		JDBCUtilsObject;
 
 	ereport(DEBUG3, (errmsg("In jq_release_resultset_id: %d", resultSetID)));
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
-	idClearResultSetID = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "clearResultSetID",
-											  "(I)V");
-	if (idClearResultSetID == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.clearResultSetID method!")));
-	}
 	jq_exception_clear();
-	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idClearResultSetID, resultSetID);
+	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idClearResultSetID, resultSetID);
 	jq_get_exception();
 
 	return NULL;
 }
 
 /*
- * jq_iterate: Read the next row from the remote server
+ * jq_columnar_kind: Choose the transfer kind requested for a column of the
+ * given type.  Types without a binary transfer kind are sent as text and
+ * converted by their input function.
  */
-TupleTableSlot *
-jq_iterate(JDBCUtilsInfo * jdbcUtilsInfo, ForeignScanState *node, List *retrieved_attrs, int resultSetID)
+static jint
+jq_columnar_kind(Oid pgtype, int32 pgtypmod)
 {
-	jobject		JDBCUtilsObject;
-	TupleTableSlot *tupleSlot = node->ss.ss_ScanTupleSlot;
-	TupleDesc	tupleDescriptor = tupleSlot->tts_tupleDescriptor;
-	jclass		JDBCUtilsClass;
-	jmethodID	idResultSet;
-	jmethodID	idNumberOfColumns;
-	jobjectArray rowArray;
-	int			numberOfColumns;
-	int			i;
-
-	ereport(DEBUG3, (errmsg("In jq_iterate")));
-
-	memset(tupleSlot->tts_values, 0, sizeof(Datum) * tupleDescriptor->natts);
-	memset(tupleSlot->tts_isnull, true, sizeof(bool) * tupleDescriptor->natts);
-
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
-
-	ExecClearTuple(tupleSlot);
-
-	idNumberOfColumns = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getNumberOfColumns", "(I)I");
-	if (idNumberOfColumns == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getNumberOfColumns method")));
-	}
-	jq_exception_clear();
-	numberOfColumns = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idNumberOfColumns, resultSetID);
-	jq_get_exception();
-	if (numberOfColumns < 0)
-	{
-		ereport(ERROR, (errmsg("getNumberOfColumns got wrong value: %d", numberOfColumns)));
-	}
-
-	if ((*Jenv)->PushLocalFrame(Jenv, (numberOfColumns + 10)) < 0)
-	{
-		ereport(ERROR, (errmsg("Error pushing local java frame")));
-	}
-
-	idResultSet = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getResultSet", "(I)[Ljava/lang/Object;");
-	if (idResultSet == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getResultSet method!")));
-	}
-	/* Allocate pointers to the row data */
-	jq_exception_clear();
-	rowArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idResultSet, resultSetID);
-	jq_get_exception();
-	if (rowArray != NULL)
+	switch (pgtype)
 	{
-		if (retrieved_attrs != NIL)
-		{
-			for (i = 0; i < retrieved_attrs->length; i++)
-			{
-				int			column_index = retrieved_attrs->elements[i].int_value - 1;
-				Oid			pgtype = TupleDescAttr(tupleDescriptor, column_index)->atttypid;
-				int32		pgtypmod = TupleDescAttr(tupleDescriptor, column_index)->atttypmod;
-				jobject		obj = (jobject) (*Jenv)->GetObjectArrayElement(Jenv, rowArray, i);
-
-				if (obj != NULL)
-				{
-					tupleSlot->tts_isnull[column_index] = false;
-					tupleSlot->tts_values[column_index] = jdbc_convert_object_to_datum(pgtype, pgtypmod, obj);
-				}
-			}
-		}
-		ExecStoreVirtualTuple(tupleSlot);
-		(*Jenv)->DeleteLocalRef(Jenv, rowArray);
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return JQ_KIND_INT64;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return JQ_KIND_FLOAT8;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return JQ_KIND_TIMESTAMP;
+		case TIMEOID:
+			return JQ_KIND_TIME;
+		case NUMERICOID:
+			return JQ_KIND_NUMERIC;
+		case BOOLOID:
+			return JQ_KIND_BOOL;
+		case DATEOID:
+			return JQ_KIND_DATE;
+		case BYTEAOID:
+			return JQ_KIND_BINARY;
+		default:
+			return JQ_KIND_TEXT;
 	}
-	(*Jenv)->PopLocalFrame(Jenv, NULL);
-	return (tupleSlot);
 }
 
 /*
- * jq_iterate_all_row: Read the all row from the remote server without an existing foreign table
+ * Fast path conversions of the values of a columnar batch, used when Java
+ * sent a column with the transfer kind requested by jq_columnar_kind().
  */
-void
-jq_iterate_all_row(FunctionCallInfo fcinfo, JDBCUtilsInfo * jdbcUtilsInfo, TupleDesc tupleDescriptor, int resultSetID)
+static Datum
+jq_convert_int2(const JcolumnConverter * converter, const char *data, int32 len)
 {
-	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	int64		value;
+
+	memcpy(&value, data, sizeof(int64));
+	if (value < PG_INT16_MIN || value > PG_INT16_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value \"" INT64_FORMAT "\" is out of range for type smallint",
+						value)));
+	return Int16GetDatum((int16) value);
+}
 
-	jobject		JDBCUtilsObject;
-	jclass		JDBCUtilsClass;
+static Datum
+jq_convert_int4(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
+
+	memcpy(&value, data, sizeof(int64));
+	if (value < PG_INT32_MIN || value > PG_INT32_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value \"" INT64_FORMAT "\" is out of range for type integer",
+						value)));
+	return Int32GetDatum((int32) value);
+}
 
-	jmethodID	idResultSet;
-	jmethodID	idNumberOfColumns;
-	jobjectArray rowArray;
+static Datum
+jq_convert_int8(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
 
-	Tuplestorestate *tupstore;
-	HeapTuple	tuple = NULL;
+	memcpy(&value, data, sizeof(int64));
+	return Int64GetDatum(value);
+}
 
-	MemoryContext oldcontext;
+static Datum
+jq_convert_float4(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	double		value;
+	float4		result;
+
+	memcpy(&value, data, sizeof(double));
+	result = (float4) value;
+	if (isinf(result) && !isinf(value))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value \"%g\" is out of range for type real",
+						value)));
+	return Float4GetDatum(result);
+}
 
-	Datum	   *values;
-	bool	   *nulls;
+static Datum
+jq_convert_float8(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	double		value;
 
-	int			numberOfColumns;
+	memcpy(&value, data, sizeof(double));
+	return Float8GetDatum(value);
+}
 
-	ereport(DEBUG3, (errmsg("In jq_iterate_all_row")));
+static Datum
+jq_convert_timestamp(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
+
+	/* Java sends microseconds since the Unix epoch in UTC */
+	memcpy(&value, data, sizeof(int64));
+	value -= POSTGRES_TO_UNIX_EPOCH_USECS;
+	if (!IS_VALID_TIMESTAMP(value))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("timestamp out of range")));
+	return TimestampGetDatum((Timestamp) value);
+}
 
-	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
-	tupstore = tuplestore_begin_heap(true, false, work_mem);
+static Datum
+jq_convert_time(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
+
+	/* Java sends microseconds since midnight */
+	memcpy(&value, data, sizeof(int64));
+	if (value < INT64CONST(0) || value > USECS_PER_DAY)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("time out of range")));
+	return TimeADTGetDatum((TimeADT) value);
+}
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+static Datum
+jq_convert_bool(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
 
-	idNumberOfColumns = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getNumberOfColumns", "(I)I");
-	if (idNumberOfColumns == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getNumberOfColumns method")));
-	}
-	jq_exception_clear();
-	numberOfColumns = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idNumberOfColumns, resultSetID);
-	jq_get_exception();
-	if (numberOfColumns < 0)
-	{
-		ereport(ERROR, (errmsg("getNumberOfColumns got wrong value: %d", numberOfColumns)));
-	}
+	memcpy(&value, data, sizeof(int64));
+	return BoolGetDatum(value != 0);
+}
 
-	if ((*Jenv)->PushLocalFrame(Jenv, (numberOfColumns + 10)) < 0)
-	{
-		ereport(ERROR, (errmsg("Error pushing local java frame")));
-	}
+static Datum
+jq_convert_date(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int64		value;
+
+	/* Java sends days since the Unix epoch */
+	memcpy(&value, data, sizeof(int64));
+	value -= POSTGRES_TO_UNIX_EPOCH_DAYS;
+	if (value < PG_INT32_MIN || value > PG_INT32_MAX ||
+		!IS_VALID_DATE((DateADT) value))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("date out of range")));
+	return DateADTGetDatum((DateADT) value);
+}
 
-	idResultSet = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getResultSet", "(I)[Ljava/lang/Object;");
-	if (idResultSet == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getResultSet method!")));
-	}
+/*
+ * jq_convert_numeric: A numeric value is sent either as 'b' followed by an
+ * int32 scale and an int64 unscaled value, or as 't' followed by its text.
+ */
+static Datum
+jq_convert_numeric(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	int32		scale;
+	int64		unscaled;
+
+	if (len != 1 + sizeof(int32) + sizeof(int64) || data[0] != 'b')
+		return InputFunctionCall((FmgrInfo *) &converter->typinput, pnstrdup(data + 1, len - 1),
+								 converter->typioparam, converter->typmod);
 
-	do
+	memcpy(&scale, data + 1, sizeof(int32));
+	memcpy(&unscaled, data + 1 + sizeof(int32), sizeof(int64));
+
+#if PG_VERSION_NUM >= 150000
+	return NumericGetDatum(int64_div_fast_to_numeric(unscaled, scale));
+#else
 	{
-		/* Allocate pointers to the row data */
-		jq_exception_clear();
-		rowArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idResultSet, resultSetID);
-		jq_get_exception();
+		/* Build the text of unscaled / 10^scale, scale is never negative */
+		char		digits[MAXINT8LEN + 1];
+		uint64		abs_value = (unscaled < 0) ? -((uint64) unscaled) : (uint64) unscaled;
+		StringInfoData buf;
+		int			ndigits;
 
-		if (rowArray != NULL)
-		{
-			values = (Datum *) palloc0(tupleDescriptor->natts * sizeof(Datum));
-			nulls = (bool *) palloc(tupleDescriptor->natts * sizeof(bool));
-			/* Initialize to nulls for any columns not present in result */
-			memset(nulls, true, tupleDescriptor->natts * sizeof(bool));
+		snprintf(digits, sizeof(digits), UINT64_FORMAT, abs_value);
+		ndigits = strlen(digits);
 
-			for (int i = 0; i < numberOfColumns; i++)
+		initStringInfo(&buf);
+		if (unscaled < 0)
+			appendStringInfoChar(&buf, '-');
+		if (ndigits > scale)
+		{
+			appendBinaryStringInfo(&buf, digits, ndigits - scale);
+			if (scale > 0)
 			{
-				int			column_index = i;
-				Oid			pgtype = TupleDescAttr(tupleDescriptor, column_index)->atttypid;
-				int32		pgtypmod = TupleDescAttr(tupleDescriptor, column_index)->atttypmod;
-				jobject		obj = (jobject) (*Jenv)->GetObjectArrayElement(Jenv, rowArray, i);
-
-				if (obj != NULL)
-				{
-					values[column_index] = jdbc_convert_object_to_datum(pgtype, pgtypmod, obj);
-					nulls[column_index] = false;
-				}
+				appendStringInfoChar(&buf, '.');
+				appendStringInfoString(&buf, digits + ndigits - scale);
 			}
-
-			tuple = heap_form_tuple(tupleDescriptor, values, nulls);
-			tuplestore_puttuple(tupstore, tuple);
-
-			(*Jenv)->DeleteLocalRef(Jenv, rowArray);
 		}
+		else
+		{
+			appendStringInfoString(&buf, "0.");
+			for (int i = ndigits; i < scale; i++)
+				appendStringInfoChar(&buf, '0');
+			appendStringInfoString(&buf, digits);
+		}
+		return InputFunctionCall((FmgrInfo *) &converter->typinput, buf.data,
+								 converter->typioparam, converter->typmod);
 	}
-	while (rowArray != NULL);
+#endif
+}
 
-	if (tuple != NULL)
-	{
-		rsinfo->setResult = tupstore;
-		rsinfo->setDesc = tupleDescriptor;
-		MemoryContextSwitchTo(oldcontext);
-	}
+static Datum
+jq_convert_bytea(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	bytea	   *result = (bytea *) palloc(len + VARHDRSZ);
 
-	(*Jenv)->PopLocalFrame(Jenv, NULL);
+	memcpy(VARDATA(result), data, len);
+	SET_VARSIZE(result, len + VARHDRSZ);
+	return PointerGetDatum(result);
 }
 
+/*
+ * jq_convert_text: Convert a text value of a columnar batch with the input
+ * function of the column's type.  Java sends text as UTF-8, so it is
+ * converted to the database encoding first when that is not UTF-8.
+ */
+static Datum
+jq_convert_text(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	char	   *value = pnstrdup(data, len);
 
+	if (GetDatabaseEncoding() != PG_UTF8)
+		value = pg_any_to_server(value, len, PG_UTF8);
 
-Jresult *
-jq_exec_prepared(JDBCUtilsInfo * jdbcUtilsInfo, const int *paramLengths,
+	return InputFunctionCall((FmgrInfo *) &converter->typinput, value,
+							 converter->typioparam, converter->typmod);
+}
+
+/*
+ * jq_convert_binary_text: Give a binary value of a columnar batch to the
+ * input function of a column whose type is not bytea, as it is.
+ */
+static Datum
+jq_convert_binary_text(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	return InputFunctionCall((FmgrInfo *) &converter->typinput, pnstrdup(data, len),
+							 converter->typioparam, converter->typmod);
+}
+
+/*
+ * jq_convert_varlena: Build a text, varchar or bpchar value of a columnar
+ * batch directly from the buffer, copying the data once.  The input
+ * functions would not check the length nor pad the value either, since
+ * they are given the typmod of the type.
+ */
+static Datum
+jq_convert_varlena(const JcolumnConverter * converter, const char *data, int32 len)
+{
+	char	   *converted;
+
+	if (GetDatabaseEncoding() == PG_UTF8)
+		return PointerGetDatum(cstring_to_text_with_len(data, len));
+
+	converted = pg_any_to_server(data, len, PG_UTF8);
+	if (converted == data)
+		return PointerGetDatum(cstring_to_text_with_len(data, len));
+	return PointerGetDatum(cstring_to_text(converted));
+}
+
+/*
+ * jq_columnar_fast_path: Return the fast path conversion of a column of the
+ * given type sent with the given transfer kind, or NULL if there is none.
+ */
+static JcolumnFastPath
+jq_columnar_fast_path(Oid pgtype, jint kind)
+{
+	switch (kind)
+	{
+		case JQ_KIND_INT64:
+			if (pgtype == INT2OID)
+				return jq_convert_int2;
+			if (pgtype == INT4OID)
+				return jq_convert_int4;
+			return jq_convert_int8;
+		case JQ_KIND_FLOAT8:
+			if (pgtype == FLOAT4OID)
+				return jq_convert_float4;
+			return jq_convert_float8;
+		case JQ_KIND_TIMESTAMP:
+			return jq_convert_timestamp;
+		case JQ_KIND_TIME:
+			return jq_convert_time;
+		case JQ_KIND_NUMERIC:
+			return jq_convert_numeric;
+		case JQ_KIND_BOOL:
+			return jq_convert_bool;
+		case JQ_KIND_DATE:
+			return jq_convert_date;
+		case JQ_KIND_BINARY:
+			if (pgtype == BYTEAOID)
+				return jq_convert_bytea;
+			return NULL;
+		case JQ_KIND_TEXT:
+			if (pgtype == TEXTOID || pgtype == VARCHAROID || pgtype == BPCHAROID)
+				return jq_convert_varlena;
+			return NULL;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * jq_init_columnar_buffer: Prepare the buffer receiving batches of rows of a
+ * scan, and the conversion plan of each retrieved column, so that no catalog
+ * lookup is needed while rows are converted.  Everything is allocated in the
+ * current memory context and must live as long as the scan.
+ */
+void
+jq_init_columnar_buffer(JcolumnarBuffer * buffer, TupleDesc tupleDescriptor, List *retrieved_attrs)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	buffer->ncolumns = list_length(retrieved_attrs);
+	buffer->kinds = (jint *) palloc0(Max(buffer->ncolumns, 1) * sizeof(jint));
+	buffer->converters = (JcolumnConverter *) palloc0(Max(buffer->ncolumns, 1) * sizeof(JcolumnConverter));
+	foreach(lc, retrieved_attrs)
+	{
+		JcolumnConverter *converter = &buffer->converters[i];
+		Form_pg_attribute attr = TupleDescAttr(tupleDescriptor, lfirst_int(lc) - 1);
+		Oid			typinput;
+		HeapTuple	tuple;
+
+		converter->column_index = lfirst_int(lc) - 1;
+		buffer->kinds[i] = jq_columnar_kind(attr->atttypid, attr->atttypmod);
+		converter->fastpath = jq_columnar_fast_path(attr->atttypid, buffer->kinds[i]);
+
+		/*
+		 * Values are given to the input function with the typmod of the type
+		 * rather than of the column, as jdbc_convert_to_pg does.
+		 */
+		tuple = SearchSysCache1(TYPEOID, ObjectIdGetDatum(attr->atttypid));
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "cache lookup failed for type%u", attr->atttypid);
+		converter->typmod = ((Form_pg_type) GETSTRUCT(tuple))->typtypmod;
+		ReleaseSysCache(tuple);
+
+		getTypeInputInfo(attr->atttypid, &typinput, &converter->typioparam);
+		fmgr_info(typinput, &converter->typinput);
+		i++;
+	}
+	buffer->size = JQ_COLUMNAR_BUFFER_SIZE;
+	buffer->data = (char *) palloc(buffer->size);
+}
+
+/*
+ * jq_iterate_batch: Read up to fetch_size rows from the remote server with a
+ * single JNI call and form them into heap tuples allocated in the current
+ * memory context. Java writes the rows column by column into buffer, which
+ * is wrapped in a direct ByteBuffer so that no Java object is created per
+ * value. Returns the number of tuples stored into *tuples, and sets
+ * *eof_reached once the remote result set has been exhausted.
+ */
+int
+jq_iterate_batch(JDBCUtilsInfo * jdbcUtilsInfo, TupleDesc tupleDescriptor, JcolumnarBuffer * buffer,
+				  int resultSetID, int fetch_size,
+				 HeapTuple **tuples, bool *eof_reached)
+{
+	jobject		JDBCUtilsObject;
+	jintArray	kindArray;
+	int			ncolumns = buffer->ncolumns;
+	int			numberOfRows;
+	int32		eof;
+	int32		batch_ncolumns;
+	char	   *ptr;
+	jint	   *kinds;
+	const uint8 **nullmaps;
+	const char **column_data;
+	const int32 **column_offsets;
+	JcolumnFastPath *conversions;
+	Datum	   *values;
+	bool	   *nulls;
+	int			row;
+	int			i;
+
+	ereport(DEBUG3, (errmsg("In jq_iterate_batch")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	kindArray = (*Jenv)->NewIntArray(Jenv, ncolumns);
+	if (kindArray == NULL)
+		ereport(ERROR, (errmsg("Failed to create java int array")));
+	(*Jenv)->SetIntArrayRegion(Jenv, kindArray, 0, ncolumns, buffer->kinds);
+
+	for (;;)
+	{
+		jobject		byteBuffer;
+		int64		needed;
+
+		byteBuffer = (*Jenv)->NewDirectByteBuffer(Jenv, buffer->data, (jlong) buffer->size);
+		if (byteBuffer == NULL)
+			ereport(ERROR, (errmsg("Failed to create java direct byte buffer")));
+
+		jq_exception_clear();
+		numberOfRows = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idFillResultSetBatch,
+													resultSetID, byteBuffer, kindArray, fetch_size);
+		jq_get_exception();
+		(*Jenv)->DeleteLocalRef(Jenv, byteBuffer);
+
+		memcpy(&needed, buffer->data + 8, sizeof(int64));
+		if (numberOfRows > 0 || needed == 0)
+			break;
+
+		/* A single row does not fit into the buffer, grow it and retry */
+		if (needed > MaxAllocSize)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("row fetched from remote server is too large")));
+		buffer->data = (char *) repalloc(buffer->data, needed);
+		buffer->size = needed;
+	}
+	(*Jenv)->DeleteLocalRef(Jenv, kindArray);
+
+	memcpy(&eof, buffer->data + 4, sizeof(int32));
+	memcpy(&batch_ncolumns, buffer->data + 16, sizeof(int32));
+	*eof_reached = (eof != 0);
+	*tuples = NULL;
+	if (numberOfRows == 0)
+		return 0;
+	if (batch_ncolumns != ncolumns)
+		ereport(ERROR,
+				(errmsg("remote query returned %d columns, expected %d",
+						batch_ncolumns, ncolumns)));
+
+	/* Locate the sections of each column */
+	kinds = (jint *) (buffer->data + 20);
+	nullmaps = (const uint8 **) palloc(Max(ncolumns, 1) * sizeof(uint8 *));
+	column_data = (const char **) palloc(Max(ncolumns, 1) * sizeof(char *));
+	column_offsets = (const int32 **) palloc(Max(ncolumns, 1) * sizeof(int32 *));
+	conversions = (JcolumnFastPath *) palloc(Max(ncolumns, 1) * sizeof(JcolumnFastPath));
+	ptr = buffer->data + TYPEALIGN(8, 20 + ncolumns * sizeof(int32));
+	for (i = 0; i < ncolumns; i++)
+	{
+		/* Java falls back to text for a column it cannot send as requested */
+		if (kinds[i] == buffer->kinds[i] && buffer->converters[i].fastpath != NULL)
+			conversions[i] = buffer->converters[i].fastpath;
+		else if (kinds[i] == JQ_KIND_BINARY)
+			conversions[i] = jq_convert_binary_text;
+		else
+			conversions[i] = jq_convert_text;
+
+		nullmaps[i] = (const uint8 *) ptr;
+		ptr += TYPEALIGN(8, (numberOfRows + 7) / 8);
+		if (kinds[i] == JQ_KIND_TEXT || kinds[i] == JQ_KIND_BINARY ||
+			kinds[i] == JQ_KIND_NUMERIC)
+		{
+			column_offsets[i] = (const int32 *) ptr;
+			ptr += TYPEALIGN(8, (numberOfRows + 1) * sizeof(int32));
+			column_data[i] = ptr;
+			ptr += TYPEALIGN(8, column_offsets[i][numberOfRows]);
+		}
+		else
+		{
+			column_offsets[i] = NULL;
+			column_data[i] = ptr;
+			ptr += numberOfRows * sizeof(int64);
+		}
+	}
+
+	*tuples = (HeapTuple *) palloc0(numberOfRows * sizeof(HeapTuple));
+	values = (Datum *) palloc(tupleDescriptor->natts * sizeof(Datum));
+	nulls = (bool *) palloc(tupleDescriptor->natts * sizeof(bool));
+
+	for (row = 0; row < numberOfRows; row++)
+	{
+		/* Initialize to nulls for any columns not present in result */
+		memset(values, 0, tupleDescriptor->natts * sizeof(Datum));
+		memset(nulls, true, tupleDescriptor->natts * sizeof(bool));
+
+		for (i = 0; i < ncolumns; i++)
+		{
+			const JcolumnConverter *converter = &buffer->converters[i];
+
+			if ((nullmaps[i][row / 8] & (1 << (row % 8))) != 0)
+				continue;
+
+			nulls[converter->column_index] = false;
+			if (column_offsets[i] != NULL)
+				values[converter->column_index] =
+					conversions[i] (converter,
+									column_data[i] + column_offsets[i][row],
+									column_offsets[i][row + 1] - column_offsets[i][row]);
+			else
+				values[converter->column_index] =
+					conversions[i] (converter, column_data[i] + row * sizeof(int64), sizeof(int64));
+		}
+		(*tuples)[row] = heap_form_tuple(tupleDescriptor, values, nulls);
+	}
+
+	pfree(values);
+	pfree(nulls);
+	pfree(nullmaps);
+	pfree(column_data);
+	pfree(column_offsets);
+	pfree(conversions);
+
+	return numberOfRows;
+}
+
+/*
+ * jq_iterate_all_row: Read the all row from the remote server without an existing foreign table
+ */
+void
+jq_iterate_all_row(FunctionCallInfo fcinfo, JDBCUtilsInfo * jdbcUtilsInfo, TupleDesc tupleDescriptor, int resultSetID)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+
+	jobject		JDBCUtilsObject;
+
+	Tuplestorestate *tupstore;
+	bool		has_rows = false;
+
+	MemoryContext oldcontext;
+	MemoryContext batch_cxt;
+
+	JcolumnarBuffer buffer;
+	List	   *retrieved_attrs = NIL;
+	bool		eof_reached = false;
+
+	int			numberOfColumns;
+
+	ereport(DEBUG3, (errmsg("In jq_iterate_all_row")));
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	numberOfColumns = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idGetNumberOfColumns, resultSetID);
+	jq_get_exception();
+	if (numberOfColumns < 0)
+	{
+		ereport(ERROR, (errmsg("getNumberOfColumns got wrong value: %d", numberOfColumns)));
+	}
+
+	for (int i = 0; i < numberOfColumns; i++)
+		retrieved_attrs = lappend_int(retrieved_attrs, i + 1);
+	jq_init_columnar_buffer(&buffer, tupleDescriptor, retrieved_attrs);
+
+	/* Tuples of a batch are copied into the tuplestore, then released */
+	batch_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "jdbc_fdw tuple data",
+									  ALLOCSET_DEFAULT_SIZES);
+
+	while (!eof_reached)
+	{
+		HeapTuple  *tuples;
+		int			numberOfRows;
+		MemoryContext tmpcontext = MemoryContextSwitchTo(batch_cxt);
+
+		numberOfRows = jq_iterate_batch(jdbcUtilsInfo, tupleDescriptor, &buffer, resultSetID,
+										 DEFAULT_FETCH_SIZE, &tuples, &eof_reached);
+		MemoryContextSwitchTo(tmpcontext);
+
+		for (int row = 0; row < numberOfRows; row++)
+			tuplestore_puttuple(tupstore, tuples[row]);
+		if (numberOfRows > 0)
+			has_rows = true;
+
+		MemoryContextReset(batch_cxt);
+	}
+
+	MemoryContextDelete(batch_cxt);
+	pfree(buffer.data);
+	pfree(buffer.kinds);
+	pfree(buffer.converters);
+
+	if (has_rows)
+	{
+		rsinfo->setResult = tupstore;
+		rsinfo->setDesc = tupleDescriptor;
+		MemoryContextSwitchTo(oldcontext);
+	}
+}
+
+
+
+Jresult *
+jq_exec_prepared(JDBCUtilsInfo * jdbcUtilsInfo, const int *paramLengths,
 				 const int *paramFormats, int resultFormat, int resultSetID)
 {
-	jmethodID	idExecPreparedStatement;
-	jclass		JDBCUtilsClass;
 	jobject		JDBCUtilsObject;
 	Jresult    *res;
 
 	ereport(DEBUG3, (errmsg("In jq_exec_prepared")));
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	jq_exception_clear();
+	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idExecPreparedStatement, resultSetID);
+	jq_get_exception();
+
+	/* Return Java memory */
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_get_affected_rows
+ *		Return the number of rows affected by the last execution of the
+ *		prepared statement, or -1 if the driver did not report the update
+ *		counts of a batch.
+ */
+int
+jq_get_affected_rows(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	int			affectedRows;
+
+	ereport(DEBUG3, (errmsg("In jq_get_affected_rows")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	affectedRows = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idGetNumberOfAffectedRows, resultSetID);
+	jq_get_exception();
+
+	return affectedRows;
+}
+
+/*
+ * jq_get_max_parameters
+ *		Return the number of parameters a statement can have on the remote
+ *		database.
+ */
+int
+jq_get_max_parameters(JDBCUtilsInfo * jdbcUtilsInfo)
+{
+	jobject		JDBCUtilsObject;
+	int			maxParameters;
+
+	ereport(DEBUG3, (errmsg("In jq_get_max_parameters")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	maxParameters = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idGetMaxParameters);
+	jq_get_exception();
+
+	return maxParameters;
+}
+
+/*
+ * jq_get_database_product_name
+ *		Return the name of the remote database product, or NULL if the
+ *		driver does not know it.
+ */
+char *
+jq_get_database_product_name(JDBCUtilsInfo * jdbcUtilsInfo)
+{
+	jobject		JDBCUtilsObject;
+	jobject		productName;
+
+	ereport(DEBUG3, (errmsg("In jq_get_database_product_name")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	productName = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetDatabaseProductName);
+	jq_get_exception();
+
+	return jdbc_convert_string_to_cstring(productName);
+}
+
+/*
+ * jq_add_batch
+ *		Add the parameters currently bound to the prepared statement to its
+ *		batch instead of executing it.
+ */
+void
+jq_add_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+
+	ereport(DEBUG3, (errmsg("In jq_add_batch")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idAddBatchPreparedStatement, resultSetID);
+	jq_get_exception();
+}
+
+/*
+ * jq_exec_batch
+ *		Send every row added by jq_add_batch to the remote server in one
+ *		executeBatch call.
+ */
+Jresult *
+jq_exec_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jq_exec_batch")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idExecBatchPreparedStatement, resultSetID);
+	jq_get_exception();
+
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_create_bulk_loader
+ *		Set up a bulk load of the given columns of the given table through
+ *		the native bulk path of the remote database.  Both are deparsed and
+ *		quoted by the caller.  Returns the ID of the bulk load, or 0 if the
+ *		driver has no bulk path, in which case the caller falls back to a
+ *		prepared INSERT.
+ */
+int
+jq_create_bulk_loader(JDBCUtilsInfo * jdbcUtilsInfo, const char *table, const char *columns)
+{
+	jobject		JDBCUtilsObject;
+	jstring		tableString;
+	jstring		columnsString;
+	int			bulkLoadID;
+
+	ereport(DEBUG3, (errmsg("In jq_create_bulk_loader: %s (%s)", table, columns)));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	tableString = (*Jenv)->NewStringUTF(Jenv, table);
+	columnsString = (*Jenv)->NewStringUTF(Jenv, columns);
+	if (tableString == NULL || columnsString == NULL)
+		ereport(ERROR, (errmsg("Failed to create bulk load arguments")));
+
+	jq_exception_clear();
+	bulkLoadID = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idCreateBulkLoader, tableString, columnsString);
+	jq_get_exception();
+
+	/* Return Java memory */
+	(*Jenv)->DeleteLocalRef(Jenv, tableString);
+	(*Jenv)->DeleteLocalRef(Jenv, columnsString);
+
+	return bulkLoadID;
+}
+
+/*
+ * jq_exec_bulk_load
+ *		Send every row added by jq_add_bulk_load_row to the remote server in
+ *		a single bulk load.
+ */
+Jresult *
+jq_exec_bulk_load(JDBCUtilsInfo * jdbcUtilsInfo, int bulkLoadID)
+{
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jq_exec_bulk_load")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
 	res = (Jresult *) palloc0(sizeof(Jresult));
 	*res = PGRES_FATAL_ERROR;
 
-	idExecPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "execPreparedStatement",
-												   "(I)V");
-	if (idExecPreparedStatement == NULL)
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idExecBulkLoad, bulkLoadID);
+	jq_get_exception();
+
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_exec_truncate
+ *		Execute the TRUNCATE statement truncate_sql.  If the remote database
+ *		rejects it as unsupported, the tables are emptied with the DELETE
+ *		statements of delete_sqls instead; pass NIL to have no fallback.
+ */
+Jresult *
+jq_exec_truncate(JDBCUtilsInfo * jdbcUtilsInfo, const char *truncate_sql, List *delete_sqls)
+{
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+	jstring		truncateString;
+	jobjectArray deleteArray;
+	ListCell   *lc;
+	int			i;
+
+	ereport(DEBUG3, (errmsg("In jq_exec_truncate: %s", truncate_sql)));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	truncateString = (*Jenv)->NewStringUTF(Jenv, truncate_sql);
+	deleteArray = (*Jenv)->NewObjectArray(Jenv, list_length(delete_sqls), jni_registry.StringClass, NULL);
+	if (truncateString == NULL || deleteArray == NULL)
+		ereport(ERROR, (errmsg("Failed to create truncate arguments")));
+
+	i = 0;
+	foreach(lc, delete_sqls)
 	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.execPreparedStatement method!")));
+		jstring		deleteString = (*Jenv)->NewStringUTF(Jenv, (char *) lfirst(lc));
+
+		if (deleteString == NULL)
+			ereport(ERROR, (errmsg("Failed to create truncate arguments")));
+		(*Jenv)->SetObjectArrayElement(Jenv, deleteArray, i++, deleteString);
+		(*Jenv)->DeleteLocalRef(Jenv, deleteString);
 	}
+
 	jq_exception_clear();
-	(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idExecPreparedStatement, resultSetID);
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idExecTruncate, truncateString, deleteArray);
 	jq_get_exception();
 
 	/* Return Java memory */
+	(*Jenv)->DeleteLocalRef(Jenv, truncateString);
+	(*Jenv)->DeleteLocalRef(Jenv, deleteArray);
+
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_exec_async_batch
+ *		Hand the rows added by jq_add_async_batch_row over to the writer
+ *		thread of the connection as one batch.  Waits while the queue of the
+ *		thread is full, and reports the error of an earlier batch, if any.
+ */
+Jresult *
+jq_exec_async_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jq_exec_async_batch")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idExecAsyncBatch, resultSetID);
+	jq_get_exception();
+
 	*res = PGRES_COMMAND_OK;
 
 	return res;
 }
 
+/*
+ * jq_wait_async_writes
+ *		Wait until the writer thread of the connection has executed every
+ *		batch handed over to it, and report the error of one of them, if any.
+ */
+void
+jq_wait_async_writes(JDBCUtilsInfo * jdbcUtilsInfo)
+{
+	jobject		JDBCUtilsObject;
+
+	ereport(DEBUG3, (errmsg("In jq_wait_async_writes")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, jni_registry.idWaitAsyncWrites);
+	jq_get_exception();
+}
+
 void
 jq_clear(Jresult * res)
 {
@@ -934,25 +1728,17 @@ Jresult *
 jq_prepare(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
 		   const Oid *paramTypes, int *resultSetID)
 {
-	jmethodID	idCreatePreparedStatement;
 	jstring		statement;
-	jclass		JDBCUtilsClass;
 	jobject		JDBCUtilsObject;
 	Jresult    *res;
 
 	ereport(DEBUG3, (errmsg("In jq_prepare(%p): %s", jdbcUtilsInfo, query)));
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
 	res = (Jresult *) palloc0(sizeof(Jresult));
 	*res = PGRES_FATAL_ERROR;
 
-	idCreatePreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "createPreparedStatement",
-													 "(Ljava/lang/String;)I");
-	if (idCreatePreparedStatement == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.createPreparedStatement method!")));
-	}
 	/* The query argument */
 	statement = (*Jenv)->NewStringUTF(Jenv, query);
 	if (statement == NULL)
@@ -961,7 +1747,7 @@ jq_prepare(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
 	}
 	jq_exception_clear();
 	/* get the resultSetID */
-	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idCreatePreparedStatement, statement);
+	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, jni_registry.idCreatePreparedStatement, statement);
 	jq_get_exception();
 	if (*resultSetID < 0)
 	{
@@ -971,11 +1757,199 @@ jq_prepare(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
 	}
 	ereport(DEBUG3, (errmsg("Get resultSetID successfully, ID: %d", *resultSetID)));
 
-	/* Return Java memory */
-	(*Jenv)->DeleteLocalRef(Jenv, statement);
-	*res = PGRES_COMMAND_OK;
+	/* Return Java memory */
+	(*Jenv)->DeleteLocalRef(Jenv, statement);
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_prepare_returning
+ *		Like jq_prepare, for a statement whose RETURNING columns are read back
+ *		with jq_get_generated_keys.  columns holds the remote names of the
+ *		columns to return.
+ */
+Jresult *
+jq_prepare_returning(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
+					 List *columns, int *resultSetID)
+{
+	jstring		statement;
+	jobjectArray columnArray;
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+	ListCell   *lc;
+	int			i;
+
+	ereport(DEBUG3, (errmsg("In jq_prepare_returning(%p): %s", jdbcUtilsInfo, query)));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	/* The query and column arguments */
+	statement = (*Jenv)->NewStringUTF(Jenv, query);
+	columnArray = (*Jenv)->NewObjectArray(Jenv, list_length(columns), jni_registry.StringClass, NULL);
+	if (statement == NULL || columnArray == NULL)
+	{
+		ereport(ERROR, (errmsg("Failed to create query argument")));
+	}
+	i = 0;
+	foreach(lc, columns)
+	{
+		jstring		column = (*Jenv)->NewStringUTF(Jenv, (char *) lfirst(lc));
+
+		if (column == NULL)
+			ereport(ERROR, (errmsg("Failed to create query argument")));
+		(*Jenv)->SetObjectArrayElement(Jenv, columnArray, i++, column);
+		(*Jenv)->DeleteLocalRef(Jenv, column);
+	}
+
+	jq_exception_clear();
+	/* get the resultSetID */
+	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idCreatePreparedStatementReturning,
+												statement, columnArray);
+	jq_get_exception();
+	if (*resultSetID < 0)
+	{
+		/* Return Java memory */
+		(*Jenv)->DeleteLocalRef(Jenv, statement);
+		(*Jenv)->DeleteLocalRef(Jenv, columnArray);
+		ereport(ERROR, (errmsg("Get resultSetID failed with code: %d", *resultSetID)));
+	}
+	ereport(DEBUG3, (errmsg("Get resultSetID successfully, ID: %d", *resultSetID)));
+
+	/* Return Java memory */
+	(*Jenv)->DeleteLocalRef(Jenv, statement);
+	(*Jenv)->DeleteLocalRef(Jenv, columnArray);
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_get_generated_keys
+ *		Return a new resultSetID holding the rows returned by the last
+ *		execution or batch of a statement prepared by jq_prepare_returning,
+ *		to be read with jq_iterate_batch, or 0 if the driver returned none.
+ */
+int
+jq_get_generated_keys(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	int			keysID;
+
+	ereport(DEBUG3, (errmsg("In jq_get_generated_keys")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	keysID = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idGetGeneratedKeysID, resultSetID);
+	jq_get_exception();
+
+	return keysID;
+}
+
+/*
+ * jq_prepare_query
+ *		Prepare a SELECT statement with parameters, which is executed with
+ *		jq_exec_prepared_query once its parameters are bound by jq_bind_row.
+ *		fetch_size is the number of rows to fetch from the server at a time.
+ */
+Jresult *
+jq_prepare_query(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int fetch_size,
+				 int *statementID)
+{
+	jstring		statement;
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jq_prepare_query(%p): %s", jdbcUtilsInfo, query)));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	/* The query argument */
+	statement = (*Jenv)->NewStringUTF(Jenv, query);
+	if (statement == NULL)
+	{
+		ereport(ERROR, (errmsg("Failed to create query argument")));
+	}
+	jq_exception_clear();
+	*statementID = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idCreatePreparedQuery, statement, fetch_size);
+	jq_get_exception();
+
+	/* Return Java memory */
+	(*Jenv)->DeleteLocalRef(Jenv, statement);
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_exec_prepared_query
+ *		Execute a statement prepared by jq_prepare_query with its currently
+ *		bound parameters.  The rows are read with jq_iterate_batch from the
+ *		returned resultSetID; the statement itself is kept for the next
+ *		execution.
+ */
+Jresult *
+jq_exec_prepared_query(JDBCUtilsInfo * jdbcUtilsInfo, int statementID, int *resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	Jresult    *res;
+
+	ereport(DEBUG3, (errmsg("In jq_exec_prepared_query: %d", statementID)));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	res = (Jresult *) palloc0(sizeof(Jresult));
+	*res = PGRES_FATAL_ERROR;
+
+	jq_exception_clear();
+	*resultSetID = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idExecPreparedQueryID, statementID);
+	jq_get_exception();
+
+	*res = PGRES_COMMAND_OK;
+
+	return res;
+}
+
+/*
+ * jq_get_column_names
+ *		Return the names of the columns of a result set, as a list of C
+ *		strings.
+ */
+List *
+jq_get_column_names(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID)
+{
+	jobject		JDBCUtilsObject;
+	jobjectArray columnNamesArray;
+	List	   *column_names = NIL;
+
+	ereport(DEBUG3, (errmsg("In jq_get_column_names")));
+
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
+
+	jq_exception_clear();
+	columnNamesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetColumnNamesByResultSetID, resultSetID);
+	jq_get_exception();
+
+	if (columnNamesArray != NULL)
+	{
+		jsize		numberOfNames = (*Jenv)->GetArrayLength(Jenv, columnNamesArray);
+		int			i;
+
+		for (i = 0; i < numberOfNames; i++)
+			column_names = lappend(column_names,
+								   jdbc_convert_string_to_cstring((*Jenv)->GetObjectArrayElement(Jenv, columnNamesArray, i)));
+		(*Jenv)->DeleteLocalRef(Jenv, columnNamesArray);
+	}
 
-	return res;
+	return column_names;
 }
 
 int
@@ -1076,339 +2050,323 @@ jq_transaction_status(const JDBCUtilsInfo * jdbcUtilsInfo)
 	return PQTRANS_UNKNOWN;
 }
 
-void *
-jq_bind_sql_var(JDBCUtilsInfo * jdbcUtilsInfo, Oid type, int attnum, Datum value, bool *isnull, int resultSetID)
+/*
+ * jq_param_kind: Choose the kind used to send a parameter of the given type
+ * to the JVM, or -1 if values of the type cannot be bound.
+ */
+static jint
+jq_param_kind(Oid pgtype)
 {
-	jmethodID	idBindPreparedStatement;
-	jclass		JDBCUtilsClass;
-	jobject		JDBCUtilsObject;
-	Jresult    *res;
-	int			nestlevel;
+	switch (pgtype)
+	{
+		case INT2OID:
+		case INT4OID:
+			return JQ_KIND_INT32;
+		case INT8OID:
+			return JQ_KIND_INT64;
+		case FLOAT4OID:
+			return JQ_KIND_FLOAT4;
+		case FLOAT8OID:
+			return JQ_KIND_FLOAT8;
+		case NUMERICOID:
+			return JQ_KIND_NUMERIC;
+		case BOOLOID:
+			return JQ_KIND_BOOL;
+		case BYTEAOID:
+			return JQ_KIND_BINARY;
+		case BPCHAROID:
+		case VARCHAROID:
+		case TEXTOID:
+		case JSONOID:
+		case NAMEOID:
+			return JQ_KIND_TEXT;
+		case TIMEOID:
+		case TIMETZOID:
+			return JQ_KIND_TIME;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return JQ_KIND_TIMESTAMP;
+		case DATEOID:
+			return JQ_KIND_DATE;
+		default:
+			return -1;
+	}
+}
 
-	ereport(DEBUG3, (errmsg("In jq_bind_sql_var")));
+/*
+ * jq_init_param_buffer: Prepare buffer to bind rows of nparams parameters of
+ * the given types with jq_bind_row.
+ */
+void
+jq_init_param_buffer(JparamBuffer * buffer, int nparams, const Oid *types)
+{
+	int			i;
 
-	res = (Jresult *) palloc0(sizeof(Jresult));
-	*res = PGRES_FATAL_ERROR;
+	buffer->nparams = nparams;
+	buffer->types = (Oid *) palloc0(Max(nparams, 1) * sizeof(Oid));
+	buffer->typoutput = (FmgrInfo *) palloc0(Max(nparams, 1) * sizeof(FmgrInfo));
+	for (i = 0; i < nparams; i++)
+	{
+		Oid			typefnoid;
+		bool		isvarlena;
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+		buffer->types[i] = types[i];
+		getTypeOutputInfo(types[i], &typefnoid, &isvarlena);
+		fmgr_info(typefnoid, &buffer->typoutput[i]);
+	}
+	initStringInfo(&buffer->data);
+}
 
-	attnum++;
-	elog(DEBUG2, "jdbc_fdw : %s %d type=%u ", __func__, attnum, type);
+/*
+ * jq_bind_row: Bind all parameters of the prepared statement with a single
+ * JNI call.  The row is serialized into buffer, which is wrapped in a direct
+ * ByteBuffer and applied by JDBCUtils.bindRowPreparedStatement.
+ *
+ * Layout of a row (native byte order):
+ *		int32	number of parameters
+ *		int32	kind of each parameter, padded to 8 bytes
+ *		null bitmap, one bit per parameter, bit set means NULL, padded to 8
+ *		one 8-byte slot per parameter: the value for fixed-width kinds, or
+ *		int32 offset and int32 length into the data area for JQ_KIND_TEXT,
+ *		JQ_KIND_BINARY and JQ_KIND_NUMERIC
+ *		the data area
+ *
+ * Values are converted in the current memory context.
+ */
+void
+jq_bind_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+			const bool *isnull, int resultSetID)
+{
+	ereport(DEBUG3, (errmsg("In jq_bind_row")));
 
-	if (*isnull)
-	{
-		idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindNullPreparedStatement",
-													   "(II)V");
-		if (idBindPreparedStatement == NULL)
-		{
-			ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bind method!")));
-		}
-		jq_exception_clear();
-		(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, attnum, resultSetID);
-		jq_get_exception();
-		*res = PGRES_COMMAND_OK;
-		return NULL;
-	}
+	jq_send_row(jdbcUtilsInfo, buffer, values, isnull,
+				jni_registry.idBindRowPreparedStatement, resultSetID);
+}
 
-	switch (type)
-	{
-		case INT2OID:
-			{
-				int16		dat = DatumGetInt16(value);
+/*
+ * jq_add_bulk_load_row: Append a row to the data of a bulk load.  The row is
+ * serialized as for jq_bind_row.
+ */
+void
+jq_add_bulk_load_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+					 const bool *isnull, int bulkLoadID)
+{
+	ereport(DEBUG3, (errmsg("In jq_add_bulk_load_row")));
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindIntPreparedStatement",
-															   "(III)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindInt method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-		case INT4OID:
-			{
-				int32		dat = DatumGetInt32(value);
+	jq_send_row(jdbcUtilsInfo, buffer, values, isnull,
+				jni_registry.idAddBulkLoadRow, bulkLoadID);
+}
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindIntPreparedStatement",
-															   "(III)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindInt method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-		case INT8OID:
-			{
-				int64		dat = DatumGetInt64(value);
+/*
+ * jq_add_async_batch_row: Add a row to the next batch of the prepared
+ * statement executed by the writer thread of the connection.  The row is
+ * serialized as for jq_bind_row, and only bound by that thread.
+ */
+void
+jq_add_async_batch_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+					   const bool *isnull, int resultSetID)
+{
+	ereport(DEBUG3, (errmsg("In jq_add_async_batch_row")));
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindLongPreparedStatement",
-															   "(JII)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindLong method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
+	jq_send_row(jdbcUtilsInfo, buffer, values, isnull,
+				jni_registry.idAddAsyncBatchRow, resultSetID);
+}
 
-		case FLOAT4OID:
+/*
+ * jq_send_row: Serialize a row into buffer and hand it over to the given
+ * JDBCUtils method, which takes the buffer and an ID.
+ */
+static void
+jq_send_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+			const bool *isnull, jmethodID methodID, int id)
+{
+	jobject		JDBCUtilsObject;
+	jobject		byteBuffer;
+	StringInfo	buf = &buffer->data;
+	int32		nparams = buffer->nparams;
+	Size		nulls_off = TYPEALIGN(8, sizeof(int32) * (nparams + 1));
+	Size		slots_off = nulls_off + TYPEALIGN(8, (nparams + 7) / 8);
+	Size		data_off = slots_off + 8 * nparams;
+	int			i;
 
-			{
-				float4		dat = DatumGetFloat4(value);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindFloatPreparedStatement",
-															   "(FII)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindFloat method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-		case FLOAT8OID:
-			{
-				float8		dat = DatumGetFloat8(value);
+	resetStringInfo(buf);
+	enlargeStringInfo(buf, data_off);
+	memset(buf->data, 0, data_off);
+	buf->len = data_off;
+	memcpy(buf->data, &nparams, sizeof(int32));
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindDoublePreparedStatement",
-															   "(DII)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindDouble method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
+	for (i = 0; i < nparams; i++)
+	{
+		Oid			type = buffer->types[i];
+		jint		kind = jq_param_kind(type);
+		char		slot[8] = {0};
+		const char *data = NULL;
+		int32		len = 0;
 
-		case NUMERICOID:
-			{
-				Datum		valueDatum = DirectFunctionCall1(numeric_float8, value);
-				float8		dat = DatumGetFloat8(valueDatum);
+		if (isnull[i])
+		{
+			buf->data[nulls_off + i / 8] |= (1 << (i % 8));
+			memcpy(buf->data + sizeof(int32) * (i + 1), &kind, sizeof(jint));
+			continue;
+		}
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindDoublePreparedStatement",
-															   "(DII)V");
-				if (idBindPreparedStatement == NULL)
+		switch (kind)
+		{
+			case JQ_KIND_INT32:
 				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindDouble method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-		case BOOLOID:
-			{
-				bool		dat = (bool) value;
+					int32		dat = (type == INT2OID) ? DatumGetInt16(values[i]) : DatumGetInt32(values[i]);
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindBooleanPreparedStatement",
-															   "(ZII)V");
-				if (idBindPreparedStatement == NULL)
-				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindBoolean method!")));
+					memcpy(slot, &dat, sizeof(int32));
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-
-		case BYTEAOID:
-			{
-				long		len;
-				char	   *dat = NULL;
-				char	   *result = DatumGetPointer(value);
-				jbyteArray	retArray;
-
-				if (VARATT_IS_1B(result))
+			case JQ_KIND_INT64:
 				{
-					len = VARSIZE_1B(result) - VARHDRSZ_SHORT;
-					dat = VARDATA_1B(result);
+					int64		dat = DatumGetInt64(values[i]);
+
+					memcpy(slot, &dat, sizeof(int64));
+					break;
 				}
-				else
+			case JQ_KIND_FLOAT4:
 				{
-					len = VARSIZE_4B(result) - VARHDRSZ;
-					dat = VARDATA_4B(result);
-				}
-
-				retArray = (*Jenv)->NewByteArray(Jenv, len);
-				(*Jenv)->SetByteArrayRegion(Jenv, retArray, 0, len, (jbyte *) (dat));
+					float4		dat = DatumGetFloat4(values[i]);
 
+					memcpy(slot, &dat, sizeof(float4));
+					break;
+				}
+			case JQ_KIND_FLOAT8:
+				{
+					float8		dat = DatumGetFloat8(values[i]);
 
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindByteaPreparedStatement",
-															   "([BJII)V");
-				if (idBindPreparedStatement == NULL)
+					memcpy(slot, &dat, sizeof(float8));
+					break;
+				}
+			case JQ_KIND_NUMERIC:
 				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindBytea method!")));
+					Numeric		num = DatumGetNumeric(values[i]);
+
+#if PG_VERSION_NUM >= 140000
+					if (numeric_is_nan(num) || numeric_is_inf(num))
+#else
+					if (numeric_is_nan(num))
+#endif
+					{
+						/* NaN and infinity cannot be a BigDecimal, bind as double */
+						float8		dat = DatumGetFloat8(DirectFunctionCall1(numeric_float8, values[i]));
+
+						kind = JQ_KIND_FLOAT8;
+						memcpy(slot, &dat, sizeof(float8));
+					}
+					else
+					{
+						/* numeric_out gives every digit of the value */
+						data = DatumGetCString(DirectFunctionCall1(numeric_out, values[i]));
+						len = strlen(data);
+					}
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, retArray, len, attnum, resultSetID);
-				jq_get_exception();
+			case JQ_KIND_BOOL:
+				slot[0] = DatumGetBool(values[i]) ? 1 : 0;
 				break;
-			}
-		case BPCHAROID:
-		case VARCHAROID:
-		case TEXTOID:
-		case JSONOID:
-		case NAMEOID:
-			{
-				/* Bind as text */
-				char	   *outputString = NULL;
-				jstring		dat = NULL;
-				Oid			outputFunctionId = InvalidOid;
-				bool		typeVarLength = false;
-
-				getTypeOutputInfo(type, &outputFunctionId, &typeVarLength);
-				outputString = OidOutputFunctionCall(outputFunctionId, value);
-				dat = (*Jenv)->NewStringUTF(Jenv, outputString);
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindStringPreparedStatement",
-															   "(Ljava/lang/String;II)V");
-				if (idBindPreparedStatement == NULL)
+			case JQ_KIND_BINARY:
 				{
-					/* Return Java memory */
-					(*Jenv)->DeleteLocalRef(Jenv, dat);
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindString method!")));
-				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
+					bytea	   *dat = DatumGetByteaPP(values[i]);
 
-				/* Return Java memory */
-				(*Jenv)->DeleteLocalRef(Jenv, dat);
-				break;
-			}
-		case TIMEOID:
-			{
-				/* Bind as text */
-				char	   *outputString = NULL;
-				jstring		dat = NULL;
-				Oid			outputFunctionId = InvalidOid;
-				bool		typeVarLength = false;
-
-				getTypeOutputInfo(type, &outputFunctionId, &typeVarLength);
-				outputString = OidOutputFunctionCall(outputFunctionId, value);
-				dat = (*Jenv)->NewStringUTF(Jenv, outputString);
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindTimePreparedStatement",
-															   "(Ljava/lang/String;II)V");
-				if (idBindPreparedStatement == NULL)
+					data = VARDATA_ANY(dat);
+					len = VARSIZE_ANY_EXHDR(dat);
+					break;
+				}
+			case JQ_KIND_TEXT:
 				{
-					/* Return Java memory */
-					(*Jenv)->DeleteLocalRef(Jenv, dat);
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindTime method!")));
+					const char *converted;
+
+					if (type == TEXTOID || type == VARCHAROID || type == BPCHAROID)
+					{
+						text	   *dat = DatumGetTextPP(values[i]);
+
+						data = VARDATA_ANY(dat);
+						len = VARSIZE_ANY_EXHDR(dat);
+					}
+					else
+					{
+						data = OutputFunctionCall(&buffer->typoutput[i], values[i]);
+						len = strlen(data);
+					}
+
+					/* Java decodes text as UTF-8 */
+					converted = (const char *) pg_server_to_any(data, len, PG_UTF8);
+					if (converted != data)
+					{
+						data = converted;
+						len = strlen(data);
+					}
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-
-				/* Return Java memory */
-				(*Jenv)->DeleteLocalRef(Jenv, dat);
-				break;
-			}
-		case TIMETZOID:
-			{
-				/* Bind as text */
-				char	   *outputString = NULL;
-				jstring		dat = NULL;
-				Oid			outputFunctionId = InvalidOid;
-				bool		typeVarLength = false;
-
-				getTypeOutputInfo(type, &outputFunctionId, &typeVarLength);
-				outputString = OidOutputFunctionCall(outputFunctionId, value);
-				dat = (*Jenv)->NewStringUTF(Jenv, outputString);
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindTimeTZPreparedStatement",
-															   "(Ljava/lang/String;II)V");
-				if (idBindPreparedStatement == NULL)
+			case JQ_KIND_TIME:
 				{
-					/* Return Java memory */
-					(*Jenv)->DeleteLocalRef(Jenv, dat);
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindTimeTZ method!")));
+					/* Microseconds since midnight, the zone of a timetz is dropped */
+					int64		dat;
+
+					if (type == TIMETZOID)
+						dat = DatumGetTimeTzADTP(values[i])->time;
+					else
+						dat = DatumGetTimeADT(values[i]);
+					memcpy(slot, &dat, sizeof(int64));
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-
-				/* Return Java memory */
-				(*Jenv)->DeleteLocalRef(Jenv, dat);
-				break;
-			}
-		case TIMESTAMPOID:
-		case TIMESTAMPTZOID:
-			{
-				/*
-				 * Bind as microseconds from Unix Epoch time in UTC time zone
-				 * to avoid being affected by JVM's time zone.
-				 */
-				Timestamp	valueTimestamp = DatumGetTimestamp(value);	/* Already in UTC time
-																		 * zone */
-				int64		valueMicroSecs = valueTimestamp + POSTGRES_TO_UNIX_EPOCH_USECS;
-
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindTimestampPreparedStatement",
-															   "(JII)V");
-				if (idBindPreparedStatement == NULL)
+			case JQ_KIND_TIMESTAMP:
 				{
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindTimestamp method!")));
+					/*
+					 * Bind as microseconds from Unix Epoch time in UTC time
+					 * zone to avoid being affected by JVM's time zone.
+					 */
+					int64		dat = DatumGetTimestamp(values[i]) + POSTGRES_TO_UNIX_EPOCH_USECS;
+
+					memcpy(slot, &dat, sizeof(int64));
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, valueMicroSecs, attnum, resultSetID);
-				jq_get_exception();
-				break;
-			}
-		case DATEOID:
-			{
-				/* Bind as text */
-				char	   *outputString = NULL;
-				jstring		dat = NULL;
-				Oid			outputFunctionId = InvalidOid;
-				bool		typeVarLength = false;
-
-				/*
-				 * Make sure the DATE value is unambiguous to the remote
-				 * server
-				 */
-				nestlevel = jdbc_set_transmission_modes();
-
-				getTypeOutputInfo(type, &outputFunctionId, &typeVarLength);
-				outputString = OidOutputFunctionCall(outputFunctionId, value);
-
-				jdbc_reset_transmission_modes(nestlevel);
-
-				dat = (*Jenv)->NewStringUTF(Jenv, outputString);
-				idBindPreparedStatement = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "bindDatePreparedStatement",
-															   "(Ljava/lang/String;II)V");
-				if (idBindPreparedStatement == NULL)
+			case JQ_KIND_DATE:
 				{
-					/* Return Java memory */
-					(*Jenv)->DeleteLocalRef(Jenv, dat);
-					ereport(ERROR, (errmsg("Failed to find the JDBCUtils.bindDatePreparedStatement method!")));
+					DateADT		date = DatumGetDateADT(values[i]);
+					int64		dat;
+
+					if (DATE_NOT_FINITE(date))
+						ereport(ERROR,
+								(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+								 errmsg("infinite date cannot be sent to the remote server")));
+					/* Days since the Unix epoch */
+					dat = (int64) date + POSTGRES_TO_UNIX_EPOCH_DAYS;
+					memcpy(slot, &dat, sizeof(int64));
+					break;
 				}
-				jq_exception_clear();
-				(*Jenv)->CallObjectMethod(Jenv, jdbcUtilsInfo->JDBCUtilsObject, idBindPreparedStatement, dat, attnum, resultSetID);
-				jq_get_exception();
-
-				/* Return Java memory */
-				(*Jenv)->DeleteLocalRef(Jenv, dat);
-
-				break;
-			}
-		default:
-			{
+			default:
 				ereport(ERROR, (errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
 								errmsg("cannot convert constant value to JDBC value %u", type),
 								errhint("Constant value data type: %u", type)));
 				break;
-			}
+		}
+
+		if (data != NULL)
+		{
+			int32		offset = buf->len - data_off;
+
+			memcpy(slot, &offset, sizeof(int32));
+			memcpy(slot + sizeof(int32), &len, sizeof(int32));
+			appendBinaryStringInfo(buf, data, len);
+		}
+		memcpy(buf->data + sizeof(int32) * (i + 1), &kind, sizeof(jint));
+		memcpy(buf->data + slots_off + 8 * i, slot, 8);
 	}
-	*res = PGRES_COMMAND_OK;
-	return 0;
+
+	byteBuffer = (*Jenv)->NewDirectByteBuffer(Jenv, buf->data, (jlong) buf->len);
+	if (byteBuffer == NULL)
+		ereport(ERROR, (errmsg("Failed to create java direct byte buffer")));
+
+	jq_exception_clear();
+	(*Jenv)->CallVoidMethod(Jenv, JDBCUtilsObject, methodID, byteBuffer, id);
+	jq_get_exception();
+	(*Jenv)->DeleteLocalRef(Jenv, byteBuffer);
 }
 
 /*
@@ -1462,8 +2420,6 @@ jq_get_exception()
 	if ((*Jenv)->ExceptionCheck(Jenv))
 	{
 		jthrowable	exc;
-		jmethodID	exceptionMsgID;
-		jclass		objectClass;
 		jstring		exceptionMsg;
 		char	   *exceptionString;
 		char	   *err_msg = NULL;
@@ -1471,13 +2427,7 @@ jq_get_exception()
 		/* determines if an exception is being thrown */
 		exc = (*Jenv)->ExceptionOccurred(Jenv);
 		/* get to the message and stack trace one as String */
-		objectClass = (*Jenv)->FindClass(Jenv, "java/lang/Object");
-		if (objectClass == NULL)
-		{
-			ereport(ERROR, (errmsg("java/lang/Object class could not be created")));
-		}
-		exceptionMsgID = (*Jenv)->GetMethodID(Jenv, objectClass, "toString", "()Ljava/lang/String;");
-		exceptionMsg = (jstring) (*Jenv)->CallObjectMethod(Jenv, exc, exceptionMsgID);
+		exceptionMsg = (jstring) (*Jenv)->CallObjectMethod(Jenv, exc, jni_registry.idToString);
 		exceptionString = jdbc_convert_string_to_cstring((jobject) exceptionMsg);
 		err_msg = pstrdup(exceptionString);
 		ereport(DEBUG3, (errmsg("%s", err_msg)));
@@ -1490,22 +2440,18 @@ static List *
 jq_get_column_infos(JDBCUtilsInfo * jdbcUtilsInfo, char *tablename)
 {
 	jobject		JDBCUtilsObject;
-	jclass		JDBCUtilsClass;
 	jstring		jtablename = (*Jenv)->NewStringUTF(Jenv, tablename);
 	int			i;
 
 	/* getColumnNames */
-	jmethodID	idGetColumnNames;
 	jobjectArray columnNamesArray;
 	jsize		numberOfNames;
 
 	/* getColumnTypes */
-	jmethodID	idGetColumnTypes;
 	jobjectArray columnTypesArray;
 	jsize		numberOfTypes;
 
 	/* getPrimaryKey */
-	jmethodID	idGetPrimaryKey;
 	jobjectArray primaryKeyArray;
 	jsize		numberOfKeys;
 	List	   *primaryKey = NIL;
@@ -1518,7 +2464,7 @@ jq_get_column_infos(JDBCUtilsInfo * jdbcUtilsInfo, char *tablename)
 	/* Get JDBCUtils */
 	PG_TRY();
 	{
-		jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+		jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 	}
 	PG_CATCH();
 	{
@@ -1528,46 +2474,16 @@ jq_get_column_infos(JDBCUtilsInfo * jdbcUtilsInfo, char *tablename)
 	PG_END_TRY();
 
 	/* getColumnNames */
-	idGetColumnNames = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getColumnNames", "(Ljava/lang/String;)[Ljava/lang/String;");
-	if (idGetColumnNames == NULL)
-	{
-		(*Jenv)->DeleteLocalRef(Jenv, jtablename);
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getColumnNames method")));
-	}
 	jq_exception_clear();
-	columnNamesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetColumnNames, jtablename);
+	columnNamesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetColumnNames, jtablename);
 	jq_get_exception();
 	/* getColumnTypes */
-	idGetColumnTypes = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getColumnTypes", "(Ljava/lang/String;)[Ljava/lang/String;");
-	if (idGetColumnTypes == NULL)
-	{
-		(*Jenv)->DeleteLocalRef(Jenv, jtablename);
-		if (columnNamesArray != NULL)
-		{
-			(*Jenv)->DeleteLocalRef(Jenv, columnNamesArray);
-		}
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getColumnTypes method")));
-	}
 	jq_exception_clear();
-	columnTypesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetColumnTypes, jtablename);
+	columnTypesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetColumnTypes, jtablename);
 	jq_get_exception();
 	/* getPrimaryKey */
-	idGetPrimaryKey = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getPrimaryKey", "(Ljava/lang/String;)[Ljava/lang/String;");
-	if (idGetPrimaryKey == NULL)
-	{
-		(*Jenv)->DeleteLocalRef(Jenv, jtablename);
-		if (columnNamesArray != NULL)
-		{
-			(*Jenv)->DeleteLocalRef(Jenv, columnNamesArray);
-		}
-		if (columnTypesArray != NULL)
-		{
-			(*Jenv)->DeleteLocalRef(Jenv, columnTypesArray);
-		}
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getColumnTypes method")));
-	}
 	jq_exception_clear();
-	primaryKeyArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetPrimaryKey, jtablename);
+	primaryKeyArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetPrimaryKey, jtablename);
 	jq_get_exception();
 	if (primaryKeyArray != NULL)
 	{
@@ -1644,21 +2560,17 @@ List *
 jq_get_column_infos_without_key(JDBCUtilsInfo * jdbcUtilsInfo, int *resultSetID, int *column_num)
 {
 	jobject		JDBCUtilsObject;
-	jclass		JDBCUtilsClass;
 	int			i;
 
 	/* getColumnNames */
-	jmethodID	idGetColumnNamesByResultSetID;
 	jobjectArray columnNamesArray;
 	jsize		numberOfNames;
 
 	/* getColumnTypes */
-	jmethodID	idGetColumnTypesByResultSetID;
 	jobjectArray columnTypesArray;
 	jsize		numberOfTypes;
 
 	/* getColumnNumber */
-	jmethodID	idNumberOfColumns;
 	jint		jresultSetID = *resultSetID;
 	int			numberOfColumns;
 
@@ -1669,7 +2581,7 @@ jq_get_column_infos_without_key(JDBCUtilsInfo * jdbcUtilsInfo, int *resultSetID,
 	/* Get JDBCUtils */
 	PG_TRY();
 	{
-		jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+		jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 	}
 	PG_CATCH();
 	{
@@ -1678,37 +2590,18 @@ jq_get_column_infos_without_key(JDBCUtilsInfo * jdbcUtilsInfo, int *resultSetID,
 	PG_END_TRY();
 
 	/* getColumnNames by resultSetID */
-	idGetColumnNamesByResultSetID = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getColumnNamesByResultSetID", "(I)[Ljava/lang/String;");
-	if (idGetColumnNamesByResultSetID == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getColumnNamesByResultSetID method")));
-	}
 	jq_exception_clear();
-	columnNamesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetColumnNamesByResultSetID, jresultSetID);
+	columnNamesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetColumnNamesByResultSetID, jresultSetID);
 	jq_get_exception();
 
 	/* getColumnTypes by resultSetID */
-	idGetColumnTypesByResultSetID = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getColumnTypesByResultSetID", "(I)[Ljava/lang/String;");
-	if (idGetColumnTypesByResultSetID == NULL)
-	{
-		if (columnNamesArray != NULL)
-		{
-			(*Jenv)->DeleteLocalRef(Jenv, columnNamesArray);
-		}
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getColumnTypesByResultSetID method")));
-	}
 	jq_exception_clear();
-	columnTypesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetColumnTypesByResultSetID, jresultSetID);
+	columnTypesArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetColumnTypesByResultSetID, jresultSetID);
 	jq_get_exception();
 
 	/* getNumberOfColumns */
-	idNumberOfColumns = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getNumberOfColumns", "(I)I");
-	if (idNumberOfColumns == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getNumberOfColumns method")));
-	}
 	jq_exception_clear();
-	numberOfColumns = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, idNumberOfColumns, jresultSetID);
+	numberOfColumns = (int) (*Jenv)->CallIntMethod(Jenv, JDBCUtilsObject, jni_registry.idGetNumberOfColumns, jresultSetID);
 	*column_num = numberOfColumns;
 	jq_get_exception();
 
@@ -1758,22 +2651,15 @@ static List *
 jq_get_table_names(JDBCUtilsInfo * jdbcUtilsInfo)
 {
 	jobject		JDBCUtilsObject;
-	jclass		JDBCUtilsClass;
-	jmethodID	idGetTableNames;
 	jobjectArray tableNameArray;
 	List	   *tableName = NIL;
 	jsize		numberOfTables;
 	int			i;
 
-	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsClass, &JDBCUtilsObject);
+	jq_get_JDBCUtils(jdbcUtilsInfo, &JDBCUtilsObject);
 
-	idGetTableNames = (*Jenv)->GetMethodID(Jenv, JDBCUtilsClass, "getTableNames", "()[Ljava/lang/String;");
-	if (idGetTableNames == NULL)
-	{
-		ereport(ERROR, (errmsg("Failed to find the JDBCUtils.getTableNames method")));
-	}
 	jq_exception_clear();
-	tableNameArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, idGetTableNames);
+	tableNameArray = (*Jenv)->CallObjectMethod(Jenv, JDBCUtilsObject, jni_registry.idGetTableNames);
 	jq_get_exception();
 	if (tableNameArray != NULL)
 	{
@@ -1819,10 +2705,11 @@ jq_get_schema_info(JDBCUtilsInfo * jdbcUtilsInfo)
 }
 
 /*
- * jq_get_JDBCUtils: get JDBCUtilsClass and JDBCUtilsObject
+ * jq_get_JDBCUtils: get JDBCUtilsObject and make sure the JNI registry is
+ * loaded for the current thread
  */
 static void
-jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jclass * JDBCUtilsClass, jobject * JDBCUtilsObject)
+jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jobject * JDBCUtilsObject)
 {
 	/* Our object of the JDBCUtils class is on the connection */
 	*JDBCUtilsObject = jdbcUtilsInfo->JDBCUtilsObject;
@@ -1830,11 +2717,7 @@ jq_get_JDBCUtils(JDBCUtilsInfo * jdbcUtilsInfo, jclass * JDBCUtilsClass, jobject
 	{
 		ereport(ERROR, (errmsg("Cannot get the utilsObject from the connection")));
 	}
-	*JDBCUtilsClass = (*Jenv)->FindClass(Jenv, "JDBCUtils");
-	if (*JDBCUtilsClass == NULL)
-	{
-		ereport(ERROR, (errmsg("JDBCUtils class could not be created")));
-	}
+	jq_load_jni_registry();
 }
 
 /*
@@ -1846,7 +2729,6 @@ void
 jq_inval_callback(int cacheid, uint32 hashvalue)
 {
 	jmethodID	callback = NULL;
-	jclass		JDBCUtilsClass;
 
 	Assert(cacheid == FOREIGNSERVEROID || cacheid == USERMAPPINGOID);
 
@@ -1859,23 +2741,24 @@ jq_inval_callback(int cacheid, uint32 hashvalue)
 	if (Jenv == NULL)
 		jdbc_attach_jvm();
 
-	JDBCUtilsClass = (*Jenv)->FindClass(Jenv, "JDBCUtils");
+	/* The registry may not have been loaded by this thread yet */
+	jq_load_jni_registry();
 
 	/* hashvalue == 0 means a cache reset, must clear all state */
 	if (hashvalue == 0)
 	{
 		/* release all connection */
-		callback = (*Jenv)->GetStaticMethodID(Jenv, JDBCUtilsClass, "finalizeAllConns", "(J)V");
+		callback = jni_registry.idFinalizeAllConns;
 	}
 	else if (cacheid == FOREIGNSERVEROID)
 	{
 		/* release connections of foreign server hashvalue */
-		callback = (*Jenv)->GetStaticMethodID(Jenv, JDBCUtilsClass, "finalizeAllServerConns", "(J)V");
+		callback = jni_registry.idFinalizeAllServerConns;
 	}
 	else if (cacheid == USERMAPPINGOID)
 	{
 		/* release connections of usermapping hashvalue */
-		callback = (*Jenv)->GetStaticMethodID(Jenv, JDBCUtilsClass, "finalizeAllUserMapingConns", "(J)V");
+		callback = jni_registry.idFinalizeAllUserMapingConns;
 	}
 
 	if (callback == NULL)
@@ -1883,23 +2766,69 @@ jq_inval_callback(int cacheid, uint32 hashvalue)
 		ereport(ERROR, (errmsg("Failed to find the JDBCUtils inval callback method!")));
 	}
 	jq_exception_clear();
-	(*Jenv)->CallStaticVoidMethod(Jenv, JDBCUtilsClass, callback, (jlong) hashvalue);
+	(*Jenv)->CallStaticVoidMethod(Jenv, jni_registry.JDBCUtilsClass, callback, (jlong) hashvalue);
 	jq_get_exception();
 
 	jdbc_detach_jvm();
 	Jenv = NULL;
 }
 
+/*
+ * jq_wait_all_async_writes
+ *		Wait for the batches still executed by the writer threads of all
+ *		connections before the local transaction commits, and report the
+ *		error of one of them, if any.
+ */
+void
+jq_wait_all_async_writes(void)
+{
+	/* No JVM, so no writer thread either */
+	if (jvm == NULL)
+		return;
+
+	/* Current thread can be detached, the connections are cached by Java */
+	if (Jenv == NULL)
+		jdbc_attach_jvm();
+
+	jq_load_jni_registry();
+
+	jq_exception_clear();
+	(*Jenv)->CallStaticVoidMethod(Jenv, jni_registry.JDBCUtilsClass, jni_registry.idWaitAllAsyncWrites);
+	jq_get_exception();
+}
+
+/*
+ * jq_commit_all_streaming
+ *		Commit the remote transactions begun for streaming before the local
+ *		transaction commits.  A failed remote commit aborts the local
+ *		transaction.
+ */
+void
+jq_commit_all_streaming(void)
+{
+	/* No JVM, so no remote transaction either */
+	if (jvm == NULL)
+		return;
+
+	/* Current thread can be detached, the connections are cached by Java */
+	if (Jenv == NULL)
+		jdbc_attach_jvm();
+
+	jq_load_jni_registry();
+
+	jq_exception_clear();
+	(*Jenv)->CallStaticVoidMethod(Jenv, jni_registry.JDBCUtilsClass, jni_registry.idCommitAllStreaming);
+	jq_get_exception();
+}
+
 /*
  * jq_release_all_result_sets
- *		release all cached result set
+ *		release all cached result set, and roll back the remote transactions
+ *		begun for streaming that were not committed before the local commit
  */
 void
 jq_release_all_result_sets(void)
 {
-	jmethodID	methodId = NULL;
-	jclass		JDBCUtilsClass;
-
 	if (jvm == NULL)
 		return;
 
@@ -1907,13 +2836,12 @@ jq_release_all_result_sets(void)
 	if (Jenv == NULL)
 		jdbc_attach_jvm();
 
-	JDBCUtilsClass = (*Jenv)->FindClass(Jenv, "JDBCUtils");
+	/* The registry may not have been loaded by this thread yet */
+	jq_load_jni_registry();
 
 	/* release all cached result set */
-	methodId = (*Jenv)->GetStaticMethodID(Jenv, JDBCUtilsClass, "finalizeAllResultSet", "()V");
-
 	jq_exception_clear();
-	(*Jenv)->CallStaticVoidMethod(Jenv, JDBCUtilsClass, methodId);
+	(*Jenv)->CallStaticVoidMethod(Jenv, jni_registry.JDBCUtilsClass, jni_registry.idFinalizeAllResultSet);
 	jq_get_exception();
 
 	jdbc_detach_jvm();
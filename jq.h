@@ -14,6 +14,7 @@
 #include "libpq-fe.h"
 #include "jni.h"
 #include "executor/tuptable.h"
+#include "lib/stringinfo.h"
 #include "nodes/execnodes.h"
 
 typedef struct jdbcFdwExecutionState
@@ -49,19 +50,92 @@ typedef struct JtableInfo
 	List	   *column_info;
 }			JtableInfo;
 
+/*
+ * Transfer kinds of a columnar batch, must match KIND_* in
+ * JDBCColumnarBatch.java
+ */
+#define JQ_KIND_TEXT		0
+#define JQ_KIND_BINARY		1
+#define JQ_KIND_INT64		2
+#define JQ_KIND_FLOAT8		3
+#define JQ_KIND_TIMESTAMP	4
+#define JQ_KIND_BOOL		5
+#define JQ_KIND_DATE		6
+#define JQ_KIND_TIME		7
+#define JQ_KIND_NUMERIC		8
+/* Only used for the parameters of a bound row */
+#define JQ_KIND_INT32		9
+#define JQ_KIND_FLOAT4		10
+
+/* Initial size of the buffer receiving a columnar batch */
+#define JQ_COLUMNAR_BUFFER_SIZE	(1024 * 1024)
+
+typedef struct JcolumnConverter JcolumnConverter;
+
+/* Converts one value of a columnar batch, data points to len bytes */
+typedef Datum (*JcolumnFastPath) (const JcolumnConverter * converter, const char *data, int32 len);
+
+/* Conversion plan of a retrieved column, resolved once per scan */
+struct JcolumnConverter
+{
+	int			column_index;	/* index of the attribute in the tuple */
+	FmgrInfo	typinput;		/* input function of the type */
+	Oid			typioparam;		/* argument of the input function */
+	int32		typmod;			/* typmod given to the input function */
+	JcolumnFastPath fastpath;	/* conversion of the requested kind, or NULL */
+};
+
+/* Buffer shared with the JVM to receive batches of rows */
+typedef struct JcolumnarBuffer
+{
+	char	   *data;			/* wrapped in a direct ByteBuffer */
+	Size		size;			/* allocated size of data */
+	int			ncolumns;		/* number of retrieved columns */
+	jint	   *kinds;			/* requested transfer kind of each column */
+	JcolumnConverter *converters;	/* conversion plan of each column */
+}			JcolumnarBuffer;
+
+/* Buffer shared with the JVM to bind all parameters of a row at once */
+typedef struct JparamBuffer
+{
+	int			nparams;		/* number of parameters of the statement */
+	Oid		   *types;			/* type of each parameter */
+	FmgrInfo   *typoutput;		/* output function of each parameter */
+	StringInfoData data;		/* row serialized for the JVM */
+}			JparamBuffer;
+
 /*
  * Replacement for libpq-fe.h functions
  */
 extern Jresult * jq_exec(JDBCUtilsInfo * jdbcUtilsInfo, const char *query);
-extern Jresult * jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int *resultSetID);
+extern Jresult * jq_exec_id(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int fetch_size, int *resultSetID);
 extern void *jq_release_resultset_id(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
 extern Jresult * jq_exec_prepared(JDBCUtilsInfo * jdbcUtilsInfo, const int *paramLengths,
 								  const int *paramFormats, int resultFormat, int resultSetID);
+extern int	jq_get_affected_rows(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
+extern char *jq_get_database_product_name(JDBCUtilsInfo * jdbcUtilsInfo);
+extern int	jq_get_max_parameters(JDBCUtilsInfo * jdbcUtilsInfo);
+extern void jq_add_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
+extern Jresult * jq_exec_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
+extern int	jq_create_bulk_loader(JDBCUtilsInfo * jdbcUtilsInfo, const char *table, const char *columns);
+extern Jresult * jq_exec_bulk_load(JDBCUtilsInfo * jdbcUtilsInfo, int bulkLoadID);
+extern Jresult * jq_exec_truncate(JDBCUtilsInfo * jdbcUtilsInfo, const char *truncate_sql, List *delete_sqls);
+extern Jresult * jq_exec_async_batch(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
+extern void jq_wait_async_writes(JDBCUtilsInfo * jdbcUtilsInfo);
+extern void jq_wait_all_async_writes(void);
+extern void jq_commit_all_streaming(void);
 extern void jq_clear(Jresult * res);
 extern char *jq_cmd_tuples(Jresult * res);
 extern char *jq_get_value(const Jresult * res, int tup_num, int field_num);
 extern Jresult * jq_prepare(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
 							const Oid *paramTypes, int *resultSetID);
+extern Jresult * jq_prepare_returning(JDBCUtilsInfo * jdbcUtilsInfo, const char *query,
+									  List *columns, int *resultSetID);
+extern int	jq_get_generated_keys(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
+extern Jresult * jq_prepare_query(JDBCUtilsInfo * jdbcUtilsInfo, const char *query, int fetch_size,
+								  int *statementID);
+extern Jresult * jq_exec_prepared_query(JDBCUtilsInfo * jdbcUtilsInfo, int statementID, int *resultSetID);
+extern List *jq_get_column_names(JDBCUtilsInfo * jdbcUtilsInfo, int resultSetID);
 extern int	jq_nfields(const Jresult * res);
 extern int	jq_get_is_null(const Jresult * res, int tup_num, int field_num);
 extern JDBCUtilsInfo * jq_connect_db_params(const ForeignServer *server, const UserMapping *user, const char *const *keywords,
@@ -72,10 +146,18 @@ extern void jq_finish(void);
 extern int	jq_server_version(const JDBCUtilsInfo * jdbcUtilsInfo);
 extern char *jq_result_error_field(const Jresult * res, int fieldcode);
 extern PGTransactionStatusType jq_transaction_status(const JDBCUtilsInfo * jdbcUtilsInfo);
-extern TupleTableSlot *jq_iterate(JDBCUtilsInfo * jdbcUtilsInfo, ForeignScanState *node, List *retrieved_attrs, int resultSetID);
+extern void jq_init_columnar_buffer(JcolumnarBuffer * buffer, TupleDesc tupleDescriptor, List *retrieved_attrs);
+extern int	jq_iterate_batch(JDBCUtilsInfo * jdbcUtilsInfo, TupleDesc tupleDescriptor, JcolumnarBuffer * buffer,
+							 int resultSetID, int fetch_size, HeapTuple **tuples, bool *eof_reached);
 extern void jq_iterate_all_row(FunctionCallInfo fcinfo, JDBCUtilsInfo * jdbcUtilsInfo, TupleDesc tupleDescriptor, int resultSetID);
 extern List *jq_get_column_infos_without_key(JDBCUtilsInfo * jdbcUtilsInfo, int *resultSetID, int *column_num);
-extern void *jq_bind_sql_var(JDBCUtilsInfo * jdbcUtilsInfo, Oid type, int attnum, Datum value, bool *isnull, int resultSetID);
+extern void jq_init_param_buffer(JparamBuffer * buffer, int nparams, const Oid *types);
+extern void jq_bind_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+						const bool *isnull, int resultSetID);
+extern void jq_add_bulk_load_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+								 const bool *isnull, int bulkLoadID);
+extern void jq_add_async_batch_row(JDBCUtilsInfo * jdbcUtilsInfo, JparamBuffer * buffer, const Datum *values,
+								   const bool *isnull, int resultSetID);
 extern Datum jdbc_convert_to_pg(Oid pgtyp, int pgtypmod, char *value);
 extern List *jq_get_schema_info(JDBCUtilsInfo * jdbcUtilsInfo);
 extern void jdbc_jvm_init(const ForeignServer *server, const UserMapping *user);
@@ -140,11 +140,80 @@ jdbc_fdw_validator(PG_FUNCTION_ARGS)
 		 * Validate option value, when we can do so without any context.
 		 */
 		if (strcmp(def->defname, "use_remote_estimate") == 0 ||
-			strcmp(def->defname, "updatable") == 0)
+			strcmp(def->defname, "updatable") == 0 ||
+			strcmp(def->defname, "stream_results") == 0 ||
+			strcmp(def->defname, "bulk_load") == 0 ||
+			strcmp(def->defname, "async_write") == 0 ||
+			strcmp(def->defname, "truncatable") == 0 ||
+			strcmp(def->defname, "upsert") == 0)
 		{
 			/* these accept only boolean values */
 			(void) defGetBoolean(def);
 		}
+		else if (strcmp(def->defname, "fetch_size") == 0 ||
+				 strcmp(def->defname, "batch_size") == 0 ||
+				 strcmp(def->defname, "key_batch_size") == 0 ||
+				 strcmp(def->defname, "lookup_cache_size") == 0)
+		{
+			char	   *value;
+			int			int_val;
+			bool		is_parsed;
+
+			value = defGetString(def);
+			is_parsed = parse_int(value, &int_val, 0, NULL);
+
+			if (!is_parsed)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for integer option \"%s\": %s",
+								def->defname, value)));
+
+			if (int_val <= 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("\"%s\" must be an integer value greater than zero",
+								def->defname)));
+		}
+		else if (strcmp(def->defname, "dialect") == 0)
+		{
+			char	   *value = defGetString(def);
+
+			if (!jdbc_parse_dialect(value, NULL))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for option \"%s\": %s",
+								def->defname, value),
+						 errhint("Valid values are \"postgresql\", \"mysql\" and \"standard\".")));
+		}
+		else if (strcmp(def->defname, "estimate_cache_ttl") == 0)
+		{
+			char	   *value;
+			int			int_val;
+
+			value = defGetString(def);
+			if (!parse_int(value, &int_val, 0, NULL))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for integer option \"%s\": %s",
+								def->defname, value)));
+
+			if (int_val < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("\"%s\" must be an integer value greater than or equal to zero",
+								def->defname)));
+		}
+		else if (strcmp(def->defname, "analyze_sampling") == 0)
+		{
+			char	   *value = defGetString(def);
+
+			if (!jdbc_parse_analyze_sampling(value, NULL))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for option \"%s\": %s",
+								def->defname, value),
+						 errhint("Valid values are \"off\", \"auto\", \"random\", \"system\", \"bernoulli\" and \"order\".")));
+		}
 		else if (strcmp(def->defname, "fdw_startup_cost") == 0 ||
 				 strcmp(def->defname, "fdw_tuple_cost") == 0)
 		{
@@ -194,17 +263,43 @@ init_jdbcfdw_options(void)
 		{"querytimeout", ForeignServerRelationId, false},
 		{"jarfile", ForeignServerRelationId, false},
 		{"maxheapsize", ForeignServerRelationId, false},
+		{"stream_results", ForeignServerRelationId, false},
 		{"username", UserMappingRelationId, false},
 		{"password", UserMappingRelationId, false},
 		/* use_remote_estimate is available on both server and table */
 		{"use_remote_estimate", ForeignServerRelationId, false},
 		{"use_remote_estimate", ForeignTableRelationId, false},
+		/* fetch_size is available on both server and table */
+		{"fetch_size", ForeignServerRelationId, false},
+		{"fetch_size", ForeignTableRelationId, false},
+		/* batch_size is available on both server and table */
+		{"batch_size", ForeignServerRelationId, false},
+		{"batch_size", ForeignTableRelationId, false},
+		{"bulk_load", ForeignTableRelationId, false},
+		{"upsert", ForeignTableRelationId, false},
+		{"dialect", ForeignServerRelationId, false},
+		/* key_batch_size is available on both server and table */
+		{"key_batch_size", ForeignServerRelationId, false},
+		{"key_batch_size", ForeignTableRelationId, false},
+		/* lookup_cache_size is available on both server and table */
+		{"lookup_cache_size", ForeignServerRelationId, false},
+		{"lookup_cache_size", ForeignTableRelationId, false},
+		/* async_write is available on both server and table */
+		{"async_write", ForeignServerRelationId, false},
+		{"async_write", ForeignTableRelationId, false},
+		/* analyze_sampling is available on both server and table */
+		{"analyze_sampling", ForeignServerRelationId, false},
+		{"analyze_sampling", ForeignTableRelationId, false},
+		{"estimate_cache_ttl", ForeignServerRelationId, false},
 		/* cost factors */
 		{"fdw_startup_cost", ForeignServerRelationId, false},
 		{"fdw_tuple_cost", ForeignServerRelationId, false},
 		/* updatable is available on both server and table */
 		{"updatable", ForeignServerRelationId, false},
 		{"updatable", ForeignTableRelationId, false},
+		/* truncatable is available on both server and table */
+		{"truncatable", ForeignServerRelationId, false},
+		{"truncatable", ForeignTableRelationId, false},
 		{"schema_name", ForeignTableRelationId, false},
 		{"table_name", ForeignTableRelationId, false},
 		{"key", AttributeRelationId, false},
@@ -351,3 +446,85 @@ jdbc_extract_connection_options(List *defelems, const char **keywords,
 	}
 	return i;
 }
+
+/*
+ * Parse the value of the "dialect" option.  Returns false if it is not a
+ * known dialect.
+ */
+bool
+jdbc_parse_dialect(const char *value, JdbcDialect *dialect)
+{
+	JdbcDialect result;
+
+	if (pg_strcasecmp(value, "postgresql") == 0)
+		result = JDBC_DIALECT_POSTGRESQL;
+	else if (pg_strcasecmp(value, "mysql") == 0)
+		result = JDBC_DIALECT_MYSQL;
+	else if (pg_strcasecmp(value, "standard") == 0)
+		result = JDBC_DIALECT_STANDARD;
+	else
+		return false;
+
+	if (dialect)
+		*dialect = result;
+	return true;
+}
+
+/*
+ * Parse the value of the "analyze_sampling" option.  Returns false if it is
+ * not a known sampling method.
+ */
+bool
+jdbc_parse_analyze_sampling(const char *value, JdbcAnalyzeSampling * method)
+{
+	JdbcAnalyzeSampling result;
+
+	if (pg_strcasecmp(value, "off") == 0)
+		result = JDBC_SAMPLE_OFF;
+	else if (pg_strcasecmp(value, "auto") == 0)
+		result = JDBC_SAMPLE_AUTO;
+	else if (pg_strcasecmp(value, "random") == 0)
+		result = JDBC_SAMPLE_RANDOM;
+	else if (pg_strcasecmp(value, "system") == 0)
+		result = JDBC_SAMPLE_SYSTEM;
+	else if (pg_strcasecmp(value, "bernoulli") == 0)
+		result = JDBC_SAMPLE_BERNOULLI;
+	else if (pg_strcasecmp(value, "order") == 0)
+		result = JDBC_SAMPLE_ORDER;
+	else
+		return false;
+
+	if (method)
+		*method = result;
+	return true;
+}
+
+/*
+ * Determine the SQL dialect of the remote server, from the "dialect" option
+ * of the foreign server or else from the product name the driver reports.
+ */
+JdbcDialect
+jdbc_get_dialect(ForeignServer *server, JDBCUtilsInfo * jdbcUtilsInfo)
+{
+	JdbcDialect dialect = JDBC_DIALECT_STANDARD;
+	char	   *product_name;
+	ListCell   *lc;
+
+	foreach(lc, server->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "dialect") == 0 &&
+			jdbc_parse_dialect(defGetString(def), &dialect))
+			return dialect;
+	}
+
+	product_name = jq_get_database_product_name(jdbcUtilsInfo);
+	if (product_name == NULL)
+		return JDBC_DIALECT_STANDARD;
+	if (strcmp(product_name, "PostgreSQL") == 0)
+		return JDBC_DIALECT_POSTGRESQL;
+	if (strcmp(product_name, "MySQL") == 0 || strcmp(product_name, "MariaDB") == 0)
+		return JDBC_DIALECT_MYSQL;
+	return JDBC_DIALECT_STANDARD;
+}
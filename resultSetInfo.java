@@ -1,56 +1,159 @@
-/*-------------------------------------------------------------------------
- *
- *                foreign-data wrapper for JDBC
- *
- * Portions Copyright (c) 2021, TOSHIBA CORPORATION
- *
- * This software is released under the PostgreSQL Licence
- *
- * IDENTIFICATION
- *                jdbc_fdw/resultSetInfo.java
- *
- *-------------------------------------------------------------------------
- */
-import java.sql.*;
-
-public class resultSetInfo {
-  private ResultSet resultSet;
-  private Integer numberOfColumns;
-  private int numberOfAffectedRows;
-  private PreparedStatement pstmt;
-
-  public resultSetInfo(
-      ResultSet fieldResultSet,
-      Integer fieldNumberOfColumns,
-      int fieldNumberOfAffectedRows,
-      PreparedStatement fieldPstmt) {
-    this.resultSet = fieldResultSet;
-    this.numberOfColumns = fieldNumberOfColumns;
-    this.numberOfAffectedRows = fieldNumberOfAffectedRows;
-    this.pstmt = fieldPstmt;
-  }
-
-  public void setPstmt(PreparedStatement fieldPstmt) {
-    this.pstmt = fieldPstmt;
-  }
-
-  public void setNumberOfAffectedRows(int fieldNumberOfAffectedRows) {
-    this.numberOfAffectedRows = fieldNumberOfAffectedRows;
-  }
-
-  public ResultSet getResultSet() {
-    return resultSet;
-  }
-
-  public Integer getNumberOfColumns() {
-    return numberOfColumns;
-  }
-
-  public int getNumberOfAffectedRows() {
-    return numberOfAffectedRows;
-  }
-
-  public PreparedStatement getPstmt() {
-    return pstmt;
-  }
-}
+/*-------------------------------------------------------------------------
+ *
+ *                foreign-data wrapper for JDBC
+ *
+ * Portions Copyright (c) 2021, TOSHIBA CORPORATION
+ *
+ * This software is released under the PostgreSQL Licence
+ *
+ * IDENTIFICATION
+ *                jdbc_fdw/resultSetInfo.java
+ *
+ *-------------------------------------------------------------------------
+ */
+import java.nio.ByteBuffer;
+import java.sql.*;
+import java.util.*;
+
+public class resultSetInfo {
+  private ResultSet resultSet;
+  private Integer numberOfColumns;
+  private int numberOfAffectedRows;
+  private PreparedStatement pstmt;
+  private int[] columnTypes;
+  private int[] columnPrecisions;
+  private Calendar utcCalendar;
+  private JDBCColumnarBatch columnarBatch;
+  private JDBCConnection streamingConnection;
+  private BulkLoader bulkLoader;
+  private boolean sharedStatement = false;
+  private List<ByteBuffer> asyncBatchRows = new ArrayList<ByteBuffer>();
+
+  public resultSetInfo(
+      ResultSet fieldResultSet,
+      Integer fieldNumberOfColumns,
+      int fieldNumberOfAffectedRows,
+      PreparedStatement fieldPstmt) {
+    this.resultSet = fieldResultSet;
+    this.numberOfColumns = fieldNumberOfColumns;
+    this.numberOfAffectedRows = fieldNumberOfAffectedRows;
+    this.pstmt = fieldPstmt;
+  }
+
+  /*
+   * setColumnMetaData
+   *      Keeps the JDBC type and precision of each column of the result set,
+   *      so that rows can be read without metadata calls.
+   */
+  public void setColumnMetaData(int[] fieldColumnTypes, int[] fieldColumnPrecisions) {
+    this.columnTypes = fieldColumnTypes;
+    this.columnPrecisions = fieldColumnPrecisions;
+    this.utcCalendar = Calendar.getInstance(TimeZone.getTimeZone("UTC"));
+  }
+
+  /*
+   * setStreamingConnection
+   *      Remembers that autocommit was turned off on the connection to
+   *      stream this result set.
+   */
+  public void setStreamingConnection(JDBCConnection fieldStreamingConnection) {
+    this.streamingConnection = fieldStreamingConnection;
+  }
+
+  /*
+   * endStreaming
+   *      Closes the statement of a streamed result set.  The remote
+   *      transaction it ran in is ended at local transaction end.
+   */
+  public void endStreaming() throws SQLException {
+    if (streamingConnection != null) {
+      streamingConnection = null;
+      if (resultSet != null && !resultSet.isClosed()) {
+        resultSet.getStatement().close();
+      }
+    }
+  }
+
+  public void setBulkLoader(BulkLoader fieldBulkLoader) {
+    this.bulkLoader = fieldBulkLoader;
+  }
+
+  public BulkLoader getBulkLoader() {
+    return bulkLoader;
+  }
+
+  /*
+   * addAsyncBatchRow
+   *      Keeps a serialized row for the next asynchronous batch
+   */
+  public void addAsyncBatchRow(ByteBuffer row) {
+    asyncBatchRows.add(row);
+  }
+
+  /*
+   * takeAsyncBatchRows
+   *      Returns the rows of the next asynchronous batch and starts a new one
+   */
+  public List<ByteBuffer> takeAsyncBatchRows() {
+    List<ByteBuffer> rows = asyncBatchRows;
+
+    asyncBatchRows = new ArrayList<ByteBuffer>();
+    return rows;
+  }
+
+  /*
+   * setSharedStatement
+   *      Marks a result set whose statement belongs to another resultID,
+   *      such as the result set of getGeneratedKeys or of a prepared query
+   */
+  public void setSharedStatement(boolean fieldSharedStatement) {
+    this.sharedStatement = fieldSharedStatement;
+  }
+
+  public boolean isSharedStatement() {
+    return sharedStatement;
+  }
+
+  public void setPstmt(PreparedStatement fieldPstmt) {
+    this.pstmt = fieldPstmt;
+  }
+
+  public void setNumberOfAffectedRows(int fieldNumberOfAffectedRows) {
+    this.numberOfAffectedRows = fieldNumberOfAffectedRows;
+  }
+
+  public ResultSet getResultSet() {
+    return resultSet;
+  }
+
+  public Integer getNumberOfColumns() {
+    return numberOfColumns;
+  }
+
+  public int getNumberOfAffectedRows() {
+    return numberOfAffectedRows;
+  }
+
+  public PreparedStatement getPstmt() {
+    return pstmt;
+  }
+
+  public int[] getColumnTypes() {
+    return columnTypes;
+  }
+
+  public int[] getColumnPrecisions() {
+    return columnPrecisions;
+  }
+
+  public Calendar getUtcCalendar() {
+    return utcCalendar;
+  }
+
+  public JDBCColumnarBatch getColumnarBatch() {
+    if (columnarBatch == null) {
+      columnarBatch = new JDBCColumnarBatch(columnTypes, columnPrecisions, utcCalendar);
+    }
+    return columnarBatch;
+  }
+}
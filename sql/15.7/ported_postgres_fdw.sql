@@ -736,6 +736,30 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT t1.c1, t2.c2, t1.c3 FROM ft1 t1 FULL JOIN ft2 t2 ON (t1.c1 = t2.c1) WHERE postgres_fdw_abs(t1.c1) > 0 OFFSET 10 LIMIT 10;
 --Testcase 160:
 -- ALTER SERVER :DB_SERVERNAME OPTIONS (ADD extensions :DB_EXTENSIONNAME);
+-- inner join, the conditions of both sides go to the WHERE clause
+--Testcase 890:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft4 t1 INNER JOIN ft5 t2 ON (t1.c1 = t2.c1) WHERE t1.c1 > 20 AND t2.c1 < 40 ORDER BY t1.c1;
+--Testcase 891:
+SELECT t1.c1, t2.c1 FROM ft4 t1 INNER JOIN ft5 t2 ON (t1.c1 = t2.c1) WHERE t1.c1 > 20 AND t2.c1 < 40 ORDER BY t1.c1;
+-- left outer join, the conditions of the nullable side go to the ON clause
+--Testcase 892:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft4 t1 LEFT JOIN ft5 t2 ON (t1.c1 = t2.c1 AND t2.c1 < 40) WHERE t1.c1 > 20 AND t1.c1 < 50 ORDER BY t1.c1;
+--Testcase 893:
+SELECT t1.c1, t2.c1 FROM ft4 t1 LEFT JOIN ft5 t2 ON (t1.c1 = t2.c1 AND t2.c1 < 40) WHERE t1.c1 > 20 AND t1.c1 < 50 ORDER BY t1.c1;
+-- right outer join, deparsed as a left outer join
+--Testcase 894:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft5 t1 RIGHT JOIN ft4 t2 ON (t1.c1 = t2.c1 AND t1.c1 < 40) WHERE t2.c1 > 20 AND t2.c1 < 50 ORDER BY t2.c1;
+--Testcase 895:
+SELECT t1.c1, t2.c1 FROM ft5 t1 RIGHT JOIN ft4 t2 ON (t1.c1 = t2.c1 AND t1.c1 < 40) WHERE t2.c1 > 20 AND t2.c1 < 50 ORDER BY t2.c1;
+-- full outer join is not pushed down when a joining relation has conditions
+--Testcase 896:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(t1.c1), count(t2.c1) FROM ft4 t1 FULL JOIN (SELECT c1 FROM ft5 WHERE c1 < 10) t2 ON (t1.c1 = t2.c1);
+--Testcase 897:
+SELECT count(t1.c1), count(t2.c1) FROM ft4 t1 FULL JOIN (SELECT c1 FROM ft5 WHERE c1 < 10) t2 ON (t1.c1 = t2.c1);
 -- join two tables with FOR UPDATE clause
 -- tests whole-row reference for row marks
 --Testcase 161:
@@ -1917,9 +1941,9 @@ ALTER TABLE ft1 ADD CONSTRAINT c2positive CHECK (c2 >= 0);
 --Testcase 478:
 INSERT INTO ft1(c1, c2) VALUES(11, 12);  -- duplicate key
 --Testcase 479:
--- Does not support ON CONFLICT DO NOTHING
+-- ON CONFLICT DO NOTHING skips the existing row (GridDB has no MERGE)
 --Testcase 837:
-INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT DO NOTHING; -- error
+INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT DO NOTHING; -- works
 --Testcase 480:
 INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT (c1, c2) DO NOTHING; -- unsupported
 --Testcase 481:
@@ -4456,6 +4480,85 @@ ALTER FOREIGN DATA WRAPPER :DB_EXTENSIONNAME OPTIONS (nonexistent 'fdw');
 -- ALTER SERVER loopback OPTIONS (DROP parallel_commit);
 -- ALTER SERVER loopback2 OPTIONS (DROP parallel_commit);
 
+-- ===================================================================
+-- test for ANALYZE sampling
+-- ===================================================================
+--Testcase 898:
+CREATE FOREIGN TABLE analyze_ftable (id int OPTIONS (key 'true'), a text, b bigint)
+       SERVER :DB_SERVERNAME OPTIONS (table_name 'analyze_rtable1');
+--Testcase 899:
+INSERT INTO analyze_ftable (SELECT x FROM generate_series(1001, 1500) x);
+-- sample 300 rows
+--Testcase 900:
+SET default_statistics_target = 1;
+
+--Testcase 901:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (analyze_sampling 'invalid');
+
+-- the number of rows of a PostgreSQL table is taken from the remote
+-- catalog, the rows of other tables are counted
+--Testcase 902:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (ADD analyze_sampling 'auto');
+--Testcase 903:
+ANALYZE analyze_ftable;
+--Testcase 904:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 905:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'system');
+--Testcase 906:
+ANALYZE analyze_ftable;
+--Testcase 907:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 908:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'bernoulli');
+--Testcase 909:
+ANALYZE analyze_ftable;
+--Testcase 910:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 911:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'random');
+--Testcase 912:
+ANALYZE analyze_ftable;
+--Testcase 913:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 914:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'order');
+--Testcase 915:
+ANALYZE analyze_ftable;
+--Testcase 916:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+
+-- without sampling, all the rows are fetched and counted
+--Testcase 917:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'off');
+--Testcase 918:
+ANALYZE analyze_ftable;
+--Testcase 919:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 920:
+SELECT attname, null_frac FROM pg_stats WHERE tablename = 'analyze_ftable' ORDER BY attname;
+
+-- the remote catalog has no estimate before the table is analyzed
+--Testcase 921:
+CREATE FOREIGN TABLE analyze_ftable2 (id int OPTIONS (key 'true'), a text, b bigint)
+       SERVER :DB_SERVERNAME OPTIONS (table_name 'analyze_rtable2', analyze_sampling 'random');
+--Testcase 922:
+INSERT INTO analyze_ftable2 (SELECT x FROM generate_series(1, 1000) x);
+--Testcase 923:
+ANALYZE analyze_ftable2;
+--Testcase 924:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable2';
+--Testcase 925:
+SELECT attname, null_frac FROM pg_stats WHERE tablename = 'analyze_ftable2' ORDER BY attname;
+
+-- cleanup
+--Testcase 926:
+RESET default_statistics_target;
+--Testcase 927:
+DROP FOREIGN TABLE analyze_ftable;
+--Testcase 928:
+DROP FOREIGN TABLE analyze_ftable2;
+
 --Testcase 838:
 DROP TYPE user_enum CASCADE;
 --Testcase 839:
@@ -229,6 +229,37 @@ SELECT a, b, char_length(c) FROM update_test;
 --Testcase 71:
 SELECT a, b, char_length(c) FROM update_test;
 
+-- UPDATE is sent to the remote server as a single statement, unless some
+-- of the work has to be done locally.
+-- A qual that cannot be sent to the remote server
+--Testcase 79:
+EXPLAIN (VERBOSE, COSTS OFF)
+UPDATE update_test SET b = b + 1 WHERE a = 100 AND random() >= 0;
+--Testcase 80:
+UPDATE update_test SET b = b + 1 WHERE a = 100 AND random() >= 0;
+-- A new value that cannot be computed by the remote server
+--Testcase 81:
+EXPLAIN (VERBOSE, COSTS OFF)
+UPDATE update_test SET c = to_char(b, 'FM999') WHERE a = 100;
+--Testcase 82:
+UPDATE update_test SET c = to_char(b, 'FM999') WHERE a = 100;
+-- RETURNING, which needs the rows, is only supported on PostgreSQL
+--Testcase 83:
+EXPLAIN (VERBOSE, COSTS OFF)
+UPDATE update_test SET b = b + 1 WHERE a = 100 RETURNING a, b;
+--Testcase 84:
+UPDATE update_test SET b = b + 1 WHERE a = 100 RETURNING a, b;
+-- A join with another relation
+--Testcase 85:
+EXPLAIN (VERBOSE, COSTS OFF)
+UPDATE update_test SET b = v.j FROM (VALUES (12, 50), (13, 60)) AS v(i, j)
+  WHERE update_test.a = v.i;
+--Testcase 86:
+UPDATE update_test SET b = v.j FROM (VALUES (12, 50), (13, 60)) AS v(i, j)
+  WHERE update_test.a = v.i;
+--Testcase 87:
+SELECT a, b, char_length(c) FROM update_test ORDER BY a, b;
+
 --Testcase 74:
 DROP FOREIGN TABLE update_test;
 
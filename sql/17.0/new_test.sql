@@ -263,6 +263,461 @@ SELECT * FROM public.jdbc_fdw_version();
 --Testcase 95:
 SELECT jdbc_fdw_version();
 
+-- ===================================================================
+-- test for batch_size
+-- ===================================================================
+--Testcase 101:
+CREATE FOREIGN TABLE batch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'batch_tbl', batch_size 'abc');
+--Testcase 102:
+CREATE FOREIGN TABLE batch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'batch_tbl', batch_size '0');
+--Testcase 103:
+CREATE FOREIGN TABLE batch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'batch_tbl', batch_size '4');
+-- rows are sent in batches of 4, 4 and 2 rows
+--Testcase 104:
+INSERT INTO batch_ft SELECT id, 'row ' || id FROM generate_series(1, 10) id;
+--Testcase 105:
+SELECT * FROM batch_ft ORDER BY id;
+-- an error of a batched row fails the statement
+--Testcase 106:
+INSERT INTO batch_ft SELECT id, 'new ' || id FROM generate_series(9, 10) id;
+--Testcase 107:
+SELECT count(*) FROM batch_ft;
+-- rows are sent one at a time when the table has row triggers
+--Testcase 108:
+CREATE FUNCTION batch_trig_func() RETURNS trigger LANGUAGE plpgsql AS $$ BEGIN NEW.c1 := NEW.c1 || ' (trigger)'; RETURN NEW; END $$;
+--Testcase 109:
+CREATE TRIGGER batch_trig BEFORE INSERT ON batch_ft FOR EACH ROW EXECUTE PROCEDURE batch_trig_func();
+--Testcase 110:
+INSERT INTO batch_ft SELECT id, 'row ' || id FROM generate_series(11, 12) id;
+--Testcase 111:
+SELECT * FROM batch_ft WHERE id > 10 ORDER BY id;
+--Testcase 112:
+DROP TRIGGER batch_trig ON batch_ft;
+--Testcase 113:
+DROP FUNCTION batch_trig_func();
+--Testcase 114:
+DROP FOREIGN TABLE batch_ft;
+
+-- ===================================================================
+-- test for COPY and tuple routing into foreign tables
+-- ===================================================================
+--Testcase 115:
+CREATE FOREIGN TABLE copy_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'copy_tbl');
+--Testcase 116:
+COPY copy_ft FROM stdin;
+1	foo
+2	bar
+\.
+--Testcase 117:
+SELECT * FROM copy_ft ORDER BY id;
+--Testcase 118:
+CREATE TABLE copy_pt (id int, c1 text) PARTITION BY RANGE (id);
+--Testcase 119:
+CREATE TABLE copy_pt_local PARTITION OF copy_pt FOR VALUES FROM (100) TO (200);
+--Testcase 120:
+ALTER TABLE copy_pt ATTACH PARTITION copy_ft FOR VALUES FROM (1) TO (100);
+--Testcase 121:
+INSERT INTO copy_pt VALUES (3, 'baz'), (150, 'local');
+--Testcase 122:
+COPY copy_pt FROM stdin;
+4	qux
+160	local2
+\.
+--Testcase 123:
+SELECT tableoid::regclass, * FROM copy_pt ORDER BY id;
+-- rows routed into the foreign partition are batched with batch_size
+--Testcase 124:
+ALTER FOREIGN TABLE copy_ft OPTIONS (ADD batch_size '2');
+--Testcase 125:
+INSERT INTO copy_pt VALUES (5, 'a'), (6, 'b'), (170, 'local3'), (7, 'c');
+--Testcase 126:
+SELECT tableoid::regclass, * FROM copy_pt ORDER BY id;
+--Testcase 127:
+DROP TABLE copy_pt;
+
+-- ===================================================================
+-- test for bulk_load
+-- ===================================================================
+--Testcase 128:
+CREATE FOREIGN TABLE bulk_ft (id int OPTIONS (key 'true'), c1 text, c2 timestamp, c3 boolean) SERVER :DB_SERVERNAME OPTIONS (table_name 'bulk_tbl', bulk_load 'maybe');
+--Testcase 129:
+CREATE FOREIGN TABLE bulk_ft (id int OPTIONS (key 'true'), c1 text, c2 timestamp, c3 boolean) SERVER :DB_SERVERNAME OPTIONS (table_name 'bulk_tbl', bulk_load 'true', batch_size '3');
+-- PostgreSQL loads the rows with COPY, MySQL with LOAD DATA LOCAL, which
+-- the connection does not allow here, and GridDB has no bulk path
+--Testcase 130:
+INSERT INTO bulk_ft VALUES (1, 'one', '2000-01-01 00:00:00', true), (2, NULL, '2010-10-01 10:10:00', false),
+       (3, 'back\slash', NULL, true), (4, 'four', '1999-10-01 00:00:00', NULL);
+--Testcase 131:
+SELECT * FROM bulk_ft ORDER BY id;
+--Testcase 132:
+DROP FOREIGN TABLE bulk_ft;
+-- MySQL skips the rows of LOAD DATA LOCAL with a duplicate key, which then
+-- fails the statement as the prepared INSERT does
+--Testcase 268:
+ALTER SERVER :DB_SERVERNAME OPTIONS (SET url :DB_URL_BULK);
+--Testcase 269:
+CREATE FOREIGN TABLE bulk_dup_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'bulk_tbl', bulk_load 'true', batch_size '3');
+--Testcase 270:
+INSERT INTO bulk_dup_ft VALUES (11, 'eleven'), (12, 'twelve'), (13, 'thirteen');
+--Testcase 271:
+INSERT INTO bulk_dup_ft VALUES (13, 'dup'), (15, 'fifteen');
+--Testcase 272:
+SELECT * FROM bulk_dup_ft WHERE id > 10 ORDER BY id;
+--Testcase 273:
+DROP FOREIGN TABLE bulk_dup_ft;
+--Testcase 274:
+ALTER SERVER :DB_SERVERNAME OPTIONS (SET url :DB_URL);
+
+-- ===================================================================
+-- test for async_write
+-- ===================================================================
+--Testcase 133:
+CREATE FOREIGN TABLE async_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'async_tbl', async_write 'maybe');
+--Testcase 134:
+CREATE FOREIGN TABLE async_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'async_tbl', batch_size '2', async_write 'true');
+--Testcase 135:
+INSERT INTO async_ft SELECT id, 'row ' || id FROM generate_series(1, 7) id;
+--Testcase 136:
+SELECT * FROM async_ft ORDER BY id;
+-- an error of a batch executed in the background fails the statement
+--Testcase 137:
+INSERT INTO async_ft VALUES (1, 'dup'), (2, 'dup');
+--Testcase 138:
+SELECT count(*) FROM async_ft;
+-- the scan of the same connection waits for the pending batches
+--Testcase 139:
+INSERT INTO async_ft SELECT id + 100, c1 FROM async_ft;
+--Testcase 140:
+SELECT count(*) FROM async_ft;
+--Testcase 141:
+DROP FOREIGN TABLE async_ft;
+
+-- ===================================================================
+-- test for TRUNCATE
+-- ===================================================================
+--Testcase 142:
+CREATE FOREIGN TABLE trunc_ft1 (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'trunc_tbl1', truncatable 'maybe');
+--Testcase 143:
+CREATE FOREIGN TABLE trunc_ft1 (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'trunc_tbl1');
+--Testcase 144:
+CREATE FOREIGN TABLE trunc_ft2 (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'trunc_tbl2');
+--Testcase 145:
+INSERT INTO trunc_ft1 SELECT id, 'row ' || id FROM generate_series(1, 3) id;
+--Testcase 146:
+INSERT INTO trunc_ft2 SELECT id, 'row ' || id FROM generate_series(1, 3) id;
+--Testcase 147:
+TRUNCATE trunc_ft1;
+--Testcase 148:
+SELECT count(*) FROM trunc_ft1;
+--Testcase 149:
+INSERT INTO trunc_ft1 VALUES (4, 'row 4'), (5, 'row 5');
+-- MySQL truncates one table per statement, so the tables are emptied
+-- by DELETE instead
+--Testcase 150:
+TRUNCATE trunc_ft1, trunc_ft2;
+--Testcase 151:
+SELECT (SELECT count(*) FROM trunc_ft1) AS count1, (SELECT count(*) FROM trunc_ft2) AS count2;
+-- there is no fallback for RESTART IDENTITY and CASCADE
+--Testcase 152:
+INSERT INTO trunc_ft1 VALUES (6, 'row 6');
+--Testcase 153:
+TRUNCATE trunc_ft1 RESTART IDENTITY;
+--Testcase 154:
+SELECT count(*) FROM trunc_ft1;
+-- truncatable
+--Testcase 155:
+ALTER FOREIGN TABLE trunc_ft1 OPTIONS (ADD truncatable 'false');
+--Testcase 156:
+TRUNCATE trunc_ft1;
+--Testcase 157:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD truncatable 'false');
+--Testcase 158:
+TRUNCATE trunc_ft2;
+-- the table option overrides the server option
+--Testcase 159:
+ALTER FOREIGN TABLE trunc_ft1 OPTIONS (SET truncatable 'true');
+--Testcase 160:
+INSERT INTO trunc_ft1 VALUES (7, 'row 7');
+--Testcase 161:
+TRUNCATE trunc_ft1;
+--Testcase 162:
+SELECT count(*) FROM trunc_ft1;
+--Testcase 163:
+ALTER SERVER :DB_SERVERNAME OPTIONS (DROP truncatable);
+--Testcase 164:
+DROP FOREIGN TABLE trunc_ft1;
+--Testcase 165:
+DROP FOREIGN TABLE trunc_ft2;
+
+-- ===================================================================
+-- test for key_batch_size
+-- ===================================================================
+--Testcase 166:
+CREATE FOREIGN TABLE keyset_ft (id int OPTIONS (key 'true'), c1 int, c2 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'keyset_tbl', key_batch_size '-1');
+--Testcase 167:
+CREATE FOREIGN TABLE keyset_ft (id int OPTIONS (key 'true'), c1 int, c2 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'keyset_tbl', key_batch_size '3');
+--Testcase 168:
+INSERT INTO keyset_ft SELECT id, id, 'row ' || id FROM generate_series(1, 10) id;
+-- random() cannot be sent to the remote server, so the rows are deleted
+-- with the keys of up to 3 rows per statement
+--Testcase 169:
+DELETE FROM keyset_ft WHERE id % 2 = 0 AND random() >= 0;
+--Testcase 170:
+SELECT * FROM keyset_ft ORDER BY id;
+-- rows are only updated together while their new values are the same
+--Testcase 171:
+UPDATE keyset_ft SET c2 = 'odd ' || (id % 4) WHERE random() >= 0;
+--Testcase 172:
+SELECT * FROM keyset_ft ORDER BY id;
+--Testcase 173:
+UPDATE keyset_ft SET c1 = c1 * 10 WHERE id > 1 AND random() >= 0;
+--Testcase 174:
+SELECT * FROM keyset_ft ORDER BY id;
+-- a key of several columns
+--Testcase 175:
+ALTER FOREIGN TABLE keyset_ft ALTER COLUMN c1 OPTIONS (ADD key 'true');
+--Testcase 176:
+DELETE FROM keyset_ft WHERE id > 3 AND random() >= 0;
+--Testcase 177:
+SELECT * FROM keyset_ft ORDER BY id;
+--Testcase 178:
+DROP FOREIGN TABLE keyset_ft;
+
+-- ===================================================================
+-- test for ON CONFLICT, upsert and dialect
+-- ===================================================================
+--Testcase 179:
+CREATE FOREIGN TABLE upsert_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'upsert_tbl', upsert 'maybe');
+--Testcase 180:
+CREATE FOREIGN TABLE upsert_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'upsert_tbl');
+--Testcase 181:
+INSERT INTO upsert_ft VALUES (1, 'one'), (2, 'two');
+--Testcase 182:
+EXPLAIN (VERBOSE, COSTS OFF)
+INSERT INTO upsert_ft VALUES (2, 'new two'), (3, 'three') ON CONFLICT DO NOTHING;
+--Testcase 183:
+INSERT INTO upsert_ft VALUES (2, 'new two'), (3, 'three') ON CONFLICT DO NOTHING;
+--Testcase 184:
+SELECT * FROM upsert_ft ORDER BY id;
+-- rows of ON CONFLICT DO NOTHING are batched, and only the inserted ones
+-- are counted
+--Testcase 264:
+ALTER FOREIGN TABLE upsert_ft OPTIONS (ADD batch_size '2');
+--Testcase 265:
+DO $$
+DECLARE
+  n int;
+BEGIN
+  INSERT INTO upsert_ft VALUES (1, 'new one'), (3, 'new three'), (4, 'four') ON CONFLICT DO NOTHING;
+  GET DIAGNOSTICS n = ROW_COUNT;
+  RAISE NOTICE 'inserted % rows', n;
+END $$;
+--Testcase 266:
+SELECT * FROM upsert_ft ORDER BY id;
+--Testcase 267:
+ALTER FOREIGN TABLE upsert_ft OPTIONS (DROP batch_size);
+-- the upsert option updates the existing rows
+--Testcase 185:
+ALTER FOREIGN TABLE upsert_ft OPTIONS (ADD upsert 'true');
+--Testcase 186:
+EXPLAIN (VERBOSE, COSTS OFF)
+INSERT INTO upsert_ft VALUES (3, 'new three'), (4, 'four');
+--Testcase 187:
+INSERT INTO upsert_ft VALUES (3, 'new three'), (4, 'four');
+--Testcase 188:
+SELECT * FROM upsert_ft ORDER BY id;
+-- the dialect option
+--Testcase 189:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD dialect 'oracle');
+--Testcase 190:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD dialect 'standard');
+--Testcase 191:
+EXPLAIN (VERBOSE, COSTS OFF)
+INSERT INTO upsert_ft VALUES (4, 'new four');
+-- PostgreSQL has MERGE since version 15, MySQL and GridDB have none
+--Testcase 192:
+INSERT INTO upsert_ft VALUES (4, 'new four');
+--Testcase 193:
+SELECT * FROM upsert_ft ORDER BY id;
+--Testcase 194:
+ALTER SERVER :DB_SERVERNAME OPTIONS (DROP dialect);
+-- MySQL finds the existing rows with the unique keys of the remote table,
+-- the other dialects need key columns
+--Testcase 195:
+CREATE FOREIGN TABLE upsert_nokey_ft (id int, c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'upsert_tbl', upsert 'true');
+--Testcase 196:
+INSERT INTO upsert_nokey_ft VALUES (1, 'new one');
+--Testcase 197:
+SELECT * FROM upsert_ft ORDER BY id;
+--Testcase 198:
+DROP FOREIGN TABLE upsert_ft;
+--Testcase 199:
+DROP FOREIGN TABLE upsert_nokey_ft;
+
+-- ===================================================================
+-- test for RETURNING
+-- ===================================================================
+--Testcase 200:
+CREATE FOREIGN TABLE ret_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'ret_tbl');
+--Testcase 201:
+INSERT INTO ret_ft VALUES (1, 'one'), (2, 'two') RETURNING id;
+-- only PostgreSQL returns the columns that are not keys
+--Testcase 202:
+INSERT INTO ret_ft VALUES (3, 'three') RETURNING *;
+--Testcase 203:
+UPDATE ret_ft SET c1 = c1 || '!' WHERE id = 1 RETURNING id, c1;
+--Testcase 204:
+DELETE FROM ret_ft WHERE id = 2 RETURNING *;
+--Testcase 205:
+SELECT * FROM ret_ft ORDER BY id;
+--Testcase 206:
+DROP FOREIGN TABLE ret_ft;
+
+-- ===================================================================
+-- test for parameterized foreign scans
+-- ===================================================================
+--Testcase 207:
+CREATE FOREIGN TABLE param_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl');
+--Testcase 208:
+INSERT INTO param_ft SELECT id, 'row ' || id FROM generate_series(1, 10) id;
+--Testcase 209:
+CREATE TABLE param_loc (id int);
+--Testcase 210:
+INSERT INTO param_loc VALUES (3);
+--Testcase 211:
+ANALYZE param_loc;
+--Testcase 212:
+INSERT INTO param_loc VALUES (5), (12);
+-- the join clause on the key column is sent with the value of the outer row
+--Testcase 213:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT l.id, f.c1 FROM param_loc l JOIN param_ft f ON f.id = l.id;
+-- the prepared query is executed again for each outer row
+--Testcase 214:
+SELECT l.id, f.c1 FROM param_loc l JOIN param_ft f ON f.id = l.id ORDER BY l.id;
+--Testcase 215:
+DROP TABLE param_loc;
+--Testcase 216:
+DROP FOREIGN TABLE param_ft;
+
+-- ===================================================================
+-- test for lookup_cache_size
+-- ===================================================================
+--Testcase 217:
+CREATE FOREIGN TABLE lookup_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', lookup_cache_size 'abc');
+--Testcase 218:
+CREATE FOREIGN TABLE lookup_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', lookup_cache_size '0');
+--Testcase 219:
+CREATE FOREIGN TABLE lookup_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', lookup_cache_size '2');
+--Testcase 220:
+CREATE TABLE lookup_loc (id int);
+--Testcase 221:
+INSERT INTO lookup_loc VALUES (3);
+--Testcase 222:
+ANALYZE lookup_loc;
+--Testcase 223:
+INSERT INTO lookup_loc VALUES (5), (3), (12), (5), (3);
+--Testcase 224:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT l.id, f.c1 FROM lookup_loc l JOIN lookup_ft f ON f.id = l.id;
+-- the rows of repeated values are taken from the cache,
+-- which is emptied when a third value comes
+--Testcase 225:
+SELECT l.id, f.c1 FROM lookup_loc l JOIN lookup_ft f ON f.id = l.id ORDER BY l.id;
+--Testcase 226:
+SELECT l.id, f.c1 FROM lookup_loc l LEFT JOIN lookup_ft f ON f.id = l.id ORDER BY l.id;
+--Testcase 227:
+DROP TABLE lookup_loc;
+--Testcase 228:
+DROP FOREIGN TABLE lookup_ft;
+
+-- ===================================================================
+-- test for use_remote_estimate and estimate_cache_ttl
+-- ===================================================================
+--Testcase 229:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD estimate_cache_ttl 'abc');
+--Testcase 230:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD estimate_cache_ttl '-1');
+--Testcase 231:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD estimate_cache_ttl '0');
+--Testcase 232:
+CREATE FOREIGN TABLE est_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', use_remote_estimate 'maybe');
+--Testcase 233:
+CREATE FOREIGN TABLE est_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', use_remote_estimate 'true');
+-- the remote server is asked for the estimate
+--Testcase 234:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT * FROM est_ft WHERE c1 = 'row 1';
+--Testcase 235:
+SELECT * FROM est_ft WHERE c1 = 'row 1';
+-- the second planning reuses the cached estimate
+--Testcase 236:
+ALTER SERVER :DB_SERVERNAME OPTIONS (SET estimate_cache_ttl '60');
+--Testcase 237:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT * FROM est_ft WHERE c1 = 'row 1';
+--Testcase 238:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT * FROM est_ft WHERE c1 = 'row 1';
+--Testcase 239:
+ALTER SERVER :DB_SERVERNAME OPTIONS (DROP estimate_cache_ttl);
+--Testcase 240:
+DROP FOREIGN TABLE est_ft;
+
+-- ===================================================================
+-- test for fetch_size and stream_results
+-- ===================================================================
+--Testcase 241:
+CREATE FOREIGN TABLE fetch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', fetch_size 'abc');
+--Testcase 242:
+CREATE FOREIGN TABLE fetch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', fetch_size '0');
+-- the rows are fetched 3 at a time
+--Testcase 243:
+CREATE FOREIGN TABLE fetch_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'param_tbl', fetch_size '3');
+--Testcase 244:
+SELECT * FROM fetch_ft ORDER BY id;
+--Testcase 245:
+ALTER FOREIGN TABLE fetch_ft OPTIONS (SET fetch_size '1');
+--Testcase 246:
+SELECT * FROM fetch_ft WHERE id > 7 ORDER BY id;
+--Testcase 247:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD stream_results 'maybe');
+-- the result sets are streamed by the driver
+--Testcase 248:
+ALTER SERVER :DB_SERVERNAME OPTIONS (ADD stream_results 'true');
+--Testcase 249:
+ALTER FOREIGN TABLE fetch_ft OPTIONS (SET fetch_size '4');
+--Testcase 250:
+SELECT * FROM fetch_ft ORDER BY id;
+-- the remote transaction begun for streaming is committed before the local
+-- one, so that a remote commit that fails aborts the local transaction
+--Testcase 253:
+CREATE FOREIGN TABLE defer_ft (id int OPTIONS (key 'true'), c1 text) SERVER :DB_SERVERNAME OPTIONS (table_name 'defer_tbl');
+--Testcase 254:
+BEGIN;
+--Testcase 255:
+SELECT count(*) FROM fetch_ft;
+--Testcase 256:
+INSERT INTO defer_ft VALUES (1, 'accept');
+--Testcase 257:
+COMMIT;
+--Testcase 258:
+BEGIN;
+--Testcase 259:
+SELECT count(*) FROM fetch_ft;
+--Testcase 260:
+INSERT INTO defer_ft VALUES (2, 'reject');
+--Testcase 261:
+COMMIT;
+--Testcase 262:
+SELECT * FROM defer_ft ORDER BY id;
+--Testcase 263:
+DROP FOREIGN TABLE defer_ft;
+--Testcase 251:
+ALTER SERVER :DB_SERVERNAME OPTIONS (DROP stream_results);
+--Testcase 252:
+DROP FOREIGN TABLE fetch_ft;
+
 --Testcase 70:
 DROP SERVER :DB_SERVERNAME CASCADE;
 --Testcase 71:
@@ -799,6 +799,30 @@ EXPLAIN (VERBOSE, COSTS OFF)
 SELECT t1.c1, t2.c2, t1.c3 FROM ft1 t1 FULL JOIN ft2 t2 ON (t1.c1 = t2.c1) WHERE postgres_fdw_abs(t1.c1) > 0 OFFSET 10 LIMIT 10;
 --Testcase 160:
 -- ALTER SERVER :DB_SERVERNAME OPTIONS (ADD extensions :DB_EXTENSIONNAME);
+-- inner join, the conditions of both sides go to the WHERE clause
+--Testcase 948:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft4 t1 INNER JOIN ft5 t2 ON (t1.c1 = t2.c1) WHERE t1.c1 > 20 AND t2.c1 < 40 ORDER BY t1.c1;
+--Testcase 949:
+SELECT t1.c1, t2.c1 FROM ft4 t1 INNER JOIN ft5 t2 ON (t1.c1 = t2.c1) WHERE t1.c1 > 20 AND t2.c1 < 40 ORDER BY t1.c1;
+-- left outer join, the conditions of the nullable side go to the ON clause
+--Testcase 950:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft4 t1 LEFT JOIN ft5 t2 ON (t1.c1 = t2.c1 AND t2.c1 < 40) WHERE t1.c1 > 20 AND t1.c1 < 50 ORDER BY t1.c1;
+--Testcase 951:
+SELECT t1.c1, t2.c1 FROM ft4 t1 LEFT JOIN ft5 t2 ON (t1.c1 = t2.c1 AND t2.c1 < 40) WHERE t1.c1 > 20 AND t1.c1 < 50 ORDER BY t1.c1;
+-- right outer join, deparsed as a left outer join
+--Testcase 952:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT t1.c1, t2.c1 FROM ft5 t1 RIGHT JOIN ft4 t2 ON (t1.c1 = t2.c1 AND t1.c1 < 40) WHERE t2.c1 > 20 AND t2.c1 < 50 ORDER BY t2.c1;
+--Testcase 953:
+SELECT t1.c1, t2.c1 FROM ft5 t1 RIGHT JOIN ft4 t2 ON (t1.c1 = t2.c1 AND t1.c1 < 40) WHERE t2.c1 > 20 AND t2.c1 < 50 ORDER BY t2.c1;
+-- full outer join is not pushed down when a joining relation has conditions
+--Testcase 954:
+EXPLAIN (VERBOSE, COSTS OFF)
+SELECT count(t1.c1), count(t2.c1) FROM ft4 t1 FULL JOIN (SELECT c1 FROM ft5 WHERE c1 < 10) t2 ON (t1.c1 = t2.c1);
+--Testcase 955:
+SELECT count(t1.c1), count(t2.c1) FROM ft4 t1 FULL JOIN (SELECT c1 FROM ft5 WHERE c1 < 10) t2 ON (t1.c1 = t2.c1);
 -- join two tables with FOR UPDATE clause
 -- tests whole-row reference for row marks
 --Testcase 161:
@@ -2171,9 +2195,9 @@ ALTER TABLE ft1 ADD CONSTRAINT c2positive CHECK (c2 >= 0);
 --Testcase 478:
 INSERT INTO ft1(c1, c2) VALUES(11, 12);  -- duplicate key
 --Testcase 479:
--- Does not support ON CONFLICT DO NOTHING
+-- ON CONFLICT DO NOTHING skips the existing row (GridDB has no MERGE)
 --Testcase 837:
-INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT DO NOTHING; -- error
+INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT DO NOTHING; -- works
 --Testcase 480:
 INSERT INTO ft1(c1, c2) VALUES(11, 12) ON CONFLICT (c1, c2) DO NOTHING; -- unsupported
 --Testcase 481:
@@ -5059,37 +5083,84 @@ ALTER FOREIGN DATA WRAPPER :DB_EXTENSIONNAME OPTIONS (nonexistent 'fdw');
 -- ALTER SERVER loopback2 OPTIONS (DROP parallel_commit);
 -- ALTER SERVER loopback2 OPTIONS (DROP parallel_abort);
 
--- -- ===================================================================
--- -- test for ANALYZE sampling
--- -- ===================================================================
-
--- CREATE TABLE analyze_table (id int, a text, b bigint);
-
--- CREATE FOREIGN TABLE analyze_ftable (id int, a text, b bigint)
---        SERVER loopback OPTIONS (table_name 'analyze_rtable1');
-
--- INSERT INTO analyze_table (SELECT x FROM generate_series(1,1000) x);
--- ANALYZE analyze_table;
-
--- SET default_statistics_target = 10;
--- ANALYZE analyze_table;
-
--- ALTER SERVER loopback OPTIONS (analyze_sampling 'invalid');
-
--- ALTER SERVER loopback OPTIONS (analyze_sampling 'auto');
--- ANALYZE analyze_table;
-
--- ALTER SERVER loopback OPTIONS (SET analyze_sampling 'system');
--- ANALYZE analyze_table;
-
--- ALTER SERVER loopback OPTIONS (SET analyze_sampling 'bernoulli');
--- ANALYZE analyze_table;
-
--- ALTER SERVER loopback OPTIONS (SET analyze_sampling 'random');
--- ANALYZE analyze_table;
+-- ===================================================================
+-- test for ANALYZE sampling
+-- ===================================================================
+--Testcase 956:
+CREATE FOREIGN TABLE analyze_ftable (id int OPTIONS (key 'true'), a text, b bigint)
+       SERVER :DB_SERVERNAME OPTIONS (table_name 'analyze_rtable1');
+--Testcase 957:
+INSERT INTO analyze_ftable (SELECT x FROM generate_series(1001, 1500) x);
+-- sample 300 rows
+--Testcase 958:
+SET default_statistics_target = 1;
+
+--Testcase 959:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (analyze_sampling 'invalid');
+
+-- the number of rows of a PostgreSQL table is taken from the remote
+-- catalog, the rows of other tables are counted
+--Testcase 960:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (ADD analyze_sampling 'auto');
+--Testcase 961:
+ANALYZE analyze_ftable;
+--Testcase 962:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 963:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'system');
+--Testcase 964:
+ANALYZE analyze_ftable;
+--Testcase 965:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 966:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'bernoulli');
+--Testcase 967:
+ANALYZE analyze_ftable;
+--Testcase 968:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 969:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'random');
+--Testcase 970:
+ANALYZE analyze_ftable;
+--Testcase 971:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 972:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'order');
+--Testcase 973:
+ANALYZE analyze_ftable;
+--Testcase 974:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+
+-- without sampling, all the rows are fetched and counted
+--Testcase 975:
+ALTER FOREIGN TABLE analyze_ftable OPTIONS (SET analyze_sampling 'off');
+--Testcase 976:
+ANALYZE analyze_ftable;
+--Testcase 977:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable';
+--Testcase 978:
+SELECT attname, null_frac FROM pg_stats WHERE tablename = 'analyze_ftable' ORDER BY attname;
+
+-- the remote catalog has no estimate before the table is analyzed
+--Testcase 979:
+CREATE FOREIGN TABLE analyze_ftable2 (id int OPTIONS (key 'true'), a text, b bigint)
+       SERVER :DB_SERVERNAME OPTIONS (table_name 'analyze_rtable2', analyze_sampling 'random');
+--Testcase 980:
+INSERT INTO analyze_ftable2 (SELECT x FROM generate_series(1, 1000) x);
+--Testcase 981:
+ANALYZE analyze_ftable2;
+--Testcase 982:
+SELECT reltuples FROM pg_class WHERE relname = 'analyze_ftable2';
+--Testcase 983:
+SELECT attname, null_frac FROM pg_stats WHERE tablename = 'analyze_ftable2' ORDER BY attname;
 
--- ALTER SERVER loopback OPTIONS (SET analyze_sampling 'off');
--- ANALYZE analyze_table;
+-- cleanup
+--Testcase 984:
+RESET default_statistics_target;
+--Testcase 985:
+DROP FOREIGN TABLE analyze_ftable;
+--Testcase 986:
+DROP FOREIGN TABLE analyze_ftable2;
 
 -- jdbc_fdw does not support query cancel
 -- SELECT version() ~ 'cygwin' AS skip_test \gset
@@ -5113,9 +5184,6 @@ ALTER FOREIGN DATA WRAPPER :DB_EXTENSIONNAME OPTIONS (nonexistent 'fdw');
 -- SELECT count(*) FROM ft1 a CROSS JOIN ft1 b CROSS JOIN ft1 c CROSS JOIN ft1 d;
 -- COMMIT;
 
--- -- cleanup
--- DROP FOREIGN TABLE analyze_ftable;
--- DROP TABLE analyze_table;
 
 --Testcase 838:
 DROP TYPE user_enum CASCADE;